@@ -23,10 +23,6 @@
 #include <regex.h>
 #include <assert.h>
 
-/* This entire file is dependent on the Tcl/Tk version */
-#ifdef TCL_QROUTER
-#include <tk.h>
-
 #include "qrouter.h"
 #include "qconfig.h"
 #include "mask.h"
@@ -35,10 +31,13 @@
 #include "lef.h"
 #include "def.h"
 #include "point.h"
+#include "pool.h"
+#include "routegraph.h"
+#include "congest.h"
 
-/* Node Hash Table routines taken from delay.c */
-extern GATE FindGateNode(Tcl_HashTable *, NODE, int *);
-extern void FreeNodeTable(Tcl_HashTable *);
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 extern int TotalRoutes;
 
@@ -52,6 +51,8 @@ struct antennainfo_ {
    NODE node;		/* A gate-end node that is in violation */
    ROUTE route;		/* A route that is part of the antenna	*/
    int layer;		/* Uppermost metal layer of the antenna */
+   float metal_area;	/* Metal area of the antenna		*/
+   float gate_area;	/* Gate area connected to the antenna	*/
 };
 
 /* Keep the list as a global variable so it can be accessed	*/
@@ -74,6 +75,19 @@ ANNOTATEINFO AnnotateList = NULL;
 #define ANNO_INIT 0
 #define ANNO_OUTPUT 1
 
+/* A free antenna tap, and the grid positions that connect to it */
+
+typedef struct antennatap_ {
+   NODE node;		/* Node of the antenna cell		*/
+   int x, y;		/* Grid position, for measuring distance */
+   int first;		/* First position in the position list	*/
+   int num;		/* Number of positions			*/
+   u_char used;		/* Tap has been assigned to a violation	*/
+} ANTENNATAP;
+
+/* Number of nearest taps considered for each violation */
+#define ANTENNA_TAP_CHOICES	4
+
 /*----------------------------------------------------------------------*/
 /* Report connection of a fixed antenna violation, given the net.	*/
 /*----------------------------------------------------------------------*/
@@ -174,6 +188,8 @@ find_free_antenna_taps(char *antennacell)
 		    ginst->netnum[i] = ANTENNA_NET;
 		    ginst->noderec[i] = (NODE)calloc(1, sizeof(struct node_));
 		    ginst->noderec[i]->netnum = ANTENNA_NET;
+		    ginst->noderec[i]->gate = ginst;
+		    ginst->noderec[i]->gateidx = i;
 		}
 	    }
 	}
@@ -215,29 +231,282 @@ count_free_antenna_taps(char *antennacell)
 /* change all but the one that was routed back to ANTENNA_NET.	*/
 /* Identify the unused taps by finding the OBSVAL record with	*/
 /* net set to netnum but not connected to the same node.	*/
+/* If "tap" is not NULL, then it was the only target, and only	*/
+/* its positions (in "tappos") need to be checked.		*/
 /*--------------------------------------------------------------*/
 
-void revert_antenna_taps(int netnum, NODE node)
+static void
+revert_antenna_position(int x, int y, int lay, int netnum, NODE node)
 {
-    int x, y, lay;
     PROUTE *Pr;
-    NODEINFO lnode = NULL;
+    NODEINFO lnode;
+
+    if ((OBSVAL(x, y, lay) & NETNUM_MASK) == netnum) {
+	Pr = &OBS2VAL(x, y, lay);
+	if (Pr->flags & PR_TARGET) {
+	    lnode = NODEIPTR(x, y, lay);
+	    if ((lnode == NULL) || (lnode->nodesav != node)) {
+		OBSVAL(x, y, lay) &= ~(NETNUM_MASK | ROUTED_NET);
+		OBSVAL(x, y, lay) |= ANTENNA_NET;
+		congestion_update(x, y);
+	    }
+	}
+    }
+}
+
+void revert_antenna_taps(int netnum, NODE node, ANTENNATAP *tap, int *tappos)
+{
+    int x, y, lay, i;
 
     /* Clear all targets except for the one just routed */
 
+    if (tap != NULL) {
+	for (i = tap->first; i < tap->first + tap->num; i++)
+	    revert_antenna_position(tappos[3 * i], tappos[3 * i + 1],
+			tappos[3 * i + 2], netnum, node);
+	return;
+    }
+
     for (lay = 0; lay < Num_layers; lay++)
 	for (x = 0; x < NumChannelsX; x++)
 	    for (y = 0; y < NumChannelsY; y++)
-		if ((OBSVAL(x, y, lay) & NETNUM_MASK) == netnum) {
-		    Pr = &OBS2VAL(x, y, lay);
-		    if (Pr->flags & PR_TARGET) {
-			lnode = NODEIPTR(x, y, lay);
-			if ((lnode == NULL) || (lnode->nodesav != node)) {
-			    OBSVAL(x, y, lay) &= ~(NETNUM_MASK | ROUTED_NET);
-			    OBSVAL(x, y, lay) |= ANTENNA_NET;
-			}
-		    }
+		revert_antenna_position(x, y, lay, netnum, node);
+}
+
+/*--------------------------------------------------------------*/
+/* Find the grid positions of the free antenna taps in one	*/
+/* pass over the grid.  The taps are the nodes of antenna	*/
+/* cells that were set to ANTENNA_NET by find_free_antenna_taps	*/
+/* and that still have positions on ANTENNA_NET.  Return the	*/
+/* list of taps, in the order of the gate list, and set		*/
+/* "numtapsptr" to their number.  The positions of all taps	*/
+/* are put in "posptr" as (x, y, layer) triples.		*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+    NODE node;
+    int idx;
+} tapindex;
+
+static int
+tap_index_compare(const void *a, const void *b)
+{
+    const tapindex *ta = (const tapindex *)a;
+    const tapindex *tb = (const tapindex *)b;
+
+    if (ta->node == tb->node) return 0;
+    return ((size_t)ta->node < (size_t)tb->node) ? -1 : 1;
+}
+
+static ANTENNATAP *
+find_antenna_tap_positions(int *numtapsptr, int **posptr)
+{
+    ANTENNATAP *taps;
+    tapindex *index, key, *found;
+    int numtaps, numpos, allocpos, i, n, x, y, lay;
+    int *posidx, *pos, *tappos;
+    NODEINFO lnode;
+    GATE ginst;
+
+    numtaps = 0;
+    for (ginst = Nlgates; ginst; ginst = ginst->next)
+	for (i = 0; i < ginst->nodes; i++)
+	    if ((ginst->netnum[i] == ANTENNA_NET) && (ginst->noderec[i] != NULL))
+		numtaps++;
+
+    taps = (ANTENNATAP *)calloc(numtaps + 1, sizeof(ANTENNATAP));
+    index = (tapindex *)malloc((numtaps + 1) * sizeof(tapindex));
+    n = 0;
+    for (ginst = Nlgates; ginst; ginst = ginst->next)
+	for (i = 0; i < ginst->nodes; i++)
+	    if ((ginst->netnum[i] == ANTENNA_NET) && (ginst->noderec[i] != NULL)) {
+		taps[n].node = ginst->noderec[i];
+		index[n].node = ginst->noderec[i];
+		index[n].idx = n;
+		n++;
+	    }
+    qsort(index, numtaps, sizeof(tapindex), tap_index_compare);
+
+    /* Collect the positions, with the tap of each */
+
+    numpos = allocpos = 0;
+    posidx = NULL;
+    pos = NULL;
+    for (lay = 0; lay < Num_layers; lay++)
+	for (x = 0; x < NumChannelsX; x++)
+	    for (y = 0; y < NumChannelsY; y++) {
+		if ((OBSVAL(x, y, lay) & NETNUM_MASK) != ANTENNA_NET) continue;
+		lnode = NODEIPTR(x, y, lay);
+		if ((lnode == NULL) || (lnode->nodesav == NULL)) continue;
+		key.node = lnode->nodesav;
+		found = (tapindex *)bsearch(&key, index, numtaps, sizeof(tapindex),
+				tap_index_compare);
+		if (found == NULL) continue;
+
+		if (numpos == allocpos) {
+		    allocpos = (allocpos == 0) ? 64 : 2 * allocpos;
+		    posidx = (int *)realloc(posidx, allocpos * sizeof(int));
+		    pos = (int *)realloc(pos, 3 * allocpos * sizeof(int));
 		}
+		posidx[numpos] = found->idx;
+		pos[3 * numpos] = x;
+		pos[3 * numpos + 1] = y;
+		pos[3 * numpos + 2] = lay;
+		numpos++;
+		taps[found->idx].num++;
+	    }
+    free(index);
+
+    /* Group the positions by tap, and drop taps with none */
+
+    n = 0;
+    for (i = 0; i < numtaps; i++) {
+	taps[i].first = n;
+	n += taps[i].num;
+	taps[i].num = 0;
+    }
+    tappos = (int *)malloc((3 * numpos + 1) * sizeof(int));
+    for (i = 0; i < numpos; i++) {
+	n = taps[posidx[i]].first + taps[posidx[i]].num++;
+	tappos[3 * n] = pos[3 * i];
+	tappos[3 * n + 1] = pos[3 * i + 1];
+	tappos[3 * n + 2] = pos[3 * i + 2];
+    }
+    if (posidx != NULL) free(posidx);
+    if (pos != NULL) free(pos);
+
+    n = 0;
+    for (i = 0; i < numtaps; i++) {
+	if (taps[i].num == 0) continue;
+	taps[n] = taps[i];
+	taps[n].x = tappos[3 * taps[n].first];
+	taps[n].y = tappos[3 * taps[n].first + 1];
+	n++;
+    }
+
+    *numtapsptr = n;
+    *posptr = tappos;
+    return taps;
+}
+
+/*--------------------------------------------------------------*/
+/* Assign free antenna taps to the violations in "violations",	*/
+/* so that each tap is used at most once and the taps are as	*/
+/* close as possible.  The nearest few taps of each violation	*/
+/* are candidates, and the candidate pairs are assigned in	*/
+/* order of distance.  Violations that lose all of their	*/
+/* candidates to closer violations then get the nearest tap	*/
+/* left.  "assign" is set to the tap index for each violation,	*/
+/* or -1 if there are no taps left.				*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+    int dist;
+    int v, t;
+} tapchoice;
+
+static int
+tap_choice_compare(const void *a, const void *b)
+{
+    const tapchoice *ca = (const tapchoice *)a;
+    const tapchoice *cb = (const tapchoice *)b;
+
+    if (ca->dist != cb->dist) return (ca->dist < cb->dist) ? -1 : 1;
+    if (ca->v != cb->v) return (ca->v < cb->v) ? -1 : 1;
+    return (ca->t < cb->t) ? -1 : (ca->t > cb->t) ? 1 : 0;
+}
+
+static void
+assign_antenna_taps(ANTENNAINFO *violations, int numviolations,
+		ANTENNATAP *taps, int numtaps, int *assign)
+{
+    tapchoice *choices, *vchoice;
+    int v, t, k, n, numchoices, dist, best, bestdist, x, y;
+    int *vx, *vy;
+    ANTENNAINFO violation;
+    ROUTE rt;
+    SEG seg;
+
+    choices = (tapchoice *)malloc((numviolations * ANTENNA_TAP_CHOICES + 1)
+		* sizeof(tapchoice));
+    vx = (int *)malloc((numviolations + 1) * sizeof(int));
+    vy = (int *)malloc((numviolations + 1) * sizeof(int));
+    numchoices = 0;
+
+    for (v = 0; v < numviolations; v++) {
+	assign[v] = -1;
+
+	/* The violation is where its route meets the node */
+
+	violation = violations[v];
+	rt = violation->route;
+	x = y = 0;
+	if ((rt != NULL) && (rt->segments != NULL)) {
+	    if ((rt->flags & RT_START_NODE) && (rt->start.node == violation->node)) {
+		x = rt->segments->x1;
+		y = rt->segments->y1;
+	    }
+	    else {
+		for (seg = rt->segments; seg->next; seg = seg->next);
+		x = seg->x2;
+		y = seg->y2;
+	    }
+	}
+	else if (violation->node->taps != NULL) {
+	    x = violation->node->taps->gridx;
+	    y = violation->node->taps->gridy;
+	}
+	vx[v] = x;
+	vy[v] = y;
+
+	/* Keep the nearest taps, in order of distance */
+
+	vchoice = choices + numchoices;
+	n = 0;
+	for (t = 0; t < numtaps; t++) {
+	    dist = ABSDIFF(taps[t].x, x) + ABSDIFF(taps[t].y, y);
+	    if ((n == ANTENNA_TAP_CHOICES) && (dist >= vchoice[n - 1].dist))
+		continue;
+	    if (n < ANTENNA_TAP_CHOICES) n++;
+	    for (k = n - 1; (k > 0) && (vchoice[k - 1].dist > dist); k--)
+		vchoice[k] = vchoice[k - 1];
+	    vchoice[k].dist = dist;
+	    vchoice[k].v = v;
+	    vchoice[k].t = t;
+	}
+	numchoices += n;
+    }
+
+    qsort(choices, numchoices, sizeof(tapchoice), tap_choice_compare);
+    for (k = 0; k < numchoices; k++) {
+	if ((assign[choices[k].v] < 0) && !taps[choices[k].t].used) {
+	    assign[choices[k].v] = choices[k].t;
+	    taps[choices[k].t].used = TRUE;
+	}
+    }
+
+    /* Violations whose nearest taps all went elsewhere */
+
+    for (v = 0; v < numviolations; v++) {
+	if (assign[v] >= 0) continue;
+	best = -1;
+	bestdist = 0;
+	for (t = 0; t < numtaps; t++) {
+	    if (taps[t].used) continue;
+	    dist = ABSDIFF(taps[t].x, vx[v]) + ABSDIFF(taps[t].y, vy[v]);
+	    if ((best < 0) || (dist < bestdist)) {
+		best = t;
+		bestdist = dist;
+	    }
+	}
+	if (best >= 0) {
+	    assign[v] = best;
+	    taps[best].used = TRUE;
+	}
+    }
+    free(choices);
+    free(vx);
+    free(vy);
 }
 
 /*--------------------------------------------------------------*/
@@ -253,11 +522,11 @@ enum visit_states {NOT_VISITED = 0, VISITED, PROCESSED, ANCHOR};
 
 /* Forward declarations */
 float get_route_area_reverse(NET, ROUTE, int, u_char *, u_char,
-		Tcl_HashTable *, struct routeinfo_ *);
+		ROUTEGRAPH, struct routeinfo_ *);
 float get_route_area_forward(NET, ROUTE, int, u_char *, u_char,
-		Tcl_HashTable *, struct routeinfo_ *);
+		ROUTEGRAPH, struct routeinfo_ *);
 float get_route_area_reverse_fromseg(NET, ROUTE, SEG, int, u_char *, u_char,
-		Tcl_HashTable *, struct routeinfo_ *);
+		ROUTEGRAPH, struct routeinfo_ *);
 
 /*--------------------------------------------------------------*/
 /* Determine the amount of metal in the route, starting at the	*/
@@ -271,11 +540,12 @@ float get_route_area_reverse_fromseg(NET, ROUTE, SEG, int, u_char *, u_char,
 
 float
 get_route_area_forward_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
-		u_char *visited, u_char method, Tcl_HashTable *NodeTable,
+		u_char *visited, u_char method, ROUTEGRAPH rg,
 		struct routeinfo_ *iroute)
 {
     float area, length, width, thick;
     int x, y, l, compat;
+    int k, n, *ends;
     SEG seg, iseg, chkseg;
     ROUTE rt2;
     u_char found;
@@ -302,7 +572,7 @@ get_route_area_forward_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
 		/* then this node may have been visited already.	*/
 
 		if (visited[node->nodenum] == NOT_VISITED) {
-		    g = FindGateNode(NodeTable, node, &i);
+		    g = FindGateNode(node, &i);
 		    if (g->area[i] == 0.0) {
 			/* There's a diffusion diode here! */
 			visited[node->nodenum] = ANCHOR;
@@ -320,19 +590,23 @@ get_route_area_forward_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
 
 	    /* Walk all other routes that start or end on this node */
 
-	    for (rt2 = net->routes; rt2; rt2 = rt2->next) {
+	    n = routegraph_at_node(rg, node, &ends);
+	    for (k = -1; n > 0; ends++, n--) {
+		if (RG_ROUTE(*ends) == k) continue;
+		k = RG_ROUTE(*ends);
+		rt2 = rg->routes[k];
 		if (rt2->flags & RT_VISITED) continue;
 
 		if ((rt2->flags & RT_START_NODE) && (rt2->start.node == node)) {
 		    /* The start point of rt2 connects to the same node */
 		    area += get_route_area_forward(net, rt2, layer, visited,
-				method, NodeTable, NULL);
+				method, rg, NULL);
 		}
 		else if ((rt2->flags & RT_END_NODE) && (rt2->end.node == node)) {
 		    /* The end point of rt2 connects to the same node */
 		    for (iseg = rt2->segments; iseg && iseg->next; iseg = iseg->next);
 		    area += get_route_area_reverse(net, rt2, layer, visited,
-				method, NodeTable, NULL);
+				method, rg, NULL);
 		}
 	    }
 	}
@@ -443,9 +717,12 @@ get_route_area_forward_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
 	}
     }
 
-    /* Check other routes for intersection with this route */
+    /* Check other routes for intersection with this route.  Only	*/
+    /* the routes that start or end on this route can intersect it.	*/
 
-    for (rt2 = net->routes; rt2; rt2 = rt2->next) {
+    n = routegraph_attached(rg, rt, &ends);
+    for (k = 0; k < n; k++) {
+	rt2 = rg->routes[ends[k]];
 	if (rt2->flags & RT_VISITED) continue;
 
 	if (!(rt2->flags & RT_START_NODE) && (rt2->start.route == rt)) {
@@ -532,10 +809,10 @@ get_route_area_forward_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
 	if (found == (u_char)1) {
 	    if (rt2->start.route == rt)
 		area += get_route_area_forward(net, rt2, layer, visited,
-				method, NodeTable, iroute);
+				method, rg, iroute);
 	    else
 		area += get_route_area_reverse(net, rt2, layer, visited,
-				method, NodeTable, iroute);
+				method, rg, iroute);
 	}
     }
 
@@ -552,23 +829,27 @@ get_route_area_forward_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
 
 	    /* Walk all other routes that start or end on this node */
 
-	    for (rt2 = net->routes; rt2; rt2 = rt2->next) {
+	    n = routegraph_at_node(rg, node, &ends);
+	    for (k = -1; n > 0; ends++, n--) {
+		if (RG_ROUTE(*ends) == k) continue;
+		k = RG_ROUTE(*ends);
+		rt2 = rg->routes[k];
 		if (rt2->flags & RT_VISITED) continue;
 
 		if ((rt2->flags & RT_START_NODE) && (rt2->start.node == node)) {
 		    /* The start point of rt2 connects to the same node */
 		    area += get_route_area_forward(net, rt2, layer, visited,
-				method, NodeTable, NULL);
+				method, rg, NULL);
 		}
 		else if ((rt2->flags & RT_END_NODE) && (rt2->end.node == node)) {
 		    /* The end point of rt2 connects to the same node */
 		    for (iseg = rt2->segments; iseg && iseg->next; iseg = iseg->next);
 		    area += get_route_area_reverse(net, rt2, layer, visited,
-				method, NodeTable, NULL);
+				method, rg, NULL);
 		}
 	    }
 
-	    g = FindGateNode(NodeTable, node, &i);
+	    g = FindGateNode(node, &i);
 	    if (g == NULL) {
 		/* This should not happen */
 	 	Fprintf(stderr, "Error: net %s route end marked as node, but"
@@ -656,9 +937,9 @@ get_route_area_forward_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
 
 	    if (rseg->next != NULL)
 	        area += get_route_area_forward_fromseg(net, rt2, rseg->next,
-			layer, visited, method, NodeTable, iroute);
+			layer, visited, method, rg, iroute);
 	    area += get_route_area_reverse_fromseg(net, rt2, rseg, layer,
-			visited, method, NodeTable, iroute);
+			visited, method, rg, iroute);
 	}
     }
     return area;
@@ -670,12 +951,12 @@ get_route_area_forward_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
 
 float
 get_route_area_forward(NET net, ROUTE rt, int layer, u_char *visited,
-	u_char method, Tcl_HashTable *NodeTable, struct routeinfo_ *iroute)
+	u_char method, ROUTEGRAPH rg, struct routeinfo_ *iroute)
 {
     float area;
 
     area = get_route_area_forward_fromseg(net, rt, NULL, layer, visited,
-		method, NodeTable, iroute);
+		method, rg, iroute);
     return area;
 }
 
@@ -687,10 +968,10 @@ get_route_area_forward(NET net, ROUTE rt, int layer, u_char *visited,
 
 float
 get_route_area_reverse_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
-	u_char *visited, u_char method, Tcl_HashTable *NodeTable,
+	u_char *visited, u_char method, ROUTEGRAPH rg,
 	struct routeinfo_ *iroute)
 {
-    SEG seg, dseg, newseg, firstseg, saveseg;
+    SEG seg, newseg, firstseg, saveseg;
     NODE savestartnode, saveendnode;
     float area;
     u_char saveflags;
@@ -699,7 +980,7 @@ get_route_area_reverse_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
 
     /* Reverse the route */
     for (seg = rt->segments; seg; seg = seg->next) {
-	newseg = (SEG)malloc(sizeof(struct seg_));
+	newseg = allocSEG();
 	newseg->layer = seg->layer;
 	newseg->x1 = seg->x2;
 	newseg->x2 = seg->x1;
@@ -728,7 +1009,7 @@ get_route_area_reverse_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
     if (saveflags & RT_END_NODE) rt->flags |= RT_START_NODE;
 
     area = get_route_area_forward_fromseg(net, rt, nseg, layer, visited,
-		method, NodeTable, iroute);
+		method, rg, iroute);
 
     /* Replace the route segment with the original route */
     rt->segments = saveseg;
@@ -742,11 +1023,7 @@ get_route_area_reverse_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
     rt->flags |= saveflags;
 
     /* Free the reversed route */
-    for (seg = firstseg; seg; ) {
-	dseg = seg->next;
-	free(seg);
-	seg = dseg;
-    }
+    freeSEGlist(firstseg);
     return area;
 }
 
@@ -756,186 +1033,715 @@ get_route_area_reverse_fromseg(NET net, ROUTE rt, SEG nseg, int layer,
 
 float
 get_route_area_reverse(NET net, ROUTE rt, int layer, u_char *visited,
-		u_char method, Tcl_HashTable *NodeTable,
+		u_char method, ROUTEGRAPH rg,
 		struct routeinfo_ *iroute)
 {
     float area;
     area = get_route_area_reverse_fromseg(net, rt, NULL, layer, visited,
-		method, NodeTable, iroute);
+		method, rg, iroute);
     return area;
 }
 
 /*--------------------------------------------------------------*/
-/* Find all antenna violations at a specific metal layer	*/
+/* Antenna sub-nets of a net on all metal layers at once.	*/
+/*								*/
+/* The antenna of a gate at "layer" is the part of the net	*/
+/* that connects to the gate without going above "layer".	*/
+/* Instead of walking the routes of each net once per layer,	*/
+/* every segment of the net's routes and every node of the net	*/
+/* is made a set in a union-find forest, and each connection	*/
+/* between two of them is an edge at the higher of their two	*/
+/* layers.  When all edges up to "layer" have been merged, the	*/
+/* sets are the sub-nets at "layer".  Each set keeps the sum	*/
+/* of the metal area and the gate area of its members, so one	*/
+/* pass up through the layers finds the antenna ratios of all	*/
+/* layers.  Nodes with no gate area are source/drain		*/
+/* connections (anchors), and a sub-net with an anchor has no	*/
+/* antenna violation.						*/
 /*--------------------------------------------------------------*/
 
-int find_layer_antenna_violations(int layer, Tcl_HashTable *NodeTable)
-{
-    int numerrors, n, nn, numroutes, i, j, new, neterrors;
-    u_char *visited, method;
-    float antenna_ratio, thick;
-    GATE g;
-    NET net;
-    ROUTE rt, saveroute;
-    NODEINFO nodeptr;
-    NODE node, tnode;
-    SEG seg;
-    ANTENNAINFO newantenna;
-    float gate_area, metal_area, ratio, save_gate, save_metal, max_ratio;
+typedef struct antset_ {
+    int parent;		/* Parent set, or itself for a root	*/
+    int size;		/* Number of members (for roots)	*/
+    int layer;		/* Layer of a segment, -1 for a node	*/
+    int stamp;		/* Last layer + 1 the set was checked	*/
+    int anchors;	/* Number of member anchor nodes	*/
+    double area;	/* Top area of metal on all layers	*/
+    double sidearea;	/* Side area of metal on all layers	*/
+    double larea;	/* Top area of metal on current layer	*/
+    double lsidearea;	/* Side area of metal on current layer	*/
+    double gatearea;	/* Combined gate area of member nodes	*/
+} ANTSET;
+
+typedef struct antedge_ {
+    int level;		/* Layer at which the edge connects	*/
+    int a, b;		/* The two sets connected		*/
+} ANTEDGE;
 
-    numerrors = 0;
+/*--------------------------------------------------------------*/
+/* Find the root of the set containing "e"			*/
+/*--------------------------------------------------------------*/
 
-    /* Get the metal layer record for this layer and find the metal	*/
-    /* area ratio limit and the method to be used for calculating	*/
-    /* metal area.							*/
+static int
+antset_find(ANTSET *sets, int e)
+{
+    while (sets[e].parent != e) {
+	sets[e].parent = sets[sets[e].parent].parent;
+	e = sets[e].parent;
+    }
+    return e;
+}
 
-    method = LefGetRouteAntennaMethod(layer);
-    if (method == CALC_NONE) return 0;	/* No antenna information in tech */
-    antenna_ratio = (float)LefGetRouteAreaRatio(layer);
-    thick = (float)LefGetRouteThickness(layer);
-    if (((method == CALC_SIDEAREA) || (method == CALC_AGG_SIDEAREA)) && (thick == 0.0))
-	return 0;	/* Insufficient antenna information in tech */
+/*--------------------------------------------------------------*/
+/* Merge the sets containing "a" and "b"			*/
+/*--------------------------------------------------------------*/
 
-    /* Make a pass through all nets to find antenna violations */
+static void
+antset_union(ANTSET *sets, int a, int b)
+{
+    int t;
+
+    a = antset_find(sets, a);
+    b = antset_find(sets, b);
+    if (a == b) return;
+    if (sets[a].size < sets[b].size) {
+	t = a;
+	a = b;
+	b = t;
+    }
+    sets[b].parent = a;
+    sets[a].size += sets[b].size;
+    sets[a].area += sets[b].area;
+    sets[a].sidearea += sets[b].sidearea;
+    sets[a].larea += sets[b].larea;
+    sets[a].lsidearea += sets[b].lsidearea;
+    sets[a].gatearea += sets[b].gatearea;
+    sets[a].anchors += sets[b].anchors;
+}
 
-    for (n = 0; n < Numnets; n++) {
-	net = Nlnets[n];
+/* Initialize set "e" as a set of its own.  A node set with no	*/
+/* gate area is an anchor.					*/
 
-	if ((net->netnum == VDD_NET) || (net->netnum == GND_NET) ||
-		(net->netnum == ANTENNA_NET)) continue;
+static void
+antset_init(ANTSET *sets, int e, int layer, double area, double sidearea,
+		double gatearea)
+{
+    sets[e].parent = e;
+    sets[e].size = 1;
+    sets[e].layer = layer;
+    sets[e].stamp = 0;
+    sets[e].area = area;
+    sets[e].sidearea = sidearea;
+    sets[e].larea = sets[e].lsidearea = 0.0;
+    sets[e].gatearea = gatearea;
+    sets[e].anchors = ((layer < 0) && (gatearea == 0.0)) ? 1 : 0;
+}
 
-	/* Ignore nets with no routes */
-	numroutes = 0;
-	for (rt = net->routes; rt; rt = rt->next) numroutes++;
-	if (numroutes == 0) continue;
+/*--------------------------------------------------------------*/
+/* Find the segment of route "rt" on which the point (x, y) on	*/
+/* layer "l" at the end of segment "iseg" of another route	*/
+/* lands.  Return the index of the segment in the route, or -1	*/
+/* if there is none.						*/
+/*--------------------------------------------------------------*/
 
-	/* Consider each terminal as a separate sub-net calculation.	*/
-	/* But if multiple terminals belong to the same sub-net, they	*/
-	/* are marked visited and ignored on subsequent calculations.	*/
+static int
+antenna_landing_seg(ROUTE rt, SEG iseg, int x, int y, int l)
+{
+    SEG chkseg;
+    int idx, compat;
 
-	visited = (u_char *)malloc(net->numnodes * sizeof(u_char));
-	for (node = net->netnodes; node != NULL; node = node->next) {
-	    nn = node->nodenum;
-	    visited[nn] = NOT_VISITED;
+    for (chkseg = rt->segments, idx = 0; chkseg; chkseg = chkseg->next, idx++) {
+	if (chkseg->segtype & ST_WIRE) {
+	    if (iseg->segtype & ST_WIRE)
+		compat = (l == chkseg->layer);
+	    else
+		compat = (l == chkseg->layer) || (l + 1 == chkseg->layer);
 	}
+	else {
+	    if (iseg->segtype & ST_WIRE)
+		compat = (l == chkseg->layer) || (l == chkseg->layer + 1);
+	    else
+		compat = (l == chkseg->layer) || (l == chkseg->layer + 1) ||
+				(l + 1 == chkseg->layer);
+	}
+	if (!compat) continue;
 
-	/* Make a pass through all nodes of the net.  Where they are	*/
-	/* not connected together at "layer", these are individual	*/
-	/* sub-nets.							*/
+	if (chkseg->segtype & ST_VIA) {
+	    if ((chkseg->x1 == x) && (chkseg->y1 == y))
+		return idx;
+	}
+	else if (chkseg->x1 != chkseg->x2) {
+	    if ((chkseg->y1 == y) && (x >= MIN(chkseg->x1, chkseg->x2)) &&
+			(x <= MAX(chkseg->x1, chkseg->x2)))
+		return idx;
+	}
+	else if ((chkseg->x1 == x) && (y >= MIN(chkseg->y1, chkseg->y2)) &&
+			(y <= MAX(chkseg->y1, chkseg->y2)))
+	    return idx;
+    }
+    return -1;
+}
 
-	neterrors = 0;
-	max_ratio = 0.0;	/* For diagnostics only */
-	for (node = net->netnodes; node != NULL; node = node->next) {
-	    nn = node->nodenum;
-	    if (visited[nn] >= PROCESSED) continue; 	/* Already seen */
+/* Antenna rule and route geometry of a metal layer */
 
-	    /* Find the gate area of this node */
-	    g = FindGateNode(NodeTable, node, &i);
-	    metal_area = 0.0;
+typedef struct antlayer_ {
+    u_char method;	/* Area calculation method		*/
+    float ratio;	/* Area ratio limit			*/
+    double width;	/* Route width				*/
+    double thick;	/* Route thickness			*/
+} ANTLAYER;
 
-	    if (g->area[i] == 0.0) {
-		visited[nn] = ANCHOR;	/* Mark as S/D connection */
-		continue;		/* No gate, so no violation */
-	    }
-	    else
-		visited[nn] = VISITED;
+/*--------------------------------------------------------------*/
+/* Look up the antenna rules and the route width and thickness	*/
+/* of each layer, so that the nets can be checked without	*/
+/* going back to the LEF records.  The method is CALC_NONE for	*/
+/* layers where the technology does not have enough		*/
+/* information to check antennas.				*/
+/*--------------------------------------------------------------*/
 
-	    /* Clear visited flags for routes */
+static void
+antenna_layer_info(ANTLAYER *layers)
+{
+    int layer;
+    u_char method;
 
-	    for (rt = net->routes; rt; rt = rt->next)
-		rt->flags &= ~RT_VISITED;
+    for (layer = 0; layer < Num_layers; layer++) {
+	method = LefGetRouteAntennaMethod(layer);
+	layers[layer].ratio = (float)LefGetRouteAreaRatio(layer);
+	layers[layer].width = LefGetRouteWidth(layer);
+	layers[layer].thick = LefGetRouteThickness(layer);
+	if (((method == CALC_SIDEAREA) || (method == CALC_AGG_SIDEAREA)) &&
+		(layers[layer].thick == 0.0))
+	    method = CALC_NONE;
+	layers[layer].method = method;
+    }
+}
 
-	    /* Find the route or routes that connect to this node */
+/*--------------------------------------------------------------*/
+/* Find the antenna violations of "net" on the layers from	*/
+/* "minlayer" to "maxlayer", using the layer information in	*/
+/* "layers".  Each violation is added to the front of the list	*/
+/* for its layer in "lists", and counted in "counts".  Return	*/
+/* the number of violations found.				*/
+/*								*/
+/* Nets are checked in parallel, so this routine must not	*/
+/* change anything but the lists and counts.  The violations	*/
+/* are reported by report_antenna_violations().		*/
+/*--------------------------------------------------------------*/
 
-	    for (rt = net->routes; rt; rt = rt->next) {
-		if ((rt->flags & RT_START_NODE) && (rt->start.node == node)) {
-		    saveroute = rt;
-		    metal_area += get_route_area_forward(net, rt, layer, visited,
-				method, NodeTable, NULL);
-		}
-		else if ((rt->flags & RT_END_NODE) && (rt->end.node == node)) {
-		    saveroute = rt;
-		    metal_area += get_route_area_reverse(net, rt, layer, visited,
-				method, NodeTable, NULL);
-		} 
-		else continue;
+static int
+net_antenna_violations(NET net, int minlayer, int maxlayer, ANTLAYER *layers,
+		ANTENNAINFO *lists, int *counts)
+{
+    int numroutes, numsegs, numslots, numsets, numedges, neterrors;
+    int layer, i, j, k, n, e, last, *ids, *rtbase;
+    int levelstart[MAX_LAYERS + 1];
+    int x, y, l;
+    double length, width, metal_area, gate_area, ratio;
+    double max_ratio, save_gate, save_metal;
+    ANTSET *sets;
+    ANTEDGE *edges, *sorted;
+    ANTENNAINFO newantenna;
+    ROUTEGRAPH rg;
+    ROUTE rt, rt2, *noderoute;
+    SEG seg, iseg;
+    NODE node, *nodes;
+    GATE g;
+
+    numroutes = numsegs = 0;
+    for (rt = net->routes; rt; rt = rt->next) {
+	numroutes++;
+	for (seg = rt->segments; seg; seg = seg->next) numsegs++;
+    }
+    if (numsegs == 0) return 0;
+
+    /* Index the nodes of the net by node number */
+
+    numslots = 0;
+    for (node = net->netnodes; node; node = node->next)
+	if (node->nodenum >= numslots) numslots = node->nodenum + 1;
+    nodes = (NODE *)calloc(numslots + 1, sizeof(NODE));
+    noderoute = (ROUTE *)calloc(numslots + 1, sizeof(ROUTE));
+    for (node = net->netnodes; node; node = node->next)
+	nodes[node->nodenum] = node;
+
+    /* The sets are the route segments in order, then the nodes	*/
+    /* by node number, then any nodes at route ends that are	*/
+    /* not in the net's node list (such as antenna taps).	*/
+
+    sets = (ANTSET *)malloc((numsegs + numslots + 2 * numroutes) *
+		sizeof(ANTSET));
+    rtbase = (int *)malloc(numroutes * sizeof(int));
+    numsets = 0;
+    k = 0;
+    for (rt = net->routes; rt; rt = rt->next, k++) {
+	rtbase[k] = numsets;
+	for (seg = rt->segments; seg; seg = seg->next, numsets++) {
+
+	    /* Vias don't contribute to area, at least for now. */
+	    if (seg->segtype & ST_VIA) {
+		antset_init(sets, numsets, seg->layer, 0.0, 0.0, 0.0);
+		continue;
 	    }
 
-	    /* Gate area is combined area of gates visited */
+	    /* Note that one of x or y is zero, depending on segment orientation */
+	    x = ABSDIFF(seg->x2, seg->x1);
+	    y = ABSDIFF(seg->y2, seg->y1);
+	    length = (x == 0) ? (double)y * PitchY : (double)x * PitchX;
+	    width = layers[seg->layer].width;
+	    antset_init(sets, numsets, seg->layer, length * width,
+			layers[seg->layer].thick * 2.0 * (length + width), 0.0);
+	}
+    }
+    for (i = 0; i < numslots; i++, numsets++) {
+	gate_area = 0.0;
+	if ((node = nodes[i]) != NULL) {
+	    g = FindGateNode(node, &j);
+	    if (g != NULL) gate_area = g->area[j];
+	}
+	antset_init(sets, numsets, -1, 0.0, 0.0, gate_area);
+    }
 
-	    gate_area = 0.0;
-	    for (tnode = net->netnodes; tnode != NULL; tnode = tnode->next) {
-		j = tnode->nodenum;
-		if (visited[j] == VISITED) {
-		    g = FindGateNode(NodeTable, tnode, &i);
-		    if (g->area[i] == 0.0) {
-			visited[j] = ANCHOR;
-			gate_area = 0.0;
-			break;
-		    }
-		    else
-			gate_area += g->area[i];
-		}
+    /* Find the connections between sets */
 
+    edges = (ANTEDGE *)malloc((numsegs + 3 * numroutes) * sizeof(ANTEDGE));
+    numedges = 0;
+    rg = routegraph_build(net);
+
+    for (k = 0; k < numroutes; k++) {
+	rt = rg->routes[k];
+	if (rt->segments == NULL) continue;
+
+	/* Consecutive segments of the route */
+
+	for (seg = rt->segments, i = rtbase[k]; seg->next; seg = seg->next, i++) {
+	    edges[numedges].level = MAX(seg->layer, seg->next->layer);
+	    edges[numedges].a = i;
+	    edges[numedges].b = i + 1;
+	    numedges++;
+	}
+	last = i;
+
+	/* Nodes at the route start and end */
+
+	for (j = 0; j < 2; j++) {
+	    if (!(rt->flags & ((j == 0) ? RT_START_NODE : RT_END_NODE))) continue;
+	    node = (j == 0) ? rt->start.node : rt->end.node;
+	    if (node == NULL) continue;
+	    if ((node->nodenum >= 0) && (node->nodenum < numslots) &&
+			(nodes[node->nodenum] == node)) {
+		e = numsegs + node->nodenum;
+		noderoute[node->nodenum] = rt;
 	    }
+	    else {
+		e = numsets++;
+		g = FindGateNode(node, &i);
+		antset_init(sets, e, -1, 0.0, 0.0, (g) ? g->area[i] : 0.0);
+	    }
+	    edges[numedges].level = sets[(j == 0) ? rtbase[k] : last].layer;
+	    edges[numedges].a = e;
+	    edges[numedges].b = (j == 0) ? rtbase[k] : last;
+	    numedges++;
+	}
 
-	    if (gate_area > 0.0) {
-		ratio = metal_area / gate_area;
-		if (ratio > max_ratio) {
-		    max_ratio = ratio;
-		    save_gate = gate_area;
-		    save_metal = metal_area;
+	/* Routes that start or end somewhere on this route */
+
+	n = routegraph_attached(rg, rt, &ids);
+	for (; n > 0; ids++, n--) {
+	    rt2 = rg->routes[*ids];
+	    if (rt2->segments == NULL) continue;
+	    for (j = 0; j < 2; j++) {
+		if (j == 0) {
+		    if ((rt2->flags & RT_START_NODE) || (rt2->start.route != rt))
+			continue;
+		    iseg = rt2->segments;
+		    x = iseg->x1;
+		    y = iseg->y1;
+		    e = rtbase[*ids];
 		}
+		else {
+		    if ((rt2->flags & RT_END_NODE) || (rt2->end.route != rt))
+			continue;
+		    for (iseg = rt2->segments, e = rtbase[*ids]; iseg->next;
+				iseg = iseg->next, e++);
+		    x = iseg->x2;
+		    y = iseg->y2;
+		}
+		l = antenna_landing_seg(rt, iseg, x, y, iseg->layer);
+		if (l < 0) continue;
+		edges[numedges].level = MAX(iseg->layer, sets[rtbase[k] + l].layer);
+		edges[numedges].a = e;
+		edges[numedges].b = rtbase[k] + l;
+		numedges++;
+	    }
+	}
+    }
+    routegraph_free(rg);
 
-		if (ratio > antenna_ratio) {
+    /* Sort the connections by layer */
 
-		    /* Record and report the violation */
+    for (layer = 0; layer <= Num_layers; layer++) levelstart[layer] = 0;
+    for (i = 0; i < numedges; i++) levelstart[edges[i].level + 1]++;
+    for (layer = 0; layer < Num_layers; layer++)
+	levelstart[layer + 1] += levelstart[layer];
+    sorted = (ANTEDGE *)malloc((numedges + 1) * sizeof(ANTEDGE));
+    for (i = 0; i < numedges; i++)
+	sorted[levelstart[edges[i].level]++] = edges[i];
+    free(edges);
 
-		    numerrors++;
-		    neterrors++;
-		    if (Verbose > 1) {
-			Fprintf(stderr,
-				"Antenna violation on node %d of net %s at metal%d\n",
-				nn, net->netname, layer + 1);
-		    }
-		    if (Verbose > 2) {
-			Fprintf(stderr, "Metal area = %f, Gate area = %f, Ratio = %f\n",
-				metal_area, gate_area, ratio);
-		    }
-		    newantenna = (ANTENNAINFO)malloc(sizeof(struct antennainfo_));
-		    newantenna->net = net;
-		    newantenna->node = node;
-		    newantenna->layer = layer;
-		    newantenna->route = saveroute;
-		    newantenna->next = AntennaList;
-		    AntennaList = newantenna;
-		}
+    /* Working up from the lowest layer, merge the sets connected	*/
+    /* at each layer, then check the sub-net of each gate.	*/
+
+    neterrors = 0;
+    i = 0;
+    for (layer = 0; layer <= maxlayer; layer++) {
+
+	/* Sets with segments on this layer have not been merged	*/
+	/* with anything yet, so their area is all on this layer.	*/
+
+	for (e = 0; e < numsets; e++) {
+	    if (sets[e].layer == layer) {
+		sets[e].larea = sets[e].area;
+		sets[e].lsidearea = sets[e].sidearea;
 	    }
+	    else
+		sets[e].larea = sets[e].lsidearea = 0.0;
+	}
+	for (; (i < numedges) && (sorted[i].level == layer); i++)
+	    antset_union(sets, sorted[i].a, sorted[i].b);
 
-	    /* Mark gates as visited on previous pass */
-	    for (tnode = net->netnodes; tnode != NULL; tnode = tnode->next) {
-		j = tnode->nodenum;
-		if (visited[j] == VISITED) visited[j] = PROCESSED;
+	if ((layer < minlayer) || (layers[layer].method == CALC_NONE)) continue;
+
+	max_ratio = 0.0;	/* For diagnostics only */
+	for (node = net->netnodes; node; node = node->next) {
+	    e = numsegs + node->nodenum;
+	    if (sets[e].gatearea == 0.0) continue;	/* S/D connection */
+	    e = antset_find(sets, e);
+	    if (sets[e].stamp == layer + 1) continue;	/* Already seen */
+	    sets[e].stamp = layer + 1;
+	    if (sets[e].anchors > 0) continue;	/* No gate, so no violation */
+
+	    switch (layers[layer].method) {
+		case CALC_AREA:
+		    metal_area = sets[e].larea;
+		    break;
+		case CALC_SIDEAREA:
+		    metal_area = sets[e].lsidearea;
+		    break;
+		case CALC_AGG_AREA:
+		    metal_area = sets[e].area;
+		    break;
+		default:
+		    metal_area = sets[e].sidearea;
+		    break;
+	    }
+	    gate_area = sets[e].gatearea;
+	    ratio = metal_area / gate_area;
+	    if (ratio > max_ratio) {
+		max_ratio = ratio;
+		save_gate = gate_area;
+		save_metal = metal_area;
 	    }
+	    if (ratio <= layers[layer].ratio) continue;
+
+	    /* Record the violation */
+
+	    neterrors++;
+	    counts[layer]++;
+	    newantenna = (ANTENNAINFO)malloc(sizeof(struct antennainfo_));
+	    newantenna->net = net;
+	    newantenna->node = node;
+	    newantenna->layer = layer;
+	    newantenna->route = noderoute[node->nodenum];
+	    newantenna->metal_area = (float)metal_area;
+	    newantenna->gate_area = (float)gate_area;
+	    newantenna->next = lists[layer];
+	    lists[layer] = newantenna;
 	}
-	free(visited);
 
 	if (Verbose > 3) {
-	    /* Diagnostic */
-	    if (neterrors == 0) {
-		if (max_ratio > 0.0)
-		    Fprintf(stderr, "Worst case:  Metal area = %f, Gate area = %f, "
+	    /* Diagnostic (nets are checked in one thread at this level) */
+	    if ((neterrors == 0) && (max_ratio > 0.0))
+		Fprintf(stderr, "Worst case:  Metal area = %f, Gate area = %f, "
 			"Ratio = %f\n", save_metal, save_gate, max_ratio);
-	    }
 	}
+    }
+
+    free(sorted);
+    free(sets);
+    free(rtbase);
+    free(nodes);
+    free(noderoute);
+    return neterrors;
+}
+
+/*--------------------------------------------------------------*/
+/* Reverse the part of a violation list from "list" up to	*/
+/* "stop", and return its new head.				*/
+/*--------------------------------------------------------------*/
+
+static ANTENNAINFO
+reverse_antenna_violations(ANTENNAINFO list, ANTENNAINFO stop)
+{
+    ANTENNAINFO prev, next;
+
+    prev = stop;
+    while (list != stop) {
+	next = list->next;
+	list->next = prev;
+	prev = list;
+	list = next;
+    }
+    return prev;
+}
+
+/*--------------------------------------------------------------*/
+/* Report the violations in a list from "list" up to "stop".	*/
+/* The lists are in reverse net order, so turn the list around	*/
+/* to report them in net order, and then put it back.		*/
+/*--------------------------------------------------------------*/
+
+static void
+report_antenna_violations(ANTENNAINFO list, ANTENNAINFO stop)
+{
+    ANTENNAINFO violation;
+
+    if ((Verbose <= 1) || (list == stop)) return;
+
+    list = reverse_antenna_violations(list, stop);
+    for (violation = list; violation != stop; violation = violation->next) {
+	Fprintf(stderr, "Antenna violation on node %d of net %s at metal%d\n",
+		violation->node->nodenum, violation->net->netname,
+		violation->layer + 1);
+	if (Verbose > 2) {
+	    Fprintf(stderr, "Metal area = %f, Gate area = %f, Ratio = %f\n",
+		violation->metal_area, violation->gate_area,
+		violation->metal_area / violation->gate_area);
+	}
+    }
+    reverse_antenna_violations(list, stop);
+}
+
+/*--------------------------------------------------------------*/
+/* Parallel antenna checks.  The nets are divided among the	*/
+/* worker threads, each of which keeps its own violation lists.	*/
+/* The lists are then joined in net order.			*/
+/*--------------------------------------------------------------*/
+
+#define ANTENNA_THREAD_MIN	64	/* Minimum nets per thread	*/
+
+typedef struct {
+    int first;			/* First net for this thread	*/
+    int last;			/* One past the last net	*/
+    int minlayer, maxlayer;	/* Layers to check		*/
+    ANTLAYER *layers;		/* Antenna rules of each layer	*/
+    ANTENNAINFO lists[MAX_LAYERS];	/* Violations by layer	*/
+    int counts[MAX_LAYERS];	/* Number of violations by layer */
+} AntennaSlice;
+
+static void *
+antenna_net_worker(void *arg)
+{
+    AntennaSlice *slice = (AntennaSlice *)arg;
+    NET net;
+    int n;
+
+    for (n = slice->first; n < slice->last; n++) {
+	net = Nlnets[n];
+	if ((net->netnum == VDD_NET) || (net->netnum == GND_NET) ||
+		(net->netnum == ANTENNA_NET)) continue;
+	net_antenna_violations(net, slice->minlayer, slice->maxlayer,
+		slice->layers, slice->lists, slice->counts);
+    }
+    return NULL;
+}
+
+/*--------------------------------------------------------------*/
+/* Find the antenna violations of all nets on the layers from	*/
+/* "minlayer" to "maxlayer", dividing the nets among up to	*/
+/* thread_count() threads.  The violations found are added to	*/
+/* the front of "lists" in reverse net order, as if the nets	*/
+/* were checked one at a time, and counted in "counts".  Return	*/
+/* the total number of violations found.			*/
+/*--------------------------------------------------------------*/
+
+static int
+find_antenna_violations(int minlayer, int maxlayer, ANTENNAINFO *lists,
+		int *counts)
+{
+    ANTLAYER layers[MAX_LAYERS];
+    ANTENNAINFO stop[MAX_LAYERS], lastviolation;
+    AntennaSlice *slice;
+    int t, nthreads, layer, numerrors;
+#ifdef HAVE_PTHREAD_H
+    pthread_t *thread;
+    u_char *started;
+#endif
+
+    antenna_layer_info(layers);
+
+    nthreads = 1;
+#ifdef HAVE_PTHREAD_H
+    /* The worst case diagnostics are printed as the nets are	*/
+    /* checked, so keep them in one thread.			*/
+    if (Verbose <= 3) {
+	nthreads = thread_count();
+	if (nthreads > Numnets / ANTENNA_THREAD_MIN)
+	    nthreads = Numnets / ANTENNA_THREAD_MIN;
+	if (nthreads < 1) nthreads = 1;
+    }
+#endif
+
+    slice = (AntennaSlice *)malloc(nthreads * sizeof(AntennaSlice));
+    for (t = 0; t < nthreads; t++) {
+	slice[t].first = (int)(((long)Numnets * t) / nthreads);
+	slice[t].last = (int)(((long)Numnets * (t + 1)) / nthreads);
+	slice[t].minlayer = minlayer;
+	slice[t].maxlayer = maxlayer;
+	slice[t].layers = layers;
+	for (layer = minlayer; layer <= maxlayer; layer++) {
+	    slice[t].lists[layer] = NULL;
+	    slice[t].counts[layer] = 0;
+	}
+    }
 
-	/* Clear route visited flags */
-	for (rt = net->routes; rt; rt = rt->next)
-	    rt->flags &= ~RT_VISITED;
+#ifdef HAVE_PTHREAD_H
+    if (nthreads > 1) {
+	thread = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+	started = (u_char *)malloc(nthreads * sizeof(u_char));
+
+	for (t = 0; t < nthreads; t++)
+	    started[t] = (pthread_create(&thread[t], NULL, antenna_net_worker,
+			(void *)&slice[t]) == 0);
+	for (t = 0; t < nthreads; t++)
+	    if (!started[t]) antenna_net_worker((void *)&slice[t]);
+	for (t = 0; t < nthreads; t++)
+	    if (started[t]) pthread_join(thread[t], NULL);
+
+	free(started);
+	free(thread);
+    }
+    else
+#endif
+    antenna_net_worker((void *)&slice[0]);
+
+    /* Join the lists.  Each slice's list is in reverse net	*/
+    /* order, so each goes in front of the previous slices.	*/
+
+    numerrors = 0;
+    for (layer = minlayer; layer <= maxlayer; layer++) {
+	stop[layer] = lists[layer];
+	for (t = 0; t < nthreads; t++) {
+	    if (slice[t].lists[layer] != NULL) {
+		for (lastviolation = slice[t].lists[layer]; lastviolation->next;
+			lastviolation = lastviolation->next);
+		lastviolation->next = lists[layer];
+		lists[layer] = slice[t].lists[layer];
+	    }
+	    counts[layer] += slice[t].counts[layer];
+	    numerrors += slice[t].counts[layer];
+	}
+	report_antenna_violations(lists[layer], stop[layer]);
     }
+    free(slice);
     return numerrors;
 }
 
+/*--------------------------------------------------------------*/
+/* Antenna-aware routing.  When "AntennaCost" is nonzero, the	*/
+/* route search of a net that connects to gates keeps, at each	*/
+/* grid position, the length of the route on its layer since it	*/
+/* last came down from a higher layer.  That is the metal that	*/
+/* a gate at the end of the route would see when the layer is	*/
+/* checked for antennas.  Each step costs extra in proportion	*/
+/* to how much of the antenna limit of the layer the run has	*/
+/* used (see eval_pt()), so that a long route hops up to a	*/
+/* higher layer early instead of leaving a violation for	*/
+/* resolve_antenna() to fix.  The top layer is not costed,	*/
+/* since there is no higher layer to go to.			*/
+/*--------------------------------------------------------------*/
+
+u_short **AntennaRun = NULL;		/* Run length by position, or	*/
+					/* NULL if not costing antennas	*/
+int AntennaRunLimit[MAX_LAYERS];	/* Run length allowed by the	*/
+					/* antenna rule (0 = no limit)	*/
+
+static u_short *AntRunStore[MAX_LAYERS];
+static int AntRunLayers = 0;
+static long AntRunSize = 0;
+
+/*--------------------------------------------------------------*/
+/* antenna_cost_net() ---					*/
+/*								*/
+/* Set up antenna costing for routing "net".  The limit on each	*/
+/* layer is for the smallest gate on the net, since any gate	*/
+/* may end up at the end of a route.  Nets that do not connect	*/
+/* to a gate, and power and antenna nets, are not costed.  If	*/
+/* "net" is NULL, or antenna costing is off, turn it off.	*/
+/*--------------------------------------------------------------*/
+
+void
+antenna_cost_net(NET net)
+{
+    ANTLAYER layers[MAX_LAYERS];
+    NODE node;
+    GATE g;
+    int layer, i;
+    double gate_area, pitch, step, limit;
+
+    AntennaRun = NULL;
+    for (layer = 0; layer < MAX_LAYERS; layer++) AntennaRunLimit[layer] = 0;
+
+    if ((net == NULL) || (AntennaCost == 0)) return;
+    if ((net->netnum == VDD_NET) || (net->netnum == GND_NET) ||
+		(net->netnum == ANTENNA_NET))
+	return;
+
+    gate_area = 0.0;
+    for (node = net->netnodes; node; node = node->next) {
+	g = FindGateNode(node, &i);
+	if ((g == NULL) || (g->area[i] == 0.0)) continue;
+	if ((gate_area == 0.0) || (g->area[i] < gate_area))
+	    gate_area = g->area[i];
+    }
+    if (gate_area == 0.0) return;
+
+    antenna_layer_info(layers);
+    for (layer = 0; layer < Num_layers - 1; layer++) {
+	pitch = (Vert[layer]) ? PitchY : PitchX;
+	switch (layers[layer].method) {
+	    case CALC_AREA:
+	    case CALC_AGG_AREA:
+		step = pitch * layers[layer].width;
+		break;
+	    case CALC_SIDEAREA:
+	    case CALC_AGG_SIDEAREA:
+		step = layers[layer].thick * 2.0 * pitch;
+		break;
+	    default:
+		step = 0.0;
+		break;
+	}
+	if ((step <= 0.0) || (layers[layer].ratio <= 0.0)) continue;
+	limit = layers[layer].ratio * gate_area / step;
+	AntennaRunLimit[layer] = (limit < 1.0) ? 1 :
+		(limit > 65535.0) ? 65535 : (int)limit;
+    }
+
+    /* (Re)allocate the run lengths to the size of the grid */
+
+    if ((AntRunSize != (long)NUMCHANNELS) || (AntRunLayers != Num_layers)) {
+	for (layer = 0; layer < AntRunLayers; layer++)
+	    free(AntRunStore[layer]);
+	AntRunLayers = Num_layers;
+	AntRunSize = (long)NUMCHANNELS;
+	for (layer = 0; layer < AntRunLayers; layer++)
+	    AntRunStore[layer] = (u_short *)calloc(AntRunSize,
+			sizeof(u_short));
+    }
+    AntennaRun = AntRunStore;
+}
+
 /*--------------------------------------------------------------*/
 /* This routine is a combination of set_node_to_net(),		*/
 /* set_routes_to_net(), and disable_node_nets() (see qrouter.c	*/
@@ -947,11 +1753,13 @@ int find_layer_antenna_violations(int layer, Tcl_HashTable *NodeTable)
 /*--------------------------------------------------------------*/
 
 int set_antenna_to_net(int newflags, struct routeinfo_ *iroute,
-		u_char stage, ANTENNAINFO violation, Tcl_HashTable *NodeTable)
+		u_char stage, ANTENNAINFO violation, ANTENNATAP *tap,
+		int *tappos)
 {
-    int x, y, lay, rval, layer;
+    int x, y, lay, rval, layer, i;
     PROUTE *Pr;
     ROUTE rt, clrrt;
+    ROUTEGRAPH rg;
     NODE node;
     NET net;
 
@@ -961,16 +1769,18 @@ int set_antenna_to_net(int newflags, struct routeinfo_ *iroute,
     node = violation->node;
     net = violation->net;
     layer = violation->layer;
+    rg = routegraph_build(net);
 
     if ((rt->flags & RT_START_NODE) && (rt->start.node == node))
-	get_route_area_forward(net, rt, layer, NULL, ANTENNA_ROUTE, NodeTable,
+	get_route_area_forward(net, rt, layer, NULL, ANTENNA_ROUTE, rg,
 		iroute);
     else if ((rt->flags & RT_END_NODE) && (rt->end.node == node))
-	get_route_area_reverse(net, rt, layer, NULL, ANTENNA_ROUTE, NodeTable,
+	get_route_area_reverse(net, rt, layer, NULL, ANTENNA_ROUTE, rg,
 		iroute);
     else {
 	/* This should not happen */
 	Fprintf(stderr, "Error:  Antenna route and node do not connect!\n");
+	routegraph_free(rg);
 	return 1;
     }
 
@@ -981,25 +1791,49 @@ int set_antenna_to_net(int newflags, struct routeinfo_ *iroute,
     /* Disable the remainder of the route */
 
     if ((rt->flags & RT_START_NODE) && (rt->start.node == node))
-	get_route_area_forward(net, rt, layer, NULL, ANTENNA_DISABLE, NodeTable,
+	get_route_area_forward(net, rt, layer, NULL, ANTENNA_DISABLE, rg,
 		iroute);
     else if ((rt->flags & RT_END_NODE) && (rt->end.node == node))
-	get_route_area_reverse(net, rt, layer, NULL, ANTENNA_DISABLE, NodeTable,
+	get_route_area_reverse(net, rt, layer, NULL, ANTENNA_DISABLE, rg,
 		iroute);
     else {
 	/* This should not happen */
 	Fprintf(stderr, "Error:  Antenna route and node do not connect!\n");
+	routegraph_free(rg);
 	return 1;
     }
 
     /* Done checking routes;  clear route visited flags */
     for (clrrt = iroute->net->routes; clrrt; clrrt = clrrt->next)
 	clrrt->flags &= ~RT_VISITED;
+    routegraph_free(rg);
 
     /* Set the antenna taps to the net number.		*/
     /* Routine is similar to set_powerbus_to_net().	*/
+    /* If a tap has been chosen, then only that tap is	*/
+    /* a target.					*/
 
     rval = 0;
+    if (tap != NULL) {
+	for (i = tap->first; i < tap->first + tap->num; i++) {
+	    x = tappos[3 * i];
+	    y = tappos[3 * i + 1];
+	    lay = tappos[3 * i + 2];
+	    if ((OBSVAL(x, y, lay) & NETNUM_MASK) != ANTENNA_NET) continue;
+	    Pr = &OBS2VAL(x, y, lay);
+	    if (!(Pr->flags & PR_COST) && (Pr->prdata.net == MAXNETNUM))
+		continue;
+	    else if (!(Pr->flags & PR_SOURCE)) {
+		Pr->flags |= (PR_TARGET | PR_COST);
+		Pr->prdata.cost = MAXRT;
+		rval = 1;
+		OBSVAL(x, y, lay) &= ~NETNUM_MASK;
+		OBSVAL(x, y, lay) |= net->netnum;
+	    }
+	}
+	return rval;
+    }
+
     for (lay = 0; lay < Num_layers; lay++)
 	for (x = 0; x < NumChannelsX; x++)
 	    for (y = 0; y < NumChannelsY; y++)
@@ -1030,16 +1864,22 @@ int set_antenna_to_net(int newflags, struct routeinfo_ *iroute,
 /* the complete net).  Disable the remainder of the net.	*/
 /* Set all free antenna taps to the net number being routed,	*/
 /* then route like stage 1 power routing.			*/
+/*								*/
+/* If "tap" is not NULL, then it is the only target, and the	*/
+/* search is limited to the area around the antenna and the	*/
+/* tap.								*/
 /*--------------------------------------------------------------*/
 
 int antenna_setup(struct routeinfo_ *iroute, ANTENNAINFO violation,
-	Tcl_HashTable *NodeTable)
+		ANTENNATAP *tap, int *tappos)
 {
-    int i, j, netnum, rval;
+    int i, rval;
+    gindex j;
+    obsword netnum;
     PROUTE *Pr;
 
     for (i = 0; i < Num_layers; i++) {
-	for (j = 0; j < NumChannelsX * NumChannelsY; j++) {
+	for (j = 0; j < NUMCHANNELS; j++) {
 	    netnum = Obs[i][j] & (~BLOCKED_MASK);
 	    Pr = &Obs2[i][j];
 	    if (netnum != 0) {
@@ -1071,17 +1911,21 @@ int antenna_setup(struct routeinfo_ *iroute, ANTENNAINFO violation,
     iroute->bbox.x1 = NumChannelsX;
     iroute->bbox.y1 = NumChannelsY;
 
-    rval = set_antenna_to_net(PR_SOURCE, iroute, 0, violation, NodeTable);
+    rval = set_antenna_to_net(PR_SOURCE, iroute, 0, violation, tap, tappos);
 
     /* Unlikely that MASK_BBOX would be useful, since one does	*/
     /* not know if an antenna tap is inside the box or not.	*/
     /* Maybe if bounding box is expanded to encompass some	*/
     /* number of taps. . .					*/
+    /* But when a single tap has been chosen, the box of the	*/
+    /* antenna and the tap is the likely area of the route.	*/
 
-    // if (maskMode == MASK_NONE)
-	   fillMask((u_char)0);
-    // else if (maskMode == MASK_BBOX)
-    //	   createBboxMask(iroute->net, (u_char)Numpasses);
+    if (tap != NULL)
+	createBoxMask(MIN(iroute->bbox.x1, tap->x), MIN(iroute->bbox.y1, tap->y),
+		MAX(iroute->bbox.x2, tap->x), MAX(iroute->bbox.y2, tap->y),
+		(u_char)Numpasses);
+    else
+	fillMask((u_char)0);
 
     iroute->maxcost = 20;
     return rval;
@@ -1096,7 +1940,7 @@ int antenna_setup(struct routeinfo_ *iroute, ANTENNAINFO violation,
 /* for failure.							*/
 /*--------------------------------------------------------------*/
 
-int simpleantennafix(ANTENNAINFO violation, Tcl_HashTable *NodeTable)
+int simpleantennafix(ANTENNAINFO violation)
 {
     return -1;		/* Antenna was not fixed */
 }
@@ -1109,12 +1953,14 @@ int simpleantennafix(ANTENNAINFO violation, Tcl_HashTable *NodeTable)
 /* some special handling related to the antenna taps, which	*/
 /* have much in common with VDD and GND taps but significant	*/
 /* differences as well.						*/
+/*								*/
+/* If "tap" is not NULL, then route only to that tap.		*/
 /*--------------------------------------------------------------*/
 
-int doantennaroute(ANTENNAINFO violation, Tcl_HashTable *NodeTable)
+int doantennaroute(ANTENNAINFO violation, ANTENNATAP *tap, int *tappos)
 {
     NET net;
-    NODE node;
+    NODE node, tapnode;
     ROUTE rt1, lrt;
     int layer, i, result, savelayers;
     struct routeinfo_ iroute;
@@ -1123,7 +1969,7 @@ int doantennaroute(ANTENNAINFO violation, Tcl_HashTable *NodeTable)
     node = violation->node;
     layer = violation->layer;
 
-    result = antenna_setup(&iroute, violation, NodeTable);
+    result = antenna_setup(&iroute, violation, tap, tappos);
 
     rt1 = createemptyroute();
     rt1->netnum = net->netnum;
@@ -1140,11 +1986,16 @@ int doantennaroute(ANTENNAINFO violation, Tcl_HashTable *NodeTable)
 
     if (result < 0) {
 	/* To do:  Handle failures? */
-	Fprintf(stderr, "Antenna anchoring route failed.\n");
-	free(rt1);
+	/* (A route to a chosen tap is tried again to any tap)	*/
+	if (tap == NULL)
+	    Fprintf(stderr, "Antenna anchoring route failed.\n");
+	tapnode = NULL;
+	freeROUTE(rt1);
     }
     else {
+	tapnode = rt1->start.node;
 	TotalRoutes++;
+	net->flags |= (NET_DIRTY | NET_RC_DIRTY);
 	if (net->routes) {
 	    for (lrt = net->routes; lrt->next; lrt = lrt->next);
 	    lrt->next = rt1;
@@ -1160,7 +2011,7 @@ int doantennaroute(ANTENNAINFO violation, Tcl_HashTable *NodeTable)
     free_glist(&iroute);
 
     /* Put free taps back to ANTENNA_NET */
-    revert_antenna_taps(net->netnum, rt1->start.node);
+    revert_antenna_taps(net->netnum, tapnode, tap, tappos);
 
     return result;
 }
@@ -1174,14 +2025,17 @@ resolve_antenna(char *antennacell, u_char do_fix)
 {
     FILE *fout;
     int numtaps, numerrors, numfixed, result;
-    int layererrors;
-    int layer, i, new;
-    Tcl_HashTable NodeTable;
-    Tcl_HashEntry *entry;
+    int layererrors, numfixednets, numviolations, numfreetaps;
+    int layer, l, i, k, *assign, *tappos;
+    int counts[MAX_LAYERS];
     GATE g;
-    NET net;
+    NET net, *fixednets;
     ROUTE rt;
     ANTENNAINFO nextviolation, FixedList = NULL, BadList = NULL;
+    ANTENNAINFO lists[MAX_LAYERS], stop[MAX_LAYERS], *vptr;
+    ANTENNAINFO *violations;
+    ANTLAYER layers[MAX_LAYERS];
+    ANTENNATAP *taps, *tap;
 
     numtaps = count_free_antenna_taps(antennacell);
     if (Verbose > 3) {
@@ -1192,30 +2046,24 @@ resolve_antenna(char *antennacell, u_char do_fix)
     numerrors = 0;
     numfixed = 0;
 
-    /* Build a hash table of nodes, so the gate area can be found	*/
-    /* quickly for any node by hash lookup.				*/
-
-    Tcl_InitHashTable(&NodeTable, TCL_ONE_WORD_KEYS);
-
-    for (g = Nlgates; g; g = g->next) {
-	for (i = 0; i < g->nodes; i++) {
-	    GATENODE gn;
-	    gn = (GATENODE)malloc(sizeof(struct gatenode_));
-	    gn->idx = i;
-	    gn->gate = g;
-	    entry = Tcl_CreateHashEntry(&NodeTable, (char *)(*(g->noderec + i)), &new);
-	    Tcl_SetHashValue(entry, gn);
-	}
-    }
-
     /* Working from the 1nd layer metal to the top, compute	*/
     /* route metal to gate area ratios.  Mark each one when	*/
     /* done, as an antenna violation that has been fixed at, 	*/
     /* say, metal2 can no longer be a violation on any higer	*/
-    /* layer of metal.						*/
+    /* layer of metal.  The ratios of all layers are found in	*/
+    /* one pass, and nets that get an antenna route are checked	*/
+    /* again on the layers above the one that was fixed.	*/
 
     for (layer = 0; layer < Num_layers; layer++) {
-	layererrors = find_layer_antenna_violations(layer, &NodeTable);
+	lists[layer] = NULL;
+	counts[layer] = 0;
+    }
+    find_antenna_violations(0, Num_layers - 1, lists, counts);
+    antenna_layer_info(layers);
+    fixednets = (NET *)malloc((Numnets + 1) * sizeof(NET));
+
+    for (layer = 0; layer < Num_layers; layer++) {
+	layererrors = counts[layer];
 	numerrors += layererrors;
 	if (Verbose > 2) {
 	    Fprintf(stdout, "Number of antenna errors on metal%d = %d\n",
@@ -1225,18 +2073,56 @@ resolve_antenna(char *antennacell, u_char do_fix)
 	/* Fix the violations found on this layer before moving	*/
 	/* on to the next layer.				*/
 
-	while (AntennaList != NULL) {
+	AntennaList = lists[layer];
+	lists[layer] = NULL;
+	numfixednets = 0;
+
+	/* Assign free antenna taps to all of the violations on this	*/
+	/* layer together, so that each violation is routed to a tap	*/
+	/* of its own, instead of searching for every free tap.	*/
+
+	assign = NULL;
+	taps = NULL;
+	tappos = NULL;
+	if (do_fix && (AntennaList != NULL)) {
+	    numviolations = 0;
+	    for (nextviolation = AntennaList; nextviolation;
+			nextviolation = nextviolation->next)
+		numviolations++;
+	    violations = (ANTENNAINFO *)malloc(numviolations * sizeof(ANTENNAINFO));
+	    assign = (int *)malloc(numviolations * sizeof(int));
+	    for (i = 0, nextviolation = AntennaList; nextviolation;
+			nextviolation = nextviolation->next)
+		violations[i++] = nextviolation;
+
+	    taps = find_antenna_tap_positions(&numfreetaps, &tappos);
+	    assign_antenna_taps(violations, numviolations, taps, numfreetaps,
+			assign);
+	    free(violations);
+	}
+
+	for (k = 0; AntennaList != NULL; k++) {
 	    nextviolation = AntennaList->next;
+	    result = -1;
     
 	    if (do_fix) {
-		result = simpleantennafix(AntennaList, &NodeTable);
+		result = simpleantennafix(AntennaList);
 		if (result == 0) {
 		    /* No antenna cell involved, so no backannotation	*/
 		    /* required.  Remove the "route" record. */
 		    AntennaList->route = NULL;
 		}
-		else
-		    result = doantennaroute(AntennaList, &NodeTable);
+		else {
+		    tap = (assign[k] >= 0) ? &taps[assign[k]] : NULL;
+		    result = doantennaroute(AntennaList, tap, tappos);
+		    if ((result < 0) && (tap != NULL))
+			result = doantennaroute(AntennaList, NULL, NULL);
+
+		    /* Violations of a net are together in the list */
+		    if ((result >= 0) && ((numfixednets == 0) ||
+				(fixednets[numfixednets - 1] != AntennaList->net)))
+			fixednets[numfixednets++] = AntennaList->net;
+		}
 		if (result >= 0) numfixed++;
 	    }
 
@@ -1259,7 +2145,40 @@ resolve_antenna(char *antennacell, u_char do_fix)
 	    }
 	    AntennaList = nextviolation;
 	}
+	if (assign != NULL) {
+	    free(assign);
+	    free(taps);
+	    free(tappos);
+	}
+
+	/* The antenna routes changed the nets that were fixed, so	*/
+	/* replace their violations on the higher layers.	*/
+
+	for (i = 0; i < numfixednets; i++) {
+	    net = fixednets[i];
+	    for (l = layer + 1; l < Num_layers; l++) {
+		vptr = &lists[l];
+		while (*vptr != NULL) {
+		    if ((*vptr)->net == net) {
+			nextviolation = (*vptr)->next;
+			free(*vptr);
+			*vptr = nextviolation;
+			counts[l]--;
+		    }
+		    else
+			vptr = &(*vptr)->next;
+		}
+	    }
+	    if (layer + 1 < Num_layers) {
+		for (l = layer + 1; l < Num_layers; l++) stop[l] = lists[l];
+		net_antenna_violations(net, layer + 1, Num_layers - 1,
+			layers, lists, counts);
+		for (l = layer + 1; l < Num_layers; l++)
+		    report_antenna_violations(lists[l], stop[l]);
+	    }
+	}
     }
+    free(fixednets);
 
     if (Verbose > 0) {
 	Fprintf(stdout, "Total number of antenna errors found = %d\n", numerrors);
@@ -1313,7 +2232,7 @@ resolve_antenna(char *antennacell, u_char do_fix)
 	    // NOTE:  nextviolation->route was changed from the route that
 	    // connects to the gate in violation, to the route that fixes
 	    // the antenna error.
-	    g = FindGateNode(&NodeTable, nextviolation->route->start.node, &i);
+	    g = FindGateNode(nextviolation->route->start.node, &i);
 	    fprintf(fout, "Net=%s Instance=%s Cell=%s Pin=%s\n",
 			nextviolation->net->netname, g->gatename,
 			g->gatetype->gatename, g->gatetype->node[i]);
@@ -1336,7 +2255,7 @@ resolve_antenna(char *antennacell, u_char do_fix)
 
 	for (nextviolation = BadList; nextviolation;
 			nextviolation = nextviolation->next) {
-	    g = FindGateNode(&NodeTable, nextviolation->node, &i);
+	    g = FindGateNode(nextviolation->node, &i);
 	    fprintf(fout, "Net=%s Instance=%s Cell=%s Pin=%s error on Metal%d\n",
 			nextviolation->net->netname,
 			g->gatename, g->gatetype->gatename,
@@ -1346,11 +2265,6 @@ resolve_antenna(char *antennacell, u_char do_fix)
 
     if ((FixedList != NULL) || (BadList != NULL)) fclose(fout);
 
-    /* Free up the node hash table */
-
-    FreeNodeTable(&NodeTable);
-    Tcl_DeleteHashTable(&NodeTable);
-
     /* Free up the violation lists */
 
     if (FixedList != NULL) {
@@ -1367,6 +2281,4 @@ resolve_antenna(char *antennacell, u_char do_fix)
     }
 }
 
-#endif	/* TCL_QROUTER */
-
 /* end of antenna.c */
@@ -0,0 +1,361 @@
+/*--------------------------------------------------------------*/
+/* congest.c --							*/
+/*								*/
+/* Routing congestion map.  The number of occupied layers at	*/
+/* each grid position is kept up to date as routes are written	*/
+/* back to Obs[], ripped up, and blocked for DRC spacing, so	*/
+/* that it does not need to be found again by scanning all of	*/
+/* Obs[] each time it is used.  Sums along rows, used to place	*/
+/* trunk lines in createMask(), come from prefix sums of each	*/
+/* row, which are made again only for rows that have changed.	*/
+/*								*/
+/* Also here are the estimate of congestion made from the net	*/
+/* bounding boxes, and summed-area tables to get the total	*/
+/* congestion over any area of the grid in constant time.	*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qrouter.h"
+#include "qconfig.h"
+#include "memstat.h"
+#include "congest.h"
+
+/* The congestion map.  "used" counts the layers at each	*/
+/* position that are routed, obstructed, or have a stub or	*/
+/* offset tap;  "blocked" counts the layers that are blocked	*/
+/* in any direction.  Row "y" of the prefix sums of "used" is	*/
+/* at rowsum[y * (nx + 1)], and is made again when the row is	*/
+/* marked dirty.						*/
+
+static struct {
+    int     nx, ny;		/* Size of the grid		*/
+    int     layers;		/* Number of layers counted	*/
+    u_char *used;		/* Routed or obstructed layers	*/
+    u_char *blocked;		/* Blocked layers		*/
+    int    *rowsum;		/* Prefix sums of "used" by row	*/
+    u_char *dirty;		/* Rows with stale prefix sums	*/
+} Cong = {0, 0, 0, NULL, NULL, NULL, NULL};
+
+/*--------------------------------------------------------------*/
+/* Count the occupied layers at grid position (x, y).		*/
+/*--------------------------------------------------------------*/
+
+static void
+congestion_count(int x, int y, int *used, int *blocked)
+{
+    int i;
+    obsword n;
+
+    *used = *blocked = 0;
+    for (i = 0; i < Cong.layers; i++) {
+	n = OBSVAL(x, y, i);
+	if (n & ROUTED_NET) (*used)++;
+	if (n & NO_NET) (*used)++;
+	if (n & PINOBSTRUCTMASK) (*used)++;
+	if (n & BLOCKED_MASK) (*blocked)++;
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* congestion_free() ---					*/
+/*--------------------------------------------------------------*/
+
+void
+congestion_free(void)
+{
+    gindex cells = (gindex)Cong.nx * (gindex)Cong.ny;
+
+    if (Cong.used == NULL) return;
+    mem_free(MEM_GRID, Cong.used, cells * sizeof(u_char));
+    mem_free(MEM_GRID, Cong.blocked, cells * sizeof(u_char));
+    mem_free(MEM_GRID, Cong.rowsum, (gindex)(Cong.nx + 1) * (gindex)Cong.ny
+		* sizeof(int));
+    mem_free(MEM_GRID, Cong.dirty, Cong.ny * sizeof(u_char));
+    Cong.used = Cong.blocked = Cong.dirty = NULL;
+    Cong.rowsum = NULL;
+    Cong.nx = Cong.ny = 0;
+}
+
+/*--------------------------------------------------------------*/
+/* congestion_init() ---					*/
+/*								*/
+/* Make the congestion map from the Obs[] array.  This is done	*/
+/* once the obstructions and any fixed routes have been set up	*/
+/* (see post_def_setup()), after which the map is kept up to	*/
+/* date by congestion_update().					*/
+/*--------------------------------------------------------------*/
+
+void
+congestion_init(void)
+{
+    int x, y, used, blocked;
+    gindex cells;
+
+    congestion_free();
+    if ((NumChannelsX <= 0) || (NumChannelsY <= 0) || (Obs[0] == NULL))
+	return;
+
+    Cong.nx = NumChannelsX;
+    Cong.ny = NumChannelsY;
+    Cong.layers = Num_layers;
+    cells = NUMCHANNELS;
+
+    Cong.used = (u_char *)mem_calloc(MEM_GRID, cells, sizeof(u_char));
+    Cong.blocked = (u_char *)mem_calloc(MEM_GRID, cells, sizeof(u_char));
+    Cong.rowsum = (int *)mem_calloc(MEM_GRID, (gindex)(Cong.nx + 1) *
+		(gindex)Cong.ny, sizeof(int));
+    Cong.dirty = (u_char *)mem_calloc(MEM_GRID, Cong.ny, sizeof(u_char));
+
+    for (y = 0; y < Cong.ny; y++) {
+	for (x = 0; x < Cong.nx; x++) {
+	    congestion_count(x, y, &used, &blocked);
+	    Cong.used[OGRID(x, y)] = (u_char)used;
+	    Cong.blocked[OGRID(x, y)] = (u_char)blocked;
+	}
+	Cong.dirty[y] = (u_char)1;
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* The map is made again if the grid has changed size since it	*/
+/* was made.  Return FALSE if there is no grid.			*/
+/*--------------------------------------------------------------*/
+
+static u_char
+congestion_check(void)
+{
+    if ((Cong.used == NULL) || (Cong.nx != NumChannelsX) ||
+		(Cong.ny != NumChannelsY))
+	congestion_init();
+    return (Cong.used == NULL) ? FALSE : TRUE;
+}
+
+/*--------------------------------------------------------------*/
+/* congestion_update() ---					*/
+/*								*/
+/* Count the occupied layers at (x, y) again after Obs[] has	*/
+/* changed there.						*/
+/*--------------------------------------------------------------*/
+
+void
+congestion_update(int x, int y)
+{
+    int used, blocked;
+    gindex c;
+
+    if ((Cong.used == NULL) || (Cong.nx != NumChannelsX) ||
+		(Cong.ny != NumChannelsY))
+	return;
+    if ((x < 0) || (x >= Cong.nx) || (y < 0) || (y >= Cong.ny))
+	return;
+
+    congestion_count(x, y, &used, &blocked);
+    c = OGRID(x, y);
+    if (Cong.used[c] != (u_char)used) {
+	Cong.used[c] = (u_char)used;
+	Cong.dirty[y] = (u_char)1;
+    }
+    Cong.blocked[c] = (u_char)blocked;
+}
+
+/*--------------------------------------------------------------*/
+/* congestion_update_seg() ---					*/
+/*								*/
+/* Update the congestion map at every position of "seg".	*/
+/*--------------------------------------------------------------*/
+
+void
+congestion_update_seg(SEG seg)
+{
+    int x, y;
+
+    x = seg->x1;
+    y = seg->y1;
+    while (1) {
+	congestion_update(x, y);
+	if ((x == seg->x2) && (y == seg->y2)) break;
+	if (x < seg->x2) x++;
+	else if (x > seg->x2) x--;
+	if (y < seg->y2) y++;
+	else if (y > seg->y2) y--;
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* congestion_value() ---					*/
+/*								*/
+/* Return the number of occupied and blocked layers at (x, y).	*/
+/*--------------------------------------------------------------*/
+
+int
+congestion_value(int x, int y)
+{
+    gindex c;
+
+    if (congestion_check() == FALSE) return 0;
+    if ((x < 0) || (x >= Cong.nx) || (y < 0) || (y >= Cong.ny)) return 0;
+    c = OGRID(x, y);
+    return (int)Cong.used[c] + (int)Cong.blocked[c];
+}
+
+/*--------------------------------------------------------------*/
+/* congestion_row() ---						*/
+/*								*/
+/* Return the number of routed and obstructed layers summed	*/
+/* over the positions xmin to xmax of row y.			*/
+/*--------------------------------------------------------------*/
+
+int
+congestion_row(int y, int xmin, int xmax)
+{
+    int x, *row;
+    u_char *used;
+
+    if (congestion_check() == FALSE) return 0;
+    if ((y < 0) || (y >= Cong.ny)) return 0;
+    if (xmin < 0) xmin = 0;
+    if (xmax >= Cong.nx) xmax = Cong.nx - 1;
+    if (xmin > xmax) return 0;
+
+    row = Cong.rowsum + (gindex)y * (gindex)(Cong.nx + 1);
+    if (Cong.dirty[y]) {
+	used = Cong.used + OGRID(0, y);
+	row[0] = 0;
+	for (x = 0; x < Cong.nx; x++)
+	    row[x + 1] = row[x] + (int)used[x];
+	Cong.dirty[y] = (u_char)0;
+    }
+    return row[xmax + 1] - row[xmin];
+}
+
+/*--------------------------------------------------------------*/
+/* congestion_estimate() ---					*/
+/*								*/
+/* Estimate the congestion at each grid position from the	*/
+/* net bounding boxes.  Each net adds a wire density over its	*/
+/* bounding box.  The boxes are added to a table of differences	*/
+/* at their corners, which is then summed up, so that the time	*/
+/* does not depend on the size of the boxes.  Return an array	*/
+/* indexed by OGRID(), to be freed by the caller.		*/
+/*--------------------------------------------------------------*/
+
+float *
+congestion_estimate(void)
+{
+    NET net;
+    int i, x, y, x1, y1, x2, y2, nwidth, nheight, area, length;
+    double density, *diff, *drow, *prow;
+    float *Congestion;
+    gindex w;
+
+    Congestion = (float *)calloc(NUMCHANNELS, sizeof(float));
+    if (NUMCHANNELS == 0) return Congestion;
+
+    w = (gindex)(NumChannelsX + 1);
+    diff = (double *)calloc(w * (gindex)(NumChannelsY + 1), sizeof(double));
+
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	nwidth = (net->xmax - net->xmin + 1);
+	nheight = (net->ymax - net->ymin + 1);
+	area = nwidth * nheight;
+	if (nwidth > nheight) {
+	    length = nwidth + (nheight >> 1) * net->numnodes;
+	}
+	else {
+	    length = nheight + (nwidth >> 1) * net->numnodes;
+	}
+	density = (double)((float)length / (float)area);
+
+	/* The density covers xmin to xmax - 1 and ymin to ymax - 1 */
+
+	x1 = MAX(net->xmin, 0);
+	y1 = MAX(net->ymin, 0);
+	x2 = MIN(net->xmax, NumChannelsX);
+	y2 = MIN(net->ymax, NumChannelsY);
+	if ((x1 >= x2) || (y1 >= y2)) continue;
+
+	diff[y1 * w + x1] += density;
+	diff[y1 * w + x2] -= density;
+	diff[y2 * w + x1] -= density;
+	diff[y2 * w + x2] += density;
+    }
+
+    /* Sum the differences along rows, then down columns */
+
+    for (y = 0; y < NumChannelsY; y++) {
+	drow = diff + y * w;
+	for (x = 1; x < NumChannelsX; x++)
+	    drow[x] += drow[x - 1];
+	if (y > 0) {
+	    prow = drow - w;
+	    for (x = 0; x < NumChannelsX; x++)
+		drow[x] += prow[x];
+	}
+	for (x = 0; x < NumChannelsX; x++)
+	    Congestion[OGRID(x, y)] = (float)drow[x];
+    }
+
+    free(diff);
+    return Congestion;
+}
+
+/*--------------------------------------------------------------*/
+/* congestion_table() ---					*/
+/*								*/
+/* Make a summed-area table of the per-position values in	*/
+/* "cells" (indexed by OGRID()).  Entry (x, y) of the table is	*/
+/* at [y * (NumChannelsX + 1) + x], and holds the sum of all	*/
+/* values below x and below y.  To be freed by the caller.	*/
+/*--------------------------------------------------------------*/
+
+double *
+congestion_table(float *cells)
+{
+    int x, y;
+    double *table, *trow, *prow, rsum;
+    gindex w;
+
+    w = (gindex)(NumChannelsX + 1);
+    table = (double *)calloc(w * (gindex)(NumChannelsY + 1), sizeof(double));
+
+    for (y = 0; y < NumChannelsY; y++) {
+	prow = table + y * w;
+	trow = prow + w;
+	rsum = 0.0;
+	for (x = 0; x < NumChannelsX; x++) {
+	    rsum += (double)cells[OGRID(x, y)];
+	    trow[x + 1] = prow[x + 1] + rsum;
+	}
+    }
+    return table;
+}
+
+/*--------------------------------------------------------------*/
+/* congestion_table_sum() ---					*/
+/*								*/
+/* Return the sum of the values from x1 to x2 and from y1 to y2	*/
+/* (inclusive) using a table made by congestion_table().	*/
+/* Positions outside of the grid count as zero.		*/
+/*--------------------------------------------------------------*/
+
+double
+congestion_table_sum(double *table, int x1, int y1, int x2, int y2)
+{
+    gindex w;
+
+    if (x1 < 0) x1 = 0;
+    if (y1 < 0) y1 = 0;
+    if (x2 >= NumChannelsX) x2 = NumChannelsX - 1;
+    if (y2 >= NumChannelsY) y2 = NumChannelsY - 1;
+    if ((x1 > x2) || (y1 > y2)) return 0.0;
+
+    w = (gindex)(NumChannelsX + 1);
+    return table[(gindex)(y2 + 1) * w + x2 + 1] - table[(gindex)y1 * w + x2 + 1]
+		- table[(gindex)(y2 + 1) * w + x1] + table[(gindex)y1 * w + x1];
+}
+
+/* end of congest.c */
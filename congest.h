@@ -0,0 +1,25 @@
+/*--------------------------------------------------------------*/
+/* congest.h --							*/
+/*								*/
+/* Routing congestion map (header file)				*/
+/*--------------------------------------------------------------*/
+
+#ifndef _CONGEST_H
+#define _CONGEST_H
+
+extern void   congestion_init(void);
+extern void   congestion_free(void);
+extern void   congestion_update(int x, int y);
+extern void   congestion_update_seg(SEG seg);
+
+extern int    congestion_value(int x, int y);
+extern int    congestion_row(int y, int xmin, int xmax);
+
+extern float  *congestion_estimate(void);
+extern double *congestion_table(float *cells);
+extern double  congestion_table_sum(double *table, int x1, int y1,
+			int x2, int y2);
+
+#endif /* _CONGEST_H */
+
+/* end of congest.h */
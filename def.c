@@ -24,6 +24,9 @@
 #include <errno.h>
 #include <stdarg.h>
 #include <math.h>		/* for roundf() function, if std=c99 */
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 #include "qrouter.h"
 #include "node.h"
@@ -31,114 +34,61 @@
 #include "maze.h"
 #include "lef.h"
 #include "def.h"
+#include "pool.h"
+#include "hash.h"
+#include "memstat.h"
+#include "zfile.h"
 
 TRACKS *Tracks = NULL;
 int numSpecial = 0;		/* Tracks number of specialnets */
 
-#ifndef TCL_QROUTER
+/* These hash tables speed up DEF file reading.  Names	*/
+/* are case sensitive unless the DEF file declares	*/
+/* NAMESCASESENSITIVE OFF.				*/
 
-/* Find an instance in the instance list.  If qrouter	*/
-/* is compiled with Tcl support, then this routine	*/
-/* uses Tcl hash tables, greatly speeding up the	*/
-/* read-in of large DEF files.				*/
+static HashTable InstanceTable;
+static HashTable NetTable;
 
-GATE
-DefFindGate(char *name)
-{
-    GATE ginst;
-
-    for (ginst = Nlgates; ginst; ginst = ginst->next) {
-	if (!strcasecmp(ginst->gatename, name))
-	    return ginst;
-    }
-    return NULL;
-}
-
-/* Find a net in the list of nets.  If qrouter is	*/
-/* compiled with Tcl support, then this routine		*/
-/* uses Tcl hash tables, greatly speeding up the	*/
-/* read-in of large DEF files.				*/
-
-NET
-DefFindNet(char *name)
-{
-    int i;
-    NET net;
-
-    for (i = 0; i < Numnets; i++) {
-	net = Nlnets[i];
-	if (!strcasecmp(net->netname, name))
-	    return net;
-    }
-    return NULL;
-}
-
-/* For the non-Tcl version, these are empty placeholders */
-
-static void
-DefHashInit(void)
-{
-}
-
-static void
-DefHashInstance(GATE gateginfo)
-{
-}
-
-static void
-DefHashNet(NET net)
-{
-}
-
-#else /* The versions using TCL hash tables */
-
-#include <tk.h>
-
-/* These hash tables speed up DEF file reading */
-
-static Tcl_HashTable InstanceTable;
-static Tcl_HashTable NetTable;
+#ifdef HAVE_PTHREAD_H
+static int DefReadNetsParallel(FILE *f, float oscale, int total, double *home,
+		int *netidx, int *fixed);
+static int DefReadComponentsParallel(FILE *f, float oscale, int total,
+		int *err_fatal);
+#endif
 
 /*--------------------------------------------------------------*/
-/* Cell macro lookup based on the hash table			*/
+/* Instance and net lookup based on the hash tables		*/
 /*--------------------------------------------------------------*/
 
 static void
-DefHashInit(void)
+DefHashInit(int nocase)
 {
-   /* Initialize the macro hash table */
+   /* Discard any tables from a previously read DEF file */
+
+   HashKill(&InstanceTable);
+   HashKill(&NetTable);
 
-   Tcl_InitHashTable(&InstanceTable, TCL_STRING_KEYS);
-   Tcl_InitHashTable(&NetTable, TCL_STRING_KEYS);
+   HashInit(&InstanceTable, 1024, nocase);
+   HashInit(&NetTable, 1024, nocase);
 }
 
 GATE
 DefFindGate(char *name)
 {
-    GATE ginst;
-    Tcl_HashEntry *entry;
-
-    entry = Tcl_FindHashEntry(&InstanceTable, name);
-    ginst = (entry) ? (GATE)Tcl_GetHashValue(entry) : NULL;
-    return ginst;
+    return (GATE)HashLookup(&InstanceTable, name);
 }
 
 NET
 DefFindNet(char *name)
 {
-    NET net;
-    Tcl_HashEntry *entry;
-
     // Guard against calls to find nets before DEF file is read
     if (Numnets == 0) return NULL;
 
-    entry = Tcl_FindHashEntry(&NetTable, name);
-    net = (entry) ? (NET)Tcl_GetHashValue(entry) : NULL;
-    return net;
+    return (NET)HashLookup(&NetTable, name);
 }
 
 /*--------------------------------------------------------------*/
-/* Cell macro hash table generation				*/
+/* Instance hash table generation				*/
 /* Given an instance record, create an entry in the hash table	*/
 /* for the instance name, with the record entry pointing to the	*/
 /* instance record.						*/
@@ -147,13 +97,7 @@ DefFindNet(char *name)
 static void
 DefHashInstance(GATE gateginfo)
 {
-    int new;
-    Tcl_HashEntry *entry;
-
-    entry = Tcl_CreateHashEntry(&InstanceTable,
-		gateginfo->gatename, &new);
-    if (entry != NULL)
-	Tcl_SetHashValue(entry, (ClientData)gateginfo);
+    HashInsert(&InstanceTable, gateginfo->gatename, (void *)gateginfo);
 }
 
 /*--------------------------------------------------------------*/
@@ -166,16 +110,9 @@ DefHashInstance(GATE gateginfo)
 static void
 DefHashNet(NET net)
 {
-    int new;
-    Tcl_HashEntry *entry;
-
-    entry = Tcl_CreateHashEntry(&NetTable, net->netname, &new);
-    if (entry != NULL)
-	Tcl_SetHashValue(entry, (ClientData)net);
+    HashInsert(&NetTable, net->netname, (void *)net);
 }
 
-#endif	/* TCL_QROUTER */
-
 /*
  *------------------------------------------------------------
  *
@@ -242,6 +179,9 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		(net->netnum != VDD_NET) && (net->netnum != GND_NET)) ?
 		TRUE : FALSE;
 
+    /* Any cached R and C values of the net are out of date */
+    net->flags |= NET_RC_DIRTY;
+
     while (initial || (token = LefNextToken(f, TRUE)) != NULL)
     {
 	/* Get next point, token "NEW", or via name */
@@ -290,7 +230,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 	    // Create a new route record, add to the 1st node
 
 	    if (special == (char)0) {
-	       routednet = (ROUTE)malloc(sizeof(struct route_));
+	       routednet = allocROUTE();
 	       routednet->next = net->routes;
 	       net->routes = routednet;
 
@@ -376,7 +316,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		if ((special == (char)0) && (paintLayer >= 0) &&
 				(paintLayer < (Num_layers - 1))) {
 
-		    newRoute = (SEG)malloc(sizeof(struct seg_));
+		    newRoute = allocSEG();
 		    newRoute->segtype = ST_VIA;
 		    newRoute->x1 = refp.x1;
 		    newRoute->x2 = refp.x1;
@@ -385,7 +325,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		    newRoute->layer = paintLayer;
 
 		    if (routednet == NULL) {
-			routednet = (ROUTE)malloc(sizeof(struct route_));
+			routednet = allocROUTE();
 			routednet->next = net->routes;
 			net->routes = routednet;
 
@@ -460,7 +400,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		{
 		    LefError(DEF_ERROR, "No reference point for \"*\" wildcard\n"); 
 		    if (newRoute != NULL) {
-			free(newRoute);
+			freeSEG(newRoute);
 			newRoute = NULL;
 		    }
 		    goto endCoord;
@@ -539,7 +479,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		   }
 		}
 		else if ((paintLayer >= 0) && (paintLayer < Num_layers)) {
-		   newRoute = (SEG)malloc(sizeof(struct seg_));
+		   newRoute = allocSEG();
 		   newRoute->segtype = ST_WIRE;
 		   // NOTE: Segments are added at the front of the linked
 		   // list, so they are backwards from the entry in the
@@ -552,7 +492,7 @@ DefAddRoutes(FILE *f, float oscale, NET net, char special)
 		   newRoute->layer = paintLayer;
 
 		   if (routednet == NULL) {
-			routednet = (ROUTE)malloc(sizeof(struct route_));
+			routednet = allocROUTE();
 			routednet->next = net->routes;
 			net->routes = routednet;
 
@@ -595,6 +535,130 @@ endCoord:
     return token;	/* Pass back the last token found */
 }
 
+/*
+ *------------------------------------------------------------
+ *
+ * DefGatePinTaps ---
+ *
+ *	Find pin "pinname" of gate instance "g" and record in
+ *	"node" the routing grid points that fall on the pin
+ *	geometry.  Does not change the gate, so it may be run
+ *	on a worker thread.
+ *
+ * Results:
+ *	Index of the pin in the gate, or -1 if the gate has
+ *	no such pin.
+ *
+ *------------------------------------------------------------
+ */
+
+static int
+DefGatePinTaps(GATE g, NODE node, char *pinname, double *home)
+{
+    int i;
+    GATE gateginfo;
+    DSEG drect;
+    double dx, dy;
+    int gridx, gridy;
+    DPOINT dp;
+
+    gateginfo = g->gatetype;
+
+    for (i = 0; i < gateginfo->nodes; i++) {
+	if (!strcasecmp(gateginfo->node[i], pinname)) {
+	    node->taps = (DPOINT)NULL;
+	    node->extend = (DPOINT)NULL;
+
+	    for (drect = g->taps[i]; drect; drect = drect->next) {
+
+		// Add all routing gridpoints that fall inside
+		// the rectangle.  Much to do here:
+		// (1) routable area should extend 1/2 route width
+		// to each side, as spacing to obstructions allows.
+		// (2) terminals that are wide enough to route to
+		// but not centered on gridpoints should be marked
+		// in some way, and handled appropriately.
+
+		gridx = (int)((drect->x1 - Xlowerbound) / PitchX) - 1;
+
+		if (gridx < 0) gridx = 0;
+		while (1) {
+		    if (gridx >= NumChannelsX) break;
+		    dx = (gridx * PitchX) + Xlowerbound;
+		    if (dx > drect->x2 + home[drect->layer] - EPS) break;
+		    if (dx < drect->x1 - home[drect->layer] + EPS) {
+			gridx++;
+			continue;
+		    }
+		    gridy = (int)((drect->y1 - Ylowerbound) / PitchY) - 1;
+
+		    if (gridy < 0) gridy = 0;
+		    while (1) {
+			if (gridy >= NumChannelsY) break;
+			dy = (gridy * PitchY) + Ylowerbound;
+			if (dy > drect->y2 + home[drect->layer] - EPS) break;
+			if (dy < drect->y1 - home[drect->layer] + EPS) {
+			    gridy++;
+			    continue;
+			}
+
+			// Routing grid point is an interior point
+			// of a gate port.  Record the position
+
+			dp = (DPOINT)mem_malloc(MEM_TAPS,
+				    sizeof(struct dpoint_));
+			dp->layer = drect->layer;
+			dp->x = dx;
+			dp->y = dy;
+			dp->gridx = gridx;
+			dp->gridy = gridy;
+
+			if ((dy >= drect->y1 - EPS) &&
+				    (dx >= drect->x1 - EPS) &&
+				    (dy <= drect->y2 + EPS) &&
+				    (dx <= drect->x2 + EPS)) {
+			    dp->next = node->taps;
+			    node->taps = dp;
+			}
+			else {
+			    dp->next = node->extend;
+			    node->extend = dp;
+			}
+			gridy++;
+		    }
+		    gridx++;
+		}
+	    }
+	    return i;
+	}
+    }
+    return -1;
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * DefLinkGatePin ---
+ *
+ *	Connect "node", which is pin "i" of gate instance "g",
+ *	to net "net".
+ *
+ *------------------------------------------------------------
+ */
+
+static void
+DefLinkGatePin(NET net, NODE node, GATE g, int i)
+{
+    node->netnum = net->netnum;
+    g->netnum[i] = net->netnum;
+    g->noderec[i] = node;
+    node->gate = g;
+    node->gateidx = i;
+    node->netname = net->netname;
+    node->next = net->netnodes;
+    net->netnodes = node;
+}
+
 /*
  *------------------------------------------------------------
  *
@@ -613,97 +677,208 @@ static void
 DefReadGatePin(NET net, NODE node, char *instname, char *pinname, double *home)
 {
     int i;
-    GATE gateginfo;
-    DSEG drect;
     GATE g;
-    double dx, dy;
-    int gridx, gridy;
-    DPOINT dp;
 
     g = DefFindGate(instname);
     if (g) {
-
-	gateginfo = g->gatetype;
-
-	if (!gateginfo) {
+	if (!g->gatetype) {
 	    LefError(DEF_ERROR, "Endpoint %s/%s of net %s not found\n",
 				instname, pinname, net->netname);
 	    return;
 	}
-	for (i = 0; i < gateginfo->nodes; i++) {
-	    if (!strcasecmp(gateginfo->node[i], pinname)) {
-		node->taps = (DPOINT)NULL;
-		node->extend = (DPOINT)NULL;
+	i = DefGatePinTaps(g, node, pinname, home);
+	if (i >= 0) DefLinkGatePin(net, node, g, i);
+    }
+}
 
-		for (drect = g->taps[i]; drect; drect = drect->next) {
+/*
+ *------------------------------------------------------------
+ *
+ * DefNewNet --
+ *
+ *	Create a record for the net named "netname", add it to
+ *	Nlnets and the net hash table, and give it the next
+ *	net number from "netidx" (unless it is the power or
+ *	ground net).
+ *
+ *------------------------------------------------------------
+ */
 
-		    // Add all routing gridpoints that fall inside
-		    // the rectangle.  Much to do here:
-		    // (1) routable area should extend 1/2 route width
-		    // to each side, as spacing to obstructions allows.
-		    // (2) terminals that are wide enough to route to
-		    // but not centered on gridpoints should be marked
-		    // in some way, and handled appropriately.
+static NET
+DefNewNet(char *netname, int *netidx)
+{
+    NET net;
 
-		    gridx = (int)((drect->x1 - Xlowerbound) / PitchX) - 1;
+    net = (NET)malloc(sizeof(struct net_));
+    Nlnets[Numnets++] = net;
+    net->netorder = 0;
+    net->numnodes = 0;
+    net->flags = 0;
+    net->netname = strdup(netname);
+    net->netnodes = (NODE)NULL;
+    net->noripup = (NETLIST)NULL;
+    net->routes = (ROUTE)NULL;
+    net->defpos[0] = net->defpos[1] = -1;
+    net->deflen[0] = net->deflen[1] = 0;
+    net->rc = NULL;
+    net->xmin = net->ymin = 0;
+    net->xmax = net->ymax = 0;
+
+    // Net numbers start at MIN_NET_NUMBER for regular nets,
+    // use VDD_NET and GND_NET for power and ground, and 0
+    // is not a valid net number.
+
+    if (vddnet && !strcmp(netname, vddnet))
+       net->netnum = VDD_NET;
+    else if (gndnet && !strcmp(netname, gndnet))
+       net->netnum = GND_NET;
+    else
+       net->netnum = (*netidx)++;
+    DefHashNet(net);
+    return net;
+}
 
-		    if (gridx < 0) gridx = 0;
-		    while (1) {
-			if (gridx >= NumChannelsX) break;
-			dx = (gridx * PitchX) + Xlowerbound;
-			if (dx > drect->x2 + home[drect->layer] - EPS) break;
-			if (dx < drect->x1 - home[drect->layer] + EPS) {
-			    gridx++;
-			    continue;
-			}
-			gridy = (int)((drect->y1 - Ylowerbound) / PitchY) - 1;
-
-			if (gridy < 0) gridy = 0;
-			while (1) {
-			    if (gridy >= NumChannelsY) break;
-			    dy = (gridy * PitchY) + Ylowerbound;
-			    if (dy > drect->y2 + home[drect->layer] - EPS) break;
-			    if (dy < drect->y1 - home[drect->layer] + EPS) {
-				gridy++;
-				continue;
-			    }
+/*
+ *------------------------------------------------------------
+ *
+ * DefReadNet --
+ *
+ *	Read one entry of a NETS or SPECIALNETS section, after
+ *	the "-" that starts it, up to and including the ";"
+ *	that ends it.
+ *
+ * Side Effects:
+ *	The net is created if it does not already exist, and
+ *	its connections and routes are added to it.  "netidx"
+ *	is advanced for a new net, and "fixed" for a fixed net.
+ *
+ *------------------------------------------------------------
+ */
 
-			    // Routing grid point is an interior point
-			    // of a gate port.  Record the position
-
-			    dp = (DPOINT)malloc(sizeof(struct dpoint_));
-			    dp->layer = drect->layer;
-			    dp->x = dx;
-			    dp->y = dy;
-			    dp->gridx = gridx;
-			    dp->gridy = gridy;
-
-			    if ((dy >= drect->y1 - EPS) &&
-					(dx >= drect->x1 - EPS) &&
-					(dy <= drect->y2 + EPS) &&
-					(dx <= drect->x2 + EPS)) {
-				dp->next = node->taps;
-				node->taps = dp;
-			    }
-			    else {
-				dp->next = node->extend;
-				node->extend = dp;
-			    }
-			    gridy++;
-			}
-			gridx++;
-		    }
+enum def_net_keys {DEF_NET_START = 0, DEF_NET_END};
+enum def_netprop_keys {
+	DEF_NETPROP_USE = 0, DEF_NETPROP_ROUTED, DEF_NETPROP_FIXED,
+	DEF_NETPROP_COVER, DEF_NETPROP_SHAPE, DEF_NETPROP_SOURCE,
+	DEF_NETPROP_WEIGHT, DEF_NETPROP_PROPERTY};
+
+static char *net_property_keys[] = {
+    "USE",
+    "ROUTED",
+    "FIXED",
+    "COVER",
+    "SHAPE",
+    "SOURCE",
+    "WEIGHT",
+    "PROPERTY",
+    NULL
+};
+
+static void
+DefReadNet(FILE *f, float oscale, char special, double *home,
+		int *netidx, int *fixed)
+{
+    char *token;
+    int subkey;
+    int nodeidx;
+    char instname[MAX_NAME_LEN], pinname[MAX_NAME_LEN];
+    u_char is_new;
+    NET net;
+    NODE node;
+
+    /* Get net name */
+    token = LefNextToken(f, TRUE);
+    net = DefFindNet(token);
+
+    if (net == NULL) {
+	net = DefNewNet(token, netidx);
+	nodeidx = 0;
+	is_new = TRUE;
+    }
+    else {
+	nodeidx = net->numnodes;
+	is_new = FALSE;
+    }
+
+    /* Get next token;  will be '(' if this is a netlist	*/
+    token = LefNextToken(f, TRUE);
+
+    /* Process all properties */
+    while (token && (*token != ';'))
+    {
+	/* Find connections for the net */
+	if (*token == '(')
+	{
+	    token = LefNextToken(f, TRUE);  /* get pin or gate */
+	    strcpy(instname, token);
+	    token = LefNextToken(f, TRUE);	/* get node name */
+
+	    if (!strcasecmp(instname, "pin")) {
+		strcpy(instname, token);
+		strcpy(pinname, "pin");
+	    }
+	    else
+		strcpy(pinname, token);
+
+	    node = (NODE)calloc(1, sizeof(struct node_));
+	    node->nodenum = nodeidx++;
+	    DefReadGatePin(net, node, instname, pinname, home);
+
+	    token = LefNextToken(f, TRUE);	/* should be ')' */
+
+	    continue;
+	}
+	else if (*token != '+')
+	{
+	    token = LefNextToken(f, TRUE);	/* Not a property */
+	    continue;	/* Ignore it, whatever it is */
+	}
+	else
+	    token = LefNextToken(f, TRUE);
+
+	subkey = Lookup(token, net_property_keys);
+	if (subkey < 0)
+	{
+	    LefError(DEF_WARNING, "Unknown net property \"%s\" in "
+			"NET definition; ignoring.\n", token);
+	    continue;
+	}
+	switch (subkey)
+	{
+	    case DEF_NETPROP_USE:
+		/* Presently, we ignore this */
+		break;
+	    case DEF_NETPROP_SHAPE:
+		/* Ignore this too, along with the next keyword */
+		token = LefNextToken(f, TRUE);
+		break;
+	    case DEF_NETPROP_FIXED:
+	    case DEF_NETPROP_COVER:
+		/* Read in fixed nets like regular nets but mark
+		 * them as NET_IGNORED.  HOWEVER, if the net
+		 * already exists and is not marked NET_IGNORED,
+		 * then don't force it to be ignored.  That is
+		 * particularly an issue for a net like power or
+		 * ground, which may need to be routed like a
+		 * regular net but also has fixed portions. */
+		if (is_new) {
+		    net->flags |= NET_IGNORED;
+		    (*fixed)++;
+		}
+		// fall through
+	    case DEF_NETPROP_ROUTED:
+		// Read in the route;  qrouter now takes
+		// responsibility for this route.
+		while (token && (*token != ';'))
+		    token = DefAddRoutes(f, oscale, net, special);
+		// Treat power and ground nets in specialnets as fixed 
+		if ((subkey == DEF_NETPROP_ROUTED ||
+			subkey == DEF_NETPROP_FIXED) &&
+			special == (char)1) {
+		    if (net->netnum == VDD_NET || net->netnum == GND_NET)
+			(*fixed)++;
 		}
-		node->netnum = net->netnum;
-		g->netnum[i] = net->netnum;
-		g->noderec[i] = node;
-		node->netname = net->netname;
-		node->next = net->netnodes;
-		net->netnodes = node;
 		break;
-	    }
 	}
-	if (i < gateginfo->nodes) return;
     }
 }
 
@@ -728,22 +903,13 @@ DefReadGatePin(NET net, NODE node, char *instname, char *pinname, double *home)
  *------------------------------------------------------------
  */
 
-enum def_net_keys {DEF_NET_START = 0, DEF_NET_END};
-enum def_netprop_keys {
-	DEF_NETPROP_USE = 0, DEF_NETPROP_ROUTED, DEF_NETPROP_FIXED,
-	DEF_NETPROP_COVER, DEF_NETPROP_SHAPE, DEF_NETPROP_SOURCE,
-	DEF_NETPROP_WEIGHT, DEF_NETPROP_PROPERTY};
-
 static int
 DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 {
     char *token;
-    int keyword, subkey;
+    int keyword;
     int i, processed = 0;
-    int nodeidx;
     int fixed = 0;
-    char instname[MAX_NAME_LEN], pinname[MAX_NAME_LEN];
-    u_char is_new;
 
     NET net;
     int netidx;
@@ -756,18 +922,6 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 	NULL
     };
 
-    static char *net_property_keys[] = {
-	"USE",
-	"ROUTED",
-	"FIXED",
-	"COVER",
-	"SHAPE",
-	"SOURCE",
-	"WEIGHT",
-	"PROPERTY",
-	NULL
-    };
-
     /* Set pitches and allocate memory for Obs[] if we haven't yet. */
     set_num_channels();
 
@@ -777,13 +931,6 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 	netidx = MIN_NET_NUMBER;
 	Nlnets = (NET *)malloc(total * sizeof(NET));
 	for (i = 0; i < total; i++) Nlnets[i] = NULL;
-
-	// Compute distance for keepout halo for each route layer
-	// NOTE:  This must match the definition for the keepout halo
-	// used in nodes.c!
-	for (i = 0; i < Num_layers; i++) {
-	    home[i] = LefGetViaWidth(i, i, 0) / 2.0 + LefGetRouteSpacing(i);
-	}
     }
     else {
 	netidx = Numnets;
@@ -791,6 +938,19 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 	for (i = Numnets; i < (Numnets + total); i++) Nlnets[i] = NULL;
     }
 
+    // Compute distance for keepout halo for each route layer
+    // NOTE:  This must match the definition for the keepout halo
+    // used in nodes.c!
+    for (i = 0; i < Num_layers; i++) {
+	home[i] = LefGetViaWidth(i, i, 0) / 2.0 + LefGetRouteSpacing(i);
+    }
+
+#ifdef HAVE_PTHREAD_H
+    /* Regular nets without routes can be read on worker threads */
+    if (special == FALSE)
+	processed = DefReadNetsParallel(f, oscale, total, home, &netidx, &fixed);
+#endif
+
     while ((token = LefNextToken(f, TRUE)) != NULL)
     {
 	keyword = Lookup(token, net_keys);
@@ -806,129 +966,11 @@ DefReadNets(FILE *f, char *sname, float oscale, char special, int total)
 	{
 	    case DEF_NET_START:
 
-		/* Get net name */
-		token = LefNextToken(f, TRUE);
-		net = DefFindNet(token);
-
-		if (net == NULL) {
-		    net = (NET)malloc(sizeof(struct net_));
-		    Nlnets[Numnets++] = net;
-		    net->netorder = 0;
-		    net->numnodes = 0;
-		    net->flags = 0;
-		    net->netname = strdup(token);
-		    net->netnodes = (NODE)NULL;
-		    net->noripup = (NETLIST)NULL;
-		    net->routes = (ROUTE)NULL;
-		    net->xmin = net->ymin = 0;
-		    net->xmax = net->ymax = 0;
-
-		    // Net numbers start at MIN_NET_NUMBER for regular nets,
-		    // use VDD_NET and GND_NET for power and ground, and 0
-		    // is not a valid net number.
-
-		    if (vddnet && !strcmp(token, vddnet))
-		       net->netnum = VDD_NET;
-		    else if (gndnet && !strcmp(token, gndnet))
-		       net->netnum = GND_NET;
-		    else
-		       net->netnum = netidx++;
-		    DefHashNet(net);
-
-		    nodeidx = 0;
-		    is_new = TRUE;
-		}
-		else {
-		    nodeidx = net->numnodes;
-		    is_new = FALSE;
-		}
-
 		/* Update the record of the number of nets processed	*/
 		/* and spit out a message for every 5% finished.	*/
 
 		processed++;
-
-		/* Get next token;  will be '(' if this is a netlist	*/
-		token = LefNextToken(f, TRUE);
-
-		/* Process all properties */
-		while (token && (*token != ';'))
-		{
-		    /* Find connections for the net */
-		    if (*token == '(')
-		    {
-			token = LefNextToken(f, TRUE);  /* get pin or gate */
-			strcpy(instname, token);
-			token = LefNextToken(f, TRUE);	/* get node name */
-
-			if (!strcasecmp(instname, "pin")) {
-			    strcpy(instname, token);
-			    strcpy(pinname, "pin");
-			}
-			else
-			    strcpy(pinname, token);
-
-			node = (NODE)calloc(1, sizeof(struct node_));
-			node->nodenum = nodeidx++;
-			DefReadGatePin(net, node, instname, pinname, home);
-
-			token = LefNextToken(f, TRUE);	/* should be ')' */
-
-			continue;
-		    }
-		    else if (*token != '+')
-		    {
-			token = LefNextToken(f, TRUE);	/* Not a property */
-			continue;	/* Ignore it, whatever it is */
-		    }
-		    else
-			token = LefNextToken(f, TRUE);
-
-		    subkey = Lookup(token, net_property_keys);
-		    if (subkey < 0)
-		    {
-			LefError(DEF_WARNING, "Unknown net property \"%s\" in "
-				"NET definition; ignoring.\n", token);
-			continue;
-		    }
-		    switch (subkey)
-		    {
-			case DEF_NETPROP_USE:
-			    /* Presently, we ignore this */
-			    break;
-			case DEF_NETPROP_SHAPE:
-			    /* Ignore this too, along with the next keyword */
-			    token = LefNextToken(f, TRUE);
-			    break;
-			case DEF_NETPROP_FIXED:
-			case DEF_NETPROP_COVER:
-			    /* Read in fixed nets like regular nets but mark
-			     * them as NET_IGNORED.  HOWEVER, if the net
-			     * already exists and is not marked NET_IGNORED,
-			     * then don't force it to be ignored.  That is
-			     * particularly an issue for a net like power or
-			     * ground, which may need to be routed like a
-			     * regular net but also has fixed portions. */
-			    if (is_new) {
-				net->flags |= NET_IGNORED;
-				fixed++;
-			    }
-			    // fall through
-			case DEF_NETPROP_ROUTED:
-			    // Read in the route;  qrouter now takes
-			    // responsibility for this route.
-			    while (token && (*token != ';'))
-			        token = DefAddRoutes(f, oscale, net, special);
-			    // Treat power and ground nets in specialnets as fixed 
-			    if ((subkey == DEF_NETPROP_ROUTED ||
-				    subkey == DEF_NETPROP_FIXED) &&
-				    special == (char)1) {
-				if (net->netnum == VDD_NET || net->netnum == GND_NET)
-				    fixed++;
-			    }
-			    break;
-		    }
-		}
+		DefReadNet(f, oscale, special, home, &netidx, &fixed);
 		break;
 
 	    case DEF_NET_END:
@@ -1278,7 +1320,7 @@ DefReadPins(FILE *f, char *sname, float oscale, int total)
 		    gate->next = Nlgates;
 		    Nlgates = gate;
 
-		    // Used by Tcl version of qrouter
+		    // Add to the instance hash table
 		    DefHashInstance(gate);
 		}
 		else {
@@ -1579,16 +1621,15 @@ DefReadBlockages(FILE *f, char *sname, float oscale, int total)
 /*
  *------------------------------------------------------------
  *
- * DefReadComponents --
+ * DefReadComponent --
  *
- *	Read a COMPONENTS section from a DEF file.
+ *	Read one entry of the COMPONENTS section, after the "-"
+ *	that starts it, up to and including the ";" that ends it.
  *
  * Results:
- *	0 on success, 1 on fatal error.
- *
- * Side Effects:
- *	Many.  Cell instances are created and added to
- *	the database.
+ *	A new gate instance record, or NULL if the entry could
+ *	not be read.  The record is not yet added to Nlgates.
+ *	"err_fatal" is incremented for each fatal error.
  *
  *------------------------------------------------------------
  */
@@ -1601,25 +1642,16 @@ enum def_prop_keys {
 	DEF_PROP_REGION, DEF_PROP_GENERATE, DEF_PROP_PROPERTY,
 	DEF_PROP_EEQMASTER};
 
-static int
-DefReadComponents(FILE *f, char *sname, float oscale, int total)
+static GATE
+DefReadComponent(FILE *f, float oscale, int *err_fatal)
 {
     GATE gateginfo;
     GATE gate = NULL;
     char *token;
     char usename[512];
-    int keyword, subkey, i;
-    int processed = 0;
-    char OK;
+    int subkey, i;
     DSEG drect, newrect;
     double tmp;
-    int err_fatal = 0;
-
-    static char *component_keys[] = {
-	"-",
-	"END",
-	NULL
-    };
 
     static char *property_keys[] = {
 	"FIXED",
@@ -1636,255 +1668,762 @@ DefReadComponents(FILE *f, char *sname, float oscale, int total)
 	NULL
     };
 
+    /* Get use and macro names */
+    token = LefNextToken(f, TRUE);
+    if (sscanf(token, "%511s", usename) != 1)
+    {
+	LefError(DEF_ERROR, "Bad component statement:  Need use "
+		    "and macro names\n");
+	LefEndStatement(f);
+	(*err_fatal)++;
+	return NULL;
+    }
+    token = LefNextToken(f, TRUE);
+
+    /* Find the corresponding macro */
+    gateginfo = lefFindCell(token);
+    if (gateginfo == NULL) {
+	LefError(DEF_ERROR, "Could not find a macro definition for \"%s\"\n",
+		    token);
+	gate = NULL;
+	(*err_fatal)++;
+    }
+    else {
+	gate = (GATE)malloc(sizeof(struct gate_));
+	gate->gatename = strdup(usename);
+	gate->gatetype = gateginfo;
+    }
+
+    /* Now do a search through the line for "+" entries     */
+    /* And process each.                                    */
+
     while ((token = LefNextToken(f, TRUE)) != NULL)
     {
-	keyword = Lookup(token, component_keys);
+	if (*token == ';') break;
+	if (*token != '+') continue;
 
-	if (keyword < 0)
+	token = LefNextToken(f, TRUE);
+	subkey = Lookup(token, property_keys);
+	if (subkey < 0)
 	{
-	    LefError(DEF_WARNING, "Unknown keyword \"%s\" in COMPONENT "
-			"definition; ignoring.\n", token);
-	    LefEndStatement(f);
+	    LefError(DEF_WARNING, "Unknown component property \"%s\" in "
+		    "COMPONENT definition; ignoring.\n", token);
 	    continue;
 	}
-	switch (keyword)
+	switch (subkey)
 	{
-	    case DEF_COMP_START:		/* "-" keyword */
+	    case DEF_PROP_PLACED:
+	    case DEF_PROP_UNPLACED:
+	    case DEF_PROP_FIXED:
+	    case DEF_PROP_COVER:
+		DefReadLocation(gate, f, oscale);
+		break;
+	    case DEF_PROP_SOURCE:
+	    case DEF_PROP_WEIGHT:
+	    case DEF_PROP_FOREIGN:
+	    case DEF_PROP_REGION:
+	    case DEF_PROP_GENERATE:
+	    case DEF_PROP_PROPERTY:
+	    case DEF_PROP_EEQMASTER:
+		token = LefNextToken(f, TRUE);
+		break;
+	}
+    }
 
-		/* Update the record of the number of components	*/
-		/* processed and spit out a message for every 5% done.	*/
- 
-		processed++;
+    if (gate != NULL)
+    {
+	/* Process the gate */
+	gate->width = gateginfo->width;   
+	gate->height = gateginfo->height;   
+	gate->nodes = gateginfo->nodes;   
+	gate->obs = (DSEG)NULL;
+
+	gate->taps = (DSEG *)malloc(gate->nodes * sizeof(DSEG));
+	gate->noderec = (NODE *)malloc(gate->nodes * sizeof(NODE));
+	gate->direction = (u_char *)malloc(gate->nodes * sizeof(u_char));
+	gate->area = (float *)malloc(gate->nodes * sizeof(float));
+	gate->netnum = (int *)malloc(gate->nodes * sizeof(int));
+	gate->node = (char **)malloc(gate->nodes * sizeof(char *));
+
+	for (i = 0; i < gate->nodes; i++) {
+	    /* Let the node names point to the master cell; */
+	    /* this is just diagnostic;  allows us, for     */
+	    /* instance, to identify vdd and gnd nodes, so  */
+	    /* we don't complain about them being           */
+	    /* disconnected.                                */
+
+	    gate->node[i] = gateginfo->node[i];  /* copy pointer */
+	    gate->direction[i] = gateginfo->direction[i];  /* copy */
+	    gate->area[i] = gateginfo->area[i];
+	    gate->taps[i] = (DSEG)NULL;
+
+	    /* Global power/ground bus check */
+	    if (vddnet && gate->node[i] &&
+			    !strcmp(gate->node[i], vddnet)) {
+	       /* Create a placeholder node with no taps */
+	       gate->netnum[i] = VDD_NET;
+	       gate->noderec[i] = (NODE)calloc(1, sizeof(struct node_));
+	       gate->noderec[i]->netnum = VDD_NET;
+	       gate->noderec[i]->gate = gate;
+	       gate->noderec[i]->gateidx = i;
+	    }
+	    else if (gndnet && gate->node[i] &&
+			    !strcmp(gate->node[i], gndnet)) {
+	       /* Create a placeholder node with no taps */
+	       gate->netnum[i] = GND_NET;
+	       gate->noderec[i] = (NODE)calloc(1, sizeof(struct node_));
+	       gate->noderec[i]->netnum = GND_NET;
+	       gate->noderec[i]->gate = gate;
+	       gate->noderec[i]->gateidx = i;
+	    }
+	    else {
+	       gate->netnum[i] = 0;         /* Until we read NETS */
+	       gate->noderec[i] = NULL;
+	    }
 
-		/* Get use and macro names */
-		token = LefNextToken(f, TRUE);
-		if (sscanf(token, "%511s", usename) != 1)
-		{
-		    LefError(DEF_ERROR, "Bad component statement:  Need use "
-				"and macro names\n");
-		    LefEndStatement(f);
-		    err_fatal++;
-		    break;
+	    /* Make a copy of the gate nodes and adjust for */
+	    /* instance position and number of layers       */
+
+	    for (drect = gateginfo->taps[i]; drect; drect = drect->next) {
+		if (drect->layer < Num_layers) {
+		    newrect = (DSEG)malloc(sizeof(struct dseg_));
+		    *newrect = *drect;
+		    newrect->next = gate->taps[i];
+		    gate->taps[i] = newrect;
 		}
-		token = LefNextToken(f, TRUE);
+	    }
 
-		/* Find the corresponding macro */
-		OK = 0;
-		for (gateginfo = GateInfo; gateginfo; gateginfo = gateginfo->next) {
-		    if (!strcasecmp(gateginfo->gatename, token)) {
-			OK = 1;
-			break;
-		    }
+	    for (drect = gate->taps[i]; drect; drect = drect->next) {
+		// handle offset from gate origin
+		drect->x1 -= gateginfo->placedX;
+		drect->x2 -= gateginfo->placedX;
+		drect->y1 -= gateginfo->placedY;
+		drect->y2 -= gateginfo->placedY;
+
+		// handle rotations and orientations here
+		if (gate->orient & R90) {
+		    tmp = drect->y1;
+		    drect->y1 = -drect->x1;
+		    drect->y1 += gateginfo->width;
+		    drect->x1 = tmp;
+
+		    tmp = drect->y2;
+		    drect->y2 = -drect->x2;
+		    drect->y2 += gateginfo->width;
+		    drect->x2 = tmp;
 		}
-		if (!OK) {
-		    LefError(DEF_ERROR, "Could not find a macro definition for \"%s\"\n",
-				token);
-		    gate = NULL;
-		    err_fatal++;
+
+		if (gate->orient & MX) {
+		    tmp = drect->x1;
+		    drect->x1 = -drect->x2;
+		    drect->x1 += gate->placedX + gateginfo->width;
+		    drect->x2 = -tmp;
+		    drect->x2 += gate->placedX + gateginfo->width;
 		}
 		else {
-		    gate = (GATE)malloc(sizeof(struct gate_));
-		    gate->gatename = strdup(usename);
-		    gate->gatetype = gateginfo;
+		    drect->x1 += gate->placedX;
+		    drect->x2 += gate->placedX;
 		}
-		
-		/* Now do a search through the line for "+" entries	*/
-		/* And process each.					*/
+		if (gate->orient & MY) {
+		    tmp = drect->y1;
+		    drect->y1 = -drect->y2;
+		    drect->y1 += gate->placedY + gateginfo->height;
+		    drect->y2 = -tmp;
+		    drect->y2 += gate->placedY + gateginfo->height;
+		}
+		else {
+		    drect->y1 += gate->placedY;
+		    drect->y2 += gate->placedY;
+		}
+	    }
+	}
 
-		while ((token = LefNextToken(f, TRUE)) != NULL)
-		{
-		    if (*token == ';') break;
-		    if (*token != '+') continue;
+	/* Make a copy of the gate obstructions and adjust  */
+	/* for instance position                            */
+	for (drect = gateginfo->obs; drect; drect = drect->next) {
+	    if (drect->layer < Num_layers) {
+		newrect = (DSEG)malloc(sizeof(struct dseg_));
+		*newrect = *drect;
+		newrect->next = gate->obs;
+		gate->obs = newrect;
+	    }
+	}
 
-		    token = LefNextToken(f, TRUE);
-		    subkey = Lookup(token, property_keys);
-		    if (subkey < 0)
-		    {
-			LefError(DEF_WARNING, "Unknown component property \"%s\" in "
-				"COMPONENT definition; ignoring.\n", token);
-			continue;
-		    }
-		    switch (subkey)
-		    {
-			case DEF_PROP_PLACED:
-			case DEF_PROP_UNPLACED:
-			case DEF_PROP_FIXED:
-			case DEF_PROP_COVER:
-			    DefReadLocation(gate, f, oscale);
-			    break;
-			case DEF_PROP_SOURCE:
-			case DEF_PROP_WEIGHT:
-			case DEF_PROP_FOREIGN:
-			case DEF_PROP_REGION:
-			case DEF_PROP_GENERATE:
-			case DEF_PROP_PROPERTY:
-			case DEF_PROP_EEQMASTER:
-			    token = LefNextToken(f, TRUE);
-			    break;
-		    }
+	for (drect = gate->obs; drect; drect = drect->next) {
+	    drect->x1 -= gateginfo->placedX;
+	    drect->x2 -= gateginfo->placedX;
+	    drect->y1 -= gateginfo->placedY;
+	    drect->y2 -= gateginfo->placedY;
+
+	    // handle rotations and orientations here
+	    if (gate->orient & R90) {
+		tmp = drect->y1;
+		drect->y1 = -drect->x1;
+		drect->y1 += gateginfo->width;
+		drect->x1 = tmp;
+
+		tmp = drect->y2;
+		drect->y2 = -drect->x2;
+		drect->y2 += gateginfo->width;
+		drect->x2 = tmp;
+	    }
+
+	    if (gate->orient & MX) {
+		tmp = drect->x1;
+		drect->x1 = -drect->x2;
+		drect->x1 += gate->placedX + gateginfo->width;
+		drect->x2 = -tmp;
+		drect->x2 += gate->placedX + gateginfo->width;
+	    }
+	    else {
+		drect->x1 += gate->placedX;
+		drect->x2 += gate->placedX;
+	    }
+	    if (gate->orient & MY) {
+		tmp = drect->y1;
+		drect->y1 = -drect->y2;
+		drect->y1 += gate->placedY + gateginfo->height;
+		drect->y2 = -tmp;
+		drect->y2 += gate->placedY + gateginfo->height;
+	    }
+	    else {
+		drect->y1 += gate->placedY;
+		drect->y2 += gate->placedY;
+	    }
+	}
+    }
+    return gate;
+}
+
+#ifdef HAVE_PTHREAD_H
+
+/*
+ *------------------------------------------------------------
+ * Parallel reading of COMPONENTS and NETS
+ *
+ *	When the DEF file is memory-mapped, the entries of these
+ *	sections are read in batches.  The main thread finds where
+ *	each entry starts;  worker threads parse the entries into
+ *	records that are not yet part of the database;  and the
+ *	main thread then adds the records to the database in file
+ *	order, so that the result is the same as reading the file
+ *	serially.  An entry that raises an error or warning, or
+ *	that needs something only the main thread can do (a net
+ *	with routes, or a net that already exists), is read again
+ *	by the serial code in the main thread, which also prints
+ *	any messages in order.
+ *------------------------------------------------------------
+ */
+
+#define DEF_BATCH_SIZE	65536	/* Maximum entries in one batch	  */
+#define DEF_THREAD_MIN	1024	/* Minimum entries per thread	  */
+
+typedef struct defbatch_ DefBatch;
+
+struct defbatch_ {
+    FILE   *f;
+    float   oscale;
+    double *home;			/* Keepout halo by layer (NETS) */
+    int     count;			/* Number of entries in batch	*/
+    void *(*parse)(DefBatch *, int);	/* Parse entry on a worker	*/
+    LefMark mark[DEF_BATCH_SIZE + 1];	/* Start of each entry, and end */
+    void   *result[DEF_BATCH_SIZE];	/* Record made by a worker	*/
+    u_char  redo[DEF_BATCH_SIZE];	/* Entry must be read serially	*/
+};
+
+typedef struct {
+    DefBatch *batch;
+    int first;			/* First entry for this thread	*/
+    int last;			/* One past the last entry	*/
+} DefSlice;
+
+/* Return TRUE if the read position of "f" is at "mark" */
+
+static u_char
+DefAtMark(FILE *f, LefMark *mark)
+{
+    LefMark here;
+
+    LefGetMark(f, &here);
+    return ((here.pos == mark->pos) && (here.next == mark->next));
+}
+
+/*--------------------------------------------------------------*/
+/* Find the start of each entry of the section, from the	*/
+/* current position, up to the END statement or DEF_BATCH_SIZE	*/
+/* entries.  Entries start with "-" and end with ";".  Anything	*/
+/* else at the start of an entry ends the batch and is left to	*/
+/* the serial reader.  The read position is left at the end of	*/
+/* the batch.  Returns the number of entries found.		*/
+/*--------------------------------------------------------------*/
+
+static int
+DefScanEntries(DefBatch *b)
+{
+    LefMark m;
+    char *token;
+    int len, n = 0;
+    u_char atstart = TRUE;
+
+    for (;;) {
+	LefGetMark(b->f, &m);
+	token = LefNextTokenView(b->f, TRUE, &len);
+	if (token == NULL) break;
+	if (atstart) {
+	    if ((len != 1) || (*token != '-') || (n == DEF_BATCH_SIZE)) break;
+	    b->mark[n++] = m;
+	    atstart = FALSE;
+	}
+	else if (*token == ';')
+	    atstart = TRUE;
+    }
+
+    /* An entry cut off by the end of the file is read serially */
+    if (!atstart) m = b->mark[--n];
+
+    b->mark[n] = m;
+    LefSetMark(b->f, &m);
+    b->count = n;
+    return n;
+}
+
+/*--------------------------------------------------------------*/
+/* Worker thread:  parse a range of entries of the batch.	*/
+/*--------------------------------------------------------------*/
+
+static void *
+DefBatchWorker(void *arg)
+{
+    DefSlice *slice = (DefSlice *)arg;
+    DefBatch *b = slice->batch;
+    int r;
+
+    LefWorkerBegin();
+    for (r = slice->first; r < slice->last; r++) {
+	LefSetMark(b->f, &b->mark[r]);
+	LefNextToken(b->f, TRUE);		/* "-" */
+	b->redo[r] = FALSE;
+	b->result[r] = (*b->parse)(b, r);
+	if (LefWorkerErrors() > 0) b->redo[r] = TRUE;
+
+	/* The entry must end where the next one starts */
+	if (!DefAtMark(b->f, &b->mark[r + 1])) b->redo[r] = TRUE;
+    }
+    LefWorkerEnd();
+    return NULL;
+}
+
+/*--------------------------------------------------------------*/
+/* Parse all entries of a batch, dividing them among up to	*/
+/* "nthreads" threads.  If a thread cannot be started, its	*/
+/* share is parsed in the main thread.				*/
+/*--------------------------------------------------------------*/
+
+static void
+DefRunBatch(DefBatch *b, int nthreads)
+{
+    pthread_t *thread;
+    DefSlice *slice;
+    u_char *started;
+    int t;
+
+    if (nthreads > b->count / DEF_THREAD_MIN)
+	nthreads = b->count / DEF_THREAD_MIN;
+    if (nthreads < 1) nthreads = 1;
+
+    thread = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+    slice = (DefSlice *)malloc(nthreads * sizeof(DefSlice));
+    started = (u_char *)malloc(nthreads * sizeof(u_char));
+
+    for (t = 0; t < nthreads; t++) {
+	slice[t].batch = b;
+	slice[t].first = (int)(((long)b->count * t) / nthreads);
+	slice[t].last = (int)(((long)b->count * (t + 1)) / nthreads);
+	started[t] = (nthreads > 1) && (pthread_create(&thread[t], NULL,
+			DefBatchWorker, (void *)&slice[t]) == 0);
+    }
+    for (t = 0; t < nthreads; t++)
+	if (!started[t]) DefBatchWorker((void *)&slice[t]);
+    for (t = 0; t < nthreads; t++)
+	if (started[t]) pthread_join(thread[t], NULL);
+
+    free(started);
+    free(slice);
+    free(thread);
+}
+
+/*--------------------------------------------------------------*/
+/* COMPONENTS							*/
+/*--------------------------------------------------------------*/
+
+/* Free a gate instance record that was not added to Nlgates */
+
+static void
+DefFreeGate(GATE gate)
+{
+    DSEG drect, dnext;
+    int i;
+
+    if (gate == NULL) return;
+
+    for (i = 0; i < gate->nodes; i++) {
+	for (drect = gate->taps[i]; drect; drect = dnext) {
+	    dnext = drect->next;
+	    free(drect);
+	}
+	if (gate->noderec[i] != NULL) free(gate->noderec[i]);
+    }
+    for (drect = gate->obs; drect; drect = dnext) {
+	dnext = drect->next;
+	free(drect);
+    }
+    free(gate->taps);
+    free(gate->noderec);
+    free(gate->direction);
+    free(gate->area);
+    free(gate->netnum);
+    free(gate->node);
+    free(gate->gatename);
+    free(gate);
+}
+
+static void *
+DefParseComponentEntry(DefBatch *b, int r)
+{
+    int err = 0;
+    GATE gate;
+
+    gate = DefReadComponent(b->f, b->oscale, &err);
+    if (err > 0) b->redo[r] = TRUE;
+    return (void *)gate;
+}
+
+/*--------------------------------------------------------------*/
+/* Read the entries of a COMPONENTS section using worker	*/
+/* threads, stopping at the END statement or at anything that	*/
+/* must be left to the serial reader.  Returns the number of	*/
+/* entries read;  0 if the file is not mapped or the section is	*/
+/* too small to be worth splitting up.				*/
+/*--------------------------------------------------------------*/
+
+static int
+DefReadComponentsParallel(FILE *f, float oscale, int total, int *err_fatal)
+{
+    DefBatch *b;
+    GATE gate;
+    LefMark m;
+    int r, nthreads, processed = 0;
+    u_char done = FALSE;
+
+    nthreads = thread_count();
+    if ((nthreads < 2) || (total < 2 * DEF_THREAD_MIN)) return 0;
+    if (!LefGetMark(f, &m)) return 0;
+
+    b = (DefBatch *)malloc(sizeof(DefBatch));
+    if (b == NULL) return 0;
+    b->f = f;
+    b->oscale = oscale;
+    b->home = NULL;
+    b->parse = DefParseComponentEntry;
+
+    /* Bring the macro hash table up to date before it is shared */
+    lefFindCell(NULL);
+
+    while (!done && (DefScanEntries(b) > 0)) {
+	DefRunBatch(b, nthreads);
+
+	for (r = 0; r < b->count; r++) {
+	    if (done) {
+		DefFreeGate((GATE)b->result[r]);
+		continue;
+	    }
+	    processed++;
+	    if (b->redo[r]) {
+		DefFreeGate((GATE)b->result[r]);
+		LefSetMark(f, &b->mark[r]);
+		LefNextToken(f, TRUE);		/* "-" */
+		gate = DefReadComponent(f, oscale, err_fatal);
+
+		/* If the entry ran past the next one, continue	*/
+		/* serially from wherever it ended.		*/
+		if (!DefAtMark(f, &b->mark[r + 1])) done = TRUE;
+	    }
+	    else
+		gate = (GATE)b->result[r];
+
+	    if (gate != NULL) {
+		gate->next = Nlgates;
+		Nlgates = gate;
+		DefHashInstance(gate);
+	    }
+	}
+	if (!done) LefSetMark(f, &b->mark[b->count]);
+    }
+    free(b);
+    return processed;
+}
+
+/*--------------------------------------------------------------*/
+/* NETS								*/
+/*--------------------------------------------------------------*/
+
+/* A net read by a worker:  its name and the gate pins it	*/
+/* connects to, in file order.					*/
+
+typedef struct {
+    NODE node;
+    GATE gate;
+    int  pin;		/* Index of the pin in the gate */
+} DefNetPin;
+
+typedef struct {
+    char *netname;
+    int npins;
+    int maxpins;
+    DefNetPin *pins;
+} DefNetEntry;
+
+static void
+DefFreeNetEntry(DefNetEntry *entry, u_char freenodes)
+{
+    DPOINT dp, dpnext;
+    int i;
+
+    if (entry == NULL) return;
+
+    if (freenodes) {
+	for (i = 0; i < entry->npins; i++) {
+	    for (dp = entry->pins[i].node->taps; dp; dp = dpnext) {
+		dpnext = dp->next;
+		mem_free(MEM_TAPS, dp, sizeof(struct dpoint_));
+	    }
+	    for (dp = entry->pins[i].node->extend; dp; dp = dpnext) {
+		dpnext = dp->next;
+		mem_free(MEM_TAPS, dp, sizeof(struct dpoint_));
+	    }
+	    free(entry->pins[i].node);
+	}
+    }
+    free(entry->pins);
+    free(entry->netname);
+    free(entry);
+}
+
+/*--------------------------------------------------------------*/
+/* Worker version of DefReadNet().  Finds the taps of each gate	*/
+/* pin of a net, but does not create the net or connect the	*/
+/* pins to it.  Routes are left to the main thread.		*/
+/*--------------------------------------------------------------*/
+
+static void *
+DefParseNetEntry(DefBatch *b, int r)
+{
+    FILE *f = b->f;
+    char *token;
+    char instname[MAX_NAME_LEN], pinname[MAX_NAME_LEN];
+    DefNetEntry *entry;
+    NODE node;
+    GATE g;
+    int i, nodeidx = 0;
+
+    entry = (DefNetEntry *)calloc(1, sizeof(DefNetEntry));
+
+    /* Get net name */
+    token = LefNextToken(f, TRUE);
+    entry->netname = strdup(token);
+
+    token = LefNextToken(f, TRUE);
+    while (token && (*token != ';'))
+    {
+	if (*token == '(')
+	{
+	    token = LefNextToken(f, TRUE);  /* get pin or gate */
+	    strcpy(instname, token);
+	    token = LefNextToken(f, TRUE);	/* get node name */
+
+	    if (!strcasecmp(instname, "pin")) {
+		strcpy(instname, token);
+		strcpy(pinname, "pin");
+	    }
+	    else
+		strcpy(pinname, token);
+
+	    node = (NODE)calloc(1, sizeof(struct node_));
+	    node->nodenum = nodeidx++;
+
+	    g = DefFindGate(instname);
+	    if (g && !g->gatetype) {
+		/* Error to be reported by the main thread */
+		free(node);
+		b->redo[r] = TRUE;
+		return (void *)entry;
+	    }
+	    i = (g) ? DefGatePinTaps(g, node, pinname, b->home) : -1;
+	    if (i >= 0) {
+		if (entry->npins == entry->maxpins) {
+		    entry->maxpins = (entry->maxpins == 0) ? 4 : 2 * entry->maxpins;
+		    entry->pins = (DefNetPin *)realloc(entry->pins,
+				entry->maxpins * sizeof(DefNetPin));
 		}
+		entry->pins[entry->npins].node = node;
+		entry->pins[entry->npins].gate = g;
+		entry->pins[entry->npins].pin = i;
+		entry->npins++;
+	    }
+	    else
+		free(node);
 
-		if (gate != NULL)
-		{
-		    /* Process the gate */
-		    gate->width = gateginfo->width;   
-		    gate->height = gateginfo->height;   
-		    gate->nodes = gateginfo->nodes;   
-		    gate->obs = (DSEG)NULL;
+	    token = LefNextToken(f, TRUE);	/* should be ')' */
+	    continue;
+	}
+	else if (*token != '+')
+	{
+	    token = LefNextToken(f, TRUE);	/* Not a property */
+	    continue;
+	}
+	else
+	    token = LefNextToken(f, TRUE);
 
-                    gate->taps = (DSEG *)malloc(gate->nodes * sizeof(DSEG));
-                    gate->noderec = (NODE *)malloc(gate->nodes * sizeof(NODE));
-                    gate->direction = (u_char *)malloc(gate->nodes * sizeof(u_char));
-                    gate->area = (float *)malloc(gate->nodes * sizeof(float));
-                    gate->netnum = (int *)malloc(gate->nodes * sizeof(int));
-                    gate->node = (char **)malloc(gate->nodes * sizeof(char *));
-
-		    for (i = 0; i < gate->nodes; i++) {
-			/* Let the node names point to the master cell;	*/
-			/* this is just diagnostic;  allows us, for	*/
-			/* instance, to identify vdd and gnd nodes, so	*/
-			/* we don't complain about them being		*/
-			/* disconnected.				*/
-
-			gate->node[i] = gateginfo->node[i];  /* copy pointer */
-			gate->direction[i] = gateginfo->direction[i];  /* copy */
-			gate->area[i] = gateginfo->area[i];
-			gate->taps[i] = (DSEG)NULL;
-
-			/* Global power/ground bus check */
-			if (vddnet && gate->node[i] &&
-					!strcmp(gate->node[i], vddnet)) {
-			   /* Create a placeholder node with no taps */
-			   gate->netnum[i] = VDD_NET;
-			   gate->noderec[i] = (NODE)calloc(1, sizeof(struct node_));
-			   gate->noderec[i]->netnum = VDD_NET;
-			}
-			else if (gndnet && gate->node[i] &&
-					!strcmp(gate->node[i], gndnet)) {
-			   /* Create a placeholder node with no taps */
-			   gate->netnum[i] = GND_NET;
-			   gate->noderec[i] = (NODE)calloc(1, sizeof(struct node_));
-			   gate->noderec[i]->netnum = GND_NET;
-			}
-			else {
-			   gate->netnum[i] = 0;		/* Until we read NETS */
-			   gate->noderec[i] = NULL;
-			}
+	switch (Lookup(token, net_property_keys))
+	{
+	    case DEF_NETPROP_USE:
+	    case DEF_NETPROP_SOURCE:
+	    case DEF_NETPROP_WEIGHT:
+	    case DEF_NETPROP_PROPERTY:
+		break;
+	    case DEF_NETPROP_SHAPE:
+		token = LefNextToken(f, TRUE);
+		break;
+	    default:
+		/* Routes, or an unknown property */
+		b->redo[r] = TRUE;
+		return (void *)entry;
+	}
+    }
+    return (void *)entry;
+}
 
-			/* Make a copy of the gate nodes and adjust for	*/
-			/* instance position and number of layers	*/
+/*--------------------------------------------------------------*/
+/* Read the entries of a NETS section using worker threads.	*/
+/* As DefReadComponentsParallel(), for nets.			*/
+/*--------------------------------------------------------------*/
 
-			for (drect = gateginfo->taps[i]; drect; drect = drect->next) {
-			    if (drect->layer < Num_layers) {
-				newrect = (DSEG)malloc(sizeof(struct dseg_));
-				*newrect = *drect;
-				newrect->next = gate->taps[i];
-				gate->taps[i] = newrect;
-			    }
-			}
+static int
+DefReadNetsParallel(FILE *f, float oscale, int total, double *home,
+		int *netidx, int *fixed)
+{
+    DefBatch *b;
+    DefNetEntry *entry;
+    NET net;
+    LefMark m;
+    int i, r, nthreads, processed = 0;
+    u_char done = FALSE;
+
+    nthreads = thread_count();
+    if ((nthreads < 2) || (total < 2 * DEF_THREAD_MIN)) return 0;
+    if (!LefGetMark(f, &m)) return 0;
+
+    b = (DefBatch *)malloc(sizeof(DefBatch));
+    if (b == NULL) return 0;
+    b->f = f;
+    b->oscale = oscale;
+    b->home = home;
+    b->parse = DefParseNetEntry;
+
+    while (!done && (DefScanEntries(b) > 0)) {
+	DefRunBatch(b, nthreads);
+
+	for (r = 0; r < b->count; r++) {
+	    entry = (DefNetEntry *)b->result[r];
+	    if (done) {
+		DefFreeNetEntry(entry, TRUE);
+		continue;
+	    }
+	    processed++;
+	    if (!b->redo[r] && (DefFindNet(entry->netname) == NULL)) {
+		net = DefNewNet(entry->netname, netidx);
+		for (i = 0; i < entry->npins; i++)
+		    DefLinkGatePin(net, entry->pins[i].node, entry->pins[i].gate,
+				entry->pins[i].pin);
+		DefFreeNetEntry(entry, FALSE);
+	    }
+	    else {
+		DefFreeNetEntry(entry, TRUE);
+		LefSetMark(f, &b->mark[r]);
+		LefNextToken(f, TRUE);		/* "-" */
+		DefReadNet(f, oscale, FALSE, home, netidx, fixed);
+		if (!DefAtMark(f, &b->mark[r + 1])) done = TRUE;
+	    }
+	}
+	if (!done) LefSetMark(f, &b->mark[b->count]);
+    }
+    free(b);
+    return processed;
+}
 
-			for (drect = gate->taps[i]; drect; drect = drect->next) {
-			    // handle offset from gate origin
-			    drect->x1 -= gateginfo->placedX;
-			    drect->x2 -= gateginfo->placedX;
-			    drect->y1 -= gateginfo->placedY;
-			    drect->y2 -= gateginfo->placedY;
-
-			    // handle rotations and orientations here
-			    if (gate->orient & R90) {
-				tmp = drect->y1;
-				drect->y1 = -drect->x1;
-				drect->y1 += gateginfo->width;
-				drect->x1 = tmp;
-
-				tmp = drect->y2;
-				drect->y2 = -drect->x2;
-				drect->y2 += gateginfo->width;
-				drect->x2 = tmp;
-			    }
-			    
-			    if (gate->orient & MX) {
-				tmp = drect->x1;
-				drect->x1 = -drect->x2;
-				drect->x1 += gate->placedX + gateginfo->width;
-				drect->x2 = -tmp;
-				drect->x2 += gate->placedX + gateginfo->width;
-			    }
-			    else {
-				drect->x1 += gate->placedX;
-				drect->x2 += gate->placedX;
-			    }
-			    if (gate->orient & MY) {
-				tmp = drect->y1;
-				drect->y1 = -drect->y2;
-				drect->y1 += gate->placedY + gateginfo->height;
-				drect->y2 = -tmp;
-				drect->y2 += gate->placedY + gateginfo->height;
-			    }
-			    else {
-				drect->y1 += gate->placedY;
-				drect->y2 += gate->placedY;
-			    }
-			}
-		    }
+#endif /* HAVE_PTHREAD_H */
 
-		    /* Make a copy of the gate obstructions and adjust	*/
-		    /* for instance position				*/
-		    for (drect = gateginfo->obs; drect; drect = drect->next) {
-			if (drect->layer < Num_layers) {
-			    newrect = (DSEG)malloc(sizeof(struct dseg_));
-			    *newrect = *drect;
-			    newrect->next = gate->obs;
-			    gate->obs = newrect;
-			}
-		    }
+/*
+ *------------------------------------------------------------
+ *
+ * DefReadComponents --
+ *
+ *	Read a COMPONENTS section from a DEF file.
+ *
+ * Results:
+ *	0 on success, 1 on fatal error.
+ *
+ * Side Effects:
+ *	Many.  Cell instances are created and added to
+ *	the database.
+ *
+ *------------------------------------------------------------
+ */
 
-		    for (drect = gate->obs; drect; drect = drect->next) {
-			drect->x1 -= gateginfo->placedX;
-			drect->x2 -= gateginfo->placedX;
-			drect->y1 -= gateginfo->placedY;
-			drect->y2 -= gateginfo->placedY;
-
-			// handle rotations and orientations here
-			if (gate->orient & R90) {
-			    tmp = drect->y1;
-			    drect->y1 = -drect->x1;
-			    drect->y1 += gateginfo->width;
-			    drect->x1 = tmp;
-
-			    tmp = drect->y2;
-			    drect->y2 = -drect->x2;
-			    drect->y2 += gateginfo->width;
-			    drect->x2 = tmp;
-			}
-			    
-			if (gate->orient & MX) {
-			    tmp = drect->x1;
-			    drect->x1 = -drect->x2;
-			    drect->x1 += gate->placedX + gateginfo->width;
-			    drect->x2 = -tmp;
-			    drect->x2 += gate->placedX + gateginfo->width;
-			}
-			else {
-			    drect->x1 += gate->placedX;
-			    drect->x2 += gate->placedX;
-			}
-			if (gate->orient & MY) {
-			    tmp = drect->y1;
-			    drect->y1 = -drect->y2;
-			    drect->y1 += gate->placedY + gateginfo->height;
-			    drect->y2 = -tmp;
-			    drect->y2 += gate->placedY + gateginfo->height;
-			}
-			else {
-			    drect->y1 += gate->placedY;
-			    drect->y2 += gate->placedY;
-			}
-		    }
+static int
+DefReadComponents(FILE *f, char *sname, float oscale, int total)
+{
+    GATE gate;
+    char *token;
+    int keyword;
+    int processed = 0;
+    int err_fatal = 0;
+
+    static char *component_keys[] = {
+	"-",
+	"END",
+	NULL
+    };
+
+#ifdef HAVE_PTHREAD_H
+    processed = DefReadComponentsParallel(f, oscale, total, &err_fatal);
+#endif
+
+    while ((token = LefNextToken(f, TRUE)) != NULL)
+    {
+	keyword = Lookup(token, component_keys);
+
+	if (keyword < 0)
+	{
+	    LefError(DEF_WARNING, "Unknown keyword \"%s\" in COMPONENT "
+			"definition; ignoring.\n", token);
+	    LefEndStatement(f);
+	    continue;
+	}
+	switch (keyword)
+	{
+	    case DEF_COMP_START:		/* "-" keyword */
+
+		/* Update the record of the number of components	*/
+		/* processed and spit out a message for every 5% done.	*/
+ 
+		processed++;
+		gate = DefReadComponent(f, oscale, &err_fatal);
+		if (gate != NULL) {
 		    gate->next = Nlgates;
 		    Nlgates = gate;
 
-		    // Used by Tcl version of qrouter
+		    // Add to the instance hash table
 		    DefHashInstance(gate);
 		}
 		break;
@@ -1896,13 +2435,6 @@ DefReadComponents(FILE *f, char *sname, float oscale, int total)
 		    keyword = -1;
 		    err_fatal++;
 		}
-
-		/* Finish final call by placing the cell use */
-		if ((total > 0) && (gate != NULL))
-		{
-		    // Nothing to do. . . gate has already been placed in list.
-		    gate = NULL;
-		}
 		break;
 	}
 	if (keyword == DEF_COMP_END) break;
@@ -2002,7 +2534,7 @@ DefRead(char *inName, float *retscale)
     else
 	strcpy(filename, inName);
    
-    f = fopen(filename, "r");
+    f = zfile_open(filename, "r");
 
     if (f == NULL)
     {
@@ -2011,6 +2543,7 @@ DefRead(char *inName, float *retscale)
 	*retscale = (float)0.0;
 	return 1;
     }
+    LefMapInput(f);
 
     /* Initialize */
 
@@ -2022,7 +2555,7 @@ DefRead(char *inName, float *retscale)
     oscale = 1;
     lefCurrentLine = 0;
 
-    DefHashInit();
+    DefHashInit(FALSE);
 
     /* Read file contents */
 
@@ -2044,6 +2577,9 @@ DefRead(char *inName, float *retscale)
 		LefEndStatement(f);
 		break;
 	    case DEF_NAMESCASESENSITIVE:
+		token = LefNextToken(f, TRUE);
+		if (!strcasecmp(token, "OFF"))
+		    DefHashInit(TRUE);
 		LefEndStatement(f);
 		break;
 	    case DEF_TECHNOLOGY:
@@ -2236,7 +2772,7 @@ DefRead(char *inName, float *retscale)
 		LefEndStatement(f);
 		if (total > MAX_NETNUMS) {
 		   LefError(DEF_WARNING, "Number of nets in design (%d) exceeds "
-				"maximum (%d)\n", total, MAX_NETNUMS);
+				"maximum (%d)\n", total, (int)MAX_NETNUMS);
 		}
 		DefReadNets(f, sections[DEF_NETS], oscale, FALSE, total);
 		break;
@@ -2281,7 +2817,8 @@ DefRead(char *inName, float *retscale)
 
     /* Cleanup */
 
-    if (f != NULL) fclose(f);
+    LefUnmapInput(f);
+    if (f != NULL) zfile_close(f);
     *retscale = oscale;
     return err_fatal;
 }
@@ -11,37 +11,20 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
-
-/* This entire file is dependent on the Tcl/Tk version */
-#ifdef TCL_QROUTER
-#include <tk.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 #include "qrouter.h"
 #include "qconfig.h"
 #include "node.h"
 #include "lef.h"
 #include "def.h"
-
-/*--------------------------------------------------------------*/
-/* Find a node in the node list.				*/
-/*--------------------------------------------------------------*/
-
-static GATE
-FindGateNode(Tcl_HashTable *NodeTable, NODE node, int *ridx)
-{
-    GATENODE gn;
-    GATE g;
-    Tcl_HashEntry *entry;
-
-    entry = Tcl_FindHashEntry(NodeTable, (char *)node);
-    if (entry) {
-	gn = (GATENODE)Tcl_GetHashValue(entry);
-	*ridx = gn->idx;
-	return gn->gate;
-    }
-    return NULL;
-}
+#include "pool.h"
+#include "zfile.h"
+#include "routegraph.h"
 
 /*--------------------------------------------------------------*/
 /* Structure to hold information about endpoints of a route.	*/
@@ -68,6 +51,8 @@ typedef struct _endpointinfo {
 /* endpointinfo flag definitions */
 #define EPT_VISITED    0x01	/* 1 if endpoint has been visited */
 #define EPT_DRIVER     0x02	/* 1 if endpoint is a driver */
+#define EPT_AT_START   0x04	/* 1 if route branches from the start	*/
+				/* (driver end) of the upstream route	*/
 
 /* Structure to hold R and C information for a path */
 
@@ -87,20 +72,193 @@ typedef struct _lefrcinfo {
     double viares;	/* Resistance per via */
 } lefrcinfo;
 
+/* Per-thread state of the R and C extraction.  The routes of	*/
+/* each net are broken up into copies made from pools that	*/
+/* belong to the thread, since the global pools are not locked.	*/
+
+typedef struct _delayctx {
+    lefrcinfo *lefrcvalues;	/* R and C values by layer	*/
+    RecPool segs;		/* SEG records of the copies	*/
+    RecPool routes;		/* ROUTE records of the copies	*/
+    struct _spefgate *gates;	/* SPEF instance names, or NULL	*/
+    int numgates;
+} delayctx;
+
+/* SPEF name map index of an instance, in a list sorted by	*/
+/* instance pointer.						*/
+
+typedef struct _spefgate {
+    GATE gate;
+    int  id;
+} spefgate;
+
+/* The R, C network of a net being written as SPEF.  A node of	*/
+/* the network is either a pin (coded as -1 - index in "pins")	*/
+/* or an internal node (coded as its number, from 0).		*/
+
+typedef struct _spefnet {
+    NODE   *keys;		/* Pins of the net, by address	*/
+    int    *slot;		/* Index in "pins" of each key	*/
+    int     numkeys;
+    NODE   *pins;		/* Pins in the order found	*/
+    double *pincap;		/* Capacitance at each pin	*/
+    int     numpins;
+    double *intcap;		/* Capacitance at internal nodes */
+    int     numint;
+    int    *res1;		/* Nodes at the ends of each	*/
+    int    *res2;		/* resistor			*/
+    double *resval;		/* Resistance of each resistor	*/
+    int     numres;
+} spefnet;
+
+/* Output text of one net, and messages raised while making it	*/
+/* (each message is NUL-terminated and starts with 1 for	*/
+/* stdout or 2 for stderr), held until the net is written.	*/
+
+typedef struct _delaybuf {
+    char *text;
+    long  len;
+    long  size;
+    char *msgs;
+    long  msglen;
+    long  msgsize;
+} delaybuf;
+
+/* Results of the extraction of a net.  They are kept with the	*/
+/* net until its routes change (NET_RC_DIRTY is set), so the	*/
+/* delay file can be written again without extracting the nets	*/
+/* that have not changed.					*/
+
+struct netrc_ {
+    delaybuf out;		/* Delay file text and messages	*/
+    double   totalcap;		/* Capacitance of all routes	*/
+    int      numsinks;		/* Number of receivers, or -1	*/
+				/* if the net was not walked	*/
+    RCSINK  *sinks;		/* R and delay to each receiver	*/
+};
+
+/* R and C values per layer that the results kept with the	*/
+/* nets were made with.						*/
+
+static lefrcinfo *RCvalues = NULL;
+static int RCnumlayers = 0;
+
 /* Forward declaration */
 
-static void walk_route(int, int, endpointinfo *, int, lefrcinfo *);
+static void walk_route(int, int, endpointinfo *, ROUTEGRAPH, delayctx *);
+static int spef_file_name(char *);
+
+/*--------------------------------------------------------------*/
+/* Output buffer routines.  Each net's text is formatted into a	*/
+/* buffer of its own, which may be done on a worker thread,	*/
+/* and the buffers are written in net order by the main thread.	*/
+/*--------------------------------------------------------------*/
+
+static void
+db_grow(char **text, long *size, long need)
+{
+    if (need <= *size) return;
+    *size = (*size == 0) ? 1024 : *size * 2;
+    while (need > *size) *size *= 2;
+    *text = (char *)realloc(*text, *size);
+}
+
+static void
+db_printf(delaybuf *db, char *fmt, ...)
+{
+    va_list args;
+    int n;
+
+    db_grow(&db->text, &db->size, db->len + 1);
+    va_start(args, fmt);
+    n = vsnprintf(db->text + db->len, (size_t)(db->size - db->len), fmt, args);
+    va_end(args);
+    if (n < 0) return;
+
+    if (db->len + n + 1 > db->size) {
+	db_grow(&db->text, &db->size, db->len + n + 1);
+	va_start(args, fmt);
+	vsnprintf(db->text + db->len, (size_t)(db->size - db->len), fmt, args);
+	va_end(args);
+    }
+    db->len += n;
+}
+
+/* Hold a message to be printed when the net is written */
+
+static void
+db_message(delaybuf *db, FILE *f, char *fmt, ...)
+{
+    va_list args;
+    char msg[512];
+    long n;
+
+    va_start(args, fmt);
+    vsnprintf(msg + 1, sizeof(msg) - 1, fmt, args);
+    va_end(args);
+    msg[0] = (f == stderr) ? 2 : 1;
+
+    n = (long)strlen(msg) + 1;
+    db_grow(&db->msgs, &db->msgsize, db->msglen + n);
+    memcpy(db->msgs + db->msglen, msg, n);
+    db->msglen += n;
+}
+
+/* Print the held messages and write the text (if "delayFile"	*/
+/* is not NULL).  The buffer is left as it is.			*/
+
+static void
+db_write(delaybuf *db, FILE *delayFile)
+{
+    char *mptr;
+
+    for (mptr = db->msgs; mptr && (mptr < db->msgs + db->msglen);
+		mptr += strlen(mptr) + 1) {
+	if (*mptr == 2) {
+	    Flush(stdout);
+	    Fprintf(stderr, "%s", mptr + 1);
+	}
+	else
+	    Fprintf(stdout, "%s", mptr + 1);
+    }
+    if ((delayFile != NULL) && (db->len > 0))
+	fwrite(db->text, 1, (size_t)db->len, delayFile);
+}
+
+/* Release the unused space of a buffer that is being kept */
+
+static void
+db_trim(delaybuf *db)
+{
+    if (db->len == 0) {
+	free(db->text);
+	db->text = NULL;
+	db->size = 0;
+    }
+    else if (db->size > db->len) {
+	db->text = (char *)realloc(db->text, db->len);
+	db->size = db->len;
+    }
+    if (db->msglen == 0) {
+	free(db->msgs);
+	db->msgs = NULL;
+	db->msgsize = 0;
+    }
+}
 
 /*--------------------------------------------------------------*/
 /* Add route information to the endpoint record showing where	*/
-/* a route continues downstream.				*/
+/* a route continues downstream.  "atstart" is set if the	*/
+/* route branches from the start of the upstream route.	*/
 /*--------------------------------------------------------------*/
 
 static void
-add_route_to_endpoint(endpointinfo *eptinfo, int eidx, int didx)
+add_route_to_endpoint(endpointinfo *eptinfo, int eidx, int didx,
+		u_char atstart)
 {
     int i;
 
+    if (atstart) eptinfo[didx].flags |= EPT_AT_START;
     for (i = 0; i < 5; i++) {
 	if (eptinfo[eidx].branching[i] == -1) {
 	    eptinfo[eidx].branching[i] = didx;
@@ -119,15 +277,48 @@ add_route_to_endpoint(endpointinfo *eptinfo, int eidx, int didx)
 
 static void
 check_downstream(SEG walkseg, endpointinfo *eptinfo, int eidx,
-	int numroutes, lefrcinfo *lefrcvalues, u_char end)
+	ROUTEGRAPH rg, delayctx *dc, u_char end)
 {
-    int i;
+    int i, lasti, n, nup;
+    int *ends, *upends;
     int startcompat, endcompat;
+    u_char atstart;
     NODE nodeptr;
 
+    /* When checking from the driver, the segment end may still be	*/
+    /* the start of the route (a via), or the far end of the route.	*/
+
+    atstart = (end == (u_char)0) && (walkseg->x2 == eptinfo[eidx].startx) &&
+		(walkseg->y2 == eptinfo[eidx].starty);
+
     /* At given segment "walkseg", find all routes that connect and walk them */
+    /* The routes that can connect are the ones with an endpoint at the	  */
+    /* segment end, on the segment layer or, for a via, the layer above.  */
+    /* The two lists are merged so that routes are checked in order.	  */
+
+    n = routegraph_at_point(rg, walkseg->x2, walkseg->y2, walkseg->layer,
+		&ends);
+    if (walkseg->segtype & ST_WIRE)
+	nup = 0;
+    else
+	nup = routegraph_at_point(rg, walkseg->x2, walkseg->y2,
+		walkseg->layer + 1, &upends);
+
+    lasti = -1;
+    while ((n > 0) || (nup > 0)) {
+	if ((nup == 0) || ((n > 0) && (RG_ROUTE(*ends) <= RG_ROUTE(*upends)))) {
+	    i = RG_ROUTE(*ends);
+	    ends++;
+	    n--;
+	}
+	else {
+	    i = RG_ROUTE(*upends);
+	    upends++;
+	    nup--;
+	}
+	if (i == lasti) continue;
+	lasti = i;
 
-    for (i = 0; i < numroutes; i++) {
 	if (eptinfo[i].flags & EPT_VISITED) continue;  /* already visited */
 
 	/* Check wire/via layer compatibility */
@@ -162,8 +353,8 @@ check_downstream(SEG walkseg, endpointinfo *eptinfo, int eidx,
 			eptinfo[i].startx, eptinfo[i].starty, eptinfo[i].startl);
 	    */
 	    /* Recursive walk */
-	    walk_route(i, reverse, eptinfo, numroutes, lefrcvalues);
-	    add_route_to_endpoint(eptinfo, eidx, i);
+	    walk_route(i, reverse, eptinfo, rg, dc);
+	    add_route_to_endpoint(eptinfo, eidx, i, atstart);
 	}
 	else if ((walkseg->x2 == eptinfo[i].endx) &&
 		(walkseg->y2 == eptinfo[i].endy) && endcompat) {
@@ -174,8 +365,8 @@ check_downstream(SEG walkseg, endpointinfo *eptinfo, int eidx,
 	    */
 	    /* If this is a node, output it now */
 	    /* Recursive walk */
-	    walk_route(i, 1, eptinfo, numroutes, lefrcvalues);
-	    add_route_to_endpoint(eptinfo, eidx, i);
+	    walk_route(i, 1, eptinfo, rg, dc);
+	    add_route_to_endpoint(eptinfo, eidx, i, atstart);
 	}
     }
 
@@ -187,15 +378,20 @@ check_downstream(SEG walkseg, endpointinfo *eptinfo, int eidx,
     nodeptr = (end == 0) ? eptinfo[eidx].startnode : eptinfo[eidx].endnode;
 
     if (nodeptr != NULL) {
-	for (i = 0; i < numroutes; i++) {
+	n = routegraph_at_node(rg, nodeptr, &ends);
+	lasti = -1;
+	for (; n > 0; ends++, n--) {
+	    i = RG_ROUTE(*ends);
+	    if (i == lasti) continue;
+	    lasti = i;
 	    if (eptinfo[i].flags & EPT_VISITED) continue;  /* already visited */
 	    if (eptinfo[i].startnode == nodeptr) {
-		walk_route(i, 0, eptinfo, numroutes, lefrcvalues);
-		add_route_to_endpoint(eptinfo, eidx, i);
+		walk_route(i, 0, eptinfo, rg, dc);
+		add_route_to_endpoint(eptinfo, eidx, i, (end == (u_char)0));
 	    }
 	    else if (eptinfo[i].endnode == nodeptr) {
-		walk_route(i, 1, eptinfo, numroutes, lefrcvalues);
-		add_route_to_endpoint(eptinfo, eidx, i);
+		walk_route(i, 1, eptinfo, rg, dc);
+		add_route_to_endpoint(eptinfo, eidx, i, (end == (u_char)0));
 	    }
 	}
     }
@@ -209,19 +405,19 @@ check_downstream(SEG walkseg, endpointinfo *eptinfo, int eidx,
 /* driverend is the upstream endpoint of that route		*/
 /*	(0 = start of segment, 1 = end of segment).		*/
 /* eptinfo contains the endpoints of all the routes.		*/
-/* numroutes is te number of entries in eptinfo.		*/
-/* delayFile is the output file to write to.			*/
+/* rg is the route graph indexing the endpoints in eptinfo.	*/
+/* dc holds the R and C values and the record pools to use.	*/
 /*								*/
 /* Return the R and C values for the segment			*/
 /*--------------------------------------------------------------*/
 
 static void
 walk_route(int eidx, int driverend, endpointinfo *eptinfo,
-		int numroutes, lefrcinfo *lefrcvalues)
+		ROUTEGRAPH rg, delayctx *dc)
 {
     SEG firstseg, lastseg;
     SEG walkseg, newseg, testseg;
-    SEG seg, nseg;
+    SEG seg;
     GATE g;
     NODE node;
     int i;
@@ -241,7 +437,7 @@ walk_route(int eidx, int driverend, endpointinfo *eptinfo,
 
 	/* Reverse the route */
 	for (seg = rt->segments; seg; seg = seg->next) {
-	    newseg = (SEG)malloc(sizeof(struct seg_));
+	    newseg = (SEG)pool_alloc(&dc->segs);
 	    newseg->layer = seg->layer;
 	    newseg->x1 = seg->x2;
 	    newseg->x2 = seg->x1;
@@ -253,11 +449,7 @@ walk_route(int eidx, int driverend, endpointinfo *eptinfo,
 	}
 
 	/* Delete the original route and replace it */
-	for (seg = rt->segments; seg; ) {
-	    nseg = seg->next;
-	    free(seg);
-	    seg = nseg;
-	}
+	pool_free_list(&dc->segs, rt->segments);
 	rt->segments = firstseg;
 
 	/* Everything in eptinfo related to start and end needs	*/
@@ -286,7 +478,7 @@ walk_route(int eidx, int driverend, endpointinfo *eptinfo,
     /* if it is the driver.						*/
 
     if (eptinfo[eidx].flags & EPT_DRIVER)
-	check_downstream(firstseg, eptinfo, eidx, numroutes, lefrcvalues, (u_char)0);
+	check_downstream(firstseg, eptinfo, eidx, rg, dc, (u_char)0);
 
     /* Walk the route segment and accumulate R and C */
 
@@ -298,29 +490,29 @@ walk_route(int eidx, int driverend, endpointinfo *eptinfo,
 
 	/* Accumulate C and R */
 	if (walkseg->segtype & ST_VIA) {
-	    eptinfo[eidx].res += lefrcvalues[walkseg->layer].viares;
+	    eptinfo[eidx].res += dc->lefrcvalues[walkseg->layer].viares;
 	}
 	else if (walkseg->x1 == walkseg->x2) {  /* Vertical route */
 	    rlength = (walkseg->y2 > walkseg->y1) ?
 			(walkseg->y2 - walkseg->y1 + 1) :
 			(walkseg->y1 - walkseg->y2 + 1);
 			
-	    eptinfo[eidx].res += lefrcvalues[walkseg->layer].resy * rlength;
-	    eptinfo[eidx].cap += lefrcvalues[walkseg->layer].capy * rlength;
+	    eptinfo[eidx].res += dc->lefrcvalues[walkseg->layer].resy * rlength;
+	    eptinfo[eidx].cap += dc->lefrcvalues[walkseg->layer].capy * rlength;
 	}
 	else {	/* Horizontal route */
 	    rlength = (walkseg->x2 > walkseg->x1) ?
 			(walkseg->x2 - walkseg->x1 + 1) :
 			(walkseg->x1 - walkseg->x2 + 1);
 
-	    eptinfo[eidx].res += lefrcvalues[walkseg->layer].resx * rlength;
-	    eptinfo[eidx].cap += lefrcvalues[walkseg->layer].capx * rlength;
+	    eptinfo[eidx].res += dc->lefrcvalues[walkseg->layer].resx * rlength;
+	    eptinfo[eidx].cap += dc->lefrcvalues[walkseg->layer].capx * rlength;
 	}
 	if (walkseg->next == NULL) lastseg = walkseg;
     }
 
     /* Check for downstream nodes from the last route point */
-    check_downstream(lastseg, eptinfo, eidx, numroutes, lefrcvalues, (u_char)1);
+    check_downstream(lastseg, eptinfo, eidx, rg, dc, (u_char)1);
 }
 
 /*--------------------------------------------------------------*/
@@ -328,8 +520,7 @@ walk_route(int eidx, int driverend, endpointinfo *eptinfo,
 /*--------------------------------------------------------------*/
 
 static void
-walk_route_output(endpointinfo *eptinfo, int eidx,
-		Tcl_HashTable *NodeTable, FILE *delayFile)
+walk_route_output(endpointinfo *eptinfo, int eidx, delaybuf *db)
 {
     int d, i;
     NODE node;
@@ -337,7 +528,7 @@ walk_route_output(endpointinfo *eptinfo, int eidx,
 
     /* Output information about self */
 
-    fprintf(delayFile, "( %g %g ", eptinfo[eidx].res, eptinfo[eidx].cap);
+    db_printf(db, "( %g %g ", eptinfo[eidx].res, eptinfo[eidx].cap);
 
     /* Count downstream nodes */
 
@@ -351,717 +542,1458 @@ walk_route_output(endpointinfo *eptinfo, int eidx,
 
     if (node != NULL) {
 	/* Look up the gate */
-	g = FindGateNode(NodeTable, node, &i);
+	g = FindGateNode(node, &i);
 	if (!strcmp(g->gatetype->node[i], "pin"))
-	    fprintf(delayFile, "PIN/%s ", g->gatename);
+	    db_printf(db, "PIN/%s ", g->gatename);
 	else
-	    fprintf(delayFile, "%s/%s ", g->gatename, g->gatetype->node[i]);
-	if (d > 0) fprintf(delayFile, ", ");
+	    db_printf(db, "%s/%s ", g->gatename, g->gatetype->node[i]);
+	if (d > 0) db_printf(db, ", ");
     }
     else if (d == 0) {
 	/* This should not happen:  No node, no route */
-	fprintf(delayFile, "ERROR ");
+	db_printf(db, "ERROR ");
     }
 
     /* Output downstream nodes */
     for (i = 0; i < d; i++) {
-	walk_route_output(eptinfo, eptinfo[eidx].branching[i],
-			NodeTable, delayFile);
-	if (i < (d - 1)) fprintf(delayFile, ", ");
+	walk_route_output(eptinfo, eptinfo[eidx].branching[i], db);
+	if (i < (d - 1)) db_printf(db, ", ");
     }
 
     /* End record */
-    fprintf(delayFile, ") ");
+    db_printf(db, ") ");
 }
 
 /*--------------------------------------------------------------*/
-/* Free data associated with each entry in the NodeTable hash.	*/
+/* Find the capacitance of each route of the walked tree and	*/
+/* of everything downstream of it, and return the value for	*/
+/* route "eidx".						*/
 /*--------------------------------------------------------------*/
 
-void FreeNodeTable(Tcl_HashTable *NodeTable)
+static double
+walk_route_cap(endpointinfo *eptinfo, int eidx, double *downcap)
 {
-    Tcl_HashEntry *entry;
-    Tcl_HashSearch hs;
-    GATENODE gn;
-
-    entry = Tcl_FirstHashEntry(NodeTable, &hs);
-    while (entry != NULL) {
-	gn = Tcl_GetHashValue(entry);
-	if (gn != NULL) free(gn);
-	entry = Tcl_NextHashEntry(&hs);
+    double cap;
+    int d;
+
+    cap = eptinfo[eidx].cap;
+    for (d = 0; d < 5; d++) {
+	if (eptinfo[eidx].branching[d] == -1) break;
+	cap += walk_route_cap(eptinfo, eptinfo[eidx].branching[d], downcap);
     }
+    downcap[eidx] = cap;
+    return cap;
 }
 
 /*--------------------------------------------------------------*/
-/* Write an output file of the calculated R, C for every route	*/
-/* branch.  Because the qrouter algorithm is agnostic about the	*/
-/* direction of the signaling of routes, this has to be 	*/
-/* discovered from the information at hand.  The routes for	*/
-/* each net are reorganized into directed segments, and the	*/
-/* whole directed tree walked from beginning to every endpoint.	*/
-/* The routing algorithm is also unaware of any details of the	*/
-/* nodes it routes to, so it is necessary to create a table of	*/
-/* all nodes, referenced by the pointer address found in the	*/
-/* nodeinfo array.						*/
+/* Walk the tree in the same order as walk_route_output() and	*/
+/* record the resistance and Elmore delay from the driver to	*/
+/* each receiver.  "res" and "delay" are the values at the	*/
+/* start of route "eidx".  A route is a distributed line, so	*/
+/* only half of its own capacitance is behind its resistance,	*/
+/* along with everything that branches from its far end.	*/
 /*--------------------------------------------------------------*/
 
-int write_delays(char *filename)
+static void
+walk_route_sinks(endpointinfo *eptinfo, int eidx, double res, double delay,
+		double *downcap, struct netrc_ *rc)
 {
-    FILE *delayFile;
-    NET net;
-    ROUTE rt, nxroute;
-    ROUTE droutes, newroute, lastroute;
-    NODEINFO nodeptr;
-    SEG seg, newseg, lastseg, nxseg;
-    GATE g, drivergate;
-    int i, j, n, new, driverend, testl;
-    int drivernodeidx, driveridx;
-    int nroute, numroutes;
-    endpointinfo *eptinfo;
-    lefrcinfo *lefrcvalues;
+    double endres, enddelay, endcap;
+    int d, didx;
+
+    endcap = downcap[eidx] - eptinfo[eidx].cap / 2.0;
+    for (d = 0; d < 5; d++) {
+	didx = eptinfo[eidx].branching[d];
+	if (didx == -1) break;
+	if (eptinfo[didx].flags & EPT_AT_START) endcap -= downcap[didx];
+    }
+    enddelay = delay + eptinfo[eidx].res * endcap;
+    endres = res + eptinfo[eidx].res;
+
+    if (eptinfo[eidx].endnode != NULL) {
+	rc->sinks[rc->numsinks].node = eptinfo[eidx].endnode;
+	rc->sinks[rc->numsinks].res = endres;
+	rc->sinks[rc->numsinks].delay = enddelay;
+	rc->numsinks++;
+    }
+    for (d = 0; d < 5; d++) {
+	didx = eptinfo[eidx].branching[d];
+	if (didx == -1) break;
+	if (eptinfo[didx].flags & EPT_AT_START)
+	    walk_route_sinks(eptinfo, didx, res, delay, downcap, rc);
+	else
+	    walk_route_sinks(eptinfo, didx, endres, enddelay, downcap, rc);
+    }
+}
 
-    Tcl_HashTable NodeTable;
-    Tcl_HashEntry *entry;
+/*--------------------------------------------------------------*/
+/* SPEF output.  The tree of routes walked from the driver is	*/
+/* written as a network of resistors, one per route, with the	*/
+/* capacitance of each route split between its two ends.  Nets	*/
+/* and instances are written by their index in the name map.	*/
+/*--------------------------------------------------------------*/
 
-    if (!strcmp(filename, "stdout"))
-	delayFile = stdout;
-    else if (filename == NULL)
-	delayFile = fopen(delayfilename, "w");
-    else
-	delayFile = fopen(filename, "w");
+static int
+spef_ptr_compare(const void *a, const void *b)
+{
+    const void *pa = *(void * const *)a;
+    const void *pb = *(void * const *)b;
 
-    if (!delayFile) {
-	Fprintf(stderr, "write_delays():  Couldn't open output delay file.\n");
-	return -1;
-    }
+    return (pa < pb) ? -1 : (pa > pb) ? 1 : 0;
+}
 
-    /* Build a hash table of nodes;  key = node record address,		*/
-    /* record = pointer to gate and index of the node in its noderec.	*/
+/* Write a name, escaping any character that SPEF does not	*/
+/* allow in a name.  Characters already escaped are kept.	*/
 
-    Tcl_InitHashTable(&NodeTable, TCL_ONE_WORD_KEYS);
+static void
+spef_name(delaybuf *db, char *name)
+{
+    char *sptr;
 
-    for (g = Nlgates; g; g = g->next) {
-	for (i = 0; i < g->nodes; i++) {
-	    GATENODE gn;
-	    gn = (GATENODE)malloc(sizeof(struct gatenode_));
-	    gn->idx = i;
-	    gn->gate = g;
-	    entry = Tcl_CreateHashEntry(&NodeTable, (char *)(*(g->noderec + i)), &new);
-	    Tcl_SetHashValue(entry, gn);
+    db_grow(&db->text, &db->size, db->len + 2 * strlen(name) + 1);
+    for (sptr = name; *sptr != '\0'; sptr++) {
+	if (*sptr == '\\') {
+	    db->text[db->len++] = *sptr++;
+	    if (*sptr == '\0') break;
 	}
+	else if (!isalnum((unsigned char)*sptr) && (*sptr != '_') &&
+			(*sptr != '[') && (*sptr != ']'))
+	    db->text[db->len++] = '\\';
+	db->text[db->len++] = *sptr;
     }
+    db->text[db->len] = '\0';
+}
 
-    /* Fill in the record of R and C values per layer, for efficiency */
+/* Code of the network node for pin "node" */
 
-    lefrcvalues = (lefrcinfo *)malloc(Num_layers * sizeof(lefrcinfo));
-    for (i = 0; i < Num_layers; i++) {
-	double areacap, edgecap;
-	double respersq, respervia;
-	double width, sqx, sqy;
+static int
+spef_pin(spefnet *sn, NODE node)
+{
+    NODE *kptr;
+    int k;
+
+    kptr = (NODE *)bsearch(&node, sn->keys, sn->numkeys, sizeof(NODE),
+		spef_ptr_compare);
+    k = kptr - sn->keys;
+    if (sn->slot[k] < 0) {
+	sn->slot[k] = sn->numpins;
+	sn->pins[sn->numpins++] = node;
+    }
+    return -1 - sn->slot[k];
+}
 
-	LefGetRouteRCvalues(i, &areacap, &edgecap, &respersq);
-	width = LefGetRouteWidth(i);
+/* Add the resistors of route "eidx" and everything downstream	*/
+/* of it, where "start" is the node at the start of the route.	*/
 
-	lefrcvalues[i].resx = (PitchX / width) * respersq;
-	lefrcvalues[i].resy = (PitchY / width) * respersq;
+static void
+spef_walk(endpointinfo *eptinfo, int eidx, int start, spefnet *sn)
+{
+    int d, didx, end;
 
-	lefrcvalues[i].capx = (PitchX * width) * areacap + (PitchX * edgecap);
-	lefrcvalues[i].capy = (PitchY * width) * areacap + (PitchY * edgecap);
+    if (eptinfo[eidx].endnode != NULL)
+	end = spef_pin(sn, eptinfo[eidx].endnode);
+    else
+	end = sn->numint++;
 
-	if (i < (Num_layers - 1))
-	    LefGetViaResistance(i, &(lefrcvalues[i].viares));
-	else
-	    lefrcvalues[i].viares = 0.0;	/* Not used */
+    if (start != end) {
+	sn->res1[sn->numres] = start;
+	sn->res2[sn->numres] = end;
+	sn->resval[sn->numres] = eptinfo[eidx].res;
+	sn->numres++;
+    }
+
+    if (start < 0)
+	sn->pincap[-1 - start] += eptinfo[eidx].cap / 2.0;
+    else
+	sn->intcap[start] += eptinfo[eidx].cap / 2.0;
+    if (end < 0)
+	sn->pincap[-1 - end] += eptinfo[eidx].cap / 2.0;
+    else
+	sn->intcap[end] += eptinfo[eidx].cap / 2.0;
+
+    for (d = 0; d < 5; d++) {
+	didx = eptinfo[eidx].branching[d];
+	if (didx == -1) break;
+	spef_walk(eptinfo, didx, (eptinfo[didx].flags & EPT_AT_START) ?
+			start : end, sn);
     }
+}
 
-    /* Each net is output independently.  Loop through all nets. */
+/* Write the name of a network node */
 
-    for (n = 0; n < Numnets; n++) {
-	net = Nlnets[n];
+static void
+spef_node(NET net, spefnet *sn, int code, delayctx *dc, delaybuf *db)
+{
+    spefgate key, *gptr;
+    GATE g;
+    int i;
 
-	if ((net->netnum == VDD_NET) || (net->netnum == GND_NET) ||
-		(net->netnum == ANTENNA_NET)) continue;
+    if (code >= 0) {
+	db_printf(db, "*%d:%d", net->netnum, code + 1);
+	return;
+    }
+    g = FindGateNode(sn->pins[-1 - code], &i);
+    if (g->gatetype == PinMacro) {
+	spef_name(db, g->gatename);
+	return;
+    }
+    key.gate = g;
+    gptr = (spefgate *)bsearch(&key, dc->gates, dc->numgates,
+		sizeof(spefgate), spef_ptr_compare);
+    db_printf(db, "*%d:", gptr->id);
+    spef_name(db, g->gatetype->node[i]);
+}
 
-	/* Count number of net routes */
-	numroutes = 0;
-	for (rt = net->routes; rt; rt = rt->next) numroutes++;
-	if (numroutes == 0) continue;	/* Ignore nets with no routes */
-
-	/* Determine the driver node, as determined by the node with	*/
-	/* LEF direction 'OUTPUT'.  					*/
-	/* (For now, if a net has multiple tristate drivers, just use	*/
-	/* the first one and treat the rest as receivers.)		*/
-
-	/* Allocate space for endpoint info */
-	eptinfo = (endpointinfo *)malloc(numroutes * sizeof(endpointinfo));
-	
-	/* Fill in initial endpoint information */
-	nroute = 0;
-	for (rt = net->routes; rt; rt = rt->next) {
-	    eptinfo[nroute].route = rt;
-	    eptinfo[nroute].orig = rt;
-	    eptinfo[nroute].flags = (u_char)0;
-	    eptinfo[nroute].branching = NULL;
-	    eptinfo[nroute].startnode = NULL;
-	    eptinfo[nroute].endnode = NULL;
+/* SPEF direction of a pin: from the design for a pin of the	*/
+/* design, and from the cell for an instance pin.		*/
 
-	    /* Segment start */
-	    seg = rt->segments;
-            if (seg != NULL) {
-		eptinfo[nroute].startx = seg->x1;
-		eptinfo[nroute].starty = seg->y1;
-		eptinfo[nroute].startl = seg->layer;
-		eptinfo[nroute].res = 0.0;
-		eptinfo[nroute].cap = 0.0;
-
-		/* If a via, check if direction is up or down */
-		if (seg->segtype & ST_VIA) {
-		    if (seg->next && (seg->next->layer <= seg->layer))
-			eptinfo[nroute].startl++;
-		}
+static char *
+spef_direction(NODE node)
+{
+    GATE g;
+    int i, dir;
+
+    g = FindGateNode(node, &i);
+    dir = (g->gatetype == PinMacro) ? g->direction[i] :
+		g->gatetype->direction[i];
+    switch (dir) {
+	case PORT_CLASS_INPUT:
+	    return "I";
+	case PORT_CLASS_OUTPUT:
+	case PORT_CLASS_TRISTATE:
+	    return "O";
+    }
+    return "B";
+}
+
+/*--------------------------------------------------------------*/
+/* Write the D_NET section of "net" into "db", from the walked	*/
+/* routes in "eptinfo" starting with the driver's route.	*/
+/*--------------------------------------------------------------*/
+
+static void
+spef_net_output(NET net, endpointinfo *eptinfo, int driveridx,
+		int numroutes, double totalcap, delayctx *dc, delaybuf *db)
+{
+    spefnet sn;
+    NODE driver;
+    int i, n, start;
+
+    /* The pins are the driver and the end nodes of the routes */
+
+    sn.keys = (NODE *)malloc((numroutes + 1) * sizeof(NODE));
+    n = 0;
+    driver = eptinfo[driveridx].startnode;
+    if (driver != NULL) sn.keys[n++] = driver;
+    for (i = 0; i < numroutes; i++)
+	if ((eptinfo[i].flags & EPT_VISITED) && (eptinfo[i].endnode != NULL))
+	    sn.keys[n++] = eptinfo[i].endnode;
+    qsort(sn.keys, n, sizeof(NODE), spef_ptr_compare);
+    sn.numkeys = 0;
+    for (i = 0; i < n; i++)
+	if ((sn.numkeys == 0) || (sn.keys[i] != sn.keys[sn.numkeys - 1]))
+	    sn.keys[sn.numkeys++] = sn.keys[i];
+
+    sn.slot = (int *)malloc((sn.numkeys + 1) * sizeof(int));
+    for (i = 0; i < sn.numkeys; i++) sn.slot[i] = -1;
+    sn.pins = (NODE *)malloc((sn.numkeys + 1) * sizeof(NODE));
+    sn.pincap = (double *)calloc(sn.numkeys + 1, sizeof(double));
+    sn.numpins = 0;
+    sn.intcap = (double *)calloc(numroutes + 1, sizeof(double));
+    sn.numint = 0;
+    sn.res1 = (int *)malloc(numroutes * sizeof(int));
+    sn.res2 = (int *)malloc(numroutes * sizeof(int));
+    sn.resval = (double *)malloc(numroutes * sizeof(double));
+    sn.numres = 0;
+
+    start = (driver != NULL) ? spef_pin(&sn, driver) : sn.numint++;
+    spef_walk(eptinfo, driveridx, start, &sn);
+
+    db_printf(db, "\n*D_NET *%d %g\n", net->netnum, totalcap);
+
+    db_printf(db, "*CONN\n");
+    for (i = 0; i < sn.numpins; i++) {
+	db_printf(db, (FindGateNode(sn.pins[i], &n)->gatetype == PinMacro) ?
+		"*P " : "*I ");
+	spef_node(net, &sn, -1 - i, dc, db);
+	db_printf(db, " %s\n", spef_direction(sn.pins[i]));
+    }
+
+    db_printf(db, "*CAP\n");
+    n = 0;
+    for (i = 0; i < sn.numpins; i++) {
+	if (sn.pincap[i] == 0.0) continue;
+	db_printf(db, "%d ", ++n);
+	spef_node(net, &sn, -1 - i, dc, db);
+	db_printf(db, " %g\n", sn.pincap[i]);
+    }
+    for (i = 0; i < sn.numint; i++) {
+	if (sn.intcap[i] == 0.0) continue;
+	db_printf(db, "%d ", ++n);
+	spef_node(net, &sn, i, dc, db);
+	db_printf(db, " %g\n", sn.intcap[i]);
+    }
+
+    db_printf(db, "*RES\n");
+    for (i = 0; i < sn.numres; i++) {
+	db_printf(db, "%d ", i + 1);
+	spef_node(net, &sn, sn.res1[i], dc, db);
+	db_printf(db, " ");
+	spef_node(net, &sn, sn.res2[i], dc, db);
+	db_printf(db, " %g\n", sn.resval[i]);
+    }
+    db_printf(db, "*END\n");
+
+    free(sn.keys);
+    free(sn.slot);
+    free(sn.pins);
+    free(sn.pincap);
+    free(sn.intcap);
+    free(sn.res1);
+    free(sn.res2);
+    free(sn.resval);
+}
+
+/*--------------------------------------------------------------*/
+/* Compute the R and C values of the routes of one net, and	*/
+/* format the delay file text for the net into "db".  Because	*/
+/* the qrouter algorithm is agnostic about the direction of	*/
+/* the signaling of routes, this has to be discovered from the	*/
+/* information at hand.  The routes for the net are		*/
+/* reorganized into directed segments, and the whole directed	*/
+/* tree walked from beginning to every endpoint.  The gate and	*/
+/* pin of each node found in the nodeinfo array are recorded	*/
+/* in the node itself when the DEF file is read.		*/
+/*								*/
+/* The text, the total capacitance, and the R and delay to	*/
+/* each receiver are left in "rc".  If "spef" is not NULL, the	*/
+/* SPEF text of the net is added to it.  Only the net and its	*/
+/* routes are read, and route copies come from "dc", so	*/
+/* different nets may be done at the same time on different	*/
+/* threads.							*/
+/*--------------------------------------------------------------*/
+
+static void
+delay_net(NET net, delayctx *dc, struct netrc_ *rc, delaybuf *spef)
+{
+    delaybuf *db = &rc->out;
+    ROUTE rt, nxroute;
+    ROUTE droutes, newroute, lastroute;
+    NODEINFO nodeptr;
+    SEG seg, newseg, lastseg;
+    GATE g, drivergate;
+    int i, j, driverend, testl;
+    int drivernodeidx, driveridx;
+    int nroute, numroutes;
+    endpointinfo *eptinfo;
+    ROUTEGRAPH rg;
+    double *downcap;
+
+    db->len = 0;
+    db->msglen = 0;
+    rc->totalcap = 0.0;
+    rc->numsinks = -1;
+    if (rc->sinks != NULL) {
+	free(rc->sinks);
+	rc->sinks = NULL;
+    }
+
+    if ((net->netnum == VDD_NET) || (net->netnum == GND_NET) ||
+	    (net->netnum == ANTENNA_NET)) return;
+
+    /* Count number of net routes */
+    numroutes = 0;
+    for (rt = net->routes; rt; rt = rt->next) numroutes++;
+    if (numroutes == 0) return;	/* Ignore nets with no routes */
+
+    /* Determine the driver node, as determined by the node with	*/
+    /* LEF direction 'OUTPUT'.  					*/
+    /* (For now, if a net has multiple tristate drivers, just use	*/
+    /* the first one and treat the rest as receivers.)		*/
+
+    /* Allocate space for endpoint info */
+    eptinfo = (endpointinfo *)malloc(numroutes * sizeof(endpointinfo));
+
+    /* Fill in initial endpoint information */
+    nroute = 0;
+    for (rt = net->routes; rt; rt = rt->next) {
+	eptinfo[nroute].route = rt;
+	eptinfo[nroute].orig = rt;
+	eptinfo[nroute].flags = (u_char)0;
+	eptinfo[nroute].branching = NULL;
+	eptinfo[nroute].startnode = NULL;
+	eptinfo[nroute].endnode = NULL;
+
+	/* Segment start */
+	seg = rt->segments;
+	if (seg != NULL) {
+	    eptinfo[nroute].startx = seg->x1;
+	    eptinfo[nroute].starty = seg->y1;
+	    eptinfo[nroute].startl = seg->layer;
+	    eptinfo[nroute].res = 0.0;
+	    eptinfo[nroute].cap = 0.0;
+
+	    /* If a via, check if direction is up or down */
+	    if (seg->segtype & ST_VIA) {
+		if (seg->next && (seg->next->layer <= seg->layer))
+		    eptinfo[nroute].startl++;
 	    }
+	}
 
-	    /* Segment end */
-	    testl = eptinfo[nroute].startl;
-	    for (seg = rt->segments; seg && seg->next; seg = seg->next)
-		testl = seg->layer;
+	/* Segment end */
+	testl = eptinfo[nroute].startl;
+	for (seg = rt->segments; seg && seg->next; seg = seg->next)
+	    testl = seg->layer;
 
-	    if (seg != NULL) {
-		eptinfo[nroute].endx = seg->x2;
-		eptinfo[nroute].endy = seg->y2;
-		eptinfo[nroute].endl = seg->layer;
+	if (seg != NULL) {
+	    eptinfo[nroute].endx = seg->x2;
+	    eptinfo[nroute].endy = seg->y2;
+	    eptinfo[nroute].endl = seg->layer;
 
-		/* If a via, check if direction is up or down */
-		if (seg->segtype & ST_VIA) {
-		    if (testl <= seg->layer)
-			eptinfo[nroute].endl++;
-		}
+	    /* If a via, check if direction is up or down */
+	    if (seg->segtype & ST_VIA) {
+		if (testl <= seg->layer)
+		    eptinfo[nroute].endl++;
 	    }
-	    nroute++;
 	}
+	nroute++;
+    }
 
-	/* Copy net->routes into droutes, and update eptinfo */
+    /* Copy net->routes into droutes, and update eptinfo */
 
-	droutes = (ROUTE)NULL;
-	lastroute = (ROUTE)NULL;
-	i = 0;
-	for (rt = net->routes; rt; rt = rt->next) {
-	    newroute = (ROUTE)malloc(sizeof(struct route_));
-	    newroute->next = NULL;
-	    if (lastroute == NULL)
-		droutes = newroute;
+    droutes = (ROUTE)NULL;
+    lastroute = (ROUTE)NULL;
+    i = 0;
+    for (rt = net->routes; rt; rt = rt->next) {
+	newroute = (ROUTE)pool_alloc(&dc->routes);
+	newroute->next = NULL;
+	if (lastroute == NULL)
+	    droutes = newroute;
+	else
+	    lastroute->next = newroute; 
+	lastroute = newroute;
+	newroute->segments = NULL;
+	newroute->start.route = NULL;
+	newroute->end.route = NULL;
+	newroute->flags = (u_char)0;
+	newroute->netnum = rt->netnum;
+	eptinfo[i].route = newroute;
+
+	lastseg = (SEG)NULL;
+	for (seg = rt->segments; seg; seg = seg->next) {
+	    newseg = (SEG)pool_alloc(&dc->segs);
+	    if (lastseg == NULL)
+		newroute->segments = newseg;
 	    else
-		lastroute->next = newroute; 
-	    lastroute = newroute;
-	    newroute->segments = NULL;
-	    newroute->start.route = NULL;
-	    newroute->end.route = NULL;
-	    newroute->flags = (u_char)0;
-	    newroute->netnum = rt->netnum;
-	    eptinfo[i].route = newroute;
-
-	    lastseg = (SEG)NULL;
-	    for (seg = rt->segments; seg; seg = seg->next) {
-		newseg = (SEG)malloc(sizeof(struct seg_));
-		if (lastseg == NULL)
-		    newroute->segments = newseg;
-		else
-		    lastseg->next = newseg;
-		lastseg = newseg;
-		newseg->x1 = seg->x1;
-		newseg->x2 = seg->x2;
-		newseg->y1 = seg->y1;
-		newseg->y2 = seg->y2;
-		newseg->layer = seg->layer;
-		newseg->segtype = seg->segtype;
-		newseg->next = (SEG)NULL;
-	    }
-	    i++;
+		lastseg->next = newseg;
+	    lastseg = newseg;
+	    newseg->x1 = seg->x1;
+	    newseg->x2 = seg->x2;
+	    newseg->y1 = seg->y1;
+	    newseg->y2 = seg->y2;
+	    newseg->layer = seg->layer;
+	    newseg->segtype = seg->segtype;
+	    newseg->next = (SEG)NULL;
 	}
+	i++;
+    }
 
-	/* Check each point of each route against the endpoints of the	*/
-	/* other routes, and break routes at connection points, so that	*/
-	/* each route is an independent segment for calculating R, C.	*/
-
-	j = 0;
-	for (rt = droutes; rt; rt = rt->next) {
-	    ROUTE testroute;
-	    int startx, starty, startl;
-	    int endx, endy, endl;
-	    int brkx, brky, brkl, brki, startcompat, endcompat;
-	    int initial, final;
-	    int x1, y1, x2, y2;
-
-	    /* Check all segments (but not the endpoints) */
-	    lastseg = NULL;
-	    for (seg = rt->segments; seg; lastseg = seg, seg = seg->next) {
-		initial = (seg == rt->segments) ? 1 : 0;
-		final = (seg->next == NULL) ? 1 : 0;
-
-		if (initial && (seg->segtype & ST_VIA)) continue;
-		if (final && (seg->segtype & ST_VIA) &&
-				((lastseg != rt->segments) ||
-				(!(rt->segments->segtype & ST_VIA))))
-		    continue;
-
-		x1 = seg->x1;
-		x2 = seg->x2;
-		y1 = seg->y1;
-		y2 = seg->y2;
-
-		if (initial) {
-		    if (y1 == y2) {
-			if (x1 > x2)
-			    x1--;
-			else if (x1 < x2)
-			    x1++;
-			else
-			    continue;	/* shouldn't happen */
-		    }
-		    else {
-			if (y1 > y2)
-			    y1--;
-			else if (y1 < y2)
-			    y1++;
-			else
-			    continue;	/* shouldn't happen */
-		    }
+    /* Check each point of each route against the endpoints of the	*/
+    /* other routes, and break routes at connection points, so that	*/
+    /* each route is an independent segment for calculating R, C.	*/
+    /* Only the routes that start or end on a route can break it,	*/
+    /* and the route graph lists those.				*/
+
+    rg = routegraph_build(net);
+
+    j = 0;
+    for (rt = droutes; rt; rt = rt->next) {
+	int startx, starty, startl;
+	int endx, endy, endl;
+	int brkx, brky, brkl, brki, startcompat, endcompat;
+	int initial, final;
+	int x1, y1, x2, y2;
+	int k, natt, *attached;
+
+	natt = routegraph_attached(rg, eptinfo[j].orig, &attached);
+
+	/* Check all segments (but not the endpoints) */
+	lastseg = NULL;
+	for (seg = rt->segments; seg; lastseg = seg, seg = seg->next) {
+	    initial = (seg == rt->segments) ? 1 : 0;
+	    final = (seg->next == NULL) ? 1 : 0;
+
+	    if (initial && (seg->segtype & ST_VIA)) continue;
+	    if (final && (seg->segtype & ST_VIA) &&
+			    ((lastseg != rt->segments) ||
+			    (!(rt->segments->segtype & ST_VIA))))
+		continue;
+
+	    x1 = seg->x1;
+	    x2 = seg->x2;
+	    y1 = seg->y1;
+	    y2 = seg->y2;
+
+	    if (initial) {
+		if (y1 == y2) {
+		    if (x1 > x2)
+			x1--;
+		    else if (x1 < x2)
+			x1++;
+		    else
+			continue;	/* shouldn't happen */
 		}
-		if (final) {
-		    if (y1 == y2) {
-			if (x1 > x2)
-			    x2++;
-			else if (x1 < x2)
-			    x2--;
-			/* x1 == x2 here implies that the route is made of */
-			/* exactly two vias.  To continue would be to miss */
-			/* the center point between the vias.  This unique */
-			/* condition is type == ST_VIA, final == TRUE.	   */
-		    }
-		    else {
-			if (y1 > y2)
-			    y2++;
-			else if (y1 < y2)
-			    y2--;
-			else
-			    continue;	/* shouldn't happen */
-		    }
+		else {
+		    if (y1 > y2)
+			y1--;
+		    else if (y1 < y2)
+			y1++;
+		    else
+			continue;	/* shouldn't happen */
 		}
-
-		/* Compare against endpoints of all other routes */
-		brki = -1;
-		for (i = 0; i < numroutes; i++) {
-		    if (eptinfo[i].route == rt) continue;
-
-		    testroute = eptinfo[i].orig;
-		    if ((!(testroute->flags & RT_START_NODE)) &&
-				(testroute->start.route == eptinfo[j].orig)) {
-			/* Nothing */
-		    }
-		    else if ((!(testroute->flags & RT_END_NODE)) &&
-				(testroute->end.route == eptinfo[j].orig)) {
-			/* Nothing */
-		    }
+	    }
+	    if (final) {
+		if (y1 == y2) {
+		    if (x1 > x2)
+			x2++;
+		    else if (x1 < x2)
+			x2--;
+		    /* x1 == x2 here implies that the route is made of */
+		    /* exactly two vias.  To continue would be to miss */
+		    /* the center point between the vias.  This unique */
+		    /* condition is type == ST_VIA, final == TRUE.	   */
+		}
+		else {
+		    if (y1 > y2)
+			y2++;
+		    else if (y1 < y2)
+			y2--;
 		    else
-			continue;	/* Not a connected route */
-
-		    /* Check for start/end points connecting on same layer */
-		    startx = eptinfo[i].startx;
-		    starty = eptinfo[i].starty;
-		    startl = eptinfo[i].startl;
-		    endx = eptinfo[i].endx;
-		    endy = eptinfo[i].endy;
-		    endl = eptinfo[i].endl;
-
-		    /* Check various combinations of wire and via layers */
+			continue;	/* shouldn't happen */
+		}
+	    }
 
-		    if (seg->segtype & ST_WIRE) {
+	    /* Compare against endpoints of the connected routes */
+	    brki = -1;
+	    for (k = 0; k < natt; k++) {
+		i = attached[k];
+		if (eptinfo[i].route == rt) continue;
+
+		/* Check for start/end points connecting on same layer */
+		startx = eptinfo[i].startx;
+		starty = eptinfo[i].starty;
+		startl = eptinfo[i].startl;
+		endx = eptinfo[i].endx;
+		endy = eptinfo[i].endy;
+		endl = eptinfo[i].endl;
+
+		/* Check various combinations of wire and via layers */
+
+		if (seg->segtype & ST_WIRE) {
+		    startcompat = (startl == seg->layer);
+		    endcompat = (endl == seg->layer);
+		}
+		else if (final) {
+		    /* Unique condition: route is two vias.  Look	*/
+		    /* only at the point between the vias.		*/
+		    if (lastseg->layer < seg->layer) {
 			startcompat = (startl == seg->layer);
 			endcompat = (endl == seg->layer);
 		    }
-		    else if (final) {
-			/* Unique condition: route is two vias.  Look	*/
-			/* only at the point between the vias.		*/
-			if (lastseg->layer < seg->layer) {
-			    startcompat = (startl == seg->layer);
-			    endcompat = (endl == seg->layer);
-			}
-			else {
-			    startcompat = (startl == seg->layer + 1);
-			    endcompat = (endl == seg->layer + 1);
-			}
-		    }
 		    else {
-			startcompat = (startl == seg->layer)
-					|| (startl == seg->layer + 1);
-			endcompat = (endl == seg->layer)
-					|| (endl == seg->layer + 1);
+			startcompat = (startl == seg->layer + 1);
+			endcompat = (endl == seg->layer + 1);
 		    }
+		}
+		else {
+		    startcompat = (startl == seg->layer)
+				    || (startl == seg->layer + 1);
+		    endcompat = (endl == seg->layer)
+				    || (endl == seg->layer + 1);
+		}
 
-		    if (x1 == x2) {
-			if (startcompat && (startx == x1)) {
-			    if (y1 > y2) {
-				if (starty >= y2 &&
-					starty <= y1) {
-				    brkx = startx;
-				    brky = starty;
-				    brkl = startl;
-				    y2 = brky;
-				    brki = i;
-				}
+		if (x1 == x2) {
+		    if (startcompat && (startx == x1)) {
+			if (y1 > y2) {
+			    if (starty >= y2 &&
+				    starty <= y1) {
+				brkx = startx;
+				brky = starty;
+				brkl = startl;
+				y2 = brky;
+				brki = i;
 			    }
-			    else {
-				if (starty >= y1 &&
-					starty <= y2) {
-				    brkx = startx;
-				    brky = starty;
-				    brkl = startl;
-				    y2 = brky;
-				    brki = i;
-				}
+			}
+			else {
+			    if (starty >= y1 &&
+				    starty <= y2) {
+				brkx = startx;
+				brky = starty;
+				brkl = startl;
+				y2 = brky;
+				brki = i;
 			    }
 			}
-			if (endcompat && (endx == x2)) {
-			    if (y1 > y2) {
-				if (endy >= y2 &&
-					endy <= y1) {
-				    brkx = endx;
-				    brky = endy;
-				    brkl = endl;
-				    y2 = brky;
-				    brki = i;
-				}
+		    }
+		    if (endcompat && (endx == x2)) {
+			if (y1 > y2) {
+			    if (endy >= y2 &&
+				    endy <= y1) {
+				brkx = endx;
+				brky = endy;
+				brkl = endl;
+				y2 = brky;
+				brki = i;
 			    }
-			    else {
-				if (endy >= y1 &&
-					endy <= y2) {
-				    brkx = endx;
-				    brky = endy;
-				    brkl = endl;
-				    y2 = brky;
-				    brki = i;
-				}
+			}
+			else {
+			    if (endy >= y1 &&
+				    endy <= y2) {
+				brkx = endx;
+				brky = endy;
+				brkl = endl;
+				y2 = brky;
+				brki = i;
 			    }
 			}
 		    }
-		    else if (y1 == y2) {
-			if (startcompat && (starty == y1)) {
-			    if (x1 > x2) {
-				if (startx >= x2 &&
-					startx <= x1) {
-				    brkx = startx;
-				    brky = starty;
-				    brkl = startl;
-				    x2 = brkx;
-				    brki = i;
-				}
+		}
+		else if (y1 == y2) {
+		    if (startcompat && (starty == y1)) {
+			if (x1 > x2) {
+			    if (startx >= x2 &&
+				    startx <= x1) {
+				brkx = startx;
+				brky = starty;
+				brkl = startl;
+				x2 = brkx;
+				brki = i;
 			    }
-			    else {
-				if (startx >= x1 &&
-					startx <= x2) {
-				    brkx = startx;
-				    brky = starty;
-				    brkl = startl;
-				    x2 = brkx;
-				    brki = i;
-				}
+			}
+			else {
+			    if (startx >= x1 &&
+				    startx <= x2) {
+				brkx = startx;
+				brky = starty;
+				brkl = startl;
+				x2 = brkx;
+				brki = i;
 			    }
 			}
-			if (endcompat && (endy == y2)) {
-			    if (x1 > x2) {
-				if (endx >= x2 &&
-					endx <= x1) {
-				    brkx = endx;
-				    brky = endy;
-				    brkl = endl;
-				    x2 = brkx;
-				    brki = i;
-				}
+		    }
+		    if (endcompat && (endy == y2)) {
+			if (x1 > x2) {
+			    if (endx >= x2 &&
+				    endx <= x1) {
+				brkx = endx;
+				brky = endy;
+				brkl = endl;
+				x2 = brkx;
+				brki = i;
 			    }
-			    else {
-				if (endx >= x1 &&
-					endx <= x2) {
-				    brkx = endx;
-				    brky = endy;
-				    brkl = endl;
-				    x2 = brkx;
-				    brki = i;
-				}
+			}
+			else {
+			    if (endx >= x1 &&
+				    endx <= x2) {
+				brkx = endx;
+				brky = endy;
+				brkl = endl;
+				x2 = brkx;
+				brki = i;
 			    }
 			}
 		    }
 		}
-		if (brki >= 0) {
-		    /* Disable this endpoint so it is not checked again */
-		    eptinfo[brki].endl = -2;
-
-		    /* Break route at this point */
-		    /* If route type is a wire, then make a copy of the	*/
-		    /* segment where the break occurs.  If a via, then	*/
-		    /* determine which side of the break the via goes	*/
-		    /* to.						*/
-
-		    newroute = (ROUTE)malloc(sizeof(struct route_));
-
-		    if (seg->segtype & ST_WIRE) {
-			newseg = (SEG)malloc(sizeof(struct seg_));
-			newseg->segtype = seg->segtype;
-			newseg->x1 = brkx;
-			newseg->y1 = brky;
-			newseg->x2 = seg->x2;
-			newseg->y2 = seg->y2;
-			newseg->layer = seg->layer;
-
-			newseg->next = seg->next;
-			seg->next = NULL;
-			seg->x2 = brkx;
-			seg->y2 = brky;
+	    }
+	    if (brki >= 0) {
+		/* Disable this endpoint so it is not checked again */
+		eptinfo[brki].endl = -2;
+
+		/* Break route at this point */
+		/* If route type is a wire, then make a copy of the	*/
+		/* segment where the break occurs.  If a via, then	*/
+		/* determine which side of the break the via goes	*/
+		/* to.						*/
+
+		newroute = (ROUTE)pool_alloc(&dc->routes);
+
+		if (seg->segtype & ST_WIRE) {
+		    newseg = (SEG)pool_alloc(&dc->segs);
+		    newseg->segtype = seg->segtype;
+		    newseg->x1 = brkx;
+		    newseg->y1 = brky;
+		    newseg->x2 = seg->x2;
+		    newseg->y2 = seg->y2;
+		    newseg->layer = seg->layer;
+
+		    newseg->next = seg->next;
+		    seg->next = NULL;
+		    seg->x2 = brkx;
+		    seg->y2 = brky;
 
-			newroute->segments = newseg;
-		    }
-		    else if (lastseg == NULL) {
-			/* Via is the route before the break */
+		    newroute->segments = newseg;
+		}
+		else if (lastseg == NULL) {
+		    /* Via is the route before the break */
+		    newroute->segments = seg->next;
+		    seg->next = NULL;
+		}
+		else if (lastseg->layer <= seg->layer) {
+		    if (brkl > seg->layer) {
+			/* Via goes at the end of the route before the break */
 			newroute->segments = seg->next;
 			seg->next = NULL;
 		    }
-		    else if (lastseg->layer <= seg->layer) {
-			if (brkl > seg->layer) {
-			    /* Via goes at the end of the route before the break */
-			    newroute->segments = seg->next;
-			    seg->next = NULL;
-			}
-			else {
-			    /* Via goes at the start of the route after the break */
-			    newroute->segments = seg;
-			    lastseg->next = NULL;
-			}
+		    else {
+			/* Via goes at the start of the route after the break */
+			newroute->segments = seg;
+			lastseg->next = NULL;
 		    }
-		    else {	/* (lastseg->layer > seg->layer) */
-			if (brkl > seg->layer) {
-			    /* Via goes at the start of the route after the break */
-			    newroute->segments = seg;
-			    lastseg->next = NULL;
-			}
-			else {
-			    /* Via goes at the end of the route before the break */
-			    newroute->segments = seg->next;
-			    seg->next = NULL;
-			}
+		}
+		else {	/* (lastseg->layer > seg->layer) */
+		    if (brkl > seg->layer) {
+			/* Via goes at the start of the route after the break */
+			newroute->segments = seg;
+			lastseg->next = NULL;
 		    }
+		    else {
+			/* Via goes at the end of the route before the break */
+			newroute->segments = seg->next;
+			seg->next = NULL;
+		    }
+		}
 
-		    newroute->netnum = rt->netnum;
-		    newroute->flags = (u_char)0;
-		    newroute->next = rt->next;
-		    rt->next = newroute;
+		newroute->netnum = rt->netnum;
+		newroute->flags = (u_char)0;
+		newroute->next = rt->next;
+		rt->next = newroute;
 
-		    newroute->start.route = NULL;
-		    newroute->end.route = NULL;
+		newroute->start.route = NULL;
+		newroute->end.route = NULL;
 
-		    /* Update eptinfo[j].route to point to new route */
-		    eptinfo[j].route = newroute;
+		/* Update eptinfo[j].route to point to new route */
+		eptinfo[j].route = newroute;
 
-		    /* Next loop ends list of segs and moves to next route */
-		    /* which is still the same original route, so adjust j */
-		    /* index so that it still refers to the correct	   */
-		    /* eptinfo entry.					   */
-		    j--;
-		}
+		/* Next loop ends list of segs and moves to next route */
+		/* which is still the same original route, so adjust j */
+		/* index so that it still refers to the correct	   */
+		/* eptinfo entry.					   */
+		j--;
+
+		/* The rest of the segments are checked as part of	*/
+		/* the new route.					*/
+		break;
 	    }
-	    j++;
 	}
+	j++;
+    }
 
-	/* Regenerate endpoint information */
-	free(eptinfo);
-	numroutes = 0;
-	for (rt = droutes; rt; rt = rt->next) numroutes++;
-	eptinfo = (endpointinfo *)malloc(numroutes * sizeof(endpointinfo));
-
-	/* Determine the driver and fill in endpoint information */
-	nroute = 0;
-	drivergate = NULL;
-	drivernodeidx = -1;
-	driveridx = -1;
-	for (rt = droutes; rt; rt = rt->next) {
-	    eptinfo[nroute].route = rt;
-	    eptinfo[nroute].flags = (u_char)0;
-	    /* Segment start */
-	    seg = rt->segments;
-	    if (seg == NULL) {
-		eptinfo[nroute].route = NULL;
-		eptinfo[nroute].startnode = NULL;
-		eptinfo[nroute].endnode = NULL;
-		eptinfo[nroute].branching = NULL;
-		nroute++;
-		continue;
+    routegraph_free(rg);
+
+    /* Regenerate endpoint information */
+    free(eptinfo);
+    numroutes = 0;
+    for (rt = droutes; rt; rt = rt->next) numroutes++;
+    eptinfo = (endpointinfo *)malloc(numroutes * sizeof(endpointinfo));
+
+    /* Determine the driver and fill in endpoint information */
+    nroute = 0;
+    drivergate = NULL;
+    drivernodeidx = -1;
+    driveridx = -1;
+    for (rt = droutes; rt; rt = rt->next) {
+	eptinfo[nroute].route = rt;
+	eptinfo[nroute].flags = (u_char)0;
+	/* Segment start */
+	seg = rt->segments;
+	if (seg == NULL) {
+	    eptinfo[nroute].route = NULL;
+	    eptinfo[nroute].startnode = NULL;
+	    eptinfo[nroute].endnode = NULL;
+	    eptinfo[nroute].branching = NULL;
+	    nroute++;
+	    continue;
+	}
+	eptinfo[nroute].startx = seg->x1;
+	eptinfo[nroute].starty = seg->y1;
+	eptinfo[nroute].startl = seg->layer;
+	/* Check for via in down direction rather than the default up */
+	if ((seg->segtype & ST_VIA) && seg->next && seg->next->layer <= seg->layer)
+	    eptinfo[nroute].startl++;
+	nodeptr = (seg->layer < Pinlayers) ?
+		    NODEIPTR(seg->x1, seg->y1, seg->layer) : NULL;
+	eptinfo[nroute].startnode = nodeptr ? nodeptr->nodesav : NULL;
+	/* In a 3D grid there can be at most 5 downstream branches	*/
+	/* from a single point.					*/
+	eptinfo[nroute].branching = (int *)malloc(5 * sizeof(int));
+	eptinfo[nroute].branching[0] = -1;
+	eptinfo[nroute].res = 0.0;
+	eptinfo[nroute].cap = 0.0;
+
+	/* Look up node */
+	if (nodeptr && nodeptr->nodesav) {
+	    g = FindGateNode(nodeptr->nodesav, &i);
+	    if (g && (g->gatetype->direction[i] == PORT_CLASS_OUTPUT)) {
+		drivernodeidx = i;
+		driveridx = nroute;
+		drivergate = g;
+		driverend = 0;
 	    }
-	    eptinfo[nroute].startx = seg->x1;
-	    eptinfo[nroute].starty = seg->y1;
-	    eptinfo[nroute].startl = seg->layer;
-	    /* Check for via in down direction rather than the default up */
-	    if ((seg->segtype & ST_VIA) && seg->next && seg->next->layer <= seg->layer)
-		eptinfo[nroute].startl++;
-	    nodeptr = (seg->layer < Pinlayers) ?
-			NODEIPTR(seg->x1, seg->y1, seg->layer) : NULL;
-	    eptinfo[nroute].startnode = nodeptr ? nodeptr->nodesav : NULL;
-	    /* In a 3D grid there can be at most 5 downstream branches	*/
-	    /* from a single point.					*/
-	    eptinfo[nroute].branching = (int *)malloc(5 * sizeof(int));
-	    eptinfo[nroute].branching[0] = -1;
-	    eptinfo[nroute].res = 0.0;
-	    eptinfo[nroute].cap = 0.0;
-
-	    /* Look up node */
-	    if (nodeptr && nodeptr->nodesav) {
-		g = FindGateNode(&NodeTable, nodeptr->nodesav, &i);
-		if (g && (g->gatetype->direction[i] == PORT_CLASS_OUTPUT)) {
+	    else if (g && (g->gatetype->direction[i] != PORT_CLASS_INPUT)) {
+		if (drivernodeidx == -1) {
 		    drivernodeidx = i;
 		    driveridx = nroute;
 		    drivergate = g;
 		    driverend = 0;
 		}
-		else if (g && (g->gatetype->direction[i] != PORT_CLASS_INPUT)) {
-		    if (drivernodeidx == -1) {
-			drivernodeidx = i;
-			driveridx = nroute;
-			drivergate = g;
-			driverend = 0;
-		    }
-		}
-		else if (g == NULL) {
-		    /* should not happen? */
-		    if (nodeptr->nodesav->netname == NULL)
-			Fprintf(stderr, "Cannot find recorded node of netnum %d\n",
-				nodeptr->nodesav->netnum);
-		    else
-			Fprintf(stderr, "Cannot find recorded node of net %s\n",
-				nodeptr->nodesav->netname);
-		}
 	    }
-
-	    /* Segment end */
-	    lastseg = NULL;
-	    for (seg = rt->segments; seg && seg->next; seg = seg->next)
-		lastseg = seg;
-	    eptinfo[nroute].endx = seg->x2;
-	    eptinfo[nroute].endy = seg->y2;
-	    eptinfo[nroute].endl = seg->layer;
-	    /* Check for via in down direction rather than default up */
-	    if (seg->segtype & ST_VIA) {
-		if (lastseg && lastseg->layer <= seg->layer)
-		    eptinfo[nroute].endl++;
-		else if (!lastseg && eptinfo[nroute].endl <= seg->layer)
-		    eptinfo[nroute].endl++;
+	    else if (g == NULL) {
+		/* should not happen? */
+		if (nodeptr->nodesav->netname == NULL)
+		    db_message(db, stderr, "Cannot find recorded node of netnum %d\n",
+			    nodeptr->nodesav->netnum);
+		else
+		    db_message(db, stderr, "Cannot find recorded node of net %s\n",
+			    nodeptr->nodesav->netname);
 	    }
+	}
 
-	    nodeptr = (eptinfo[nroute].endl < Pinlayers) ?
-			NODEIPTR(seg->x2, seg->y2, eptinfo[nroute].endl) : NULL;
-	    eptinfo[nroute].endnode = nodeptr ? nodeptr->nodesav : NULL;
+	/* Segment end */
+	lastseg = NULL;
+	for (seg = rt->segments; seg && seg->next; seg = seg->next)
+	    lastseg = seg;
+	eptinfo[nroute].endx = seg->x2;
+	eptinfo[nroute].endy = seg->y2;
+	eptinfo[nroute].endl = seg->layer;
+	/* Check for via in down direction rather than default up */
+	if (seg->segtype & ST_VIA) {
+	    if (lastseg && lastseg->layer <= seg->layer)
+		eptinfo[nroute].endl++;
+	    else if (!lastseg && eptinfo[nroute].endl <= seg->layer)
+		eptinfo[nroute].endl++;
+	}
 
-	    /* Look up node */
-	    if (nodeptr && nodeptr->nodesav) {
-		g = FindGateNode(&NodeTable, nodeptr->nodesav, &i);
-		if (g && (g->gatetype->direction[i] == PORT_CLASS_OUTPUT)) {
+	nodeptr = (eptinfo[nroute].endl < Pinlayers) ?
+		    NODEIPTR(seg->x2, seg->y2, eptinfo[nroute].endl) : NULL;
+	eptinfo[nroute].endnode = nodeptr ? nodeptr->nodesav : NULL;
+
+	/* Look up node */
+	if (nodeptr && nodeptr->nodesav) {
+	    g = FindGateNode(nodeptr->nodesav, &i);
+	    if (g && (g->gatetype->direction[i] == PORT_CLASS_OUTPUT)) {
+		drivernodeidx = i;
+		driveridx = nroute;
+		drivergate = g;
+		driverend = 1;
+	    }
+	    else if (g && (g->gatetype->direction[i] != PORT_CLASS_INPUT)) {
+		if (drivernodeidx == -1) {
 		    drivernodeidx = i;
 		    driveridx = nroute;
 		    drivergate = g;
 		    driverend = 1;
 		}
-		else if (g && (g->gatetype->direction[i] != PORT_CLASS_INPUT)) {
-		    if (drivernodeidx == -1) {
-			drivernodeidx = i;
-			driveridx = nroute;
-			drivergate = g;
-			driverend = 1;
-		    }
-		}
-		else if (g == NULL) {
-		    /* should not happen? */
-		    if (nodeptr->nodesav->netname == NULL)
-			Fprintf(stderr, "Cannot find recorded node of netnum %d\n",
-				nodeptr->nodesav->netnum);
-		    else
-			Fprintf(stderr, "Cannot find recorded node of net %s\n",
-				nodeptr->nodesav->netname);
-		}
 	    }
-	    nroute++;
+	    else if (g == NULL) {
+		/* should not happen? */
+		if (nodeptr->nodesav->netname == NULL)
+		    db_message(db, stderr, "Cannot find recorded node of netnum %d\n",
+			    nodeptr->nodesav->netnum);
+		else
+		    db_message(db, stderr, "Cannot find recorded node of net %s\n",
+			    nodeptr->nodesav->netname);
+	    }
 	}
+	nroute++;
+    }
 
-	/* Start with net driver node, start generating output */
+    /* Index the endpoints of the broken routes for the walk */
 
-	if ((drivernodeidx != -1) && (driveridx != -1)) {
+    rg = routegraph_new(nroute);
+    for (i = 0; i < nroute; i++) {
+	if (eptinfo[i].route == NULL) continue;
+	routegraph_add_endpoint(rg, i, 0, eptinfo[i].startx,
+		    eptinfo[i].starty, eptinfo[i].startl, eptinfo[i].startnode);
+	routegraph_add_endpoint(rg, i, 1, eptinfo[i].endx,
+		    eptinfo[i].endy, eptinfo[i].endl, eptinfo[i].endnode);
+    }
+    routegraph_finish(rg);
+
+    /* Start with net driver node, start generating output */
+
+    if ((drivernodeidx != -1) && (driveridx != -1)) {
+
+	eptinfo[driveridx].flags |= EPT_DRIVER;
+
+	/* Diagnostic, for debugging */
+	/*
+	db_message(db, stdout, "Walking net %s.\n", net->netname);
+	db_message(db, stdout, "Has %d nodes.\n", net->numnodes);
+	db_message(db, stdout, "After segmenting, has %d routes.\n", numroutes);
+	db_message(db, stdout, "Driver node %s/%s\n",
+		    drivergate->gatename,
+		    drivergate->gatetype->node[drivernodeidx]);
+	*/
+	if (!strcmp(drivergate->gatetype->node[drivernodeidx], "pin"))
+	    db_printf(db, "%s 1 PIN/%s %d ",
+		    net->netname, drivergate->gatename, net->numnodes - 1);
+	else
+	    db_printf(db, "%s 1 %s/%s %d ",
+		    net->netname, drivergate->gatename,
+		    drivergate->gatetype->node[drivernodeidx],
+		    net->numnodes - 1);
 
-	    eptinfo[driveridx].flags |= EPT_DRIVER;
+	/* Walk the route and organize from driver to terminals and */
+	/* accumulate resistance and capacitance of each segment	*/
 
-	    /* Diagnostic, for debugging */
-	    /*
-	    Fprintf(stdout, "Walking net %s.\n", net->netname);
-	    Fprintf(stdout, "Has %d nodes.\n", net->numnodes);
-	    Fprintf(stdout, "After segmenting, has %d routes.\n", numroutes);
-	    Fprintf(stdout, "Driver node %s/%s\n",
-			drivergate->gatename,
-			drivergate->gatetype->node[drivernodeidx]);
-	    */
-	    if (!strcmp(drivergate->gatetype->node[drivernodeidx], "pin"))
-		fprintf(delayFile, "%s 1 PIN/%s %d ",
-			net->netname, drivergate->gatename, net->numnodes - 1);
-	    else
-		fprintf(delayFile, "%s 1 %s/%s %d ",
-			net->netname, drivergate->gatename,
-			drivergate->gatetype->node[drivernodeidx],
-			net->numnodes - 1);
+	walk_route(driveridx, driverend, eptinfo, rg, dc);
 
-	    /* Walk the route and organize from driver to terminals and */
-	    /* accumulate resistance and capacitance of each segment	*/
+	/* Diagnostic:  There should be no unhandled segments if	*/
+	/* everything went right.					*/
 
-	    walk_route(driveridx, driverend, eptinfo, nroute, lefrcvalues);
+	for (i = 0; i < numroutes; i++) {
+	    if ((eptinfo[i].flags & EPT_VISITED) == (u_char)0) {
+		db_message(db, stderr, "Route segment %d was not walked!\n", i);
+	    }
+	}
 
-	    /* Diagnostic:  There should be no unhandled segments if	*/
-	    /* everything went right.					*/
+	walk_route_output(eptinfo, driveridx, db);
+	db_printf(db, "\n");	/* End of net output */
+
+	/* Record the total capacitance and the R and delay to each */
+	/* receiver.						    */
+
+	downcap = (double *)malloc(numroutes * sizeof(double));
+	rc->totalcap = walk_route_cap(eptinfo, driveridx, downcap);
+	rc->sinks = (RCSINK *)malloc(numroutes * sizeof(RCSINK));
+	rc->numsinks = 0;
+	walk_route_sinks(eptinfo, driveridx, 0.0, 0.0, downcap, rc);
+	free(downcap);
+	if (rc->numsinks == 0) {
+	    free(rc->sinks);
+	    rc->sinks = NULL;
+	}
+	else
+	    rc->sinks = (RCSINK *)realloc(rc->sinks,
+			rc->numsinks * sizeof(RCSINK));
 
-	    for (i = 0; i < numroutes; i++) {
-		if ((eptinfo[i].flags & EPT_VISITED) == (u_char)0) {
-		    Fprintf(stderr, "Route segment %d was not walked!\n", i);
-		}
-	    }
+	if (spef != NULL)
+	    spef_net_output(net, eptinfo, driveridx, numroutes,
+			rc->totalcap, dc, spef);
+    }
+    else {
+	if (net->netname == NULL)
+	    db_message(db, stderr, "No driver for netnum %d\n", net->netnum);
+	else
+	    db_message(db, stderr, "No driver for net %s\n", net->netname);
+    }
+
+    /* Free up allocated information */
+
+    routegraph_free(rg);
+    for (rt = droutes; rt; ) {
+	pool_free_list(&dc->segs, rt->segments);
+	nxroute = rt->next;
+	pool_free(&dc->routes, rt);
+	rt = nxroute;
+    }
+    for (i = 0; i < nroute; i++)
+	if (eptinfo[i].branching != NULL)
+	    free(eptinfo[i].branching);
+    free(eptinfo);
+}
+
+/*--------------------------------------------------------------*/
+/* Parallel extraction.  The nets to be extracted are divided	*/
+/* among the worker threads, each of which leaves the results	*/
+/* of its nets with the nets (and the SPEF text of each net in	*/
+/* a buffer of its own).  The results are then written out in	*/
+/* net order.							*/
+/*--------------------------------------------------------------*/
 
-	    walk_route_output(eptinfo, driveridx, &NodeTable, delayFile);
-	    fprintf(delayFile, "\n");	/* End of net output */
+#define DELAY_THREAD_MIN	64	/* Minimum nets per thread	 */
+#define SPEF_BATCH_SIZE		4096	/* Nets extracted between writes */
+
+typedef struct {
+    NET      *nets;
+    delaybuf *spef;		/* SPEF text of each net, or NULL */
+    int       first;		/* First net for this thread	*/
+    int       last;		/* One past the last net	*/
+    delayctx *proto;		/* R and C values and name map	*/
+} DelaySlice;
+
+static void *
+delay_net_worker(void *arg)
+{
+    DelaySlice *slice = (DelaySlice *)arg;
+    delayctx dc;
+    NET net;
+    int i;
+
+    dc.lefrcvalues = slice->proto->lefrcvalues;
+    dc.gates = slice->proto->gates;
+    dc.numgates = slice->proto->numgates;
+    pool_init(&dc.segs, sizeof(struct seg_));
+    pool_init(&dc.routes, sizeof(struct route_));
+
+    for (i = slice->first; i < slice->last; i++) {
+	net = slice->nets[i];
+	delay_net(net, &dc, net->rc,
+		(slice->spef != NULL) ? &slice->spef[i] : NULL);
+	db_trim(&net->rc->out);
+    }
+
+    pool_release(&dc.segs);
+    pool_release(&dc.routes);
+    return NULL;
+}
+
+/*--------------------------------------------------------------*/
+/* Extract nets[0] to nets[n - 1], which must all have a	*/
+/* result record, dividing the nets among up to		*/
+/* thread_count() threads.  If "spef" is not NULL, the SPEF	*/
+/* text of each net is added to spef[0] to spef[n - 1].  If a	*/
+/* thread cannot be started, its share is done in the main	*/
+/* thread.							*/
+/*--------------------------------------------------------------*/
+
+static void
+delay_net_batch(NET *nets, delaybuf *spef, int n, delayctx *proto)
+{
+    DelaySlice one;
+#ifdef HAVE_PTHREAD_H
+    pthread_t *thread;
+    DelaySlice *slice;
+    u_char *started;
+    int t, nthreads;
+#endif
+
+    one.nets = nets;
+    one.spef = spef;
+    one.first = 0;
+    one.last = n;
+    one.proto = proto;
+
+#ifdef HAVE_PTHREAD_H
+    nthreads = thread_count();
+    if (nthreads > n / DELAY_THREAD_MIN) nthreads = n / DELAY_THREAD_MIN;
+
+    if (nthreads > 1) {
+	thread = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+	slice = (DelaySlice *)malloc(nthreads * sizeof(DelaySlice));
+	started = (u_char *)malloc(nthreads * sizeof(u_char));
+
+	for (t = 0; t < nthreads; t++) {
+	    slice[t] = one;
+	    slice[t].first = (int)(((long)n * t) / nthreads);
+	    slice[t].last = (int)(((long)n * (t + 1)) / nthreads);
+	    started[t] = (pthread_create(&thread[t], NULL, delay_net_worker,
+			(void *)&slice[t]) == 0);
 	}
-	else {
-	    if (net->netname == NULL)
-		Fprintf(stderr, "No driver for netnum %d\n", net->netnum);
-	    else
-		Fprintf(stderr, "No driver for net %s\n", net->netname);
+	for (t = 0; t < nthreads; t++)
+	    if (!started[t]) delay_net_worker((void *)&slice[t]);
+	for (t = 0; t < nthreads; t++)
+	    if (started[t]) pthread_join(thread[t], NULL);
+
+	free(started);
+	free(slice);
+	free(thread);
+	return;
+    }
+#endif
+    delay_net_worker((void *)&one);
+}
+
+/*--------------------------------------------------------------*/
+/* Fill in the record of R and C values per layer.  If the	*/
+/* values are not those that the results kept with the nets	*/
+/* were made with (because LEF information has changed), then	*/
+/* mark every net to be extracted again.			*/
+/*--------------------------------------------------------------*/
+
+static lefrcinfo *
+delay_rc_values(void)
+{
+    lefrcinfo *lefrcvalues;
+    int i;
+
+    lefrcvalues = (lefrcinfo *)calloc(Num_layers, sizeof(lefrcinfo));
+    for (i = 0; i < Num_layers; i++) {
+	double areacap, edgecap;
+	double respersq, respervia;
+	double width, sqx, sqy;
+
+	LefGetRouteRCvalues(i, &areacap, &edgecap, &respersq);
+	width = LefGetRouteWidth(i);
+
+	lefrcvalues[i].resx = (PitchX / width) * respersq;
+	lefrcvalues[i].resy = (PitchY / width) * respersq;
+
+	lefrcvalues[i].capx = (PitchX * width) * areacap + (PitchX * edgecap);
+	lefrcvalues[i].capy = (PitchY * width) * areacap + (PitchY * edgecap);
+
+	if (i < (Num_layers - 1))
+	    LefGetViaResistance(i, &(lefrcvalues[i].viares));
+	else
+	    lefrcvalues[i].viares = 0.0;	/* Not used */
+    }
+
+    if ((RCvalues != NULL) && (RCnumlayers == Num_layers) &&
+		!memcmp(RCvalues, lefrcvalues, Num_layers * sizeof(lefrcinfo))) {
+	free(lefrcvalues);
+	return RCvalues;
+    }
+
+    if (RCvalues != NULL) free(RCvalues);
+    RCvalues = lefrcvalues;
+    RCnumlayers = Num_layers;
+    for (i = 0; i < Numnets; i++)
+	Nlnets[i]->flags |= NET_RC_DIRTY;
+    return RCvalues;
+}
+
+/*--------------------------------------------------------------*/
+/* Write an output file of the calculated R, C for every route	*/
+/* branch (see delay_net()).  Nets are extracted in parallel on	*/
+/* up to thread_count() threads, and written in netlist order.	*/
+/* If "incremental" is set, only the nets whose routes have	*/
+/* changed since they were last extracted are extracted, and	*/
+/* the kept results of the other nets are written again.	*/
+/*--------------------------------------------------------------*/
+
+static int
+write_delay_file(char *filename, u_char incremental)
+{
+    FILE *delayFile;
+    int i, n;
+    delayctx proto;
+    NET net, *nets;
+
+    if (filename == NULL)
+	delayFile = zfile_open(delayfilename, "w");
+    else if (!strcmp(filename, "stdout"))
+	delayFile = stdout;
+    else
+	delayFile = zfile_open(filename, "w");
+
+    if (!delayFile) {
+	Fprintf(stderr, "write_delays():  Couldn't open output delay file.\n");
+	return -1;
+    }
+
+    proto.lefrcvalues = delay_rc_values();
+    proto.gates = NULL;
+    proto.numgates = 0;
+
+    /* Each net is extracted independently.  Find the nets to	*/
+    /* extract, and extract them all before writing.		*/
+
+    nets = (NET *)malloc(((Numnets > 0) ? Numnets : 1) * sizeof(NET));
+    n = 0;
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	if (incremental && (net->rc != NULL) && !(net->flags & NET_RC_DIRTY))
+	    continue;
+	if (net->rc == NULL)
+	    net->rc = (struct netrc_ *)calloc(1, sizeof(struct netrc_));
+	nets[n++] = net;
+    }
+    if (n > 0) delay_net_batch(nets, NULL, n, &proto);
+    for (i = 0; i < n; i++)
+	nets[i]->flags &= ~NET_RC_DIRTY;
+    free(nets);
+
+    if (incremental && (Verbose > 0))
+	Fprintf(stdout, "Extracted %d of %d nets; reused the rest.\n",
+		n, Numnets);
+
+    for (i = 0; i < Numnets; i++)
+	db_write(&Nlnets[i]->rc->out, delayFile);
+
+    if (delayFile != stdout)
+	zfile_close(delayFile);
+    else
+	fflush(delayFile);
+
+    return 0;
+}
+
+int write_delays(char *filename)
+{
+    if (spef_file_name((filename == NULL) ? delayfilename : filename))
+	return write_spef((filename == NULL) ? delayfilename : filename);
+    return write_delay_file(filename, (u_char)0);
+}
+
+/*--------------------------------------------------------------*/
+/* write_delays_incremental() ---				*/
+/*								*/
+/* As write_delays(), but extract only the nets whose routes	*/
+/* have changed since they were last extracted.  (A SPEF file	*/
+/* is always written in full.)					*/
+/*--------------------------------------------------------------*/
+
+int write_delays_incremental(char *filename)
+{
+    if (spef_file_name((filename == NULL) ? delayfilename : filename))
+	return write_spef((filename == NULL) ? delayfilename : filename);
+    return write_delay_file(filename, (u_char)1);
+}
+
+/*--------------------------------------------------------------*/
+/* Return 1 if "filename" (less any compression suffix) ends	*/
+/* in ".spef", so that the file is to be written as SPEF.	*/
+/*--------------------------------------------------------------*/
+
+static int
+spef_file_name(char *filename)
+{
+    char *zsuffix;
+    size_t len;
+
+    if (filename == NULL) return 0;
+    zsuffix = zfile_suffix(filename);
+    len = (zsuffix != NULL) ? (size_t)(zsuffix - filename) : strlen(filename);
+    return ((len > 5) && !strncmp(filename + len - 5, ".spef", 5)) ? 1 : 0;
+}
+
+/*--------------------------------------------------------------*/
+/* write_spef() ---						*/
+/*								*/
+/* Write the R and C of the routes of every net as a SPEF	*/
+/* file, with the nets and instances named through the name	*/
+/* map.  Nets are extracted in batches on up to		*/
+/* thread_count() threads, and each batch is written before	*/
+/* the next one is extracted.  The results of the extraction	*/
+/* are kept with the nets as they are by write_delays().	*/
+/* If "filename" is NULL, the name of the DEF file is used	*/
+/* with the extension ".spef".					*/
+/*								*/
+/* Results:							*/
+/*	0 on success, -1 if the file cannot be opened.		*/
+/*--------------------------------------------------------------*/
+
+int
+write_spef(char *filename)
+{
+    FILE *spefFile;
+    char *spefname = NULL, *design, *dotptr, *zsuffix, *tstr;
+    delaybuf hdr, *bufs;
+    delayctx proto;
+    GATE g;
+    NET net;
+    time_t now;
+    int i, n, nbatch;
+
+    if (filename == NULL) {
+	if (DEFfilename == NULL) {
+	    Fprintf(stderr, "write_spef():  No DEF file name for output.\n");
+	    return -1;
 	}
+	spefname = (char *)malloc(strlen(DEFfilename) + 6);
+	strcpy(spefname, DEFfilename);
+	zsuffix = zfile_suffix(spefname);
+	if (zsuffix) *zsuffix = '\0';
+	dotptr = strrchr(spefname, '.');
+	if (dotptr)
+	    strcpy(dotptr, ".spef");
+	else
+	    strcat(spefname, ".spef");
+	if (zsuffix) strcat(spefname, zfile_suffix(DEFfilename));
+	filename = spefname;
+    }
+
+    if (!strcmp(filename, "stdout"))
+	spefFile = stdout;
+    else
+	spefFile = zfile_open(filename, "w");
 
-	/* Free up allocated information */
+    if (!spefFile) {
+	Fprintf(stderr, "write_spef():  Couldn't open output SPEF file %s.\n",
+		filename);
+	if (spefname) free(spefname);
+	return -1;
+    }
 
-	for (rt = droutes; rt; ) {
-	    for (seg = rt->segments; seg; ) {
-		nxseg = seg->next;
-		free(seg);
-		seg = nxseg;
-	    }
-	    nxroute = rt->next;
-	    free(rt);
-	    rt = nxroute;
+    /* The design name is the DEF file name without its path or	*/
+    /* extension.							*/
+
+    design = strdup((DEFfilename == NULL) ? "" :
+		(strrchr(DEFfilename, '/') != NULL) ?
+		strrchr(DEFfilename, '/') + 1 : DEFfilename);
+    zsuffix = zfile_suffix(design);
+    if (zsuffix) *zsuffix = '\0';
+    dotptr = strrchr(design, '.');
+    if (dotptr) *dotptr = '\0';
+
+    now = time(NULL);
+    tstr = ctime(&now);
+    if (tstr == NULL) tstr = "";
+
+    memset(&hdr, 0, sizeof(delaybuf));
+    db_printf(&hdr, "*SPEF \"IEEE 1481-1998\"\n");
+    db_printf(&hdr, "*DESIGN \"%s\"\n", design);
+    db_printf(&hdr, "*DATE \"%.24s\"\n", tstr);
+    db_printf(&hdr, "*VENDOR \"Open Circuit Design\"\n");
+    db_printf(&hdr, "*PROGRAM \"Qrouter\"\n");
+    db_printf(&hdr, "*VERSION \"%s.%s\"\n", VERSION, REVISION);
+    db_printf(&hdr, "*DESIGN_FLOW \"PIN_CAP NONE\" \"NAME_SCOPE LOCAL\"\n");
+    db_printf(&hdr, "*DIVIDER /\n");
+    db_printf(&hdr, "*DELIMITER :\n");
+    db_printf(&hdr, "*BUS_DELIMITER [ ]\n");
+    db_printf(&hdr, "*T_UNIT 1 NS\n");
+    db_printf(&hdr, "*C_UNIT 1 PF\n");
+    db_printf(&hdr, "*R_UNIT 1 OHM\n");
+    db_printf(&hdr, "*L_UNIT 1 HENRY\n");
+    free(design);
+
+    /* Name map:  each net by its net number, and each instance	*/
+    /* by its position in the instance list, after the nets.	*/
+
+    db_printf(&hdr, "\n*NAME_MAP\n");
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	if ((net->netnum == VDD_NET) || (net->netnum == GND_NET) ||
+		(net->netnum == ANTENNA_NET)) continue;
+	db_printf(&hdr, "*%d ", net->netnum);
+	spef_name(&hdr, net->netname);
+	db_printf(&hdr, "\n");
+	if (hdr.len > 65536) {
+	    db_write(&hdr, spefFile);
+	    hdr.len = 0;
 	}
-	for (i = 0; i < nroute; i++)
-	    if (eptinfo[i].branching != NULL)
-		free(eptinfo[i].branching);
-	free(eptinfo);
     }
-    fclose(delayFile);
 
-    free(lefrcvalues);
+    n = 0;
+    for (g = Nlgates; g; g = g->next)
+	if (g->gatetype != PinMacro) n++;
+    proto.gates = (spefgate *)malloc(((n > 0) ? n : 1) * sizeof(spefgate));
+    n = 0;
+    for (g = Nlgates; g; g = g->next) {
+	if (g->gatetype == PinMacro) continue;
+	proto.gates[n].gate = g;
+	proto.gates[n].id = MAXNETNUM + 1 + n;
+	db_printf(&hdr, "*%d ", proto.gates[n].id);
+	spef_name(&hdr, g->gatename);
+	db_printf(&hdr, "\n");
+	if (hdr.len > 65536) {
+	    db_write(&hdr, spefFile);
+	    hdr.len = 0;
+	}
+	n++;
+    }
+    proto.numgates = n;
+    qsort(proto.gates, n, sizeof(spefgate), spef_ptr_compare);
+
+    db_printf(&hdr, "\n*PORTS\n");
+    for (g = Nlgates; g; g = g->next) {
+	if (g->gatetype != PinMacro) continue;
+	if ((g->netnum[0] == VDD_NET) || (g->netnum[0] == GND_NET)) continue;
+	spef_name(&hdr, g->gatename);
+	db_printf(&hdr, " %s\n", (g->direction[0] == PORT_CLASS_INPUT) ? "I" :
+		(g->direction[0] == PORT_CLASS_OUTPUT) ? "O" : "B");
+	if (hdr.len > 65536) {
+	    db_write(&hdr, spefFile);
+	    hdr.len = 0;
+	}
+    }
+    db_write(&hdr, spefFile);
+    free(hdr.text);
+
+    /* Extract the nets in batches, and write each batch in order */
+
+    proto.lefrcvalues = delay_rc_values();
+    bufs = (delaybuf *)calloc(SPEF_BATCH_SIZE, sizeof(delaybuf));
+    for (n = 0; n < Numnets; n += nbatch) {
+	nbatch = Numnets - n;
+	if (nbatch > SPEF_BATCH_SIZE) nbatch = SPEF_BATCH_SIZE;
+	for (i = 0; i < nbatch; i++) {
+	    net = Nlnets[n + i];
+	    if (net->rc == NULL)
+		net->rc = (struct netrc_ *)calloc(1, sizeof(struct netrc_));
+	}
+	delay_net_batch(Nlnets + n, bufs, nbatch, &proto);
+	for (i = 0; i < nbatch; i++) {
+	    net = Nlnets[n + i];
+	    net->flags &= ~NET_RC_DIRTY;
+	    db_write(&net->rc->out, NULL);
+	    db_write(&bufs[i], spefFile);
+	    bufs[i].len = 0;
+	}
+    }
+    for (i = 0; i < SPEF_BATCH_SIZE; i++) {
+	free(bufs[i].text);
+	free(bufs[i].msgs);
+    }
+    free(bufs);
+    free(proto.gates);
 
-    FreeNodeTable(&NodeTable);
-    Tcl_DeleteHashTable(&NodeTable);
+    if (spefFile != stdout)
+	zfile_close(spefFile);
+    else
+	fflush(spefFile);
 
+    if (spefname) free(spefname);
     return 0;
 }
 
-#endif	/* TCL_QROUTER */
+/*--------------------------------------------------------------*/
+/* get_net_delays() ---						*/
+/*								*/
+/* Find the resistance and Elmore delay of the routes from the	*/
+/* driver of "net" to each of its receivers.  The net is	*/
+/* extracted only if its routes have changed since it was last	*/
+/* extracted.  Messages from the extraction are printed.	*/
+/*								*/
+/* Results:							*/
+/*	The number of receivers, with "totalcap" set to the	*/
+/*	capacitance of the routes of the net, and "sinks" to	*/
+/*	the list of receivers (which belongs to the net), or	*/
+/*	-1 if the net has no routes or no driver.		*/
+/*--------------------------------------------------------------*/
+
+int
+get_net_delays(NET net, double *totalcap, RCSINK **sinks)
+{
+    delayctx dc;
+
+    dc.lefrcvalues = delay_rc_values();
+    dc.gates = NULL;
+    dc.numgates = 0;
+
+    if ((net->rc == NULL) || (net->flags & NET_RC_DIRTY)) {
+	if (net->rc == NULL)
+	    net->rc = (struct netrc_ *)calloc(1, sizeof(struct netrc_));
+	pool_init(&dc.segs, sizeof(struct seg_));
+	pool_init(&dc.routes, sizeof(struct route_));
+	delay_net(net, &dc, net->rc, NULL);
+	pool_release(&dc.segs);
+	pool_release(&dc.routes);
+	db_trim(&net->rc->out);
+	db_write(&net->rc->out, NULL);
+	net->flags &= ~NET_RC_DIRTY;
+    }
+
+    *totalcap = net->rc->totalcap;
+    *sinks = net->rc->sinks;
+    return net->rc->numsinks;
+}
+
+/*--------------------------------------------------------------*/
+/* free_net_delays() ---					*/
+/*								*/
+/* Free the extraction results kept with "net".		*/
+/*--------------------------------------------------------------*/
+
+void
+free_net_delays(NET net)
+{
+    if (net->rc == NULL) return;
+    free(net->rc->out.text);
+    free(net->rc->out.msgs);
+    free(net->rc->sinks);
+    free(net->rc);
+    net->rc = NULL;
+}
 
 /* end of delays.c */
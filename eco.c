@@ -0,0 +1,461 @@
+/*--------------------------------------------------------------*/
+/* eco.c --							*/
+/*								*/
+/* Engineering change orders.  A new placement DEF file is	*/
+/* read in place of the current one, and the routes that were	*/
+/* made for the old placement are kept for every net that the	*/
+/* change does not touch.  Only nets with a pin on an instance	*/
+/* that was moved or added, nets whose list of pins changed,	*/
+/* and nets whose old routes now run into an obstruction or	*/
+/* another net are routed again.				*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qrouter.h"
+#include "qconfig.h"
+#include "node.h"
+#include "maze.h"
+#include "lef.h"
+#include "def.h"
+#include "pool.h"
+#include "hash.h"
+#include "eco.h"
+
+/* Placement of an instance before the change */
+
+typedef struct {
+    char   *cellname;
+    double  placedX;
+    double  placedY;
+    int     orient;
+} EcoGate;
+
+/* A net before the change:  its routes (taken off the net	*/
+/* record before it was freed), a signature of its pins, and	*/
+/* whether it was still waiting to be routed.			*/
+
+typedef struct {
+    ROUTE   routes;
+    unsigned long long pinsig;
+    int     numpins;
+    u_char  failed;
+} EcoNet;
+
+/* Routing grid before the change */
+
+typedef struct {
+    int     numchannelsx;
+    int     numchannelsy;
+    int     numlayers;
+    double  xlowerbound;
+    double  ylowerbound;
+    double  pitchx;
+    double  pitchy;
+} EcoGrid;
+
+/*--------------------------------------------------------------*/
+/* Hash of the pin "pinname" of instance "gatename".  The	*/
+/* signature of a net is the sum of the hashes of its pins, so	*/
+/* it does not depend on the order in which pins are listed.	*/
+/*--------------------------------------------------------------*/
+
+static unsigned long long
+eco_pin_hash(char *gatename, char *pinname)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    u_char *cptr;
+
+    for (cptr = (u_char *)gatename; *cptr != '\0'; cptr++) {
+	h ^= (unsigned long long)*cptr;
+	h *= 1099511628211ULL;
+    }
+    h ^= (unsigned long long)'/';
+    h *= 1099511628211ULL;
+    for (cptr = (u_char *)pinname; *cptr != '\0'; cptr++) {
+	h ^= (unsigned long long)*cptr;
+	h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+/*--------------------------------------------------------------*/
+/* Table of nets by net number, for looking up the net that a	*/
+/* gate pin is connected to.  Entries for unused numbers are	*/
+/* NULL.							*/
+/*--------------------------------------------------------------*/
+
+static NET *
+eco_nets_by_number(void)
+{
+    NET *netbynum, net;
+    int i;
+
+    netbynum = (NET *)calloc(MAXNETNUM + 1, sizeof(NET));
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	if ((net->netnum >= 0) && (net->netnum <= MAXNETNUM))
+	    netbynum[net->netnum] = net;
+    }
+    return netbynum;
+}
+
+/*--------------------------------------------------------------*/
+/* Compute the pin signature of every net from the pins of the	*/
+/* instances.  "pinsig" and "numpins" are indexed like Nlnets.	*/
+/*--------------------------------------------------------------*/
+
+static void
+eco_pin_signatures(unsigned long long *pinsig, int *numpins)
+{
+    NET *netbynum, net;
+    GATE g;
+    int *netidx, i;
+
+    netbynum = eco_nets_by_number();
+    netidx = (int *)malloc((MAXNETNUM + 1) * sizeof(int));
+    for (i = 0; i < Numnets; i++) {
+	pinsig[i] = 0;
+	numpins[i] = 0;
+	net = Nlnets[i];
+	if ((net->netnum >= 0) && (net->netnum <= MAXNETNUM))
+	    netidx[net->netnum] = i;
+    }
+
+    for (g = Nlgates; g; g = g->next) {
+	for (i = 0; i < g->nodes; i++) {
+	    if ((g->node[i] == NULL) || (g->netnum[i] <= 0) ||
+			(g->netnum[i] > MAXNETNUM))
+		continue;
+	    net = netbynum[g->netnum[i]];
+	    if (net == NULL) continue;
+	    pinsig[netidx[net->netnum]] += eco_pin_hash(g->gatename, g->node[i]);
+	    numpins[netidx[net->netnum]]++;
+	}
+    }
+    free(netidx);
+    free(netbynum);
+}
+
+/*--------------------------------------------------------------*/
+/* Check whether grid position (x, y, layer) may be occupied	*/
+/* by a route of net number "netnum".  Positions blocked only	*/
+/* for DRC spacing to a neighboring route are allowed, since	*/
+/* the old routes were placed together before.			*/
+/*--------------------------------------------------------------*/
+
+static u_char
+eco_point_free(int x, int y, int layer, int netnum)
+{
+    obsword val;
+
+    val = OBSVAL(x, y, layer) & ROUTED_NET_MASK;
+    if ((val & DRC_BLOCKAGE) == DRC_BLOCKAGE) return TRUE;
+    if (val & NO_NET) return FALSE;
+    val &= NETNUM_FIELD;
+    return ((val == 0) || (val == (obsword)netnum)) ? TRUE : FALSE;
+}
+
+/*--------------------------------------------------------------*/
+/* Check that the old routes "routes" of net "net" can be put	*/
+/* back on the new grid.  Returns TRUE if every position that	*/
+/* the routes cover is free or belongs to the net.		*/
+/*--------------------------------------------------------------*/
+
+static u_char
+eco_routes_fit(NET net, ROUTE routes)
+{
+    ROUTE rt;
+    SEG seg;
+    int x, y, dx, dy;
+
+    for (rt = routes; rt; rt = rt->next) {
+	for (seg = rt->segments; seg; seg = seg->next) {
+	    if ((seg->layer < 0) || (seg->layer >= Num_layers)) return FALSE;
+	    if ((seg->segtype & ST_VIA) && (seg->layer + 1 >= Num_layers))
+		return FALSE;
+	    if ((seg->x1 < 0) || (seg->x1 >= NumChannelsX) ||
+			(seg->x2 < 0) || (seg->x2 >= NumChannelsX) ||
+			(seg->y1 < 0) || (seg->y1 >= NumChannelsY) ||
+			(seg->y2 < 0) || (seg->y2 >= NumChannelsY))
+		return FALSE;
+
+	    if (seg->segtype & ST_VIA) {
+		if (!eco_point_free(seg->x1, seg->y1, seg->layer, net->netnum))
+		    return FALSE;
+		if (!eco_point_free(seg->x1, seg->y1, seg->layer + 1,
+			net->netnum))
+		    return FALSE;
+		continue;
+	    }
+
+	    dx = (seg->x2 > seg->x1) ? 1 : (seg->x2 < seg->x1) ? -1 : 0;
+	    dy = (seg->y2 > seg->y1) ? 1 : (seg->y2 < seg->y1) ? -1 : 0;
+	    x = seg->x1;
+	    y = seg->y1;
+	    while (1) {
+		if (!eco_point_free(x, y, seg->layer, net->netnum))
+		    return FALSE;
+		if ((x == seg->x2) && (y == seg->y2)) break;
+		x += dx;
+		y += dy;
+	    }
+	}
+    }
+    return TRUE;
+}
+
+static void
+eco_free_routes(ROUTE routes)
+{
+    ROUTE rt;
+
+    while (routes) {
+	rt = routes;
+	routes = routes->next;
+	freeSEGlist(rt->segments);
+	freeROUTE(rt);
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* eco_def() ---						*/
+/*								*/
+/* Read the placement DEF file "filename" in place of the	*/
+/* current design, keep the existing routes of nets that are	*/
+/* not affected by the change, and route the other nets.	*/
+/* Nets that cannot be routed are left in the FailedNets list	*/
+/* for the second and third routing stages.			*/
+/*								*/
+/* Results:							*/
+/*	Number of nets that were routed again, or -1 if there	*/
+/*	is no design loaded.					*/
+/*--------------------------------------------------------------*/
+
+int
+eco_def(char *filename)
+{
+    HashTable oldgates, oldnets;
+    EcoGate *egates = NULL, *eg;
+    EcoNet *enets = NULL, *en;
+    EcoGrid grid;
+    GATE g;
+    NET net, *netbynum;
+    NETLIST nl;
+    ROUTE rt;
+    unsigned long long *pinsig;
+    int *numpins;
+    u_char *reroute, samegrid;
+    int i, numgates, oldnumnets, result;
+    int moved = 0, changed = 0, conflicts = 0, incomplete = 0, kept = 0;
+    int routed = 0, failed = 0;
+
+    if ((Nlnets == NULL) || (DEFfilename == NULL)) {
+	Fprintf(stderr, "eco_def():  No design has been read.\n");
+	return -1;
+    }
+
+    /* Record the placement of each instance and take the	*/
+    /* routes off each net before the design is freed.		*/
+
+    grid.numchannelsx = NumChannelsX;
+    grid.numchannelsy = NumChannelsY;
+    grid.numlayers = Num_layers;
+    grid.xlowerbound = Xlowerbound;
+    grid.ylowerbound = Ylowerbound;
+    grid.pitchx = PitchX;
+    grid.pitchy = PitchY;
+
+    for (numgates = 0, g = Nlgates; g; g = g->next) numgates++;
+    egates = (EcoGate *)malloc(((numgates > 0) ? numgates : 1) * sizeof(EcoGate));
+    HashInit(&oldgates, numgates, 0);
+    for (i = 0, g = Nlgates; g; g = g->next, i++) {
+	eg = &egates[i];
+	eg->cellname = strdup((g->gatetype) ? g->gatetype->gatename : "");
+	eg->placedX = g->placedX;
+	eg->placedY = g->placedY;
+	eg->orient = g->orient;
+	HashInsert(&oldgates, g->gatename, (void *)eg);
+    }
+
+    oldnumnets = Numnets;
+    enets = (EcoNet *)malloc(((Numnets > 0) ? Numnets : 1) * sizeof(EcoNet));
+    pinsig = (unsigned long long *)malloc(((Numnets > 0) ? Numnets : 1) *
+		sizeof(unsigned long long));
+    numpins = (int *)malloc(((Numnets > 0) ? Numnets : 1) * sizeof(int));
+    eco_pin_signatures(pinsig, numpins);
+    HashInit(&oldnets, Numnets, 0);
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	en = &enets[i];
+	en->routes = net->routes;
+	en->pinsig = pinsig[i];
+	en->numpins = numpins[i];
+	en->failed = FALSE;
+	net->routes = NULL;
+	HashInsert(&oldnets, net->netname, (void *)en);
+    }
+    for (nl = FailedNets; nl; nl = nl->next) {
+	en = (EcoNet *)HashLookup(&oldnets, nl->net->netname);
+	if (en != NULL) en->failed = TRUE;
+    }
+    free(pinsig);
+    free(numpins);
+
+    /* Read the new placement.  This sets up the obstructions	*/
+    /* and taps for the whole layout.				*/
+
+    result = read_def(filename);
+    if (result != 0)
+	Fprintf(stderr, "eco_def():  Errors reading %s.\n", filename);
+
+    samegrid = ((grid.numchannelsx == NumChannelsX) &&
+		(grid.numchannelsy == NumChannelsY) &&
+		(grid.numlayers == Num_layers) &&
+		(grid.xlowerbound == Xlowerbound) &&
+		(grid.ylowerbound == Ylowerbound) &&
+		(grid.pitchx == PitchX) && (grid.pitchy == PitchY)) ?
+		TRUE : FALSE;
+    if (!samegrid)
+	Fprintf(stdout, "Routing grid has changed;  all nets will be "
+		"routed again.\n");
+
+    /* Find the nets with a pin on a moved or added instance */
+
+    reroute = (u_char *)calloc((Numnets > 0) ? Numnets : 1, sizeof(u_char));
+    netbynum = eco_nets_by_number();
+    {
+	int *netidx = (int *)malloc((MAXNETNUM + 1) * sizeof(int));
+
+	for (i = 0; i < Numnets; i++)
+	    if ((Nlnets[i]->netnum >= 0) && (Nlnets[i]->netnum <= MAXNETNUM))
+		netidx[Nlnets[i]->netnum] = i;
+
+	for (g = Nlgates; g; g = g->next) {
+	    eg = (EcoGate *)HashLookup(&oldgates, g->gatename);
+	    if ((eg != NULL) && (eg->placedX == g->placedX) &&
+			(eg->placedY == g->placedY) &&
+			(eg->orient == g->orient) &&
+			!strcmp(eg->cellname, (g->gatetype) ?
+			g->gatetype->gatename : ""))
+		continue;
+	    moved++;
+	    if (Verbose > 1)
+		Fprintf(stdout, "Instance %s was %s.\n", g->gatename,
+			(eg == NULL) ? "added" : "moved");
+	    for (i = 0; i < g->nodes; i++) {
+		if ((g->netnum[i] <= 0) || (g->netnum[i] > MAXNETNUM)) continue;
+		net = netbynum[g->netnum[i]];
+		if (net != NULL) reroute[netidx[net->netnum]] = TRUE;
+	    }
+	}
+	free(netidx);
+    }
+    free(netbynum);
+
+    /* Put back the old routes of each net that is not affected */
+
+    pinsig = (unsigned long long *)malloc(((Numnets > 0) ? Numnets : 1) *
+		sizeof(unsigned long long));
+    numpins = (int *)malloc(((Numnets > 0) ? Numnets : 1) * sizeof(int));
+    eco_pin_signatures(pinsig, numpins);
+
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	en = (EcoNet *)HashLookup(&oldnets, net->netname);
+
+	if (net->routes != NULL) {
+	    /* Routes given in the new DEF file take precedence */
+	    if (en != NULL) {
+		eco_free_routes(en->routes);
+		en->routes = NULL;
+	    }
+	    reroute[i] = FALSE;
+	    continue;
+	}
+	if ((en == NULL) || (en->routes == NULL)) {
+	    reroute[i] = TRUE;
+	    continue;
+	}
+	if ((en->pinsig != pinsig[i]) || (en->numpins != numpins[i]))
+	    reroute[i] = TRUE;
+	if (reroute[i] || !samegrid) {
+	    changed++;
+	    reroute[i] = TRUE;
+	}
+	else if (en->failed) {
+	    /* Partly routed before;  route it again from the start */
+	    incomplete++;
+	    reroute[i] = TRUE;
+	}
+	else if (!eco_routes_fit(net, en->routes)) {
+	    if (Verbose > 1)
+		Fprintf(stdout, "Routes of net %s are blocked by the change.\n",
+			net->netname);
+	    conflicts++;
+	    reroute[i] = TRUE;
+	}
+	if (reroute[i]) {
+	    eco_free_routes(en->routes);
+	    en->routes = NULL;
+	    continue;
+	}
+
+	net->routes = en->routes;
+	en->routes = NULL;
+	for (rt = net->routes; rt; rt = rt->next) {
+	    rt->netnum = net->netnum;
+	    rt->flags &= ~(RT_OUTPUT | RT_STUB);
+	    rt->start.route = rt->end.route = NULL;
+	}
+	for (rt = net->routes; rt; rt = rt->next)
+	    route_set_connections(net, rt);
+	writeback_all_routes(net);
+	kept++;
+    }
+    free(pinsig);
+    free(numpins);
+
+    /* Free the routes of nets that are no longer in the design */
+
+    for (i = 0; i < oldnumnets; i++)
+	eco_free_routes(enets[i].routes);
+    for (i = 0; i < numgates; i++)
+	free(egates[i].cellname);
+    HashKill(&oldgates);
+    HashKill(&oldnets);
+    free(egates);
+    free(enets);
+
+    if (Verbose > 0)
+	Fprintf(stdout, "ECO:  %d instances moved or added;  kept routes of "
+		"%d nets;  %d nets changed, %d blocked, %d incomplete.\n",
+		moved, kept, changed, conflicts, incomplete);
+
+    /* Route the affected nets */
+
+    for (i = 0; i < Numnets; i++) {
+	if (!reroute[i]) continue;
+	net = getnettoroute(i);
+	if ((net == NULL) || (net->netnodes == NULL)) continue;
+	routed++;
+	if (doroute(net, FALSE, FALSE) == 0) {
+	    if (Verbose > 0)
+		Fprintf(stdout, "Finished routing net %s\n", net->netname);
+	}
+	else {
+	    failed++;
+	    if (Verbose > 0)
+		Fprintf(stdout, "Failed to route net %s\n", net->netname);
+	}
+    }
+    free(reroute);
+
+    Fprintf(stdout, "ECO:  Routed %d nets, %d failed.\n", routed, failed);
+    Flush(stdout);
+    return routed;
+}
+
+/* end of eco.c */
@@ -0,0 +1,13 @@
+/*
+ * eco.h --
+ *
+ * This file includes the engineering change order functions
+ *
+ */
+
+#ifndef _ECOINT_H
+#define _ECOINT_H
+
+int    eco_def(char *filename);
+
+#endif /* _ECOINT_H */
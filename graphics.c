@@ -19,6 +19,7 @@
 #include "node.h"
 #include "maze.h"
 #include "lef.h"
+#include "congest.h"
 
 /*------------------------------*/
 /* Type declarations		*/
@@ -203,7 +204,7 @@ void highlight_mask(void) {
     for (x = 0; x < NumChannelsX; x++) {
 	xspc = (x + 1) * spacing - hspc;
 	for (y = 0; y < NumChannelsY; y++) {
-	    XSetForeground(dpy, gc, brownvector[RMASK(x, y)]);
+	    XSetForeground(dpy, gc, brownvector[MASKVAL(x, y)]);
 	    yspc = height - (y + 1) * spacing - hspc;
 	    XFillRectangle(dpy, win, gc, xspc, yspc, spacing, spacing);
 	}
@@ -264,53 +265,34 @@ static void
 map_congestion()
 {
     int xspc, yspc, hspc;
-    int i, x, y, n, norm;
-    u_char *Congestion;
-    u_char value, maxval;
+    int x, y, norm;
+    int value, maxval;
 
     if (dpy == NULL) return;
 
     hspc = spacing >> 1;
 
-    Congestion = (u_char *)calloc(NumChannelsX * NumChannelsY,
-			sizeof(u_char));
-
-    // Analyze Obs[] array for congestion
-    for (i = 0; i < Num_layers; i++) {
-	for (x = 0; x < NumChannelsX; x++) {
-	    for (y = 0; y < NumChannelsY; y++) {
-		value = (u_char)0;
-		n = OBSVAL(x, y, i);
-		if (n & ROUTED_NET) value++;
-		if (n & BLOCKED_MASK) value++;
-		if (n & NO_NET) value++;
-		if (n & PINOBSTRUCTMASK) value++;
-		CONGEST(x, y) += value;
-	    }
-	}
-    }
+    // The congestion map is kept up to date by the router (see congest.c)
 
     maxval = 0;
     for (x = 0; x < NumChannelsX; x++) {
 	for (y = 0; y < NumChannelsY; y++) {
-	    value = CONGEST(x, y);
+	    value = congestion_value(x, y);
 	    if (value > maxval) maxval = value;
 	}
     }
+    if (maxval == 0) maxval = 1;
     norm = (LONGSPAN - 1) / maxval;
 
     // Draw destination pins as blue squares
     for (x = 0; x < NumChannelsX; x++) {
 	xspc = (x + 1) * spacing - hspc;
 	for (y = 0; y < NumChannelsY; y++) {
-	    XSetForeground(dpy, gc, bluevector[norm * CONGEST(x, y)]);
+	    XSetForeground(dpy, gc, bluevector[norm * congestion_value(x, y)]);
 	    yspc = height - (y + 1) * spacing - hspc;
 	    XFillRectangle(dpy, buffer, gc, xspc, yspc, spacing, spacing);
 	}
     }
-
-    // Cleanup
-    free(Congestion);
 }
 
 /*----------------------------------------------------------------------*/
@@ -320,37 +302,17 @@ map_congestion()
 static void
 map_estimate()
 {
-    NET net;
     int xspc, yspc, hspc;
-    int i, x, y, nwidth, nheight, area, length, value;
+    int x, y, value;
     float density, *Congestion, norm, maxval;
 
     if (dpy == NULL) return;
 
     hspc = spacing >> 1;
 
-    Congestion = (float *)calloc(NumChannelsX * NumChannelsY,
-			sizeof(float));
-
     // Use net bounding boxes to estimate congestion
 
-    for (i = 0; i < Numnets; i++) {
-	net = Nlnets[i];
-	nwidth = (net->xmax - net->xmin + 1);
-	nheight = (net->ymax - net->ymin + 1);
-	area = nwidth * nheight;
-	if (nwidth > nheight) {
-	    length = nwidth + (nheight >> 1) * net->numnodes;
-	}
-	else {
-	    length = nheight + (nwidth >> 1) * net->numnodes;
-	}
-	density = (float)length / (float)area;
-
-	for (x = net->xmin; x < net->xmax; x++)
-	    for (y = net->ymin; y < net->ymax; y++)
-		CONGEST(x, y) += density;
-    }
+    Congestion = congestion_estimate();
 
     maxval = 0.0;
     for (x = 0; x < NumChannelsX; x++) {
@@ -359,6 +321,7 @@ map_estimate()
 	    if (density > maxval) maxval = density;
 	}
     }
+    if (maxval == 0.0) maxval = 1.0;
     norm = (float)(LONGSPAN - 1) / maxval;
 
     // Draw destination pins as blue squares
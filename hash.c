@@ -0,0 +1,219 @@
+/*--------------------------------------------------------------*/
+/* hash.c --							*/
+/*								*/
+/* String-keyed hash tables for looking up instances, nets,	*/
+/* macros, and layers by name.  These do not depend on Tcl,	*/
+/* so the same lookup code is used in both the Tcl and the	*/
+/* standalone builds.  Tables may be case sensitive or not,	*/
+/* as the LEF and DEF name spaces require.			*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "qrouter.h"
+#include "hash.h"
+
+/*--------------------------------------------------------------*/
+/* hash_string() ---						*/
+/*								*/
+/* FNV-1a hash of a string, folding case if requested.		*/
+/*--------------------------------------------------------------*/
+
+static u_int
+hash_string(char *key, int nocase)
+{
+    u_int h = 2166136261U;
+    u_char c;
+
+    if (nocase) {
+	while ((c = (u_char)*key++) != '\0') {
+	    h ^= (u_int)tolower(c);
+	    h *= 16777619U;
+	}
+    }
+    else {
+	while ((c = (u_char)*key++) != '\0') {
+	    h ^= (u_int)c;
+	    h *= 16777619U;
+	}
+    }
+    return h;
+}
+
+static int
+hash_keycmp(HashTable *table, char *key1, char *key2)
+{
+    return (table->nocase) ? strcasecmp(key1, key2) : strcmp(key1, key2);
+}
+
+/*--------------------------------------------------------------*/
+/* HashInit() ---						*/
+/*								*/
+/* Initialize an empty table.  "size" is a hint for the number	*/
+/* of buckets;  the table grows as entries are added.		*/
+/*--------------------------------------------------------------*/
+
+void
+HashInit(HashTable *table, int size, int nocase)
+{
+    int nbuckets = 16;
+
+    while (nbuckets < size) nbuckets <<= 1;
+
+    table->buckets = (HashEnt *)calloc(nbuckets, sizeof(HashEnt));
+    table->size = nbuckets;
+    table->count = 0;
+    table->nocase = nocase;
+}
+
+/*--------------------------------------------------------------*/
+/* HashKill() ---						*/
+/*								*/
+/* Free all entries and the bucket array.  The records that	*/
+/* the entries point to are not freed.  The table must be	*/
+/* initialized again before it is reused.			*/
+/*--------------------------------------------------------------*/
+
+void
+HashKill(HashTable *table)
+{
+    HashEnt he, hnext;
+    int i;
+
+    if (table->buckets == NULL) return;
+
+    for (i = 0; i < table->size; i++) {
+	for (he = table->buckets[i]; he; he = hnext) {
+	    hnext = he->next;
+	    free(he);
+	}
+    }
+    free(table->buckets);
+    table->buckets = NULL;
+    table->size = 0;
+    table->count = 0;
+}
+
+/*--------------------------------------------------------------*/
+/* hash_grow() ---						*/
+/*								*/
+/* Double the number of buckets and redistribute the entries.	*/
+/*--------------------------------------------------------------*/
+
+static void
+hash_grow(HashTable *table)
+{
+    HashEnt *newbuckets, he, hnext;
+    int i, newsize;
+    u_int idx;
+
+    newsize = table->size << 1;
+    newbuckets = (HashEnt *)calloc(newsize, sizeof(HashEnt));
+    if (newbuckets == NULL) return;	/* Keep running with long chains */
+
+    for (i = 0; i < table->size; i++) {
+	for (he = table->buckets[i]; he; he = hnext) {
+	    hnext = he->next;
+	    idx = hash_string(he->key, table->nocase) & (newsize - 1);
+	    he->next = newbuckets[idx];
+	    newbuckets[idx] = he;
+	}
+    }
+    free(table->buckets);
+    table->buckets = newbuckets;
+    table->size = newsize;
+}
+
+/*--------------------------------------------------------------*/
+/* HashLookup() ---						*/
+/*								*/
+/* Return the value stored for "key", or NULL if the key is	*/
+/* not in the table.						*/
+/*--------------------------------------------------------------*/
+
+void *
+HashLookup(HashTable *table, char *key)
+{
+    HashEnt he;
+    u_int idx;
+
+    if (table->buckets == NULL || key == NULL) return NULL;
+
+    idx = hash_string(key, table->nocase) & (table->size - 1);
+    for (he = table->buckets[idx]; he; he = he->next)
+	if (!hash_keycmp(table, he->key, key))
+	    return he->value;
+
+    return NULL;
+}
+
+/*--------------------------------------------------------------*/
+/* HashInsert() ---						*/
+/*								*/
+/* Set the value stored for "key", replacing any value that	*/
+/* was there before.  The key string is copied.			*/
+/*--------------------------------------------------------------*/
+
+void
+HashInsert(HashTable *table, char *key, void *value)
+{
+    HashEnt he;
+    u_int idx;
+
+    if (table->buckets == NULL) return;
+
+    idx = hash_string(key, table->nocase) & (table->size - 1);
+    for (he = table->buckets[idx]; he; he = he->next) {
+	if (!hash_keycmp(table, he->key, key)) {
+	    he->value = value;
+	    return;
+	}
+    }
+
+    he = (HashEnt)malloc(sizeof(struct hashent_) + strlen(key));
+    if (he == NULL) {
+	fprintf(stderr, "HashInsert: Out of memory.\n");
+	exit(1);
+    }
+    strcpy(he->key, key);
+    he->value = value;
+    he->next = table->buckets[idx];
+    table->buckets[idx] = he;
+
+    if (++table->count > table->size) hash_grow(table);
+}
+
+/*--------------------------------------------------------------*/
+/* HashRemove() ---						*/
+/*								*/
+/* Remove the entry for "key", if there is one.			*/
+/*--------------------------------------------------------------*/
+
+void
+HashRemove(HashTable *table, char *key)
+{
+    HashEnt he, hlast;
+    u_int idx;
+
+    if (table->buckets == NULL) return;
+
+    idx = hash_string(key, table->nocase) & (table->size - 1);
+    hlast = NULL;
+    for (he = table->buckets[idx]; he; he = he->next) {
+	if (!hash_keycmp(table, he->key, key)) {
+	    if (hlast == NULL)
+		table->buckets[idx] = he->next;
+	    else
+		hlast->next = he->next;
+	    free(he);
+	    table->count--;
+	    return;
+	}
+	hlast = he;
+    }
+}
+
+/* end of hash.c */
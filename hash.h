@@ -0,0 +1,37 @@
+/*--------------------------------------------------------------*/
+/* hash.h --							*/
+/*								*/
+/* String-keyed hash tables (header file)			*/
+/*--------------------------------------------------------------*/
+
+#ifndef HASH_H
+
+/* One entry of a hash table.  The key is stored in the same	*/
+/* allocation as the entry.					*/
+
+typedef struct hashent_ *HashEnt;
+
+struct hashent_ {
+    HashEnt next;	/* Next entry in the same bucket	*/
+    void   *value;	/* Record that the key refers to	*/
+    char    key[1];	/* Key string (allocated to length)	*/
+};
+
+typedef struct hashtable_ {
+    HashEnt *buckets;	/* Array of bucket lists		*/
+    int      size;	/* Number of buckets (a power of 2)	*/
+    int      count;	/* Number of entries in the table	*/
+    int      nocase;	/* If nonzero, keys are not case	*/
+			/* sensitive				*/
+} HashTable;
+
+extern void  HashInit(HashTable *table, int size, int nocase);
+extern void  HashKill(HashTable *table);
+extern void *HashLookup(HashTable *table, char *key);
+extern void  HashInsert(HashTable *table, char *key, void *value);
+extern void  HashRemove(HashTable *table, char *key);
+
+#define HASH_H
+#endif
+
+/* end of hash.h */
@@ -28,11 +28,18 @@
 #include <sys/time.h>
 #include <math.h>
 
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
 #include "qrouter.h"
 #include "node.h"
 #include "qconfig.h"
 #include "maze.h"
 #include "lef.h"
+#include "hash.h"
+#include "zfile.h"
 
 /* ---------------------------------------------------------------------*/
 
@@ -47,6 +54,32 @@ LinkedStringPtr AllowedVias = NULL;
 
 /* Gate information is in the linked list GateInfo, imported */
 
+/* Hash tables for macro and layer lookup by name.  These are	*/
+/* kept in step with the GateInfo and LefInfo lists.  Records	*/
+/* are only ever prepended to the lists, so new records are	*/
+/* found by walking the list down to the head that was seen	*/
+/* the last time the table was updated.  Renaming a record	*/
+/* invalidates the table.  Macro names are not case sensitive;	*/
+/* layer names are.						*/
+
+static HashTable MacroTable;
+static GATE MacroTableHead = NULL;
+
+static HashTable LayerTable;
+static LefList LayerTableHead = NULL;
+
+/* Flattened technology table.  The layer record for each layer	*/
+/* number, and the via record to use above each route layer in	*/
+/* each orientation, so that the LefGetRoute*() and via width	*/
+/* routines do not have to search LefInfo.  The table is built	*/
+/* after reading LEF and configuration information, and is	*/
+/* rebuilt if LefInfo changes.  LefTechHead is the head of	*/
+/* LefInfo when the table was built;  NULL means not valid.	*/
+
+static LefList LefTechLayer[MAX_TYPES];
+static LefList LefTechVia[MAX_LAYERS][4];
+static LefList LefTechHead = NULL;
+
 /*---------------------------------------------------------
  * Lookup --
  *	Searches a table of strings to find one that matches a given
@@ -173,6 +206,436 @@ LookupFull(char *name, char **table)
 }
 
 
+/*
+ *------------------------------------------------------------
+ * Memory-mapped input
+ *
+ *	LefRead() and DefRead() map the input file into memory with
+ *	LefMapInput(), and LefNextToken() then scans the mapping
+ *	directly instead of reading lines with fgets() into a fixed
+ *	buffer.  Tokens are found as (pointer, length) views into
+ *	the mapping;  only tokens returned as strings are copied,
+ *	into a token arena that is emptied at the start of each new
+ *	line.  Input that is not a regular file, such as a file
+ *	decompressed as it is read, is read into memory first.  On
+ *	a system without mmap(), the stream is read with fgets().
+ *
+ *	The read position in the mapping is kept in a cursor.  The
+ *	DEF reader may parse parts of a section on worker threads;
+ *	each worker has its own cursor (see LefWorkerBegin()), and
+ *	LefNextToken() called from a worker reads from that cursor.
+ *------------------------------------------------------------
+ */
+
+#ifdef HAVE_PTHREAD_H
+#define LEF_THREAD_LOCAL __thread
+#else
+#define LEF_THREAD_LOCAL
+#endif
+
+/* Character classes for the token scanner */
+
+#define LEF_CH_SPACE	0x1	/* whitespace other than newline */
+#define LEF_CH_EOL	0x2	/* newline */
+#define LEF_CH_STOP	0x4	/* '#' or '"' (comment or quote) */
+
+static u_char lefCharClass[256];
+
+/* Size of a token arena chunk */
+#define LEF_ARENA_CHUNK 4096
+
+typedef struct lefchunk_ *LEFCHUNK;
+
+struct lefchunk_ {
+    LEFCHUNK next;
+    int size;		/* Bytes of storage in data[] */
+    char data[1];	/* Token storage (allocated to size) */
+};
+
+typedef struct lefcursor_ *LEFCURSOR;
+
+struct lefcursor_ {
+    char *pos;		/* Start of the next line to read */
+    char *next;		/* Next token on the current line, or NULL */
+    int *line;		/* Line counter to advance */
+    int wline;		/* Line count for a worker cursor */
+    int errors;		/* Errors and warnings deferred (worker only) */
+    LEFCHUNK arena;	/* Token storage, first chunk */
+    LEFCHUNK chunk;	/* Chunk being filled */
+    int used;		/* Bytes used in "chunk" */
+};
+
+static struct {
+    FILE *f;		/* Stream that is mapped, or NULL */
+    char *base;		/* Start of the mapping */
+    char *end;		/* End of the file in the mapping */
+    size_t maplen;	/* Length of the mapping, or 0 if read */
+    struct lefcursor_ cursor;	/* Read position of the main thread */
+} lefInput;
+
+/* Cursor of a worker thread, or NULL in the main thread */
+static LEF_THREAD_LOCAL LEFCURSOR lefWorker = NULL;
+
+static void
+lefInitCharClass()
+{
+    static u_char initialized = FALSE;
+
+    if (initialized) return;
+    lefCharClass[(u_char)' '] = LEF_CH_SPACE;
+    lefCharClass[(u_char)'\t'] = LEF_CH_SPACE;
+    lefCharClass[(u_char)'\r'] = LEF_CH_SPACE;
+    lefCharClass[(u_char)'\v'] = LEF_CH_SPACE;
+    lefCharClass[(u_char)'\f'] = LEF_CH_SPACE;
+    lefCharClass[(u_char)'\n'] = LEF_CH_EOL;
+    lefCharClass[(u_char)'#'] = LEF_CH_STOP;
+    lefCharClass[(u_char)'\"'] = LEF_CH_STOP;
+    initialized = TRUE;
+}
+
+/* Return the cursor that reads stream "f" in this thread, or	*/
+/* NULL if "f" is not mapped.					*/
+
+static LEFCURSOR
+lefCursor(FILE *f)
+{
+    if ((f == NULL) || (f != lefInput.f)) return NULL;
+    return (lefWorker != NULL) ? lefWorker : &lefInput.cursor;
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * LefMapInput --
+ *
+ *	Map the file open on stream "f" into memory, so that
+ *	LefNextToken(f, ...) reads from the mapping.  Only one
+ *	stream is mapped at a time.  A stream that is not a
+ *	regular file (such as a compressed file opened with
+ *	zfile_open()) is read into memory instead.  Does nothing
+ *	if the system has no mmap(), in which case LefNextToken()
+ *	falls back to reading the stream.
+ *
+ * Results:
+ *	TRUE if the file was mapped, FALSE if not.
+ *
+ *------------------------------------------------------------
+ */
+
+int
+LefMapInput(FILE *f)
+{
+#ifdef HAVE_SYS_MMAN_H
+    struct stat st;
+    void *map;
+    char *buf;
+    size_t size, alloc, n;
+
+    if (lefInput.f != NULL) LefUnmapInput(lefInput.f);
+    if (f == NULL) return FALSE;
+
+    if ((fileno(f) >= 0) && (fstat(fileno(f), &st) == 0) &&
+		S_ISREG(st.st_mode)) {
+	if (st.st_size <= 0) return FALSE;
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+		fileno(f), 0);
+	if (map == MAP_FAILED) return FALSE;
+#ifdef MADV_SEQUENTIAL
+	madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+	lefInput.base = (char *)map;
+	lefInput.maplen = (size_t)st.st_size;
+	lefInput.end = lefInput.base + lefInput.maplen;
+    }
+    else {
+	/* Read the whole stream into memory */
+	buf = NULL;
+	size = alloc = 0;
+	do {
+	    if (size == alloc) {
+		alloc = (alloc == 0) ? (1 << 20) : alloc * 2;
+		buf = (char *)realloc(buf, alloc);
+	    }
+	    n = fread(buf + size, 1, alloc - size, f);
+	    size += n;
+	} while (n > 0);
+	if (ferror(f) || (size == 0)) {
+	    free(buf);
+	    return FALSE;
+	}
+	lefInput.base = buf;
+	lefInput.maplen = 0;
+	lefInput.end = lefInput.base + size;
+    }
+
+    lefInitCharClass();
+    lefInput.f = f;
+    lefInput.cursor.pos = lefInput.base;
+    lefInput.cursor.next = NULL;
+    lefInput.cursor.line = &lefCurrentLine;
+    lefInput.cursor.chunk = NULL;
+    lefInput.cursor.used = 0;
+    return TRUE;
+#else
+    return FALSE;
+#endif
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * LefUnmapInput --
+ *
+ *	Release the mapping made by LefMapInput(), if stream "f"
+ *	is the one mapped.  Must be called before "f" is closed.
+ *	Strings already returned by LefNextToken() are kept in
+ *	the token arena and are not affected.
+ *
+ *------------------------------------------------------------
+ */
+
+void
+LefUnmapInput(FILE *f)
+{
+#ifdef HAVE_SYS_MMAN_H
+    if ((f == NULL) || (f != lefInput.f)) return;
+
+    if (lefInput.maplen > 0)
+	munmap((void *)lefInput.base, lefInput.maplen);
+    else
+	free(lefInput.base);
+    lefInput.f = NULL;
+    lefInput.base = lefInput.end = NULL;
+    lefInput.cursor.pos = lefInput.cursor.next = NULL;
+    lefInput.maplen = 0;
+#endif
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * LefGetMark, LefSetMark --
+ *
+ *	Save or restore the read position of a mapped stream.
+ *	A mark saved before reading a token can be used later
+ *	(by the same or another thread) to read the input again
+ *	from that token.
+ *
+ * Results:
+ *	LefGetMark() returns FALSE if "f" is not mapped.
+ *
+ *------------------------------------------------------------
+ */
+
+int
+LefGetMark(FILE *f, LefMark *mark)
+{
+    LEFCURSOR c = lefCursor(f);
+
+    if (c == NULL) return FALSE;
+    mark->pos = c->pos;
+    mark->next = c->next;
+    mark->line = *c->line;
+    return TRUE;
+}
+
+void
+LefSetMark(FILE *f, LefMark *mark)
+{
+    LEFCURSOR c = lefCursor(f);
+
+    if (c == NULL) return;
+    c->pos = mark->pos;
+    c->next = mark->next;
+    *c->line = mark->line;
+}
+
+/*
+ *------------------------------------------------------------
+ *
+ * LefWorkerBegin, LefWorkerErrors, LefWorkerEnd --
+ *
+ *	Called by a worker thread to get its own cursor on the
+ *	mapped input, which is then positioned with LefSetMark().
+ *	Errors and warnings raised through LefError() on a worker
+ *	thread are not printed, only counted;  LefWorkerErrors()
+ *	returns the count since the last call, so that the caller
+ *	can parse the same input again in the main thread to get
+ *	the messages in order.
+ *
+ *------------------------------------------------------------
+ */
+
+void
+LefWorkerBegin(void)
+{
+    LEFCURSOR c;
+
+    c = (LEFCURSOR)calloc(1, sizeof(struct lefcursor_));
+    if (c == NULL) {
+	fprintf(stderr, "LefWorkerBegin: Out of memory.\n");
+	exit(1);
+    }
+    c->line = &c->wline;
+    lefWorker = c;
+}
+
+int
+LefWorkerErrors(void)
+{
+    int errors;
+
+    if (lefWorker == NULL) return 0;
+    errors = lefWorker->errors;
+    lefWorker->errors = 0;
+    return errors;
+}
+
+void
+LefWorkerEnd(void)
+{
+    LEFCHUNK chunk, nextchunk;
+
+    if (lefWorker == NULL) return;
+    for (chunk = lefWorker->arena; chunk; chunk = nextchunk) {
+	nextchunk = chunk->next;
+	free(chunk);
+    }
+    free(lefWorker);
+    lefWorker = NULL;
+}
+
+/* Copy a token view into the token arena and return it as a	*/
+/* string.  The arena is a list of chunks;  a token that does	*/
+/* not fit in the current chunk goes into the next one, which	*/
+/* is allocated if needed, so earlier tokens never move.	*/
+
+static char *
+lefArenaCopy(LEFCURSOR cur, char *tok, int len)
+{
+    LEFCHUNK c, last;
+    char *s;
+    int size;
+
+    c = cur->chunk;
+    if ((c == NULL) || (cur->used + len + 1 > c->size)) {
+	last = c;
+	c = (c == NULL) ? cur->arena : c->next;
+
+	/* Skip over chunks too small for this token */
+	while ((c != NULL) && (c->size < len + 1)) {
+	    last = c;
+	    c = c->next;
+	}
+
+	if (c == NULL) {
+	    size = (len + 1 > LEF_ARENA_CHUNK) ? len + 1 : LEF_ARENA_CHUNK;
+	    c = (LEFCHUNK)malloc(sizeof(struct lefchunk_) + size);
+	    if (c == NULL) {
+		fprintf(stderr, "LefNextToken: Out of memory.\n");
+		exit(1);
+	    }
+	    c->size = size;
+	    c->next = NULL;		/* Add to the end of the list */
+	    if (last == NULL)
+		cur->arena = c;
+	    else
+		last->next = c;
+	}
+	cur->chunk = c;
+	cur->used = 0;
+    }
+    s = c->data + cur->used;
+    memcpy(s, tok, len);
+    s[len] = '\0';
+    cur->used += len + 1;
+    return s;
+}
+
+/* Find the next token in the mapped input, returned as a view	*/
+/* (pointer and length) into the mapping.  Follows the same	*/
+/* rules as LefNextToken().					*/
+
+static char *
+lefMapNextView(LEFCURSOR c, u_char ignore_eol, int *len)
+{
+    static char eol_token = '\n';
+    char *p, *tok, *end = lefInput.end;
+
+    /* Start a new line if necessary */
+
+    if (c->next == NULL)
+    {
+	for (;;)
+	{
+	    p = c->pos;
+	    if (p >= end) return NULL;
+	    (*c->line)++;
+	    while ((p < end) && (lefCharClass[(u_char)*p] & LEF_CH_SPACE))
+		p++;		/* skip leading whitespace */
+
+	    if ((p < end) && (*p != '#') && (*p != '\n'))
+		break;
+
+	    /* Blank or comment line */
+	    p = memchr(p, '\n', end - p);
+	    c->pos = (p == NULL) ? end : p + 1;
+	}
+	c->next = p;
+
+	/* Tokens from the previous line are no longer needed */
+	c->chunk = NULL;
+	c->used = 0;
+
+	if (!ignore_eol) {
+	    *len = 1;
+	    return &eol_token;
+	}
+    }
+
+    tok = p = c->next;
+
+    /* Treat quoted material as a single token */
+
+    if (*p == '\"') {
+	p++;
+	while ((p < end) && ((*p != '\"') || (*(p - 1) == '\\'))) {
+	    if (*p == '\n') (*c->line)++;
+	    p++;	/* skip all in quotes (move past current token) */
+	}
+	if (p >= end) {
+	    c->pos = end;
+	    c->next = NULL;
+	    return NULL;
+	}
+	p++;
+	*len = (int)(p - tok);
+
+	/* As with the line reader, the character following	*/
+	/* the closing quote is taken as a separator.		*/
+	if ((p < end) && (*p != '\n')) p++;
+    }
+    else {
+	while ((p < end) && !(lefCharClass[(u_char)*p] & (LEF_CH_SPACE | LEF_CH_EOL)))
+	    p++;	/* skip non-whitespace (move past current token) */
+	*len = (int)(p - tok);
+    }
+
+    while ((p < end) && (lefCharClass[(u_char)*p] & LEF_CH_SPACE))
+	p++;		/* skip any whitespace */
+
+    if ((p >= end) || (*p == '#') || (*p == '\n')) {
+	/* End of line;  the next call starts a new one */
+	if (p < end) p = memchr(p, '\n', end - p);
+	c->pos = ((p == NULL) || (p >= end)) ? end : p + 1;
+	c->next = NULL;
+    }
+    else
+	c->next = p;
+
+    return tok;
+}
+
 /*
  *------------------------------------------------------------
  *
@@ -204,6 +667,15 @@ LefNextToken(FILE *f, u_char ignore_eol)
     static char *nexttoken = NULL;	/* pointer to next token */
     static char *curtoken;		/* pointer to current token */
     static char eol_token='\n';
+    LEFCURSOR c;
+    char *tok;
+    int len;
+
+    if ((c = lefCursor(f)) != NULL) {
+	tok = lefMapNextView(c, ignore_eol, &len);
+	if ((tok == NULL) || (*tok == '\n' && len == 1)) return tok;
+	return lefArenaCopy(c, tok, len);
+    }
 
     /* Read a new line if necessary */
 
@@ -263,6 +735,38 @@ LefNextToken(FILE *f, u_char ignore_eol)
     return curtoken;
 }
 
+/*
+ *------------------------------------------------------------
+ *
+ * LefNextTokenView --
+ *
+ *	Like LefNextToken(), but the token is not copied or
+ *	terminated:  the result points into the input and the
+ *	number of characters in the token is returned in "len".
+ *	For callers that only need to look at a token, such as
+ *	when skipping to the end of a statement.
+ *
+ * Results:
+ *	Pointer to the start of the next token, or NULL at the
+ *	end of the input.
+ *
+ *------------------------------------------------------------
+ */
+
+char *
+LefNextTokenView(FILE *f, u_char ignore_eol, int *len)
+{
+    LEFCURSOR c;
+    char *tok;
+
+    if ((c = lefCursor(f)) != NULL)
+	return lefMapNextView(c, ignore_eol, len);
+
+    tok = LefNextToken(f, ignore_eol);
+    if (tok != NULL) *len = strlen(tok);
+    return tok;
+}
+
 /*
  *------------------------------------------------------------
  *
@@ -291,6 +795,12 @@ LefError(int type, char *fmt, ...)
     int errors;
     va_list args;
 
+    /* Worker threads count errors for the caller to deal with */
+    if (lefWorker != NULL) {
+	if (fmt != NULL) lefWorker->errors++;
+	return;
+    }
+
     if (Verbose == 0) return;
 
     if ((type == DEF_WARNING) || (type == DEF_ERROR)) lefordef = 'D';
@@ -429,6 +939,50 @@ LefSkipSection(FILE *f, char *section)
     return;
 }
 
+/*
+ *------------------------------------------------------------
+ *
+ * lefSyncMacroTable --
+ *
+ *	Add any records prepended to GateInfo since the last
+ *	call to the macro hash table, or rebuild the table if
+ *	it has been invalidated.
+ *
+ *------------------------------------------------------------
+ */
+
+static void
+lefSyncMacroTable(void)
+{
+    GATE gateginfo;
+    GATE *newgates;
+    int n, i;
+
+    if (GateInfo == MacroTableHead) return;
+
+    for (n = 0, gateginfo = GateInfo; gateginfo &&
+		(gateginfo != MacroTableHead); gateginfo = gateginfo->next)
+	n++;
+
+    if ((gateginfo == NULL) || (MacroTable.buckets == NULL)) {
+	/* Old head not found (list was replaced), so start over */
+	HashKill(&MacroTable);
+	HashInit(&MacroTable, n, TRUE);
+    }
+    if (n > 0) {
+	/* Insert from the oldest record so that the newest record	*/
+	/* of any given name is the one found, as in a list search.	*/
+
+	newgates = (GATE *)malloc(n * sizeof(GATE));
+	for (i = 0, gateginfo = GateInfo; i < n; gateginfo = gateginfo->next)
+	    newgates[i++] = gateginfo;
+	for (i = n - 1; i >= 0; i--)
+	    HashInsert(&MacroTable, newgates[i]->gatename, (void *)newgates[i]);
+	free(newgates);
+    }
+    MacroTableHead = GateInfo;
+}
+
 /*
  *------------------------------------------------------------
  *
@@ -444,13 +998,8 @@ LefSkipSection(FILE *f, char *section)
 GATE
 lefFindCell(char *name)
 {
-    GATE gateginfo;
-
-    for (gateginfo = GateInfo; gateginfo; gateginfo = gateginfo->next) { 
-	if (!strcasecmp(gateginfo->gatename, name))
-	    return gateginfo;
-    }
-    return (GATE)NULL;
+    lefSyncMacroTable();
+    return (GATE)HashLookup(&MacroTable, name);
 }
 
 /*
@@ -534,7 +1083,7 @@ LefRedefined(LefList lefl, char *redefname)
 	slef = LefFindLayer(redefname);
 
 	newlefl = (LefList)malloc(sizeof(lefLayer));
-	newlefl->lefName = strdup(newlefl->lefName);
+	newlefl->lefName = strdup(redefname);
 
 	newlefl->next = LefInfo;
 	LefInfo = newlefl;
@@ -543,9 +1092,12 @@ LefRedefined(LefList lefl, char *redefname)
 	/* is "redefname", then change it.		*/
 
 	if (!strcmp(slef->lefName, redefname))
-	    if (altName != NULL)
+	    if (altName != NULL) {
 		slef->lefName = altName;
+		LayerTableHead = NULL;		/* Invalidate lookup table */
+	    }
     }
+    LefTechInvalidate();
     newlefl->type = -1;
     newlefl->obsType = -1;
     newlefl->info.via.area.x1 = 0.0;
@@ -559,6 +1111,44 @@ LefRedefined(LefList lefl, char *redefname)
     return newlefl;
 }
 
+/*
+ *------------------------------------------------------------
+ * Bring the layer hash table up to date with LefInfo
+ *------------------------------------------------------------
+ */
+
+static void
+lefSyncLayerTable(void)
+{
+    LefList lefl;
+    LefList *newlayers;
+    int n, i;
+
+    if (LefInfo == LayerTableHead) return;
+
+    for (n = 0, lefl = LefInfo; lefl && (lefl != LayerTableHead);
+		lefl = lefl->next)
+	n++;
+
+    if ((lefl == NULL) || (LayerTable.buckets == NULL)) {
+	/* Old head not found (list was replaced), so start over */
+	HashKill(&LayerTable);
+	HashInit(&LayerTable, n, FALSE);
+    }
+    if (n > 0) {
+	/* Insert from the oldest record so that the newest record	*/
+	/* of any given name is the one found, as in a list search.	*/
+
+	newlayers = (LefList *)malloc(n * sizeof(LefList));
+	for (i = 0, lefl = LefInfo; i < n; lefl = lefl->next)
+	    newlayers[i++] = lefl;
+	for (i = n - 1; i >= 0; i--)
+	    HashInsert(&LayerTable, newlayers[i]->lefName, (void *)newlayers[i]);
+	free(newlayers);
+    }
+    LayerTableHead = LefInfo;
+}
+
 /*
  *------------------------------------------------------------
  * Find a layer record in the list of layers
@@ -568,19 +1158,59 @@ LefRedefined(LefList lefl, char *redefname)
 LefList
 LefFindLayer(char *token)
 {
-    LefList lefl, rlefl;
-   
     if (token == NULL) return NULL;
-    rlefl = (LefList)NULL;
-    for (lefl = LefInfo; lefl; lefl = lefl->next) {
-	if (!strcmp(lefl->lefName, token)) {
-	   rlefl = lefl;
-	   break;
-	}
-    }
-    return rlefl;
+    lefSyncLayerTable();
+    return (LefList)HashLookup(&LayerTable, token);
 }
 	
+/*
+ *------------------------------------------------------------
+ * LefTechBuild --
+ *
+ *	Fill in the flattened technology table from LefInfo
+ *	and the Via** tables.  Called after the LEF file and
+ *	configuration have been read, and again whenever
+ *	LefInfo is found to have changed.
+ *
+ * LefTechInvalidate --
+ *
+ *	Mark the table as out of date.  Must be called when a
+ *	record already in LefInfo has its layer number changed,
+ *	or when the Via** tables are changed.
+ *------------------------------------------------------------
+ */
+
+static LefList lefFindXYVia(int base, int orient);
+
+void
+LefTechBuild(void)
+{
+    LefList lefl;
+    int i, orient;
+
+    for (i = 0; i < MAX_TYPES; i++) LefTechLayer[i] = NULL;
+
+    /* The first record in the list with a given layer number	*/
+    /* is the one that a search of the list would find.		*/
+
+    for (lefl = LefInfo; lefl; lefl = lefl->next)
+	if ((lefl->type >= 0) && (lefl->type < MAX_TYPES))
+	    if (LefTechLayer[lefl->type] == NULL)
+		LefTechLayer[lefl->type] = lefl;
+
+    for (i = 0; i < MAX_LAYERS; i++)
+	for (orient = 0; orient < 4; orient++)
+	    LefTechVia[i][orient] = lefFindXYVia(i, orient);
+
+    LefTechHead = LefInfo;
+}
+
+void
+LefTechInvalidate(void)
+{
+    LefTechHead = NULL;
+}
+
 /*
  *------------------------------------------------------------
  * Find a layer record in the list of layers, by layer number
@@ -590,16 +1220,9 @@ LefFindLayer(char *token)
 LefList
 LefFindLayerByNum(int layer)
 {
-    LefList lefl, rlefl;
-   
-    rlefl = (LefList)NULL;
-    for (lefl = LefInfo; lefl; lefl = lefl->next) {
-	if (lefl->type == layer) {
-	   rlefl = lefl;
-	   break;
-	}
-    }
-    return rlefl;
+    if (LefTechHead != LefInfo) LefTechBuild();
+    if ((layer < 0) || (layer >= MAX_TYPES)) return NULL;
+    return LefTechLayer[layer];
 }
 	
 /*
@@ -824,28 +1447,17 @@ LefGetViaWidth(int base, int layer, int dir)
 
 /*
  *------------------------------------------------------------
- * The base routine used by LefGetViaWidth(), with an
- * additional argument that specifies which via orientation
- * to use, if an alternative orientation is available.  This
- * is necessary for doing checkerboard via patterning and for
- * certain standard cells with ports that do not always fit
- * one orientation of via.
- *
- * "orient" is defined as follows:
- * 0 = XX = both layers horizontal
- * 1 = XY = bottom layer horizontal, top layer vertical
- * 2 = YX = bottom layer vertical, top layer horizontal
- * 3 = YY = both layers vertical.
- *
+ * Find the via record to use between layer "base" and the
+ * layer above it, in orientation "orient" (see below).  If
+ * the preferred orientation is not available, fall back to
+ * the others.  Return NULL if there is no such via.
  *------------------------------------------------------------
  */
 
-double
-LefGetXYViaWidth(int base, int layer, int dir, int orient)
+static LefList
+lefFindXYVia(int base, int orient)
 {
-    DSEG lrect;
     LefList lefl;
-    double width;
     char **viatable;
 
     switch (orient) {
@@ -924,6 +1536,41 @@ LefGetXYViaWidth(int base, int layer, int dir, int orient)
 	lefl = LefFindLayer(*(viatable + base));
     }
 
+    return lefl;
+}
+
+/*
+ *------------------------------------------------------------
+ * The base routine used by LefGetViaWidth(), with an
+ * additional argument that specifies which via orientation
+ * to use, if an alternative orientation is available.  This
+ * is necessary for doing checkerboard via patterning and for
+ * certain standard cells with ports that do not always fit
+ * one orientation of via.
+ *
+ * "orient" is defined as follows:
+ * 0 = XX = both layers horizontal
+ * 1 = XY = bottom layer horizontal, top layer vertical
+ * 2 = YX = bottom layer vertical, top layer horizontal
+ * 3 = YY = both layers vertical.
+ *
+ *------------------------------------------------------------
+ */
+
+double
+LefGetXYViaWidth(int base, int layer, int dir, int orient)
+{
+    DSEG lrect;
+    LefList lefl;
+    double width;
+
+    if ((base >= 0) && (base < MAX_LAYERS) && (orient >= 0) && (orient < 4)) {
+	if (LefTechHead != LefInfo) LefTechBuild();
+	lefl = LefTechVia[base][orient];
+    }
+    else
+	lefl = lefFindXYVia(base, orient);
+
     if (lefl) {
 	if (lefl->lefClass == CLASS_VIA) {
 	    if (lefl->info.via.area.layer == layer) {
@@ -1339,6 +1986,7 @@ LefReadLayers(FILE *f, u_char obstruct, int *lreturn)
 		cuttype = LefGetMaxLayer();
 		if (cuttype < MAX_TYPES) {
 		    lefl->type = cuttype;
+		    LefTechInvalidate();
 		    curlayer = cuttype;
 		    strcpy(CIFLayer[cuttype], lefl->lefName);
 		}
@@ -2223,8 +2871,9 @@ void
 LefEndStatement(FILE *f)
 {
     char *token;
+    int len;
 
-    while ((token = LefNextToken(f, TRUE)) != NULL)
+    while ((token = LefNextTokenView(f, TRUE, &len)) != NULL)
 	if (*token == ';') break;
 }
 
@@ -2278,13 +2927,9 @@ LefReadMacro(FILE *f,			/* LEF file being read	*/
     /* Start by creating a new celldef */
 
     lefMacro = (GATE)NULL;
-    for (altMacro = GateInfo; altMacro; altMacro = altMacro->next)
-    {
-	if (!strcmp(altMacro->gatename, mname)) {
-	    lefMacro = altMacro;
-	    break;
-	}
-    }
+    altMacro = lefFindCell(mname);
+    if (altMacro && !strcmp(altMacro->gatename, mname))
+	lefMacro = altMacro;
 
     while (lefMacro)
     {
@@ -2303,6 +2948,7 @@ LefReadMacro(FILE *f,			/* LEF file being read	*/
 		"Renaming original cell \"%s\"\n", mname, newname);
 
 	lefMacro->gatename = strdup(newname);
+	MacroTableHead = NULL;		/* Invalidate lookup table */
 	lefMacro = lefFindCell(mname);
     }
 
@@ -2771,6 +3417,7 @@ LefReadLayerSection(FILE *f,		/* LEF file being read	  */
 			/* bottom to top in the technology LEF file.	*/
 
 			lefl->type = LefGetMaxRouteLayer();
+			LefTechInvalidate();
 		    }
 		    else if (typekey == CLASS_CUT || typekey == CLASS_VIA) {
 			lefl->info.via.area.x1 = 0.0;
@@ -3630,6 +4277,7 @@ LefAssignLayerVias()
 	if (newViaYX[baselayer] != NULL) free(newViaYX[baselayer]);
 	if (newViaYY[baselayer] != NULL) free(newViaYY[baselayer]);
     }
+    LefTechInvalidate();
 }
 
 /*
@@ -3701,7 +4349,17 @@ LefRead(char *inName)
     else
 	strcpy(filename, inName);
 
-    f = fopen(filename, "r");
+    /* Nothing to do if the file's contents were loaded from a cache */
+
+    if (LefCacheLookup(filename, &oprecis)) {
+	if (Verbose > 0) {
+	    Fprintf(stdout, "LEF data from file %s taken from cache.\n", filename);
+	    Flush(stdout);
+	}
+	return oprecis;
+    }
+
+    f = zfile_open(filename, "r");
 
     if (f == NULL)
     {
@@ -3709,6 +4367,7 @@ LefRead(char *inName)
 	perror(filename);
 	return 0;
     }
+    LefMapInput(f);
 
     if (Verbose > 0) {
 	Fprintf(stdout, "Reading LEF data from file %s.\n", filename);
@@ -3880,13 +4539,12 @@ LefRead(char *inName)
     }
 
     /* Cleanup */
-    if (f != NULL) fclose(f);
+    LefUnmapInput(f);
+    if (f != NULL) zfile_close(f);
 
     /* Make sure that the gate list has one entry called "pin" */
 
-    for (gateginfo = GateInfo; gateginfo; gateginfo = gateginfo->next)
-	if (!strcasecmp(gateginfo->gatename, "pin"))
-	    break;
+    gateginfo = lefFindCell("pin");
 
     if (!gateginfo) {
 	/* Add a new GateInfo entry for pseudo-gate "pin" */
@@ -4112,5 +4770,11 @@ LefRead(char *inName)
     /* Find the best via(s) to use per route layer and record it (them) */
     LefAssignLayerVias();
 
+    /* Flatten the technology information for fast lookup */
+    LefTechBuild();
+
+    /* Note the file for the technology and macro library cache */
+    LefCacheRecord(filename, oprecis);
+
     return oprecis;
 }
@@ -27,6 +27,15 @@ typedef struct
     u_char has_nets;
 } NetCount;
 
+/* A saved read position in a memory-mapped LEF or DEF file */
+
+typedef struct
+{
+    char *pos;		/* Start of the next line to read */
+    char *next;		/* Next token on the current line, or NULL */
+    int line;		/* Line number */
+} LefMark;
+
 /* Various modes for writing nets. */
 #define DO_REGULAR  0
 #define DO_SPECIAL  1
@@ -152,6 +161,14 @@ void  LefSkipSection(FILE *f, char *match);
 void  LefEndStatement(FILE *f);
 GATE  lefFindCell(char *name);
 char *LefNextToken(FILE *f, u_char ignore_eol);
+char *LefNextTokenView(FILE *f, u_char ignore_eol, int *len);
+int   LefMapInput(FILE *f);
+void  LefUnmapInput(FILE *f);
+int   LefGetMark(FILE *f, LefMark *mark);
+void  LefSetMark(FILE *f, LefMark *mark);
+void  LefWorkerBegin(void);
+int   LefWorkerErrors(void);
+void  LefWorkerEnd(void);
 char *LefLower(char *token);
 DSEG  LefReadGeometry(GATE lefMacro, FILE *f, float oscale);
 LefList LefRedefined(LefList lefl, char *redefname);
@@ -160,6 +177,8 @@ DSEG LefReadRect(FILE *f, int curlayer, float oscale);
 int  LefReadLayer(FILE *f, u_char obstruct);
 LefList LefFindLayer(char *token);
 LefList LefFindLayerByNum(int layer);
+void   LefTechBuild(void);
+void   LefTechInvalidate(void);
 int    LefFindLayerNum(char *token);
 void   LefSetRoutePitchX(int layer, double value);
 void   LefSetRoutePitchY(int layer, double value);
@@ -192,6 +211,13 @@ int    LefRead(char *inName);
 void   LefAssignLayerVias();
 void   LefWriteGeneratedVias(FILE *f, double oscale, int defvias);
 
+void   LefCacheRecord(char *name, int oprecis);
+u_char LefCacheLookup(char *name, int *oprecis);
+u_char LefCacheModified(void);
+char  *LefCacheSource(int idx);
+int    LefWriteCache(char *cachename);
+int    LefReadCache(char *cachename);
+
 
 void LefError(int type, char *fmt, ...);	/* Variable argument procedure */
 						/* requires parameter list. */
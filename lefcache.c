@@ -0,0 +1,675 @@
+/*--------------------------------------------------------------*/
+/* lefcache.c --						*/
+/*								*/
+/* Binary cache of the technology and macro library.  After	*/
+/* the LEF files have been read and processed, the LefInfo	*/
+/* layer and via records and the GateInfo macros (pin taps and	*/
+/* obstructions) can be saved to a file, which is loaded back	*/
+/* much faster than the LEF files can be parsed.  The cache	*/
+/* records the name, size, and checksum of each LEF file it	*/
+/* was made from, and is not used if any of them has changed.	*/
+/*								*/
+/* Each LEF file read is noted here by LefRead().  When a cache	*/
+/* is loaded, its LEF files are marked as preloaded, and the	*/
+/* next LefRead() of each one returns at once without parsing	*/
+/* the file again.						*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qrouter.h"
+#include "qconfig.h"
+#include "lef.h"
+
+#define LEFCACHE_MAGIC	 "qrlefdb"
+#define LEFCACHE_VERSION 1
+#define LEFCACHE_BYTEORDER 0x01020304
+
+typedef unsigned long long lefsum_t;
+
+/* Record of a LEF file that has been read into the database */
+
+typedef struct lefsource_ *LEFSOURCE;
+
+struct lefsource_ {
+    LEFSOURCE next;
+    char     *name;		/* File name as passed to LefRead()	*/
+    long      size;		/* File size in bytes			*/
+    lefsum_t  checksum;		/* FNV-1a checksum of file contents	*/
+    int       oprecis;		/* Value returned by LefRead()		*/
+    u_char    preloaded;	/* Loaded from cache, not yet claimed	*/
+};
+
+static LEFSOURCE LefSources = NULL;	/* In the order read */
+
+/* Heads of the LefInfo and GateInfo lists after the last LEF	*/
+/* file was read.  Records prepended later (e.g., vias from the	*/
+/* DEF file) are not part of the library and are not cached.	*/
+
+static LefList LefCacheLayers = NULL;
+static GATE    LefCacheMacros = NULL;
+
+/* Set when a LEF file has been parsed since the database was	*/
+/* last saved to or loaded from a cache.			*/
+
+static u_char lefCacheChanged = FALSE;
+
+/* LEF file names listed in the last cache file opened */
+
+static char **LefCacheNames = NULL;
+static int    LefCacheNumNames = 0;
+
+/* Reader state;  "ok" is cleared on any short read */
+
+typedef struct {
+    FILE *f;
+    int   ok;
+} lefCacheReader;
+
+/*--------------------------------------------------------------*/
+/* lefFileChecksum() ---					*/
+/*								*/
+/* Compute a 64-bit FNV-1a checksum of the contents of a file	*/
+/* and return the file size in "size".  Returns 0 on success,	*/
+/* -1 if the file cannot be read.				*/
+/*--------------------------------------------------------------*/
+
+static int
+lefFileChecksum(char *name, long *size, lefsum_t *checksum)
+{
+    FILE *f;
+    u_char buf[65536];
+    size_t n, i;
+    lefsum_t h = 14695981039346656037ULL;
+    long total = 0;
+
+    f = fopen(name, "rb");
+    if (f == NULL) return -1;
+
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+	for (i = 0; i < n; i++) {
+	    h ^= (lefsum_t)buf[i];
+	    h *= 1099511628211ULL;
+	}
+	total += (long)n;
+    }
+    fclose(f);
+
+    *size = total;
+    *checksum = h;
+    return 0;
+}
+
+/*--------------------------------------------------------------*/
+/* LefCacheRecord() ---						*/
+/*								*/
+/* Note that the LEF file "name" has been parsed, giving the	*/
+/* manufacturing grid "oprecis".  Called at the end of		*/
+/* LefRead().							*/
+/*--------------------------------------------------------------*/
+
+void
+LefCacheRecord(char *name, int oprecis)
+{
+    LEFSOURCE src, *tail;
+
+    src = (LEFSOURCE)malloc(sizeof(struct lefsource_));
+    src->next = NULL;
+    src->name = strdup(name);
+    src->oprecis = oprecis;
+    src->preloaded = FALSE;
+    if (lefFileChecksum(name, &src->size, &src->checksum) != 0) {
+	src->size = -1;
+	src->checksum = 0;
+    }
+
+    for (tail = &LefSources; *tail; tail = &(*tail)->next);
+    *tail = src;
+
+    LefCacheLayers = LefInfo;
+    LefCacheMacros = GateInfo;
+    lefCacheChanged = TRUE;
+}
+
+/*--------------------------------------------------------------*/
+/* LefCacheLookup() ---						*/
+/*								*/
+/* If the LEF file "name" was loaded from a cache and has not	*/
+/* been read since, claim it and return TRUE, with the value	*/
+/* LefRead() returned for the file in "oprecis".  Otherwise	*/
+/* return FALSE, and the file should be parsed.			*/
+/*--------------------------------------------------------------*/
+
+u_char
+LefCacheLookup(char *name, int *oprecis)
+{
+    LEFSOURCE src;
+
+    for (src = LefSources; src; src = src->next) {
+	if (src->preloaded && !strcmp(src->name, name)) {
+	    src->preloaded = FALSE;
+	    *oprecis = src->oprecis;
+	    return TRUE;
+	}
+    }
+    return FALSE;
+}
+
+/*--------------------------------------------------------------*/
+/* LefCacheModified() ---					*/
+/*								*/
+/* Return TRUE if any LEF file has been parsed since the	*/
+/* database was last written to or read from a cache.		*/
+/*--------------------------------------------------------------*/
+
+u_char
+LefCacheModified(void)
+{
+    return lefCacheChanged;
+}
+
+/*--------------------------------------------------------------*/
+/* LefCacheSource() ---						*/
+/*								*/
+/* Return the name of the idx'th LEF file listed in the cache	*/
+/* file last opened by LefReadCache(), or NULL past the end.	*/
+/*--------------------------------------------------------------*/
+
+char *
+LefCacheSource(int idx)
+{
+    if (idx < 0 || idx >= LefCacheNumNames) return NULL;
+    return LefCacheNames[idx];
+}
+
+/*--------------------------------------------------------------*/
+/* Binary output and input helpers.  Values are written in the	*/
+/* native byte order, which is checked when the file is read.	*/
+/*--------------------------------------------------------------*/
+
+static void
+lefPutInt(FILE *f, int value)
+{
+    fwrite(&value, sizeof(int), 1, f);
+}
+
+static void
+lefPutDouble(FILE *f, double value)
+{
+    fwrite(&value, sizeof(double), 1, f);
+}
+
+static void
+lefPutString(FILE *f, char *str)
+{
+    int len = (str == NULL) ? -1 : strlen(str);
+
+    lefPutInt(f, len);
+    if (len > 0) fwrite(str, 1, len, f);
+}
+
+static void
+lefPutDseg(FILE *f, DSEG ds)
+{
+    lefPutInt(f, ds->layer);
+    lefPutDouble(f, ds->x1);
+    lefPutDouble(f, ds->y1);
+    lefPutDouble(f, ds->x2);
+    lefPutDouble(f, ds->y2);
+}
+
+static void
+lefPutDsegList(FILE *f, DSEG list)
+{
+    DSEG ds;
+    int n = 0;
+
+    for (ds = list; ds; ds = ds->next) n++;
+    lefPutInt(f, n);
+    for (ds = list; ds; ds = ds->next) lefPutDseg(f, ds);
+}
+
+static int
+lefGetInt(lefCacheReader *rd)
+{
+    int value = 0;
+
+    if (rd->ok && fread(&value, sizeof(int), 1, rd->f) != 1) rd->ok = FALSE;
+    return value;
+}
+
+static double
+lefGetDouble(lefCacheReader *rd)
+{
+    double value = 0.0;
+
+    if (rd->ok && fread(&value, sizeof(double), 1, rd->f) != 1) rd->ok = FALSE;
+    return value;
+}
+
+static char *
+lefGetString(lefCacheReader *rd)
+{
+    char *str;
+    int len;
+
+    len = lefGetInt(rd);
+    if (!rd->ok || len < 0) return NULL;
+    if (len > LEF_LINE_MAX * 16) {
+	rd->ok = FALSE;
+	return NULL;
+    }
+    str = (char *)malloc(len + 1);
+    if (len > 0 && fread(str, 1, len, rd->f) != (size_t)len) rd->ok = FALSE;
+    str[len] = '\0';
+    return str;
+}
+
+static void
+lefGetDseg(lefCacheReader *rd, DSEG ds)
+{
+    ds->layer = lefGetInt(rd);
+    ds->x1 = lefGetDouble(rd);
+    ds->y1 = lefGetDouble(rd);
+    ds->x2 = lefGetDouble(rd);
+    ds->y2 = lefGetDouble(rd);
+}
+
+static DSEG
+lefGetDsegList(lefCacheReader *rd)
+{
+    DSEG list = NULL, ds, *tail = &list;
+    int n;
+
+    n = lefGetInt(rd);
+    while (rd->ok && n-- > 0) {
+	ds = (DSEG)malloc(sizeof(struct dseg_));
+	lefGetDseg(rd, ds);
+	ds->next = NULL;
+	*tail = ds;
+	tail = &ds->next;
+    }
+    return list;
+}
+
+/*--------------------------------------------------------------*/
+/* LefWriteCache() ---						*/
+/*								*/
+/* Write the technology and macro library to the binary file	*/
+/* "cachename".  Returns 0 on success, -1 on failure.		*/
+/*--------------------------------------------------------------*/
+
+int
+LefWriteCache(char *cachename)
+{
+    FILE *f;
+    LEFSOURCE src;
+    LefList lefl;
+    GATE gateginfo;
+    lefSpacingRule *srule;
+    int n, i;
+
+    if (LefSources == NULL) {
+	Fprintf(stderr, "No LEF files have been read; no cache written.\n");
+	return -1;
+    }
+
+    f = fopen(cachename, "wb");
+    if (f == NULL) {
+	Fprintf(stderr, "Cannot open LEF cache file for writing: ");
+	perror(cachename);
+	return -1;
+    }
+
+    fwrite(LEFCACHE_MAGIC, 1, 8, f);
+    lefPutInt(f, LEFCACHE_VERSION);
+    lefPutInt(f, LEFCACHE_BYTEORDER);
+    lefPutInt(f, Num_layers);
+
+    /* Source LEF files */
+
+    for (n = 0, src = LefSources; src; src = src->next) n++;
+    lefPutInt(f, n);
+    for (src = LefSources; src; src = src->next) {
+	lefPutString(f, src->name);
+	fwrite(&src->size, sizeof(long), 1, f);
+	fwrite(&src->checksum, sizeof(lefsum_t), 1, f);
+	lefPutInt(f, src->oprecis);
+    }
+
+    /* Layer and via records, in list order */
+
+    for (n = 0, lefl = LefCacheLayers; lefl; lefl = lefl->next) n++;
+    lefPutInt(f, n);
+    for (lefl = LefCacheLayers; lefl; lefl = lefl->next) {
+	lefPutString(f, lefl->lefName);
+	lefPutInt(f, lefl->type);
+	lefPutInt(f, lefl->obsType);
+	lefPutInt(f, (int)lefl->lefClass);
+
+	if (lefl->lefClass == CLASS_ROUTE) {
+	    for (n = 0, srule = lefl->info.route.spacing; srule;
+			srule = srule->next) n++;
+	    lefPutInt(f, n);
+	    for (srule = lefl->info.route.spacing; srule; srule = srule->next) {
+		lefPutDouble(f, srule->width);
+		lefPutDouble(f, srule->spacing);
+	    }
+	    lefPutDouble(f, lefl->info.route.width);
+	    lefPutDouble(f, lefl->info.route.pitchx);
+	    lefPutDouble(f, lefl->info.route.pitchy);
+	    lefPutDouble(f, lefl->info.route.offsetx);
+	    lefPutDouble(f, lefl->info.route.offsety);
+	    lefPutDouble(f, lefl->info.route.respersq);
+	    lefPutDouble(f, lefl->info.route.areacap);
+	    lefPutDouble(f, lefl->info.route.edgecap);
+	    lefPutDouble(f, lefl->info.route.minarea);
+	    lefPutDouble(f, lefl->info.route.thick);
+	    lefPutDouble(f, lefl->info.route.antenna);
+	    lefPutInt(f, (int)lefl->info.route.method);
+	    lefPutInt(f, (int)lefl->info.route.hdirection);
+	}
+	else if (lefl->lefClass == CLASS_VIA || lefl->lefClass == CLASS_CUT) {
+	    lefPutDseg(f, &lefl->info.via.area);
+	    lefPutDsegList(f, lefl->info.via.lr);
+	    lefPutDouble(f, lefl->info.via.respervia);
+	    lefPutInt(f, lefl->info.via.obsType);
+	    lefPutInt(f, (int)lefl->info.via.generated);
+	}
+    }
+
+    /* Macros, in list order */
+
+    for (n = 0, gateginfo = LefCacheMacros; gateginfo;
+		gateginfo = gateginfo->next) n++;
+    lefPutInt(f, n);
+    for (gateginfo = LefCacheMacros; gateginfo; gateginfo = gateginfo->next) {
+	lefPutString(f, gateginfo->gatename);
+	lefPutDouble(f, gateginfo->width);
+	lefPutDouble(f, gateginfo->height);
+	lefPutDouble(f, gateginfo->placedX);
+	lefPutDouble(f, gateginfo->placedY);
+	lefPutInt(f, gateginfo->orient);
+	lefPutInt(f, gateginfo->nodes);
+	for (i = 0; i < gateginfo->nodes; i++) {
+	    lefPutString(f, gateginfo->node[i]);
+	    lefPutDouble(f, (double)gateginfo->area[i]);
+	    lefPutInt(f, (int)gateginfo->direction[i]);
+	    lefPutDsegList(f, gateginfo->taps[i]);
+	}
+	lefPutDsegList(f, gateginfo->obs);
+    }
+
+    if (ferror(f)) {
+	fclose(f);
+	Fprintf(stderr, "Error writing LEF cache file %s.\n", cachename);
+	return -1;
+    }
+    fclose(f);
+
+    lefCacheChanged = FALSE;
+    if (Verbose > 0)
+	Fprintf(stdout, "Wrote LEF cache %s.\n", cachename);
+    return 0;
+}
+
+/*--------------------------------------------------------------*/
+/* LefReadCache() ---						*/
+/*								*/
+/* Load the technology and macro library from the binary file	*/
+/* "cachename" written by LefWriteCache().  The cache is only	*/
+/* loaded into an empty database, and only if every LEF file	*/
+/* it was made from is unchanged.				*/
+/*								*/
+/* Returns 1 if the cache was loaded, -1 if the cache is stale,	*/
+/* and 0 if the file does not exist or is not a valid cache, or	*/
+/* if LEF data has already been read.  In the first two	*/
+/* cases the LEF files it lists are available from		*/
+/* LefCacheSource(), so that the caller can read them again	*/
+/* with LefRead(), which returns at once for any file taken	*/
+/* from the cache.						*/
+/*--------------------------------------------------------------*/
+
+int
+LefReadCache(char *cachename)
+{
+    lefCacheReader rd;
+    char magic[8];
+    LEFSOURCE srclist = NULL, src, *stail;
+    LefList layers = NULL, lefl, *ltail;
+    GATE macros = NULL, gateginfo, *gtail;
+    lefSpacingRule *srule, **rtail;
+    lefsum_t checksum;
+    long size;
+    u_char stale = FALSE;
+    int n, i, j, nodealloc, nlayers = 0, nmacros = 0;
+
+    for (i = 0; i < LefCacheNumNames; i++) free(LefCacheNames[i]);
+    free(LefCacheNames);
+    LefCacheNames = NULL;
+    LefCacheNumNames = 0;
+
+    if (LefInfo != NULL || GateInfo != NULL) {
+	Fprintf(stderr, "LEF data has already been read;  cache %s not used.\n",
+			cachename);
+	return 0;
+    }
+
+    rd.f = fopen(cachename, "rb");
+    if (rd.f == NULL) return 0;
+    rd.ok = TRUE;
+
+    if ((fread(magic, 1, 8, rd.f) != 8) || memcmp(magic, LEFCACHE_MAGIC, 8) ||
+		(lefGetInt(&rd) != LEFCACHE_VERSION) ||
+		(lefGetInt(&rd) != LEFCACHE_BYTEORDER)) {
+	Fprintf(stderr, "File %s is not a LEF cache for this version "
+			"of qrouter.\n", cachename);
+	fclose(rd.f);
+	return 0;
+    }
+    if (lefGetInt(&rd) != Num_layers) stale = TRUE;
+
+    /* Source LEF files;  check each against the file on disk */
+
+    n = lefGetInt(&rd);
+    if (n > 0 && rd.ok) LefCacheNames = (char **)malloc(n * sizeof(char *));
+    stail = &srclist;
+    for (i = 0; i < n && rd.ok; i++) {
+	src = (LEFSOURCE)malloc(sizeof(struct lefsource_));
+	src->next = NULL;
+	src->name = lefGetString(&rd);
+	if (fread(&src->size, sizeof(long), 1, rd.f) != 1) rd.ok = FALSE;
+	if (fread(&src->checksum, sizeof(lefsum_t), 1, rd.f) != 1) rd.ok = FALSE;
+	src->oprecis = lefGetInt(&rd);
+	src->preloaded = TRUE;
+	*stail = src;
+	stail = &src->next;
+	if (src->name == NULL) {
+	    rd.ok = FALSE;
+	    break;
+	}
+	LefCacheNames[LefCacheNumNames++] = strdup(src->name);
+
+	if ((lefFileChecksum(src->name, &size, &checksum) != 0) ||
+		(size != src->size) || (checksum != src->checksum)) {
+	    if (Verbose > 0)
+		Fprintf(stdout, "LEF file %s has changed since cache %s "
+			"was written.\n", src->name, cachename);
+	    stale = TRUE;
+	}
+    }
+
+    if (stale || !rd.ok) goto done;
+
+    /* Layer and via records */
+
+    nlayers = lefGetInt(&rd);
+    ltail = &layers;
+    for (i = 0; i < nlayers && rd.ok; i++) {
+	lefl = (LefList)calloc(1, sizeof(lefLayer));
+	lefl->next = NULL;
+	*ltail = lefl;
+	ltail = &lefl->next;
+
+	lefl->lefName = lefGetString(&rd);
+	lefl->type = lefGetInt(&rd);
+	lefl->obsType = lefGetInt(&rd);
+	lefl->lefClass = (u_char)lefGetInt(&rd);
+	if (lefl->lefName == NULL) rd.ok = FALSE;
+
+	if (lefl->lefClass == CLASS_ROUTE) {
+	    n = lefGetInt(&rd);
+	    rtail = &lefl->info.route.spacing;
+	    for (j = 0; j < n && rd.ok; j++) {
+		srule = (lefSpacingRule *)malloc(sizeof(lefSpacingRule));
+		srule->width = lefGetDouble(&rd);
+		srule->spacing = lefGetDouble(&rd);
+		srule->next = NULL;
+		*rtail = srule;
+		rtail = &srule->next;
+	    }
+	    lefl->info.route.width = lefGetDouble(&rd);
+	    lefl->info.route.pitchx = lefGetDouble(&rd);
+	    lefl->info.route.pitchy = lefGetDouble(&rd);
+	    lefl->info.route.offsetx = lefGetDouble(&rd);
+	    lefl->info.route.offsety = lefGetDouble(&rd);
+	    lefl->info.route.respersq = lefGetDouble(&rd);
+	    lefl->info.route.areacap = lefGetDouble(&rd);
+	    lefl->info.route.edgecap = lefGetDouble(&rd);
+	    lefl->info.route.minarea = lefGetDouble(&rd);
+	    lefl->info.route.thick = lefGetDouble(&rd);
+	    lefl->info.route.antenna = lefGetDouble(&rd);
+	    lefl->info.route.method = (u_char)lefGetInt(&rd);
+	    lefl->info.route.hdirection = (u_char)lefGetInt(&rd);
+	}
+	else if (lefl->lefClass == CLASS_VIA || lefl->lefClass == CLASS_CUT) {
+	    lefGetDseg(&rd, &lefl->info.via.area);
+	    lefl->info.via.area.next = NULL;
+	    lefl->info.via.cell = (GATE)NULL;
+	    lefl->info.via.lr = lefGetDsegList(&rd);
+	    lefl->info.via.respervia = lefGetDouble(&rd);
+	    lefl->info.via.obsType = lefGetInt(&rd);
+	    lefl->info.via.generated = (char)lefGetInt(&rd);
+	}
+    }
+
+    /* Macros */
+
+    nmacros = lefGetInt(&rd);
+    gtail = &macros;
+    for (i = 0; i < nmacros && rd.ok; i++) {
+	gateginfo = (GATE)malloc(sizeof(struct gate_));
+	gateginfo->next = NULL;
+	*gtail = gateginfo;
+	gtail = &gateginfo->next;
+
+	gateginfo->gatename = lefGetString(&rd);
+	gateginfo->gatetype = NULL;
+	gateginfo->width = lefGetDouble(&rd);
+	gateginfo->height = lefGetDouble(&rd);
+	gateginfo->placedX = lefGetDouble(&rd);
+	gateginfo->placedY = lefGetDouble(&rd);
+	gateginfo->orient = lefGetInt(&rd);
+	gateginfo->nodes = lefGetInt(&rd);
+	gateginfo->obs = NULL;
+	if (gateginfo->gatename == NULL || gateginfo->nodes < 0 ||
+			gateginfo->nodes > 1000000) {
+	    gateginfo->nodes = 0;
+	    rd.ok = FALSE;
+	}
+
+	/* Allocate pin arrays in blocks of 10, as LefReadMacro() does */
+	nodealloc = (gateginfo->nodes / 10 + 1) * 10;
+	gateginfo->taps = (DSEG *)malloc(nodealloc * sizeof(DSEG));
+	gateginfo->noderec = (NODE *)malloc(nodealloc * sizeof(NODE));
+	gateginfo->direction = (u_char *)malloc(nodealloc * sizeof(u_char));
+	gateginfo->area = (float *)malloc(nodealloc * sizeof(float));
+	gateginfo->netnum = (int *)malloc(nodealloc * sizeof(int));
+	gateginfo->node = (char **)malloc(nodealloc * sizeof(char *));
+	gateginfo->taps[0] = NULL;
+	gateginfo->noderec[0] = NULL;
+	gateginfo->area[0] = 0.0;
+	gateginfo->node[0] = NULL;
+	gateginfo->netnum[0] = -1;
+
+	for (j = 0; j < gateginfo->nodes; j++) {
+	    gateginfo->node[j] = lefGetString(&rd);
+	    gateginfo->area[j] = (float)lefGetDouble(&rd);
+	    gateginfo->direction[j] = (u_char)lefGetInt(&rd);
+	    gateginfo->taps[j] = lefGetDsegList(&rd);
+	    gateginfo->noderec[j] = NULL;
+	    gateginfo->netnum[j] = -1;
+	}
+	gateginfo->obs = lefGetDsegList(&rd);
+    }
+
+done:
+    fclose(rd.f);
+
+    if (!rd.ok) {
+	Fprintf(stderr, "LEF cache file %s is truncated or corrupt.\n",
+			cachename);
+	stale = TRUE;
+    }
+
+    if (stale || !rd.ok) {
+	/* Discard anything read.  DSEG lists and strings are small	*/
+	/* and this only happens once, so they are simply dropped	*/
+	/* along with the records that hold them.			*/
+
+	while (layers) {
+	    lefl = layers->next;
+	    free(layers);
+	    layers = lefl;
+	}
+	while (macros) {
+	    gateginfo = macros->next;
+	    free(macros);
+	    macros = gateginfo;
+	}
+	while (srclist) {
+	    src = srclist->next;
+	    free(srclist->name);
+	    free(srclist);
+	    srclist = src;
+	}
+	return (rd.ok) ? -1 : 0;
+    }
+
+    /* Install the records in the database */
+
+    LefInfo = layers;
+    GateInfo = macros;
+    LefCacheLayers = LefInfo;
+    LefCacheMacros = GateInfo;
+
+    for (stail = &LefSources; *stail; stail = &(*stail)->next);
+    *stail = srclist;
+    lefCacheChanged = FALSE;
+
+    PinMacro = lefFindCell("pin");
+
+    /* Restore the layer names used for route output, as LefRead()	*/
+    /* and LefReadLayers() set them.					*/
+
+    for (lefl = LefInfo; lefl; lefl = lefl->next) {
+	if ((lefl->lefClass == CLASS_ROUTE || lefl->lefClass == CLASS_CUT) &&
+			(lefl->type >= 0) && (lefl->type < MAX_TYPES))
+	    strcpy(CIFLayer[lefl->type], lefl->lefName);
+    }
+
+    /* The via choices depend on the "via" configuration		*/
+    /* statements, so these are always worked out again.		*/
+
+    LefAssignLayerVias();
+    LefTechBuild();
+
+    if (Verbose > 0) {
+	Fprintf(stdout, "Loaded LEF cache %s: %d layers and vias, %d macros.\n",
+			cachename, nlayers, nmacros);
+	Flush(stdout);
+    }
+    return 1;
+}
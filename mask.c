@@ -28,9 +28,19 @@
 #include "lef.h"
 #include "def.h"
 #include "graphics.h"
+#include "memstat.h"
+#include "congest.h"
 
 u_char   *RMask;    	        // mask out best area to route
 
+/* Area of RMask[] set by the last mask, and the value of the	*/
+/* mask everywhere else.  Each new mask sets only the area	*/
+/* around its own net, and values left in RMask[] by earlier	*/
+/* nets outside of that area are never read (see MASKVAL()).	*/
+
+struct seg_ MaskArea = {NULL, 0, 0, 0, -1, -1, 0};
+u_char   MaskFill = (u_char)0;
+
 /*--------------------------------------------------------------*/
 /* Comparison routine used for qsort.  Sort nets by number of	*/
 /* nodes.							*/
@@ -342,8 +352,7 @@ void defineRouteTree(NET net)
 
 void initMask(void)
 {
-   RMask = (u_char *)calloc(NumChannelsX * NumChannelsY,
-			sizeof(u_char));
+   RMask = (u_char *)mem_calloc(MEM_GRID, NUMCHANNELS, sizeof(u_char));
    if (!RMask) {
       fprintf(stderr, "Out of memory 3.\n");
       exit(3);
@@ -482,6 +491,33 @@ void setBboxCurrent(NET net)
 	}
 }
 
+/*--------------------------------------------------------------*/
+/* startMask() ---						*/
+/*								*/
+/* Begin a new mask covering the area from (xmin, ymin) to	*/
+/* (xmax, ymax), which is clipped to the grid and set to	*/
+/* "value".  The rest of the grid reads as "value" without	*/
+/* being cleared.  All of the mask must be drawn inside this	*/
+/* area.							*/
+/*--------------------------------------------------------------*/
+
+static void
+startMask(int xmin, int ymin, int xmax, int ymax, u_char value)
+{
+    int y;
+
+    MaskArea.x1 = MAX(xmin, 0);
+    MaskArea.y1 = MAX(ymin, 0);
+    MaskArea.x2 = MIN(xmax, NumChannelsX - 1);
+    MaskArea.y2 = MIN(ymax, NumChannelsY - 1);
+    MaskFill = value;
+
+    if (MaskArea.x1 > MaskArea.x2) return;
+    for (y = MaskArea.y1; y <= MaskArea.y2; y++)
+	memset((void *)&RMASK(MaskArea.x1, y), (int)value,
+		(size_t)(MaskArea.x2 - MaskArea.x1 + 1) * sizeof(u_char));
+}
+
 /*--------------------------------------------------------------*/
 /* createBboxMask() ---						*/
 /*								*/
@@ -495,18 +531,24 @@ void setBboxCurrent(NET net)
 
 void createBboxMask(NET net, u_char halo)
 {
-    int xmin, ymin, xmax, ymax;
-    int i, j, gx1, gy1, gx2, gy2;
+    createBoxMask(net->xmin, net->ymin, net->xmax, net->ymax, halo);
+}
 
-    fillMask((u_char)halo);
+/*--------------------------------------------------------------*/
+/* createBoxMask() ---						*/
+/*								*/
+/* Create a mask of the area from (xmin, ymin) to (xmax, ymax),	*/
+/* increased by one route track for each pass, up to "halo".	*/
+/*--------------------------------------------------------------*/
 
-    xmin = net->xmin;
-    xmax = net->xmax;
-    ymin = net->ymin;
-    ymax = net->ymax;
+void createBoxMask(int xmin, int ymin, int xmax, int ymax, u_char halo)
+{
+    int i, j, gx1, gy1, gx2, gy2;
 
-    for (gx1 = xmin; gx1 <= xmax; gx1++)
-	for (gy1 = ymin; gy1 <= ymax; gy1++)
+    startMask(xmin - halo, ymin - halo, xmax + halo, ymax + halo, halo);
+
+    for (gx1 = MAX(xmin, 0); gx1 <= MIN(xmax, NumChannelsX - 1); gx1++)
+	for (gy1 = MAX(ymin, 0); gy1 <= MIN(ymax, NumChannelsY - 1); gy1++)
 	    RMASK(gx1, gy1) = (u_char)0;
 
     for (i = 1; i <= halo; i++) {
@@ -547,7 +589,7 @@ void createBboxMask(NET net, u_char halo)
 
 int analyzeCongestion(int ycent, int ymin, int ymax, int xmin, int xmax)
 {
-    int x, y, i, minidx = -1, sidx, n;
+    int y, i, minidx = -1, sidx;
     int *score, minscore;
 
     score = (int *)malloc((ymax - ymin + 1) * sizeof(int));
@@ -555,14 +597,7 @@ int analyzeCongestion(int ycent, int ymin, int ymax, int xmin, int xmax)
     for (y = ymin; y <= ymax; y++) {
 	sidx = y - ymin;
 	score[sidx] = ABSDIFF(ycent, y) * Num_layers;
-	for (x = xmin; x <= xmax; x++) {
-	    for (i = 0; i < Num_layers; i++) {
-		n = OBSVAL(x, y, i);
-		if (n & ROUTED_NET) score[sidx]++;
-		if (n & NO_NET) score[sidx]++;
-		if (n & PINOBSTRUCTMASK) score[sidx]++;
-	    }
-	}
+	score[sidx] += congestion_row(y, xmin, xmax);
     }
     minscore = MAXRT;
     for (i = 0; i < (ymax - ymin + 1); i++) {
@@ -611,14 +646,51 @@ void createMask(NET net, u_char slack, u_char halo)
   int dx, dy, gx1, gx2, gy1, gy2;
   int xcent, ycent, xmin, ymin, xmax, ymax;
   int oxmin, oymin, oxmax, oymax;
-
-  fillMask((u_char)halo);
+  int pad;
 
   oxmin = net->xmin;
   oxmax = net->xmax;
   oymin = net->ymin;
   oymax = net->ymax;
 
+  // The mask lies within "slack + halo" tracks of the bounding box,
+  // the trunk, and the node branch and tap points.  Set only that area.
+
+  if ((oxmin > oxmax) || (oymin > oymax)) {
+     xmin = ymin = 0;
+     xmax = NumChannelsX - 1;
+     ymax = NumChannelsY - 1;
+  }
+  else {
+     xmin = MIN(oxmin, net->trunkx);
+     xmax = MAX(oxmax, net->trunkx);
+     ymin = MIN(oymin, net->trunky);
+     ymax = MAX(oymax, net->trunky);
+  }
+  for (n1 = net->netnodes; n1; n1 = n1->next) {
+     dtap = (n1->taps == NULL) ? n1->extend : n1->taps;
+     if (dtap) {
+	xmin = MIN(xmin, n1->branchx);
+	xmax = MAX(xmax, n1->branchx);
+	ymin = MIN(ymin, n1->branchy);
+	ymax = MAX(ymax, n1->branchy);
+     }
+     for (dtap = n1->taps; dtap != NULL; dtap = dtap->next) {
+	xmin = MIN(xmin, dtap->gridx);
+	xmax = MAX(xmax, dtap->gridx);
+	ymin = MIN(ymin, dtap->gridy);
+	ymax = MAX(ymax, dtap->gridy);
+     }
+     for (dtap = n1->extend; dtap != NULL; dtap = dtap->next) {
+	xmin = MIN(xmin, dtap->gridx);
+	xmax = MAX(xmax, dtap->gridx);
+	ymin = MIN(ymin, dtap->gridy);
+	ymax = MAX(ymax, dtap->gridy);
+     }
+  }
+  pad = (int)slack + (int)halo;
+  startMask(xmin - pad, ymin - pad, xmax + pad, ymax + pad, halo);
+
   xcent = net->trunkx;
   ycent = net->trunky;
 
@@ -803,12 +875,15 @@ void createMask(NET net, u_char slack, u_char halo)
 /* fillMask() fills the Mask[] array with all 1s as a last	*/
 /* resort, ensuring that no valid routes are missed due to a	*/
 /* bad guess about the optimal route positions.			*/
+/*								*/
+/* Nothing is written to RMask[];  the mask area is emptied so	*/
+/* that every position reads as "value".			*/
 /*--------------------------------------------------------------*/
 
 void fillMask(u_char value) {
-   memset((void *)RMask, (int)value,
-		(size_t)(NumChannelsX * NumChannelsY
-		* sizeof(u_char)));
+   MaskArea.x1 = MaskArea.y1 = 0;
+   MaskArea.x2 = MaskArea.y2 = -1;
+   MaskFill = value;
 }
 
 /* end of mask.c */
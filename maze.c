@@ -19,9 +19,11 @@
 #include "qrouter.h"
 #include "qconfig.h"
 #include "point.h"
+#include "pool.h"
 #include "node.h"
 #include "maze.h"
 #include "lef.h"
+#include "congest.h"
 
 extern int TotalRoutes;
 
@@ -793,7 +795,7 @@ int set_routes_to_net(NODE node, NET net, int newflags, POINT *pushlist,
 /*--------------------------------------------------------------*/
 
 static int
-addcollidingnet(NETLIST *nlptr, int netnum, int x, int y, int lay)
+addcollidingnet(NETLIST *nlptr, obsword netnum, int x, int y, int lay)
 {
     ROUTE rt;
     NETLIST cnl;
@@ -810,7 +812,7 @@ addcollidingnet(NETLIST *nlptr, int netnum, int x, int y, int lay)
     for (i = 0; i < Numnets; i++) {
 	fnet = Nlnets[i];
 	if (fnet->netnum == netnum) {
-	    cnl = (NETLIST)malloc(sizeof(struct netlist_));
+	    cnl = allocNETLIST();
 	    cnl->net = fnet;
 	    cnl->next = *nlptr;
 	    *nlptr = cnl;
@@ -866,7 +868,8 @@ NETLIST find_colliding(NET net, int *ripnum)
    NETLIST nl = (NETLIST)NULL, cnl;
    ROUTE rt;
    SEG seg;
-   int lay, x, y, orignet, rnum;
+   int lay, x, y, rnum;
+   obsword orignet;
 
    /* Scan the routed points for recorded collisions.	*/
 
@@ -1083,7 +1086,6 @@ void analyze_route_overwrite(int x, int y, int lay, int netnum)
 void remove_routes(ROUTE netroutes, u_char flagged)
 {
    ROUTE rt, rsave, rlast;
-   SEG seg;
 
    /* Remove all flagged routing information from this net	*/
    /* if "flagged" is true, otherwise remove all routing	*/
@@ -1100,12 +1102,8 @@ void remove_routes(ROUTE netroutes, u_char flagged)
 	    else
 		rlast->next = rsave->next;
 	    rsave = rsave->next;
-	    while (rt->segments) {
-	       seg = rt->segments->next;
-	       free(rt->segments);
-	       rt->segments = seg;
-	    }
-	    free(rt);
+	    freeSEGlist(rt->segments);
+	    freeROUTE(rt);
 	 }
 	 else {
 	    rlast = rsave;
@@ -1117,12 +1115,8 @@ void remove_routes(ROUTE netroutes, u_char flagged)
       while (netroutes) {
          rt = netroutes;
          netroutes = rt->next;
-         while (rt->segments) {
-	    seg = rt->segments->next;
-	    free(rt->segments);
-	    rt->segments = seg;
-         }
-         free(rt);
+         freeSEGlist(rt->segments);
+         freeROUTE(rt);
       }
    }
 }
@@ -1144,6 +1138,7 @@ void clear_drc_blockage(int x, int y, int lay)
 	OBSVAL(x, y, lay) |= (blockcount - 1);
     else
 	OBSVAL(x, y, lay) &= ~DRC_BLOCKAGE;
+    congestion_update(x, y);
 }
 
 /*--------------------------------------------------------------*/
@@ -1151,7 +1146,8 @@ void clear_drc_blockage(int x, int y, int lay)
 
 void set_drc_blockage(int x, int y, int lay)
 {
-    int blockcount, obsval;
+    int blockcount;
+    obsword obsval;
 
     obsval = OBSVAL(x, y, lay);
     if ((obsval & DRC_BLOCKAGE) == DRC_BLOCKAGE) {
@@ -1162,6 +1158,7 @@ void set_drc_blockage(int x, int y, int lay)
     else if ((obsval & NETNUM_MASK) == 0) {
 	OBSVAL(x, y, lay) &= ~OBSTRUCT_MASK;
 	OBSVAL(x, y, lay) |= DRC_BLOCKAGE;
+	congestion_update(x, y);
     }
 }
 
@@ -1185,7 +1182,8 @@ void set_drc_blockage(int x, int y, int lay)
 
 u_char ripup_net(NET net, u_char restore, u_char flagged, u_char retain)
 {
-   int thisnet, oldnet, x, y, lay, dir;
+   int thisnet, x, y, lay;
+   obsword oldnet, dir;
    NODEINFO lnode;
    NODE node;
    ROUTE rt;
@@ -1195,6 +1193,7 @@ u_char ripup_net(NET net, u_char restore, u_char flagged, u_char retain)
    if (flagged) ripup_dependent(net);
 
    thisnet = net->netnum;
+   net->flags |= NET_DIRTY | NET_RC_DIRTY;
 
    for (rt = net->routes; rt; rt = rt->next) {
       if (flagged && !(rt->flags & RT_RIP)) continue;
@@ -1208,7 +1207,7 @@ u_char ripup_net(NET net, u_char restore, u_char flagged, u_char retain)
 	       if ((oldnet > 0) && (oldnet < MAXNETNUM)) {
 	          if (oldnet != thisnet) {
 		     Fprintf(stderr, "Error: position %d %d layer %d has net "
-				"%d not %d!\n", x, y, lay, oldnet, thisnet);
+				"%d not %d!\n", x, y, lay, (int)oldnet, thisnet);
 		     // Stop-gap:  Need to analyze the root of this problem.
 		     // However, a reasonable action is to try to find the
 		     // net and route associated with the incorrect net.
@@ -1258,6 +1257,7 @@ u_char ripup_net(NET net, u_char restore, u_char flagged, u_char retain)
 				DRC_BLOCKAGE) == DRC_BLOCKAGE))
 			clear_drc_blockage(x, y + 1, lay);
 		  }
+		  congestion_update(x, y);
 	       }
 
 	       // Check for and handle via end on last route segment.
@@ -1358,13 +1358,14 @@ u_char ripup_net(NET net, u_char restore, u_char flagged, u_char retain)
 POINT eval_pt(GRIDP *ept, u_char flags, u_char stage)
 {
     int thiscost = 0;
-    int netnum;
+    obsword netnum;
     NODE node;
     NODEINFO nodeptr, lnode;
     NETLIST nl;
     PROUTE *Pr, *Pt;
     GRIDP newpt;
     POINT ptret = NULL;
+    int run = 0;
 
     newpt = *ept;
 
@@ -1546,6 +1547,21 @@ POINT eval_pt(GRIDP *ept, u_char flags, u_char stage)
     else
 	thiscost += (ept->y == newpt.y) ? SegCost : JogCost;
 
+    // Antenna-aware routing:  Count the length of the route on the
+    // layer since it last came down from a higher layer, and make
+    // each step cost more as the run nears the antenna limit.
+
+    if (AntennaRun != NULL) {
+	if (newpt.lay >= ept->lay) {
+	    Pt = &OBS2VAL(ept->x, ept->y, ept->lay);
+	    if (!(Pt->flags & PR_SOURCE))
+		run = AntennaRun[ept->lay][OGRID(ept->x, ept->y)];
+	    if ((newpt.lay == ept->lay) && (run < 65535)) run++;
+	}
+	if (AntennaRunLimit[newpt.lay] > 0)
+	    thiscost += AntennaCost * run / AntennaRunLimit[newpt.lay];
+    }
+
     // Add the cost to the cost of the original position
     thiscost += ept->cost;
 
@@ -1567,6 +1583,8 @@ POINT eval_pt(GRIDP *ept, u_char flags, u_char stage)
        Pr->flags |= flags;
        Pr->prdata.cost = thiscost;
        Pr->flags &= ~PR_PROCESSED;	// Need to reprocess this node
+       if (AntennaRun != NULL)
+	  AntennaRun[newpt.lay][OGRID(newpt.x, newpt.y)] = (u_short)run;
 
        if (Verbose > 3) {
 	  Fprintf(stdout, "New cost %d at (%d %d %d)\n", thiscost,
@@ -1612,11 +1630,11 @@ POINT eval_pt(GRIDP *ept, u_char flags, u_char stage)
 /* offset tap, then mark the tap unroutable.		*/
 /*------------------------------------------------------*/
 
-void writeback_segment(SEG seg, int netnum)
+void writeback_segment(SEG seg, obsword netnum)
 {
    double dist;
-   int  i, layer, dir;
-   u_int sobs;
+   int  i, layer;
+   obsword dir, sobs;
    NODEINFO lnode;
 
    if (seg->segtype & ST_VIA) {
@@ -1781,6 +1799,7 @@ void writeback_segment(SEG seg, int netnum)
 	    set_drc_blockage(seg->x2 - 1, seg->y2, seg->layer);
       }
    }
+   congestion_update_seg(seg);
 }
 
 /*--------------------------------------------------------------*/
@@ -2009,7 +2028,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
    NODEINFO lnode1, lnode2;
    int  lay2, rval;
    int  dx = -1, dy = -1, dl;
-   u_int netnum, netobs1, netobs2, dir1, dir2;
+   obsword netnum, netobs1, netobs2, dir1, dir2;
    u_char first = (u_char)1;
    u_char dmask;
    u_char pflags, p2flags;
@@ -2716,7 +2735,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
    lseg = (SEG)NULL;
 
    while (1) {
-      seg = (SEG)malloc(sizeof(struct seg_));
+      seg = allocSEG();
       seg->next = NULL;
 
       seg->segtype = (lrcur->layer == lrprev->layer) ? ST_WIRE : ST_VIA;
@@ -2761,7 +2780,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 
       if (Verbose > 3) {
          Fprintf(stdout, "commit: index = %d, net = %d\n",
-		Pr->prdata.net, netnum);
+		(int)Pr->prdata.net, (int)netnum);
 
 	 if (seg->segtype & ST_WIRE) {
             Fprintf(stdout, "commit: wire layer %d, (%d,%d) to (%d,%d)\n",
@@ -2814,6 +2833,7 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 	    // if the path goes down instead of up (can happen on pins,
 	    // in particular)
 	    OBSVAL(seg->x1, seg->y1, lay2) |= dir2;
+	    congestion_update(seg->x1, seg->y1);
 	 }
       }
 
@@ -2822,6 +2842,8 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 
       OBSVAL(seg->x1, seg->y1, seg->layer) |= dir1;
       OBSVAL(seg->x2, seg->y2, lay2) |= dir2;
+      congestion_update(seg->x1, seg->y1);
+      congestion_update(seg->x2, seg->y2);
 
       // An offset route end on the previous segment, if it is a via, needs
       // to carry over to this one, if it is a wire route.
@@ -2872,10 +2894,12 @@ int commit_proute(ROUTE rt, GRIDP *ept, u_char stage)
 
          if (dir2 && (stage == (u_char)0)) {
 	    OBSVAL(seg->x2, seg->y2, lay2) |= dir2;
+	    congestion_update(seg->x2, seg->y2);
          }
 	 else if (dir1 && (seg->segtype & ST_VIA)) {
 	    // This also applies to vias at the end of a route
 	    OBSVAL(seg->x1, seg->y1, seg->layer) |= dir1;
+	    congestion_update(seg->x1, seg->y1);
 	 }
 
 	 // Before returning, set *ept to the endpoint
@@ -2922,7 +2946,7 @@ int writeback_route(ROUTE rt)
 {
    SEG seg;
    int  lay2;
-   u_int netnum, dir1, dir2;
+   obsword netnum, dir1, dir2;
    u_char first = (u_char)1;
 
    netnum = rt->netnum | ROUTED_NET;
@@ -2955,6 +2979,10 @@ int writeback_route(ROUTE rt)
 	 else if (dir2)
 	    OBSVAL(seg->x2, seg->y2, lay2) |= dir2;
       }
+      if (dir1 || dir2) {
+	 congestion_update(seg->x1, seg->y1);
+	 congestion_update(seg->x2, seg->y2);
+      }
    }
    return TRUE;
 }
@@ -2968,6 +2996,7 @@ int writeback_all_routes(NET net)
    ROUTE rt;
    int result = TRUE;
 
+   net->flags |= NET_DIRTY | NET_RC_DIRTY;
    for (rt = net->routes; rt; rt = rt->next) {
       if (writeback_route(rt) == FALSE)
 	 result = FALSE;
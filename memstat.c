@@ -0,0 +1,185 @@
+/*--------------------------------------------------------------*/
+/* memstat.c --							*/
+/*								*/
+/* Memory accounting by subsystem.  The large data structures	*/
+/* (routing grid, node information, taps, route records, and	*/
+/* the POINT store) are allocated through the wrappers here,	*/
+/* which keep a running count of bytes in use and the peak	*/
+/* value for each subsystem.					*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+
+#include "qrouter.h"
+#include "memstat.h"
+
+static long MemInuse[MEM_NUMCLASSES];
+static long MemPeak[MEM_NUMCLASSES];
+static long MemTotal = 0;
+static long MemTotalPeak = 0;
+
+static char *MemClassNames[MEM_NUMCLASSES] = {
+    "grid", "nodeinfo", "taps", "routes", "points"
+};
+
+/*--------------------------------------------------------------*/
+/* mem_account() ---						*/
+/*								*/
+/* Charge (or, if negative, credit) a number of bytes to a	*/
+/* subsystem.  Used directly for memory that is not obtained	*/
+/* through mem_malloc(), such as mmap'd blocks.			*/
+/*--------------------------------------------------------------*/
+
+#ifdef HAVE_PTHREAD_H
+
+/* Worker threads may allocate through the wrappers, so the	*/
+/* counters are updated atomically.				*/
+
+static void
+mem_raise_peak(long *peak, long value)
+{
+    long old, prev;
+
+    old = __sync_fetch_and_add(peak, 0);
+    while (value > old) {
+	prev = __sync_val_compare_and_swap(peak, old, value);
+	if (prev == old) break;
+	old = prev;
+    }
+}
+
+void
+mem_account(int memclass, long bytes)
+{
+    mem_raise_peak(&MemPeak[memclass],
+		__sync_add_and_fetch(&MemInuse[memclass], bytes));
+    mem_raise_peak(&MemTotalPeak, __sync_add_and_fetch(&MemTotal, bytes));
+}
+
+#else
+
+void
+mem_account(int memclass, long bytes)
+{
+    MemInuse[memclass] += bytes;
+    if (MemInuse[memclass] > MemPeak[memclass])
+	MemPeak[memclass] = MemInuse[memclass];
+
+    MemTotal += bytes;
+    if (MemTotal > MemTotalPeak) MemTotalPeak = MemTotal;
+}
+
+#endif /* !HAVE_PTHREAD_H */
+
+/*--------------------------------------------------------------*/
+/* Wrapped allocators.  These behave like malloc(), calloc(),	*/
+/* and free(), and return NULL on failure.			*/
+/*--------------------------------------------------------------*/
+
+void *
+mem_malloc(int memclass, size_t size)
+{
+    void *ptr;
+
+    ptr = malloc(size);
+    if (ptr != NULL) mem_account(memclass, (long)size);
+    return ptr;
+}
+
+void *
+mem_calloc(int memclass, size_t nmemb, size_t size)
+{
+    void *ptr;
+
+    ptr = calloc(nmemb, size);
+    if (ptr != NULL) mem_account(memclass, (long)(nmemb * size));
+    return ptr;
+}
+
+void
+mem_free(int memclass, void *ptr, size_t size)
+{
+    if (ptr == NULL) return;
+    free(ptr);
+    mem_account(memclass, -(long)size);
+}
+
+/*--------------------------------------------------------------*/
+/* Query routines						*/
+/*--------------------------------------------------------------*/
+
+long
+mem_inuse(int memclass)
+{
+    return MemInuse[memclass];
+}
+
+long
+mem_peak(int memclass)
+{
+    return MemPeak[memclass];
+}
+
+long
+mem_total_inuse(void)
+{
+    return MemTotal;
+}
+
+long
+mem_total_peak(void)
+{
+    return MemTotalPeak;
+}
+
+char *
+mem_classname(int memclass)
+{
+    return MemClassNames[memclass];
+}
+
+/*--------------------------------------------------------------*/
+/* mem_reset_peak() ---						*/
+/*								*/
+/* Set all peak values to the current usage, so that the peak	*/
+/* of a single stage can be measured.				*/
+/*--------------------------------------------------------------*/
+
+void
+mem_reset_peak(void)
+{
+    int i;
+
+    for (i = 0; i < MEM_NUMCLASSES; i++)
+	MemPeak[i] = MemInuse[i];
+    MemTotalPeak = MemTotal;
+}
+
+/*--------------------------------------------------------------*/
+/* mem_summary() ---						*/
+/*								*/
+/* Print the current and peak memory use of each subsystem.	*/
+/* "stagename", if non-NULL, is used in the heading.		*/
+/*--------------------------------------------------------------*/
+
+void
+mem_summary(char *stagename)
+{
+    int i;
+
+    if (stagename != NULL)
+	Fprintf(stdout, "Memory use after %s (kbytes, current / peak):\n",
+		stagename);
+    else
+	Fprintf(stdout, "Memory use (kbytes, current / peak):\n");
+    for (i = 0; i < MEM_NUMCLASSES; i++)
+	Fprintf(stdout, "   %-10s %10ld / %ld\n", MemClassNames[i],
+		(MemInuse[i] + 1023) / 1024, (MemPeak[i] + 1023) / 1024);
+    Fprintf(stdout, "   %-10s %10ld / %ld\n", "total",
+		(MemTotal + 1023) / 1024, (MemTotalPeak + 1023) / 1024);
+    Flush(stdout);
+}
+
+/* end of memstat.c */
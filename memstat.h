@@ -0,0 +1,41 @@
+/*--------------------------------------------------------------*/
+/* memstat.h --							*/
+/*								*/
+/* Memory accounting by subsystem (header file)			*/
+/*--------------------------------------------------------------*/
+
+#ifndef MEMSTAT_H
+
+#include <stddef.h>
+
+/* Subsystems for which memory use is tracked */
+
+#define MEM_GRID	0	/* Obs, Obs2, Obsinfo, and RMask arrays	*/
+#define MEM_NODEINFO	1	/* Nodeinfo arrays and records		*/
+#define MEM_TAPS	2	/* Node tap and extend DPOINT lists	*/
+#define MEM_ROUTES	3	/* SEG, ROUTE, and NETLIST pools	*/
+#define MEM_POINTS	4	/* POINT store used by the maze router	*/
+
+#define MEM_NUMCLASSES	5
+
+/* The allocators take the subsystem to charge.  The size of a	*/
+/* block must be passed back to mem_free(), since no header is	*/
+/* kept with the block.						*/
+
+extern void *mem_malloc(int memclass, size_t size);
+extern void *mem_calloc(int memclass, size_t nmemb, size_t size);
+extern void  mem_free(int memclass, void *ptr, size_t size);
+extern void  mem_account(int memclass, long bytes);
+
+extern long  mem_inuse(int memclass);
+extern long  mem_peak(int memclass);
+extern long  mem_total_inuse(void);
+extern long  mem_total_peak(void);
+extern char *mem_classname(int memclass);
+extern void  mem_reset_peak(void);
+extern void  mem_summary(char *stagename);
+
+#define MEMSTAT_H
+#endif
+
+/* end of memstat.h */
@@ -20,6 +20,7 @@
 #include "lef.h"
 #include "def.h"
 #include "output.h"
+#include "memstat.h"
 
 /*--------------------------------------------------------------*/
 /* SetNodeinfo --						*/
@@ -36,7 +37,8 @@ SetNodeinfo(int gridx, int gridy, int layer, NODE node)
 
     lnodeptr = &NODEIPTR(gridx, gridy, layer);
     if (*lnodeptr == NULL) {
-	*lnodeptr = (NODEINFO)calloc(1, sizeof(struct nodeinfo_));
+	*lnodeptr = (NODEINFO)mem_calloc(MEM_NODEINFO, 1,
+		sizeof(struct nodeinfo_));
 
 	/* Make sure this position is in the list of node's taps.  Add	*/
 	/* it if it is not there.					*/
@@ -49,7 +51,7 @@ SetNodeinfo(int gridx, int gridy, int layer, NODE node)
 		if (dp->gridx == gridx && dp->gridy == gridy && dp->layer == layer)
 		    break;
 	if (dp == NULL) {
-	    dp = (DPOINT)malloc(sizeof(struct dpoint_));
+	    dp = (DPOINT)mem_malloc(MEM_TAPS, sizeof(struct dpoint_));
 	    dp->gridx = gridx;
 	    dp->gridy = gridy;
 	    dp->layer = layer;
@@ -76,11 +78,28 @@ FreeNodeinfo(int gridx, int gridy, int layer)
     lnodeptr = &NODEIPTR(gridx, gridy, layer);
 
     if (*lnodeptr != NULL) {
-        free(*lnodeptr);
+        mem_free(MEM_NODEINFO, *lnodeptr, sizeof(struct nodeinfo_));
 	*lnodeptr = NULL;
     }
 }
 
+/*--------------------------------------------------------------*/
+/* FindGateNode --						*/
+/*	Return the gate instance that "node" is a pin of, and	*/
+/*	set "ridx" to the index of the node in the gate's	*/
+/*	noderec array.  The link is made when the node is	*/
+/*	read from the DEF file.  Return NULL if the node does	*/
+/*	not belong to any gate.					*/
+/*--------------------------------------------------------------*/
+
+GATE
+FindGateNode(NODE node, int *ridx)
+{
+    if ((node == NULL) || (node->gate == NULL)) return NULL;
+    *ridx = node->gateidx;
+    return node->gate;
+}
+
 /*--------------------------------------------------------------*/
 /* count_reachable_taps()					*/
 /*								*/
@@ -113,13 +132,14 @@ count_reachable_taps(u_char unblock_all)
     NODEINFO lnode;
     GATE g;
     DSEG ds;
-    int l, i, j, orient;
+    int l, i, orient;
     int gridx, gridy;
+    gindex j;
     double deltax, deltay;
     double dx, dy;
 
     for (l = 0; l < Num_layers; l++) {
-	for (j = 0; j < NumChannelsX * NumChannelsY; j++) {
+	for (j = 0; j < NUMCHANNELS; j++) {
 	    if (Nodeinfo[l][j]) {
 		node = Nodeinfo[l][j]->nodeloc;
 		if (node != NULL) {
@@ -187,7 +207,7 @@ count_reachable_taps(u_char unblock_all)
 					    OBSVAL(gridx, gridy, ds->layer) =
 						(OBSVAL(gridx, gridy, ds->layer)
 						& BLOCKED_MASK)
-						| (u_int)node->netnum;
+						| (obsword)node->netnum;
 					    lnode = SetNodeinfo(gridx, gridy, ds->layer,
 							node);
 					    lnode->nodeloc = node;
@@ -216,7 +236,8 @@ count_reachable_taps(u_char unblock_all)
 		/* cleanly within the tap geometry, then allow it.	 */
 
 		double dist, mindist;
-		int dir, mask, tapx, tapy, tapl;
+		int dir, tapx, tapy, tapl;
+		obsword mask;
 
 		/* Will try more than one via if available */
 		for (orient = 0; orient < 4; orient += 2) {
@@ -359,7 +380,7 @@ count_reachable_taps(u_char unblock_all)
 
 			OBSVAL(tapx, tapy, tapl) =
 				(OBSVAL(tapx, tapy, tapl) & BLOCKED_MASK)
-				| mask | (u_int)node->netnum;
+				| mask | (obsword)node->netnum;
 			lnode = SetNodeinfo(tapx, tapy, tapl, node);
 			lnode->nodeloc = node;
 			lnode->nodesav = node;
@@ -642,11 +663,11 @@ void create_obstructions_from_variable_pitch(void)
 static void
 disable_gridpos(int x, int y, int lay)
 {
-    int apos = OGRID(x, y);
+    gindex apos = OGRID(x, y);
 
-    Obs[lay][apos] = (u_int)(NO_NET | OBSTRUCT_MASK);
+    Obs[lay][apos] = (obsword)(NO_NET | OBSTRUCT_MASK);
     if (Nodeinfo[lay][apos]) {
-	free(Nodeinfo[lay][apos]);
+	mem_free(MEM_NODEINFO, Nodeinfo[lay][apos], sizeof(struct nodeinfo_));
 	Nodeinfo[lay][apos] = NULL;
     }
 }
@@ -662,11 +683,12 @@ disable_gridpos(int x, int y, int lay)
 void
 count_pinlayers(void)
 {
-   int j, l;
+   int l;
+   gindex j;
 
    Pinlayers = 0;
    for (l = 0; l < Num_layers; l++) {
-      for (j = 0; j < NumChannelsX * NumChannelsY; j++) {
+      for (j = 0; j < NUMCHANNELS; j++) {
 	 if (Nodeinfo[l][j]) {
 	    Pinlayers = l + 1;
 	    break;
@@ -675,7 +697,7 @@ count_pinlayers(void)
    }
 
    for (l = Pinlayers; l < Num_layers; l++) {
-      free(Nodeinfo[l]);
+      mem_free(MEM_NODEINFO, Nodeinfo[l], NUMCHANNELS * sizeof(NODEINFO));
       Nodeinfo[l] = NULL;
    }
 }
@@ -694,8 +716,8 @@ static void
 check_obstruct(int gridx, int gridy, DSEG ds, double dx, double dy, double delta)
 {
     ObsInfoRec *obsinfoptr;
-    u_int *obsptr;
-    u_int origmask;
+    obsword *obsptr;
+    obsword origmask;
     float distx, disty;
 
     obsptr = &(OBSVAL(gridx, gridy, ds->layer));
@@ -852,7 +874,7 @@ void clip_gate_taps(void)
 		    else
 			dpl->next = dp->next;
 
-		    free(dp);
+		    mem_free(MEM_TAPS, dp, sizeof(struct dpoint_));
 		    dp = (dpl == NULL) ? node->taps : dpl->next;
 		}
 		else {
@@ -1253,7 +1275,7 @@ void create_obstructions_inside_nodes(void)
     GATE g;
     DSEG ds;
     DPOINT tpoint;
-    u_int dir, mask, k;
+    obsword dir, mask, k;
     int i, gridx, gridy;
     double dx, dy, xdist, vwx, vwy;
     u_char o0okay, o2okay, duplicate;
@@ -1294,12 +1316,12 @@ void create_obstructions_inside_nodes(void)
 			 // Area inside defined pin geometry
 
 			 if (dy > ds->y1 && gridy >= 0) {
-			     int orignet = OBSVAL(gridx, gridy, ds->layer);
+			     obsword orignet = OBSVAL(gridx, gridy, ds->layer);
 
 			     duplicate = FALSE;
 			     lnode = NULL;
 			     if ((orignet & ROUTED_NET_MASK & ~ROUTED_NET)
-					== (u_int)node->netnum) {
+					== (obsword)node->netnum) {
 
 				// Duplicate tap point, or pre-existing route.
 				// Re-process carefully.  Check for alternate
@@ -1312,7 +1334,7 @@ void create_obstructions_inside_nodes(void)
 			     }
 
 			     else if (!(orignet & NO_NET) &&
-					((orignet & ROUTED_NET_MASK) != (u_int)0)) {
+					((orignet & ROUTED_NET_MASK) != (obsword)0)) {
 
 				// Net was assigned to other net, but is inside
 				// this pin's geometry.  Declare point to be
@@ -1417,7 +1439,7 @@ void create_obstructions_inside_nodes(void)
 				if (!duplicate) {
 			           OBSVAL(gridx, gridy, ds->layer)
 			        	= (OBSVAL(gridx, gridy, ds->layer)
-					   & BLOCKED_MASK) | (u_int)node->netnum | mask;
+					   & BLOCKED_MASK) | (obsword)node->netnum | mask;
 				   if (!lnode)
 				      lnode = SetNodeinfo(gridx, gridy, ds->layer,
 						node);
@@ -1467,7 +1489,7 @@ void create_obstructions_inside_nodes(void)
 			     if ((!duplicate) && (ds->layer < Num_layers - 1)) {
 			        k = OBSVAL(gridx, gridy, ds->layer + 1);
 			        if (k & PINOBSTRUCTMASK) {
-			           if ((k & ROUTED_NET_MASK) != (u_int)node->netnum) {
+			           if ((k & ROUTED_NET_MASK) != (obsword)node->netnum) {
 				       OBSVAL(gridx, gridy, ds->layer + 1) = NO_NET;
 				       FreeNodeinfo(gridx, gridy, ds->layer + 1);
 				   }
@@ -1518,7 +1540,7 @@ void create_obstructions_outside_nodes(void)
     GATE g;
     DSEG ds;
     DPOINT tpoint;
-    u_int dir, mask, k;
+    obsword dir, mask, k;
     int i, gridx, gridy, orient;
     double dx, dy, xdist, deltax, deltay;
     float dist;
@@ -1594,9 +1616,9 @@ void create_obstructions_outside_nodes(void)
 
 			 if ((dy >= ds->y1 && gridy >= 0) && (dx >= ds->x1)
 					&& (dy <= ds->y2) && (dx <= ds->x2)) {
-			     int orignet = OBSVAL(gridx, gridy, ds->layer);
+			     obsword orignet = OBSVAL(gridx, gridy, ds->layer);
 
-			     if ((orignet & ROUTED_NET_MASK) == (u_int)node->netnum) {
+			     if ((orignet & ROUTED_NET_MASK) == (obsword)node->netnum) {
 
 				// Duplicate tap point.   Don't re-process it.
 				gridy++;
@@ -1604,7 +1626,7 @@ void create_obstructions_outside_nodes(void)
 			     }
 
 			     if (!(orignet & NO_NET) &&
-					((orignet & ROUTED_NET_MASK) != (u_int)0)) {
+					((orignet & ROUTED_NET_MASK) != (obsword)0)) {
 				/* Do nothing;  previously handled */
 			     }
 
@@ -1653,7 +1675,7 @@ void create_obstructions_outside_nodes(void)
 				lnode->nodesav = node;
 			        OBSVAL(gridx, gridy, ds->layer)
 			        	= (OBSVAL(gridx, gridy, ds->layer)
-					   & BLOCKED_MASK) | (u_int)node->netnum;
+					   & BLOCKED_MASK) | (obsword)node->netnum;
 
 			        offdptr = &(OBSINFO(gridx, gridy, ds->layer));
 			        offdx = offdptr->xoffset;
@@ -1866,7 +1888,7 @@ void create_obstructions_outside_nodes(void)
 			    dir = NI_STUB_NS | NI_STUB_EW;
 			    dist = 0.0;
 
-			    if (((k & ROUTED_NET_MASK) != (u_int)node->netnum)
+			    if (((k & ROUTED_NET_MASK) != (obsword)node->netnum)
 					&& (n2 == NULL)) {
 
 				if ((k & OBSTRUCT_MASK) != 0) {
@@ -2200,7 +2222,7 @@ void create_obstructions_outside_nodes(void)
 				if ((k < Numnets) && (dir != NI_STUB_MASK)) {
 				   OBSVAL(gridx, gridy, ds->layer)
 				   	= (OBSVAL(gridx, gridy, ds->layer)
-					  & BLOCKED_MASK) | (u_int)g->netnum[i] | mask; 
+					  & BLOCKED_MASK) | (obsword)g->netnum[i] | mask; 
 				   lnode->flags |= dir;
 				}
 				else if ((OBSVAL(gridx, gridy, ds->layer)
@@ -2239,9 +2261,9 @@ void create_obstructions_outside_nodes(void)
 
 			       // Position fails euclidean distance check
 
-			       int othernet = (k & ROUTED_NET_MASK);
+			       obsword othernet = (k & ROUTED_NET_MASK);
 
-			       if (othernet != 0 && othernet != (u_int)node->netnum) {
+			       if (othernet != 0 && othernet != (obsword)node->netnum) {
 
 			          // This location is too close to two different
 				  // node terminals and should not be used
@@ -2290,7 +2312,7 @@ void create_obstructions_outside_nodes(void)
 					!= NULL && (lnode->nodesav != NULL)) {
 
 				     u_char no_offsets = TRUE;
-				     int offset_net;
+				     obsword offset_net;
 
 				     // By how much would a tap need to be moved
 				     // to clear the obstructing geometry?
@@ -2478,7 +2500,7 @@ void create_obstructions_outside_nodes(void)
 
 			       if ((ds->layer > 0) && (n2 != NULL) && (n2->netnum
 					!= node->netnum) && ((othernet == 0) ||
-					(othernet == (u_int)node->netnum))) {
+					(othernet == (obsword)node->netnum))) {
 
 				  lnode = NODEIPTR(gridx, gridy, ds->layer);
 				  xdist = 0.5 * LefGetXYViaWidth(ds->layer, ds->layer,
@@ -2592,7 +2614,8 @@ void tap_to_tap_interactions(void)
     DPOINT tpoint;
     struct dseg_ de;
     int mingridx, mingridy, maxgridx, maxgridy;
-    int i, gridx, gridy, net, orignet;
+    int i, gridx, gridy, net;
+    obsword orignet;
     double dx, dy;
     float dist;
 
@@ -2801,7 +2824,7 @@ make_routable(NODE node)
 			 // Area inside defined pin geometry
 
 			 if (dy > ds->y1 && gridy >= 0) {
-			    int orignet = OBSVAL(gridx, gridy, ds->layer);
+			    obsword orignet = OBSVAL(gridx, gridy, ds->layer);
 
 			    if (orignet & NO_NET) {
 				OBSVAL(gridx, gridy, ds->layer) = g->netnum[i];
@@ -2844,7 +2867,8 @@ void adjust_stub_lengths(void)
     GATE g;
     DSEG ds, ds2;
     struct dseg_ dt, de;
-    int i, gridx, gridy, orignet, o;
+    int i, gridx, gridy, o;
+    obsword orignet;
     double dx, dy, wx, wy, s;
     float dist;
     u_char errbox;
@@ -3336,7 +3360,8 @@ void adjust_stub_lengths(void)
 void
 block_route(int x, int y, int lay, u_char dir)
 {
-   int bx, by, bl, ob;
+   int bx, by, bl;
+   obsword ob;
 
    bx = x;
    by = y;
@@ -11,6 +11,7 @@
 #define ANTENNA_NET	 3
 #define MIN_NET_NUMBER   4
 
+GATE FindGateNode(NODE node, int *ridx);
 void find_bounding_box(NET net);
 void defineRouteTree(NET);
 DPOINT is_testpoint(int, int, GATE, int, DSEG);
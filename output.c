@@ -12,7 +12,15 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
 #include <unistd.h>
+#include <sys/stat.h>
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 #ifdef TCL_QROUTER
 #include <tk.h>
@@ -21,6 +29,7 @@
 #include "qrouter.h"
 #include "qconfig.h"
 #include "point.h"
+#include "pool.h"
 #include "node.h"
 #include "maze.h"
 #include "mask.h"
@@ -28,16 +37,323 @@
 #include "lef.h"
 #include "def.h"
 #include "graphics.h"
+#include "zfile.h"
+
+/* The state of the path being written.  Route text may be	*/
+/* formatted on several threads at once, so each thread has	*/
+/* its own.							*/
+
+#ifdef HAVE_PTHREAD_H
+#define OUTPUT_THREAD_LOCAL __thread
+#else
+#define OUTPUT_THREAD_LOCAL
+#endif
 
-int  Pathon = -1;
+static OUTPUT_THREAD_LOCAL int Pathon = -1;
 
-struct _savepath {
+static OUTPUT_THREAD_LOCAL struct _savepath {
     u_char active;
     int x;
     int y;
     int orient;
 } path_delayed;
 
+/*--------------------------------------------------------------*/
+/* Output buffers.  The route text of each net is formatted	*/
+/* into a buffer of its own (see emit_net_batch()), and the	*/
+/* buffers are written to the output in netlist order.  The	*/
+/* output file is itself written through a buffer that is	*/
+/* passed to write() in large blocks (or to fwrite(), if the	*/
+/* output is a compressed stream with no file descriptor).  Text copied unchanged	*/
+/* from the input DEF file is kept as a span of the input, and	*/
+/* long spans are written directly from the file mapping.	*/
+/*								*/
+/* Messages raised while formatting a net are held with the	*/
+/* net's text and printed when it is written, so that they	*/
+/* come out in order and only from the main thread.		*/
+/*--------------------------------------------------------------*/
+
+#define ROUTEBUF_BLOCK	(1 << 20)	/* Size of a write() to the output */
+
+typedef struct routebuf_ *ROUTEBUF;
+
+struct routebuf_ {
+    char    *text;	/* Buffered text */
+    long     len;	/* Length of buffered text */
+    long     size;	/* Allocated size of text */
+    FILE    *out;	/* Output file, or NULL if only buffered */
+    int      fd;	/* Descriptor of out, or -1 to use fwrite() */
+    u_char   failed;	/* Set if a write to out failed */
+    long long written;	/* Bytes passed to out, or -1 if not known */
+    char    *span;	/* Input text waiting to be written, or NULL */
+    long     spanlen;	/* Length of input text waiting */
+    ROUTEBUF msgs;	/* Messages held for printing, or NULL */
+    NODEINFO *marks;	/* Nodes to flag when the net is written */
+    u_char  *markflags;	/* Flag to set on each node in marks[] */
+    int      nmarks;	/* Number of entries in marks[] */
+    int      markalloc;	/* Allocated size of marks[] */
+};
+
+static void
+rb_init(ROUTEBUF rb, FILE *out)
+{
+    rb->text = NULL;
+    rb->len = rb->size = 0;
+    rb->out = out;
+    rb->fd = (out != NULL) ? fileno(out) : -1;
+    rb->failed = FALSE;
+    rb->written = 0;
+    rb->span = NULL;
+    rb->spanlen = 0;
+    rb->msgs = NULL;
+    rb->marks = NULL;
+    rb->markflags = NULL;
+    rb->nmarks = rb->markalloc = 0;
+}
+
+static void
+rb_free(ROUTEBUF rb)
+{
+    if (rb->msgs != NULL) {
+	rb_free(rb->msgs);
+	free(rb->msgs);
+    }
+    free(rb->text);
+    free(rb->marks);
+    free(rb->markflags);
+    rb_init(rb, NULL);
+}
+
+/* Write "n" bytes to the output file, retrying short writes */
+
+static void
+rb_write_fd(ROUTEBUF rb, char *data, long n)
+{
+    ssize_t w;
+
+    if (rb->written >= 0) rb->written += n;
+    if (rb->fd < 0) {
+	if ((n > 0) && !rb->failed &&
+		(fwrite(data, 1, (size_t)n, rb->out) != (size_t)n))
+	    rb->failed = TRUE;
+	return;
+    }
+    while ((n > 0) && !rb->failed) {
+	w = write(rb->fd, data, (size_t)n);
+	if (w < 0) {
+	    if (errno == EINTR) continue;
+	    rb->failed = TRUE;
+	    break;
+	}
+	data += w;
+	n -= w;
+    }
+}
+
+/* Append to the buffer without regard to any waiting span */
+
+static void
+rb_append(ROUTEBUF rb, char *data, long n)
+{
+    if ((rb->out != NULL) && (rb->len + n > ROUTEBUF_BLOCK)) {
+	rb_write_fd(rb, rb->text, rb->len);
+	rb->len = 0;
+	if (n >= ROUTEBUF_BLOCK) {
+	    rb_write_fd(rb, data, n);
+	    return;
+	}
+    }
+    if (rb->len + n > rb->size) {
+	rb->size = (rb->size == 0) ? 256 : rb->size * 2;
+	if (rb->out != NULL && rb->size < ROUTEBUF_BLOCK) rb->size = ROUTEBUF_BLOCK;
+	while (rb->len + n > rb->size) rb->size *= 2;
+	rb->text = (char *)realloc(rb->text, rb->size);
+    }
+    memcpy(rb->text + rb->len, data, n);
+    rb->len += n;
+}
+
+/* Move any waiting span of input text into the output */
+
+static void
+rb_flush_span(ROUTEBUF rb)
+{
+    char *span = rb->span;
+    long n = rb->spanlen;
+
+    if (span == NULL) return;
+    rb->span = NULL;
+    rb->spanlen = 0;
+
+    if ((rb->out != NULL) && (n >= ROUTEBUF_BLOCK / 16)) {
+	rb_write_fd(rb, rb->text, rb->len);
+	rb->len = 0;
+	rb_write_fd(rb, span, n);
+    }
+    else
+	rb_append(rb, span, n);
+}
+
+/* Write everything buffered to the output file */
+
+static void
+rb_drain(ROUTEBUF rb)
+{
+    rb_flush_span(rb);
+    if (rb->out != NULL) {
+	rb_write_fd(rb, rb->text, rb->len);
+	rb->len = 0;
+    }
+}
+
+static void
+rb_puts(ROUTEBUF rb, char *str)
+{
+    rb_flush_span(rb);
+    rb_append(rb, str, (long)strlen(str));
+}
+
+static void
+rb_putn(ROUTEBUF rb, char *data, long n)
+{
+    rb_flush_span(rb);
+    rb_append(rb, data, n);
+}
+
+/* Add input text that stays valid until the output is drained.	*/
+/* Adjacent pieces of input are merged into a single span.	*/
+
+static void
+rb_copy(ROUTEBUF rb, char *data, long n)
+{
+    if ((rb->span != NULL) && (rb->span + rb->spanlen == data)) {
+	rb->spanlen += n;
+	return;
+    }
+    rb_flush_span(rb);
+    if (rb->out == NULL)
+	rb_append(rb, data, n);
+    else {
+	rb->span = data;
+	rb->spanlen = n;
+    }
+}
+
+/* Position in the output file of the next text added */
+
+static long long
+rb_position(ROUTEBUF rb)
+{
+    if (rb->written < 0) return -1;
+    return rb->written + rb->len + rb->spanlen;
+}
+
+/* Format a long integer and a space, in place of "%ld " */
+
+static void
+rb_putlong(ROUTEBUF rb, long value)
+{
+    char digits[24], *dptr = digits + sizeof(digits);
+    unsigned long u;
+
+    *--dptr = ' ';
+    u = (value < 0) ? -(unsigned long)value : (unsigned long)value;
+    do {
+	*--dptr = '0' + (char)(u % 10);
+	u /= 10;
+    } while (u > 0);
+    if (value < 0) *--dptr = '-';
+
+    rb_putn(rb, dptr, (long)(digits + sizeof(digits) - dptr));
+}
+
+/* Format a point in DEF syntax, "( x y ) " */
+
+static void
+rb_putpoint(ROUTEBUF rb, long x, long y)
+{
+    rb_putn(rb, "( ", 2);
+    rb_putlong(rb, x);
+    rb_putlong(rb, y);
+    rb_putn(rb, ") ", 2);
+}
+
+/* Hold a message to be printed when the buffer is written */
+
+static void
+rb_message(ROUTEBUF rb, FILE *f, char *fmt, ...)
+{
+    va_list args;
+    char msg[512];
+
+    va_start(args, fmt);
+    vsnprintf(msg + 1, sizeof(msg) - 1, fmt, args);
+    va_end(args);
+    msg[0] = (f == stderr) ? 2 : 1;
+
+    if (rb->msgs == NULL) {
+	rb->msgs = (ROUTEBUF)malloc(sizeof(struct routebuf_));
+	rb_init(rb->msgs, NULL);
+    }
+    rb_append(rb->msgs, msg, (long)strlen(msg) + 1);
+}
+
+/* Print and discard the messages held in a buffer */
+
+static void
+rb_print_messages(ROUTEBUF rb)
+{
+    char *mptr;
+
+    if ((rb->msgs == NULL) || (rb->msgs->len == 0)) return;
+
+    for (mptr = rb->msgs->text; mptr < rb->msgs->text + rb->msgs->len;
+		mptr += strlen(mptr) + 1) {
+	if (*mptr == 2) {
+	    Flush(stdout);
+	    Fprintf(stderr, "%s", mptr + 1);
+	}
+	else
+	    Fprintf(stdout, "%s", mptr + 1);
+    }
+    rb->msgs->len = 0;
+}
+
+/* Set a flag on a node record when the buffer is written.  The	*/
+/* via direction flags are set this way, so that nets formatted	*/
+/* at the same time do not write to the node records.		*/
+
+static void
+rb_mark_node(ROUTEBUF rb, NODEINFO lnode, u_char flag)
+{
+    if (rb->nmarks == rb->markalloc) {
+	rb->markalloc = (rb->markalloc == 0) ? 16 : rb->markalloc * 2;
+	rb->marks = (NODEINFO *)realloc(rb->marks,
+		rb->markalloc * sizeof(NODEINFO));
+	rb->markflags = (u_char *)realloc(rb->markflags,
+		rb->markalloc * sizeof(u_char));
+    }
+    rb->marks[rb->nmarks] = lnode;
+    rb->markflags[rb->nmarks] = flag;
+    rb->nmarks++;
+}
+
+/* Write a net buffer, and its messages, to the output */
+
+static void
+rb_output(ROUTEBUF out, ROUTEBUF rb)
+{
+    int i;
+
+    for (i = 0; i < rb->nmarks; i++)
+	rb->marks[i]->flags |= rb->markflags[i];
+    rb->nmarks = 0;
+
+    rb_print_messages(rb);
+    rb_putn(out, rb->text, rb->len);
+    rb->len = 0;
+}
+
 /*--------------------------------------------------------------*/
 /* Output a list of failed nets.				*/
 /*--------------------------------------------------------------*/
@@ -75,13 +391,13 @@ int write_failed(char *filename)
 /* Write the output annotated DEF file.				*/
 /*--------------------------------------------------------------*/
 
-int write_def(char *filename)
+static int write_def_file(char *filename, u_char incremental)
 {
    NET net;
    NETLIST nl;
 
    emit_routes((filename == NULL) ? DEFfilename : filename,
-		Scales.oscale, Scales.iscale);
+		Scales.oscale, Scales.iscale, incremental);
 
    Fprintf(stdout, "----------------------------------------------\n");
    Fprintf(stdout, "Final: ");
@@ -105,7 +421,23 @@ int write_def(char *filename)
 
    return 0;
 
-} /* write_def() */
+} /* write_def_file() */
+
+int write_def(char *filename)
+{
+   return write_def_file(filename, (u_char)0);
+}
+
+/*--------------------------------------------------------------*/
+/* Write the output annotated DEF file, copying the routes of	*/
+/* nets that have not changed since the file was last written	*/
+/* from that file.						*/
+/*--------------------------------------------------------------*/
+
+int write_def_incremental(char *filename)
+{
+   return write_def_file(filename, (u_char)1);
+}
 
 /*--------------------------------------------------------------*/
 /* pathstart - begin a DEF format route path           		*/
@@ -116,20 +448,20 @@ int write_def(char *filename)
 /*--------------------------------------------------------------*/
 
 static void
-pathstart(FILE *cmd, int layer, int x, int y, u_char special, double oscale,
+pathstart(ROUTEBUF cmd, int layer, int x, int y, u_char special, double oscale,
           double invscale, u_char horizontal, NODEINFO node)
 {
    if (Pathon == 1) {
-      Fprintf( stderr, "pathstart():  Major error.  Started a new "
+      rb_message(cmd, stderr, "pathstart():  Major error.  Started a new "
 		"path while one is in progress!\n"
 		"Doing it anyway.\n" );
    }
 
    if (layer >= 0) {
       if (Pathon == -1)
-	 fprintf(cmd, "+ ROUTED ");
+	 rb_puts(cmd, "+ ROUTED ");
       else
-	 fprintf(cmd, "\n  NEW ");
+	 rb_puts(cmd, "\n  NEW ");
       if (special) {
 	 double wvia;
 	 int vtype = 0;		/* Need to get via type from node record! */
@@ -154,13 +486,16 @@ pathstart(FILE *cmd, int layer, int x, int y, u_char special, double oscale,
 	    if (wvia2 > wvia) wvia = wvia2;
          }
 
-         fprintf(cmd, "%s %ld ( %ld %ld ) ", CIFLayer[layer],
-			(long)(0.5 + invscale * oscale * wvia),
-			(long)(0.5 + invscale * x), (long)(0.5 + invscale * y));
+         rb_puts(cmd, CIFLayer[layer]);
+         rb_puts(cmd, " ");
+         rb_putlong(cmd, (long)(0.5 + invscale * oscale * wvia));
+         rb_putpoint(cmd, (long)(0.5 + invscale * x), (long)(0.5 + invscale * y));
+      }
+      else {
+         rb_puts(cmd, CIFLayer[layer]);
+         rb_puts(cmd, " ");
+         rb_putpoint(cmd, (long)(0.5 + invscale * x), (long)(0.5 + invscale * y));
       }
-      else
-         fprintf(cmd, "%s ( %ld %ld ) ", CIFLayer[layer],
-			(long)(0.5 + invscale * x), (long)(0.5 + invscale * y));
    }
    Pathon = 1;
 
@@ -175,11 +510,11 @@ pathstart(FILE *cmd, int layer, int x, int y, u_char special, double oscale,
 /*--------------------------------------------------------------*/
 
 static void
-pathto(FILE *cmd, int x, int y, int horizontal, int lastx, int lasty,
+pathto(ROUTEBUF cmd, int x, int y, int horizontal, int lastx, int lasty,
        double invscale, u_char nextvia)
 {
     if (Pathon <= 0) {
-	Fprintf(stderr, "pathto():  Major error.  Added to a "
+	rb_message(cmd, stderr, "pathto():  Major error.  Added to a "
 		"non-existent path!\n"
 		"Doing it anyway.\n");
     }
@@ -206,18 +541,18 @@ pathto(FILE *cmd, int x, int y, int horizontal, int lastx, int lasty,
 	return;
     }
 
-    fprintf(cmd, "( ");
+    rb_puts(cmd, "( ");
     if (horizontal)
-	fprintf(cmd, "%ld ", (long)(0.5 + invscale * x));
+	rb_putlong(cmd, (long)(0.5 + invscale * x));
     else
-	fprintf(cmd, "* ");
+	rb_puts(cmd, "* ");
 
     if (horizontal)
-	fprintf(cmd, "* ");
+	rb_puts(cmd, "* ");
     else
-	fprintf(cmd, "%ld ", (long)(0.5 + invscale * y));
+	rb_putlong(cmd, (long)(0.5 + invscale * y));
 
-    fprintf(cmd, ") ");
+    rb_puts(cmd, ") ");
 
 } /* pathto() */
 
@@ -230,7 +565,7 @@ pathto(FILE *cmd, int x, int y, int horizontal, int lastx, int lasty,
 /*--------------------------------------------------------------*/
 
 static void
-pathvia(FILE *cmd, int layer, int x, int y, int lastx, int lasty,
+pathvia(ROUTEBUF cmd, int layer, int x, int y, int lastx, int lasty,
 	char *vianame, double invscale)
 {
     if (path_delayed.active == 1) {
@@ -242,11 +577,12 @@ pathvia(FILE *cmd, int layer, int x, int y, int lastx, int lasty,
 
     if (Pathon <= 0) {
        if (Pathon == -1)
-	  fprintf(cmd, "+ ROUTED ");
+	  rb_puts(cmd, "+ ROUTED ");
        else 
-	  fprintf(cmd, "\n  NEW ");
-       fprintf(cmd, "%s ( %ld %ld ) ", CIFLayer[layer],
-		(long)(0.5 + invscale * x), (long)(0.5 + invscale * y));
+	  rb_puts(cmd, "\n  NEW ");
+       rb_puts(cmd, CIFLayer[layer]);
+       rb_puts(cmd, " ");
+       rb_putpoint(cmd, (long)(0.5 + invscale * x), (long)(0.5 + invscale * y));
     }
     else {
        // Normally the path will be manhattan and only one of
@@ -260,7 +596,8 @@ pathvia(FILE *cmd, int layer, int x, int y, int lastx, int lasty,
        if (y != lasty)
 	  pathto(cmd, x, y, FALSE, x, lasty, invscale, 0);
     }
-    fprintf(cmd, "%s ", vianame);
+    rb_puts(cmd, vianame);
+    rb_puts(cmd, " ");
     Pathon = 0;
 
 } /* pathvia() */
@@ -618,8 +955,9 @@ void print_nlnets( char *filename )
 void
 print_grid_information(int gridx, int gridy, int layer)
 {
-    u_int obsval;
-    int i, apos;
+    obsword obsval;
+    int i;
+    gindex apos;
     double dx, dy;
     int netidx;
     NET net;
@@ -757,7 +1095,7 @@ print_grid_information(int gridx, int gridy, int layer)
 		" DRC violations.\n");
     }
     if (((obsval & ROUTED_NET_MASK) != 0) && ((obsval & NO_NET) == 0)) {
-	netidx = obsval & NETNUM_MASK;
+	netidx = (int)(obsval & NETNUM_MASK);
 	for (i = 0; i < Numnets; i++) {
 	    net = Nlnets[i];
 	    if (net->netnum == netidx) break;
@@ -805,7 +1143,8 @@ print_instance_information(char *instname)
 void
 print_node_information(char *nodename)
 {
-    int i, j, k, l, apos;
+    int i, j, k, l;
+    gindex apos;
     NET net;
     NODE node;
     NODEINFO lnode;
@@ -1056,7 +1395,7 @@ void cleanup_net(NET net)
 			   // avoid notch DRC errors.
 
 			   SEG newseg;
-			   newseg = (SEG)malloc(sizeof(struct seg_));
+			   newseg = allocSEG();
 			   rt->segments = newseg;
 			   newseg->next = segf;
 			   newseg->layer = lf;
@@ -1086,7 +1425,7 @@ void cleanup_net(NET net)
 			   // avoid notch DRC errors.
 
 			   SEG newseg;
-			   newseg = (SEG)malloc(sizeof(struct seg_));
+			   newseg = allocSEG();
 			   rt->segments = newseg;
 			   newseg->next = segf;
 			   newseg->layer = lf;
@@ -1122,7 +1461,7 @@ void cleanup_net(NET net)
 			   // avoid notch DRC errors.
 
 			   SEG newseg;
-			   newseg = (SEG)malloc(sizeof(struct seg_));
+			   newseg = allocSEG();
 			   segl->next = newseg;
 			   newseg->next = NULL;
 			   newseg->layer = ll;
@@ -1153,7 +1492,7 @@ void cleanup_net(NET net)
 			   // avoid notch DRC errors.
 
 			   SEG newseg;
-			   newseg = (SEG)malloc(sizeof(struct seg_));
+			   newseg = allocSEG();
 			   segl->next = newseg;
 			   newseg->next = NULL;
 			   newseg->layer = ll;
@@ -1190,7 +1529,8 @@ void cleanup_net(NET net)
       /* Check for this case and resolve if needed.			*/
 
       if ((fcheck == FALSE) && (lcheck == FALSE)) {
-	 int wlen, oval0, oval1, oval2;
+	 int wlen;
+	 obsword oval0, oval1, oval2;
 
 	 segf = rt->segments;
 	 if ((segf == NULL) || (segf->next == NULL)) continue;
@@ -1212,7 +1552,7 @@ void cleanup_net(NET net)
 			viabase = segf->layer;
 			segf->layer = (viabase == seg->layer) ? seg->layer + 1 :
 				seg->layer;
-			if (!link_up_seg(net, seg, viabase, rt)) free(seg);
+			if (!link_up_seg(net, seg, viabase, rt)) freeSEG(seg);
 		    }
 		}
 	    }
@@ -1232,7 +1572,7 @@ void cleanup_net(NET net)
 			viabase = segf->layer;
 			segf->layer = (viabase == seg->layer) ? seg->layer + 1 :
 				seg->layer;
-			if (!link_up_seg(net, seg, viabase, rt)) free(seg);
+			if (!link_up_seg(net, seg, viabase, rt)) freeSEG(seg);
 		    }
 		}
 	    }
@@ -1262,7 +1602,7 @@ void cleanup_net(NET net)
 			seg->y1 = segl->y1;
 			seg->x2 = segl->x2;
 			seg->y2 = segl->y2;
-			if (!link_up_seg(net, segl, viabase, rt)) free(segl);
+			if (!link_up_seg(net, segl, viabase, rt)) freeSEG(segl);
 		    }
 		}
 	    }
@@ -1285,16 +1625,18 @@ void cleanup_net(NET net)
 			seg->y1 = segl->y1;
 			seg->x2 = segl->x2;
 			seg->y2 = segl->y2;
-			if (!link_up_seg(net, segl, viabase, rt)) free(segl);
+			if (!link_up_seg(net, segl, viabase, rt)) freeSEG(segl);
 		    }
 		}
 	    }
 	 }
       }
    }
-   if (needfix == TRUE)
+   if (needfix == TRUE) {
+      net->flags |= NET_DIRTY | NET_RC_DIRTY;
       for (rt = net->routes; rt; rt = rt->next)
 	 route_set_connections(net, rt);
+   }
 }
 
 /*--------------------------------------------------------------*/
@@ -1314,12 +1656,12 @@ void cleanup_net(NET net)
 /*--------------------------------------------------------------*/
 
 static void
-emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
+emit_routed_net(ROUTEBUF Cmd, NET net, u_char special, double oscale, int iscale)
 {
    SEG seg, saveseg, lastseg, prevseg;
    NODEINFO lnode, lnode1, lnode2;
    ROUTE rt;
-   u_int dir1, dir2, tdir;
+   obsword dir1, dir2, tdir;
    int layer;
    int x = 0, y = 0, x2, y2;
    double dc;
@@ -1333,7 +1675,9 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
    /* in the SPECIALNETS section.					*/
 
    if ((special == (u_char)1) && (net->flags & NET_STUB)) {
-      fprintf(Cmd, ";\n- %s\n", net->netname);
+      rb_puts(Cmd, ";\n- ");
+      rb_puts(Cmd, net->netname);
+      rb_puts(Cmd, "\n");
    }
 
    Pathon = -1;
@@ -1367,7 +1711,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 	    stub = (lnode) ? lnode->stub : 0.0;
 	    if (OBSVAL(seg->x1, seg->y1, layer) & STUBROUTE) {
 	       if ((special == (u_char)0) && (Verbose > 2))
-		  Fprintf(stdout, "Stub route distance %g to terminal"
+		  rb_message(Cmd, stdout, "Stub route distance %g to terminal"
 				" at %d %d (%d)\n", stub,
 				seg->x1, seg->y1, layer);
 
@@ -1559,7 +1903,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 
 	       if (special == (u_char)0) {
 		  if ((seg->segtype & ST_VIA) && (Verbose > 2))
-		     Fprintf(stdout, "Offset terminal distance %g to grid"
+		     rb_message(Cmd, stdout, "Offset terminal distance %g to grid"
 					" at %d %d (%d)\n", offset1,
 					seg->x1, seg->y1, layer);
 	       }
@@ -1600,7 +1944,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 		  if ((seg->segtype & ST_VIA)
 					&& !(seg->segtype & ST_OFFSET_START))
 		     if (Verbose > 2)
-		        Fprintf(stdout, "Offset terminal distance %g to grid"
+		        rb_message(Cmd, stdout, "Offset terminal distance %g to grid"
 					" at %d %d (%d)\n", offset2,
 					seg->x2, seg->y2, layer);
 	       }
@@ -1651,8 +1995,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 			// tap offset and is corrected automatically by
 			// making an L-bend in the wire.
 
-		     	Flush(stdout);
-			Fprintf(stderr, "Warning:  non-Manhattan wire in route"
+			rb_message(Cmd, stderr, "Warning:  non-Manhattan wire in route"
 				" at (%d, %d) to (%d, %d)\n", x, y, x2, y2);
 		     }
 		     if (special == (u_char)0) {
@@ -1764,7 +2107,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 		     int vx = 0;
 		     int vy = 0;
 		     int flags;
-		     u_int tdirpp, tdirp, tdirn;
+		     obsword tdirpp, tdirp, tdirn;
 		     u_char viaNL, viaNM, viaNU;
 		     u_char viaSL, viaSM, viaSU;
 		     u_char viaEL, viaEM, viaEU;
@@ -1821,9 +2164,9 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 			    }
 			    /* Mark the node with which via direction was used */
 			    if ((s == ViaYY[layer]) || (s == ViaYX[layer]))
-				lnode->flags |= NI_VIA_Y;
+				rb_mark_node(Cmd, lnode, NI_VIA_Y);
 			    else
-				lnode->flags |= NI_VIA_X;
+				rb_mark_node(Cmd, lnode, NI_VIA_X);
 			}
 		     }
 
@@ -2639,7 +2982,7 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 	     if (dir2 & STUBROUTE) {
 	        stub = lnode->stub;
 		if ((special == (u_char)0) && (Verbose > 2))
-		   Fprintf(stdout, "Stub route distance %g to terminal"
+		   rb_message(Cmd, stdout, "Stub route distance %g to terminal"
 				" at %d %d (%d)\n",
 				stub, seg->x2, seg->y2, layer);
 
@@ -2790,6 +3133,347 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
    }
 }
 
+/*--------------------------------------------------------------*/
+/* The input DEF file, memory-mapped if possible, otherwise	*/
+/* read into memory.  Unchanged text is copied to the output	*/
+/* from here.  The previous output file is opened the same way	*/
+/* for an incremental write, and the route text of nets that	*/
+/* have not changed is copied from it.				*/
+/*--------------------------------------------------------------*/
+
+typedef struct {
+    char  *base;	/* Start of the file text */
+    char  *end;		/* End of the file text */
+    char  *pos;		/* Start of the next line */
+    size_t maplen;	/* Length of the mapping, or 0 if not mapped */
+} DefSource;
+
+/*--------------------------------------------------------------*/
+/* Formatting of net routes in parallel.  emit_routed_net()	*/
+/* changes only the flags of the net it is given and of that	*/
+/* net's routes and segments (the via direction flags of node	*/
+/* records are held in the buffer until it is written), so	*/
+/* different nets may be formatted at the same time on		*/
+/* different threads.  The text of each net goes to a buffer	*/
+/* of its own, and the buffers are written out in order	*/
+/* afterwards.							*/
+/*--------------------------------------------------------------*/
+
+#define EMIT_BATCH_SIZE	4096	/* Nets formatted between writes	*/
+#define EMIT_THREAD_MIN	64	/* Minimum nets per thread		*/
+
+typedef struct {
+    NET     *nets;
+    struct routebuf_ *bufs;
+    int      first;		/* First net for this thread	*/
+    int      last;		/* One past the last net	*/
+    u_char   special;
+    double   oscale;
+    int      iscale;
+    DefSource *reuse;		/* Previous output, or NULL	*/
+} EmitSlice;
+
+static void *
+emit_net_worker(void *arg)
+{
+    EmitSlice *slice = (EmitSlice *)arg;
+    int i;
+
+    for (i = slice->first; i < slice->last; i++) {
+	if ((slice->reuse != NULL) && !(slice->nets[i]->flags & NET_DIRTY))
+	    continue;
+	emit_routed_net(&slice->bufs[i], slice->nets[i], slice->special,
+		slice->oscale, slice->iscale);
+    }
+    return NULL;
+}
+
+/*--------------------------------------------------------------*/
+/* emit_net_batch --						*/
+/*								*/
+/* Format the routes of nets[0] to nets[n - 1] into bufs[0] to	*/
+/* bufs[n - 1], dividing the nets among up to thread_count()	*/
+/* threads.  If a thread cannot be started, its share is done	*/
+/* in the main thread.  If "reuse" is not NULL, nets without	*/
+/* NET_DIRTY set are not formatted.				*/
+/*--------------------------------------------------------------*/
+
+static void
+emit_net_batch(NET *nets, struct routebuf_ *bufs, int n, u_char special,
+		double oscale, int iscale, DefSource *reuse)
+{
+    EmitSlice one;
+#ifdef HAVE_PTHREAD_H
+    pthread_t *thread;
+    EmitSlice *slice;
+    u_char *started;
+    int t, nthreads;
+#endif
+
+    one.nets = nets;
+    one.bufs = bufs;
+    one.first = 0;
+    one.last = n;
+    one.special = special;
+    one.oscale = oscale;
+    one.iscale = iscale;
+    one.reuse = reuse;
+
+#ifdef HAVE_PTHREAD_H
+    nthreads = thread_count();
+    if (nthreads > n / EMIT_THREAD_MIN) nthreads = n / EMIT_THREAD_MIN;
+
+    if (nthreads > 1) {
+	/* The workers read the technology table, so make sure	*/
+	/* that it is up to date before they start.		*/
+	LefFindLayerByNum(0);
+
+	thread = (pthread_t *)malloc(nthreads * sizeof(pthread_t));
+	slice = (EmitSlice *)malloc(nthreads * sizeof(EmitSlice));
+	started = (u_char *)malloc(nthreads * sizeof(u_char));
+
+	for (t = 0; t < nthreads; t++) {
+	    slice[t] = one;
+	    slice[t].first = (int)(((long)n * t) / nthreads);
+	    slice[t].last = (int)(((long)n * (t + 1)) / nthreads);
+	    started[t] = (pthread_create(&thread[t], NULL, emit_net_worker,
+			(void *)&slice[t]) == 0);
+	}
+	for (t = 0; t < nthreads; t++)
+	    if (!started[t]) emit_net_worker((void *)&slice[t]);
+	for (t = 0; t < nthreads; t++)
+	    if (started[t]) pthread_join(thread[t], NULL);
+
+	free(started);
+	free(slice);
+	free(thread);
+	return;
+    }
+#endif
+    emit_net_worker((void *)&one);
+}
+
+/*--------------------------------------------------------------*/
+/* emit_write_batch --						*/
+/*								*/
+/* Format a batch of nets and write them to the output.  For	*/
+/* the NETS section, "pre" holds the text to write ahead of	*/
+/* each net's routes (pre[n] is the text after the last net),	*/
+/* and each net's routes are ended with a semicolon.  For the	*/
+/* SPECIALNETS section, "pre" is NULL.				*/
+/*								*/
+/* The position and length of each net's route text in the	*/
+/* output are saved in the net record.  If "reuse" is not NULL,	*/
+/* the text of nets without NET_DIRTY set is copied from the	*/
+/* saved position in "reuse" instead of being formatted again.	*/
+/*--------------------------------------------------------------*/
+
+static void
+emit_write_batch(ROUTEBUF out, NET *nets, struct routebuf_ *pre,
+		struct routebuf_ *bufs, int n, u_char special,
+		double oscale, int iscale, DefSource *reuse)
+{
+    NET net;
+    long long pos;
+    long len;
+    int i;
+
+    emit_net_batch(nets, bufs, n, special, oscale, iscale, reuse);
+
+    for (i = 0; i < n; i++) {
+	net = nets[i];
+	if (pre) rb_output(out, &pre[i]);
+	pos = rb_position(out);
+	if ((reuse != NULL) && !(net->flags & NET_DIRTY)) {
+	    len = net->deflen[special];
+	    if (len > 0) rb_copy(out, reuse->base + net->defpos[special], len);
+	}
+	else {
+	    len = bufs[i].len;
+	    rb_output(out, &bufs[i]);
+	}
+	net->defpos[special] = pos;
+	net->deflen[special] = len;
+	if (!special) rb_puts(out, ";\n");
+    }
+    if (pre) rb_output(out, &pre[n]);
+}
+
+static int
+emit_open_source(FILE *f, DefSource *src)
+{
+    size_t size = 0, alloc = 0, n;
+
+#ifdef HAVE_SYS_MMAN_H
+    struct stat st;
+    void *map;
+
+    if ((fstat(fileno(f), &st) == 0) && S_ISREG(st.st_mode) &&
+		(st.st_size > 0)) {
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+		fileno(f), 0);
+	if (map != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+	    madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+#endif
+	    src->base = src->pos = (char *)map;
+	    src->maplen = (size_t)st.st_size;
+	    src->end = src->base + src->maplen;
+	    return 0;
+	}
+    }
+#endif
+
+    src->base = NULL;
+    do {
+	if (size == alloc) {
+	    alloc = (alloc == 0) ? 65536 : alloc * 2;
+	    src->base = (char *)realloc(src->base, alloc);
+	}
+	n = fread(src->base + size, 1, alloc - size, f);
+	size += n;
+    } while (n > 0);
+
+    if (ferror(f)) {
+	free(src->base);
+	return -1;
+    }
+    src->pos = src->base;
+    src->end = src->base + size;
+    src->maplen = 0;
+    return 0;
+}
+
+static void
+emit_close_source(DefSource *src)
+{
+#ifdef HAVE_SYS_MMAN_H
+    if (src->maplen > 0) {
+	munmap((void *)src->base, src->maplen);
+	return;
+    }
+#endif
+    free(src->base);
+}
+
+/* Return the next line of the input and its length, including	*/
+/* the newline, in "len";  or NULL at the end of the file.  A	*/
+/* copy of the line, cut off at MAX_LINE_LEN, is put in "line"	*/
+/* for parsing.							*/
+
+static char *
+emit_next_line(DefSource *src, long *len, char *line)
+{
+    char *lstart = src->pos, *eol;
+    long n;
+
+    if (lstart >= src->end) return NULL;
+
+    eol = (char *)memchr(lstart, '\n', src->end - lstart);
+    src->pos = (eol) ? eol + 1 : src->end;
+    *len = (long)(src->pos - lstart);
+
+    n = (*len < MAX_LINE_LEN) ? *len : MAX_LINE_LEN;
+    memcpy(line, lstart, n);
+    line[n] = '\0';
+    return lstart;
+}
+
+/*--------------------------------------------------------------*/
+/* The output file last written by emit_routes(), recorded so	*/
+/* that an incremental write can tell whether the file is still	*/
+/* the one that the saved net positions refer to.		*/
+/*--------------------------------------------------------------*/
+
+static struct {
+    char     *name;	/* File name, or NULL if none recorded */
+    off_t     size;	/* File size, modification time, and	*/
+    time_t    mtime;	/* inode when it was written		*/
+    ino_t     ino;
+    long long length;	/* Length of the (uncompressed) text */
+    double    oscale;	/* Output scale the file was written with */
+    int       iscale;
+} LastDEFout = {NULL};
+
+static void
+emit_forget_output(void)
+{
+    free(LastDEFout.name);
+    LastDEFout.name = NULL;
+}
+
+/* Open the previous output file "filename" for copying route	*/
+/* text from.  Returns 0 on success, or -1 if there is no	*/
+/* usable previous output.					*/
+
+static int
+emit_open_previous(char *filename, double oscale, int iscale,
+		DefSource *prev)
+{
+    struct stat st;
+    FILE *f;
+    int result;
+
+    if ((LastDEFout.name == NULL) || strcmp(LastDEFout.name, filename) ||
+		(LastDEFout.oscale != oscale) || (LastDEFout.iscale != iscale))
+	return -1;
+    if ((stat(filename, &st) != 0) || (st.st_size != LastDEFout.size) ||
+		(st.st_mtime != LastDEFout.mtime) ||
+		(st.st_ino != LastDEFout.ino))
+	return -1;
+
+    f = zfile_open(filename, "r");
+    if (f == NULL) return -1;
+    result = emit_open_source(f, prev);
+    zfile_close(f);
+    if (result != 0) return -1;
+
+    if ((long long)(prev->end - prev->base) != LastDEFout.length) {
+	emit_close_source(prev);
+	return -1;
+    }
+    return 0;
+}
+
+/* Check that the saved route text of "net" lies within "prev" */
+
+static u_char
+emit_text_valid(DefSource *prev, NET net, int special)
+{
+    if ((net->defpos[special] < 0) || (net->deflen[special] < 0))
+	return FALSE;
+    return (net->defpos[special] + net->deflen[special] <=
+		(long long)(prev->end - prev->base)) ? TRUE : FALSE;
+}
+
+/* Write the generated vias to "out".  LefWriteGeneratedVias()	*/
+/* writes to a temporary file, which is then copied, so that	*/
+/* the text is counted in the output position.  Without a	*/
+/* temporary file, the vias are written to the output file	*/
+/* directly, and the output position is no longer known.	*/
+
+static void
+emit_generated_vias(ROUTEBUF out, double scale, int numvias)
+{
+    FILE *ftmp;
+    char buf[8192];
+    size_t n;
+
+    ftmp = tmpfile();
+    if (ftmp == NULL) {
+	rb_drain(out);
+	LefWriteGeneratedVias(out->out, scale, numvias);
+	fflush(out->out);
+	out->written = -1;
+	return;
+    }
+    LefWriteGeneratedVias(ftmp, scale, numvias);
+    rewind(ftmp);
+    while ((n = fread(buf, 1, sizeof(buf), ftmp)) > 0)
+	rb_putn(out, buf, (long)n);
+    fclose(ftmp);
+}
+
 /*--------------------------------------------------------------*/
 /* emit_routes - DEF file output from the list of routes	*/
 /*								*/
@@ -2797,33 +3481,47 @@ emit_routed_net(FILE *Cmd, NET net, u_char special, double oscale, int iscale)
 /*  <project>_route.def, where each net definition has the	*/
 /*  physical route appended.					*/
 /*								*/
+/*  If "incremental" is TRUE and the output file is the one	*/
+/*  written last, the route text of each net that has not	*/
+/*  changed since then (NET_DIRTY not set) is copied from that	*/
+/*  file, and only the other nets are formatted.  The new file	*/
+/*  is written under a temporary name and renamed when done.	*/
+/*								*/
 /*   ARGS: filename to list to					*/
 /*   RETURNS: nothing						*/
 /*   SIDE EFFECTS: 						*/
 /*   AUTHOR and DATE: steve beccue      Mon Aug 11 2003		*/
 /*--------------------------------------------------------------*/
 
-static void emit_routes(char *filename, double oscale, int iscale)
+static void emit_routes(char *filename, double oscale, int iscale,
+		u_char incremental)
 {
     FILE *Cmd;
-    int i, j, numnets, numvias, stubroutes;
+    int i, j, numnets, numvias, stubroutes, nbatch, numreused;
+    char *outname = NULL, *tmpname = NULL;
+    DefSource prev, *reuse = NULL;
+    struct stat st;
     char line[MAX_LINE_LEN + 1], *lptr = NULL;
+    char *lstart, *tail;
+    long llen, taillen;
     char netname[MAX_NAME_LEN];
     NET net = NULL;
-    NODE node;
+    NET *batch;
     ROUTE rt;
     FILE *fdef;
+    DefSource src;
+    struct routebuf_ out;
+    struct routebuf_ *pre, *bufs;
     u_char errcond = FALSE;
-    u_char need_cleanup = FALSE;
     u_char purge_routed = FALSE;
     u_char skip_net = FALSE;
 
-    fdef = fopen(DEFfilename, "r");
+    fdef = zfile_open(DEFfilename, "r");
     if ((fdef == NULL) && (DEFfilename != NULL)) {
 	if (strchr(DEFfilename, '.') == NULL) {
 	    char *extfilename = malloc(strlen(DEFfilename) + 5);
 	    sprintf(extfilename, "%s.def", DEFfilename);
-	    fdef = fopen(extfilename, "r");
+	    fdef = zfile_open(extfilename, "r");
 	    free(extfilename);
 	}
     }
@@ -2836,42 +3534,79 @@ static void emit_routes(char *filename, double oscale, int iscale)
 	Cmd = stdout;
     }
     else {
-	char *dotptr;
+	char *dotptr, *zsuffix;
 
 	if (filename == DEFfilename) {
-	    char *newDEFfile = (char *)malloc(strlen(filename) + 11);
-	    strcpy(newDEFfile, filename);
-	    dotptr = strrchr(newDEFfile, '.');
+	    // A compressed input file makes a compressed output
+	    // file:  "name.def.gz" is written as "name_route.def.gz".
+
+	    outname = (char *)malloc(strlen(filename) + 11);
+	    strcpy(outname, filename);
+	    zsuffix = zfile_suffix(outname);
+	    if (zsuffix) *zsuffix = '\0';
+	    dotptr = strrchr(outname, '.');
 	    if (dotptr)
 		strcpy(dotptr, "_route.def");
 	    else
-		strcat(newDEFfile, "_route.def");
-	    
-	    Cmd = fopen(newDEFfile, "w");
-	    free(newDEFfile);
+		strcat(outname, "_route.def");
+	    if (zsuffix) strcat(outname, zfile_suffix(filename));
 	}
 	else {
+	    outname = (char *)malloc(strlen(filename) + 11);
+	    strcpy(outname, filename);
 	    dotptr = strrchr(filename, '.');
-	    if (dotptr)
-	       Cmd = fopen(filename, "w");
-	    else {
-	       char *newDEFfile = (char *)malloc(strlen(filename) + 11);
-	       strcpy(newDEFfile, filename);
-	       strcat(newDEFfile, ".def");
-	       Cmd = fopen(newDEFfile, "w");
-	       free(newDEFfile);
+	    if (!dotptr)
+	       strcat(outname, ".def");
+	}
+
+	if (incremental) {
+	    if (emit_open_previous(outname, oscale, iscale, &prev) == 0) {
+		// Write to "name.qrtmp" (ahead of any compression
+		// suffix) while the previous file is being copied.
+
+		reuse = &prev;
+		tmpname = (char *)malloc(strlen(outname) + 7);
+		strcpy(tmpname, outname);
+		zsuffix = zfile_suffix(tmpname);
+		if (zsuffix) *zsuffix = '\0';
+		strcat(tmpname, ".qrtmp");
+		if (zsuffix) strcat(tmpname, zfile_suffix(outname));
 	    }
+	    else
+		Fprintf(stdout, "No previous output in %s to update;  "
+			"writing all nets.\n", outname);
 	}
+	Cmd = zfile_open((tmpname) ? tmpname : outname, "w");
     }
     if (!Cmd) {
 	Fprintf(stderr, "emit_routes():  Couldn't open output (routed) DEF file.\n");
+	zfile_close(fdef);
+	if (reuse) emit_close_source(reuse);
+	free(tmpname);
+	free(outname);
+	return;
+    }
+    if (emit_open_source(fdef, &src) != 0) {
+	Fprintf(stderr, "emit_routes():  Error reading DEF file.\n");
+	zfile_close(fdef);
+	if (Cmd != stdout) zfile_close(Cmd);
+	if (reuse) emit_close_source(reuse);
+	if (tmpname) unlink(tmpname);
+	free(tmpname);
+	free(outname);
 	return;
     }
 
+    // All output goes through "out" to the file descriptor of Cmd,
+    // which counts the position of each net's text in the file.
+
+    fflush(Cmd);
+    rb_init(&out, Cmd);
+
     // Copy DEF file up to NETS line
     numnets = 0;
     numvias = 0;
-    while (fgets(line, MAX_LINE_LEN, fdef) != NULL) {
+    while ((lstart = emit_next_line(&src, &llen, line)) != NULL) {
        lptr = line;
        while (isspace(*lptr)) lptr++;
        if (!strncmp(lptr, "NETS", 4)) {
@@ -2880,17 +3615,17 @@ static void emit_routes(char *filename, double oscale, int iscale)
        }
        if (!strncmp(lptr, "VIAS", 4)) {
 	   sscanf(lptr + 4, "%d", &numvias);
-	   LefWriteGeneratedVias(Cmd, (double)(oscale / (double)iscale), numvias);
+	   emit_generated_vias(&out, (double)(oscale / (double)iscale), numvias);
 	   continue;	/* VIAS line already written;  do not output. */
        }
        if (!strncmp(lptr, "PINS", 4) && (numvias == 0)) {
 	   /* Check if there are any generated vias, and write them	*/
 	   /* prior to the PINS section.				*/
-	   LefWriteGeneratedVias(Cmd, (double)(oscale / (double)iscale), 0);
+	   emit_generated_vias(&out, (double)(oscale / (double)iscale), 0);
        }
-       fputs(line, Cmd);
+       rb_copy(&out, lstart, llen);
     }
-    fputs(line, Cmd);	// Write the NETS line
+    if (lstart != NULL) rb_copy(&out, lstart, llen);	// Write the NETS line
 
     if ((numnets + numSpecial) != Numnets) {
       	Flush(stdout);
@@ -2900,22 +3635,64 @@ static void emit_routes(char *filename, double oscale, int iscale)
 			Numnets);
     }
 
+    // The route text of a net is copied from the previous output
+    // only if the net has not changed and its saved position lies
+    // within that file.  Every other net is formatted from the
+    // start, so its output flags are reset.
+
+    numreused = 0;
+    for (i = 0; i < Numnets; i++) {
+	net = Nlnets[i];
+	if ((reuse != NULL) && !(net->flags & (NET_DIRTY | NET_IGNORED)) &&
+		emit_text_valid(reuse, net, 0) &&
+		(!(net->flags & NET_STUB) || emit_text_valid(reuse, net, 1))) {
+	    numreused++;
+	    continue;
+	}
+	net->flags |= NET_DIRTY;
+	net->flags &= ~NET_STUB;
+	net->defpos[0] = net->defpos[1] = -1;
+	net->deflen[0] = net->deflen[1] = 0;
+	for (rt = net->routes; rt; rt = rt->next)
+	    rt->flags &= ~(RT_OUTPUT | RT_STUB);
+    }
+    if ((reuse != NULL) && (Verbose > 0))
+	Fprintf(stdout, "Copying route text of %d of %d nets from %s.\n",
+		numreused, Numnets, outname);
+
+    // Nets are collected in batches.  The text of the DEF file
+    // ahead of each net's routes is held in pre[] until the
+    // batch has been formatted.
+
+    batch = (NET *)malloc(EMIT_BATCH_SIZE * sizeof(NET));
+    pre = (struct routebuf_ *)malloc((EMIT_BATCH_SIZE + 1) *
+		sizeof(struct routebuf_));
+    bufs = (struct routebuf_ *)malloc(EMIT_BATCH_SIZE *
+		sizeof(struct routebuf_));
+    for (j = 0; j <= EMIT_BATCH_SIZE; j++) rb_init(&pre[j], NULL);
+    for (j = 0; j < EMIT_BATCH_SIZE; j++) rb_init(&bufs[j], NULL);
+    nbatch = 0;
+
     for (i = 0; i < numnets; i++) {
        char *instname, *pinname;
 
        if (errcond == TRUE) break;
        net = NULL;
-       while (fgets(line, MAX_LINE_LEN, fdef) != NULL) {
-	  if ((lptr = strchr(line, ';')) != NULL) {
-	     *lptr = '\n';
-	     *(lptr + 1) = '\0';
-#ifdef TCL_QROUTER
+       tail = NULL;
+       taillen = 0;
+       while ((lstart = emit_next_line(&src, &llen, line)) != NULL) {
+	  if ((lptr = (char *)memchr(lstart, ';', llen)) != NULL) {
+	     tail = lstart;
+	     taillen = (long)(lptr - lstart);
 	     net = DefFindNet(netname);
 	     while ((instname = get_annotate_info(net, &pinname)) != NULL) {
 		 /* Output antenna connections that were added to the net */
-		 fprintf(Cmd, "  ( %s %s )\n", instname, pinname);
+		 rb_puts(&pre[nbatch], "  ( ");
+		 rb_puts(&pre[nbatch], instname);
+		 rb_puts(&pre[nbatch], " ");
+		 rb_puts(&pre[nbatch], pinname);
+		 rb_puts(&pre[nbatch], " )\n");
 	     }
-#endif
 	     break;
 	  }
 	  else {
@@ -2925,74 +3702,80 @@ static void emit_routes(char *filename, double oscale, int iscale)
 		lptr++;
                 while (isspace(*lptr)) lptr++;
 	        sscanf(lptr, "%s", netname);
-		fputs(line, Cmd);
+		rb_copy(&pre[nbatch], lstart, llen);
 	     }
 	     else if (*lptr == '+') {
-#ifdef TCL_QROUTER
 		net = DefFindNet(netname);
 		while ((instname = get_annotate_info(net, &pinname)) != NULL) {
 		    /* Output antenna connections that were added to the net */
-		    fprintf(Cmd, "  ( %s %s )\n", instname, pinname);
+		    rb_puts(&pre[nbatch], "  ( ");
+		    rb_puts(&pre[nbatch], instname);
+		    rb_puts(&pre[nbatch], " ");
+		    rb_puts(&pre[nbatch], pinname);
+		    rb_puts(&pre[nbatch], " )\n");
 		}
-#endif
 		lptr++;
                 while (isspace(*lptr)) lptr++;
 		if (!strncmp(lptr, "ROUTED", 6)) {
 		   // This net is being handled by qrouter, so remove
 		   // the original routing information
-		   while (fgets(line, MAX_LINE_LEN, fdef) != NULL) {
-		      if ((lptr = strchr(line, ';')) != NULL) {
-			 // *lptr = '\n';
-			 // *(lptr + 1) = '\0';
-			 *line = '\0';
+		   while ((lstart = emit_next_line(&src, &llen, line)) != NULL)
+		      if (memchr(lstart, ';', llen) != NULL)
 			 break;
-		      }
-		   }
 		   break;
 		}
 		else
-		   fputs(line, Cmd);
+		   rb_copy(&pre[nbatch], lstart, llen);
 	     }
 	     else if (!strncmp(lptr, "END", 3)) {	// This should not happen
-		fputs(line, Cmd);
+		rb_copy(&pre[nbatch], lstart, llen);
 		errcond = TRUE;
 		break;
 	     }
 	     else
-		fputs(line, Cmd);
+		rb_copy(&pre[nbatch], lstart, llen);
 	  }
        }
+       if ((errcond == TRUE) || (lstart == NULL)) break;
 
        /* Find this net (if not done already) */
 
        if (!net) net = DefFindNet(netname);
        if (!net || (net->flags & NET_IGNORED)) {
 	  if (!net)
-	     Fprintf(stderr, "emit_routes():  Net %s cannot be found.\n",
-			netname);
+	     rb_message(&pre[nbatch], stderr,
+			"emit_routes():  Net %s cannot be found.\n", netname);
 
 	  /* Dump rest of net and continue */
-	  *(lptr) = ';';
-	  *(lptr + 1) = '\n';
-	  *(lptr + 2) = '\0';
-	  fputs(line, Cmd);
+	  if (tail != NULL) {
+	     rb_copy(&pre[nbatch], tail, taillen);
+	     rb_puts(&pre[nbatch], ";\n");
+	  }
 	  continue;
        }
        else {
 	  /* Add last net terminal, without the semicolon */
-	  fputs(line, Cmd);
-
-	  emit_routed_net(Cmd, net, (u_char)0, oscale, iscale);
-	  fprintf(Cmd, ";\n");
+	  if (tail != NULL) {
+	     rb_copy(&pre[nbatch], tail, taillen);
+	     rb_puts(&pre[nbatch], "\n");
+	  }
+	  batch[nbatch++] = net;
+	  if (nbatch == EMIT_BATCH_SIZE) {
+	     emit_write_batch(&out, batch, pre, bufs, nbatch, (u_char)0,
+			oscale, iscale, reuse);
+	     nbatch = 0;
+	  }
        }
     }
+    emit_write_batch(&out, batch, pre, bufs, nbatch, (u_char)0, oscale, iscale,
+		reuse);
 
     // Finish copying the rest of the NETS section
     if (errcond == FALSE) {
-       while (fgets(line, MAX_LINE_LEN, fdef) != NULL) {
+       while ((lstart = emit_next_line(&src, &llen, line)) != NULL) {
 	  lptr = line;
 	  while (isspace(*lptr)) lptr++;
-	  fputs(line, Cmd);
+	  rb_copy(&out, lstart, llen);
 	  if (!strncmp(lptr, "END", 3)) {
 	     break;
 	  }
@@ -3019,23 +3802,38 @@ static void emit_routes(char *filename, double oscale, int iscale)
     // proper width.
     if (stubroutes > 0) {
 
-        fprintf(Cmd, "\nSPECIALNETS %d ", stubroutes + numSpecial);
+	sprintf(line, "\nSPECIALNETS %d ", stubroutes + numSpecial);
+	rb_puts(&out, line);
+	nbatch = 0;
 	for (i = 0; i < Numnets; i++) {
 	     net = Nlnets[i];
 	     if (net->flags & NET_IGNORED) continue;
-	     emit_routed_net(Cmd, net, (u_char)1, oscale, iscale);
+	     batch[nbatch++] = net;
+	     if (nbatch == EMIT_BATCH_SIZE) {
+		emit_write_batch(&out, batch, NULL, bufs, nbatch, (u_char)1,
+			oscale, iscale, reuse);
+		nbatch = 0;
+	     }
 	}
+	emit_write_batch(&out, batch, NULL, bufs, nbatch, (u_char)1,
+			oscale, iscale, reuse);
 	if (numSpecial == 0)
-	    fprintf(Cmd, ";\nEND SPECIALNETS\n");
+	    rb_puts(&out, ";\nEND SPECIALNETS\n");
 	else
-	    fprintf(Cmd, ";\n");
+	    rb_puts(&out, ";\n");
     }    
 
+    for (j = 0; j <= EMIT_BATCH_SIZE; j++) rb_free(&pre[j]);
+    for (j = 0; j < EMIT_BATCH_SIZE; j++) rb_free(&bufs[j]);
+    free(pre);
+    free(bufs);
+    free(batch);
+
     // Finish copying the rest of the file.  Ignore ROUTED specialnets if
     // the nets are known nets and not power or ground nets.  FIXED or
     // COVER nets are output verbatim.
 
-    while (fgets(line, MAX_LINE_LEN, fdef) != NULL) {
+    while ((lstart = emit_next_line(&src, &llen, line)) != NULL) {
        lptr = line;
        while (isspace(*lptr)) lptr++;
        if (!strncmp(lptr, "SPECIALNETS", 11)) {
@@ -3045,10 +3843,8 @@ static void emit_routes(char *filename, double oscale, int iscale)
 	   }
        }
        if (!purge_routed)
-	  fputs(line, Cmd);
+	  rb_copy(&out, lstart, llen);
        else {
-          lptr = line;
-          while (isspace(*lptr)) lptr++;
 	  if (*lptr == '-') {
 	     lptr++;
              while (isspace(*lptr)) lptr++;
@@ -3063,14 +3859,64 @@ static void emit_routes(char *filename, double oscale, int iscale)
 	     else
 		skip_net = TRUE;
 	  }
-	  if (!skip_net) fputs(line, Cmd);
-	  else if ((lptr = strchr(line, ';')) != NULL) {
+	  if (!skip_net) rb_copy(&out, lstart, llen);
+	  else if (memchr(lstart, ';', llen) != NULL) {
 	      skip_net = FALSE;
 	  }
        }
     }
-    fclose(fdef);
-    fclose(Cmd);
+
+    rb_drain(&out);
+    if (out.failed) {
+	Fprintf(stderr, "emit_routes():  Error writing output DEF file.\n");
+	errcond = TRUE;
+    }
+
+    emit_close_source(&src);
+    zfile_close(fdef);
+    if (reuse) emit_close_source(reuse);
+    if (Cmd != stdout) {
+	if (zfile_close(Cmd) != 0) {
+	    if (!out.failed)
+		Fprintf(stderr, "emit_routes():  Error writing output DEF file.\n");
+	    errcond = TRUE;
+	}
+    }
+    else
+	fflush(Cmd);
+
+    if (tmpname != NULL) {
+	if (errcond == TRUE)
+	    unlink(tmpname);
+	else if (rename(tmpname, outname) != 0) {
+	    Fprintf(stderr, "emit_routes():  Couldn't rename %s to %s.\n",
+			tmpname, outname);
+	    unlink(tmpname);
+	    errcond = TRUE;
+	}
+	free(tmpname);
+    }
+
+    // Record the file written, so that the next incremental write
+    // can copy from it.  The saved net positions are good only if
+    // the whole file was written and every byte was counted.
+
+    emit_forget_output();
+    if ((outname != NULL) && (errcond == FALSE) && (out.written >= 0) &&
+		(stat(outname, &st) == 0)) {
+	LastDEFout.name = outname;
+	LastDEFout.size = st.st_size;
+	LastDEFout.mtime = st.st_mtime;
+	LastDEFout.ino = st.st_ino;
+	LastDEFout.length = out.written;
+	LastDEFout.oscale = oscale;
+	LastDEFout.iscale = iscale;
+	outname = NULL;
+	for (i = 0; i < Numnets; i++)
+	    Nlnets[i]->flags &= ~NET_DIRTY;
+    }
+    free(outname);
+    rb_free(&out);
 
 } /* emit_routes() */
 
@@ -8,13 +8,13 @@
 #ifndef _OUTPUTINT_H
 #define _OUTPUTINT_H
 
-extern int  Pathon;
-
 /* Function prototypes */
-static void emit_routes(char *filename, double oscale, int iscale);
+static void emit_routes(char *filename, double oscale, int iscale,
+		u_char incremental);
 
 void   cleanup_net(NET net);
 int    write_def(char *filename);
+int    write_def_incremental(char *filename);
 int    write_failed(char *filename);
 char  *print_node_name(NODE node);
 void   print_nets(char *filename);
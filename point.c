@@ -13,34 +13,74 @@
 
 #include "qrouter.h"
 #include "point.h"
+#include "memstat.h"
+
+/* Amount of point store memory (in bytes) kept mapped when the	*/
+/* store is trimmed.  Set by "point store watermark" (kbytes)	*/
+/* in the configuration file.					*/
+
+u_long PointStoreWatermark = 4 * POINT_STORE_BLOCK_SIZE;
+
+static long _points_live = 0;	/* Points handed out and not freed */
+static long _points_peak = 0;	/* Maximum value of _points_live   */
 
 #ifdef HAVE_SYS_MMAN_H
 
-POINT POINTStoreFreeList = NULL;
-POINT POINTStoreFreeList_end = NULL;
+/* Each mmap'd block starts with a header linking it to the	*/
+/* next block.  The union keeps points aligned for pointers.	*/
+
+typedef union pointblock_ *POINTBLOCK;
+
+union pointblock_ {
+    POINTBLOCK next;
+    double align;
+};
+
+static POINT POINTStoreFreeList = NULL;
 
 /* The memory mapped POINT Allocation scheme */
 
-static void *_block_begin = NULL;
+static POINTBLOCK _block_list = NULL;	/* First block mapped	  */
+static POINTBLOCK _block_cur = NULL;	/* Block being carved up  */
 static void *_current_ptr = NULL;
 static void *_block_end = NULL;
+static int _blocks_mapped = 0;
+static int _blocks_peak = 0;
+
+/* Move to the next block in the point store, mapping a new	*/
+/* one if all blocks in the list have been used.		*/
 
-/* MMAP the point store */
 static signed char
 mmapPOINTStore()
 {
     int prot = PROT_READ | PROT_WRITE;
     int flags = MAP_ANON | MAP_PRIVATE;
-    u_long map_len = POINT_STORE_BLOCK_SIZE; 	
+    u_long map_len = POINT_STORE_BLOCK_SIZE;
+    POINTBLOCK newblock;
 
-    _block_begin = mmap(NULL, map_len, prot, flags, -1, 0);
-    if (_block_begin == MAP_FAILED)
-    {
-	fprintf(stderr, "mmapPOINTStore: Unable to mmap ANON SEGMENT\n");
-	exit(1);
+    if (_block_cur && _block_cur->next) {
+	_block_cur = _block_cur->next;
     }
-    _block_end = (void *) ((unsigned long) _block_begin + map_len);
-    _current_ptr = _block_begin;
+    else {
+	newblock = (POINTBLOCK)mmap(NULL, map_len, prot, flags, -1, 0);
+	if (newblock == MAP_FAILED)
+	{
+	    fprintf(stderr, "mmapPOINTStore: Unable to mmap ANON SEGMENT\n");
+	    exit(1);
+	}
+	newblock->next = NULL;
+	if (_block_cur == NULL)
+	    _block_list = newblock;
+	else
+	    _block_cur->next = newblock;
+	_block_cur = newblock;
+
+	mem_account(MEM_POINTS, (long)map_len);
+	_blocks_mapped++;
+	if (_blocks_mapped > _blocks_peak) _blocks_peak = _blocks_mapped;
+    }
+    _current_ptr = (void *)((char *)_block_cur + sizeof(union pointblock_));
+    _block_end = (void *)((char *)_block_cur + map_len);
     return 0;
 }
 
@@ -49,9 +89,9 @@ allocPOINT()
 {
     POINT _return_point = NULL;
 
-    if (!_block_begin && !_block_end) mmapPOINTStore();
+    if (++_points_live > _points_peak) _points_peak = _points_live;
 
-    /* Check if we can get the point from the 
+    /* Check if we can get the point from the
      * Free list
      */
 
@@ -63,13 +103,13 @@ allocPOINT()
 
     /* Get it from the mmap */
 
-    if (((unsigned long)_current_ptr + sizeof(struct point_)) >
-		(unsigned long)_block_end)
+    if ((_current_ptr == NULL) || (((unsigned long)_current_ptr
+		+ sizeof(struct point_)) > (unsigned long)_block_end))
 	 mmapPOINTStore();
 
     _current_ptr  = (void *)((unsigned long)_current_ptr
 		+ sizeof(struct point_));
-	
+
     if ((unsigned long)_current_ptr > (unsigned long) _block_end) {
 	fprintf(stderr,
 		"allocPOINT(): internal assertion failure.");
@@ -78,19 +118,83 @@ allocPOINT()
     return (POINT)((unsigned long)_current_ptr - sizeof(struct point_));
 }
 
+/* Freed points are reused most-recently-freed first */
+
 void
 freePOINT(POINT gp)
 {
-    if (!POINTStoreFreeList_end || !POINTStoreFreeList) {
-	POINTStoreFreeList_end = gp;
-	gp->next = (POINT)NULL;
-	POINTStoreFreeList = POINTStoreFreeList_end;
+    gp->next = POINTStoreFreeList;
+    POINTStoreFreeList = gp;
+    _points_live--;
+}
+
+/*--------------------------------------------------------------*/
+/* trimPOINTStore() ---						*/
+/*								*/
+/* Unmap point store blocks in excess of PointStoreWatermark.	*/
+/* This can only be done when no points are in use, as points	*/
+/* are not moved.  The blocks that are kept are reused from the	*/
+/* start, and the free list is discarded.  Called between nets	*/
+/* so that one net with a huge search frontier does not leave	*/
+/* the process holding that memory for the rest of the run.	*/
+/*--------------------------------------------------------------*/
+
+void
+trimPOINTStore()
+{
+    POINTBLOCK block, nextblock, lastkept;
+    int keep, n;
+
+    if (_points_live != 0) return;
+
+    keep = (int)(PointStoreWatermark / POINT_STORE_BLOCK_SIZE);
+    if (_blocks_mapped <= keep) return;
+
+    lastkept = NULL;
+    n = 0;
+    for (block = _block_list; block; block = nextblock) {
+	nextblock = block->next;
+	if (n < keep)
+	    lastkept = block;
+	else {
+	    munmap((void *)block, POINT_STORE_BLOCK_SIZE);
+	    mem_account(MEM_POINTS, -(long)POINT_STORE_BLOCK_SIZE);
+	    _blocks_mapped--;
+	}
+	n++;
     }
-    else {
-	POINTStoreFreeList_end->next = gp;
-	POINTStoreFreeList_end = gp;
-	POINTStoreFreeList_end->next = (POINT)NULL;
+
+    if (lastkept == NULL)
+	_block_list = NULL;
+    else
+	lastkept->next = NULL;
+
+    /* Start over with the first block kept */
+
+    _block_cur = NULL;
+    _current_ptr = NULL;
+    _block_end = NULL;
+    if (_block_list != NULL) {
+	_block_cur = _block_list;
+	_current_ptr = (void *)((char *)_block_cur + sizeof(union pointblock_));
+	_block_end = (void *)((char *)_block_cur + POINT_STORE_BLOCK_SIZE);
     }
+    POINTStoreFreeList = NULL;
+}
+
+/*--------------------------------------------------------------*/
+/* reportPOINTStore() ---					*/
+/*								*/
+/* Print the number of points in use and the number of blocks	*/
+/* mapped, with peak values.					*/
+/*--------------------------------------------------------------*/
+
+void
+reportPOINTStore()
+{
+    Fprintf(stdout, "POINT store: %ld points in use (peak %ld), "
+		"%d blocks mapped (peak %d)\n", _points_live, _points_peak,
+		_blocks_mapped, _blocks_peak);
 }
 
 #else
@@ -100,15 +204,30 @@ allocPOINT()
 {
     POINT newpoint;
 
-    newpoint = (POINT)malloc((unsigned)(sizeof(struct point_)));
+    newpoint = (POINT)mem_malloc(MEM_POINTS, sizeof(struct point_));
+    if (++_points_live > _points_peak) _points_peak = _points_live;
     return (newpoint);
 }
 
 void
 freePOINT(POINT gp)
 {
-    free((char *)gp);
+    mem_free(MEM_POINTS, (void *)gp, sizeof(struct point_));
+    _points_live--;
 }
 
-#endif /* !HAVE_SYS_MMAN_H */
+/* Points are returned to the heap as they are freed */
+
+void
+trimPOINTStore()
+{
+}
 
+void
+reportPOINTStore()
+{
+    Fprintf(stdout, "POINT store: %ld points in use (peak %ld)\n",
+		_points_live, _points_peak);
+}
+
+#endif /* !HAVE_SYS_MMAN_H */
@@ -9,14 +9,14 @@
 #ifdef HAVE_SYS_MMAN_H
 #include <sys/mman.h>
 #include <unistd.h>
+#endif /* HAVE_SYS_MMAN_H */
 
 /* Page size is 4KB so we mmap a segment equal to 64 pages */
 #define POINT_STORE_BLOCK_SIZE (4 * 1024 * 64)
 
-extern POINT PointStoreFreeList;
-extern POINT PointStoreFreeList_end;
-
-#endif /* HAVE_SYS_MMAN_H */
+extern u_long PointStoreWatermark;
 
 extern POINT allocPOINT();
 extern void freePOINT(POINT gp);
+extern void trimPOINTStore();
+extern void reportPOINTStore();
@@ -0,0 +1,212 @@
+/*--------------------------------------------------------------*/
+/* pool.c --							*/
+/*								*/
+/* Pooled allocation of route records.  SEG, ROUTE, and NETLIST	*/
+/* records are created and destroyed in large numbers during	*/
+/* routing and rip-up.  Allocating them individually from the	*/
+/* heap is slow and fragments memory, so they are carved out of	*/
+/* large slabs instead, and freed records are kept on a list	*/
+/* for reuse.  Slabs are never returned to the system.		*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "qrouter.h"
+#include "pool.h"
+#include "memstat.h"
+
+/* Slab header;  the union keeps records aligned for doubles */
+
+typedef union slabhdr_ {
+    void  *next;
+    double align;
+} SlabHdr;
+
+RecPool SEGPool = {sizeof(struct seg_), NULL, NULL, NULL, NULL, 0, 0, 0};
+RecPool ROUTEPool = {sizeof(struct route_), NULL, NULL, NULL, NULL, 0, 0, 0};
+RecPool NETLISTPool = {sizeof(struct netlist_), NULL, NULL, NULL, NULL, 0, 0, 0};
+
+/*--------------------------------------------------------------*/
+/* pool_init() ---						*/
+/*								*/
+/* Set up an empty pool of records of size "recsize".  Besides	*/
+/* the global pools above, a thread may keep pools of its own	*/
+/* for records that no other thread sees, since the pools are	*/
+/* not locked.  Such a pool is emptied with pool_release().	*/
+/*--------------------------------------------------------------*/
+
+void
+pool_init(RecPool *pool, size_t recsize)
+{
+    pool->recsize = recsize;
+    pool->freelist = NULL;
+    pool->slabs = NULL;
+    pool->cur = NULL;
+    pool->end = NULL;
+    pool->inuse = 0;
+    pool->peak = 0;
+    pool->nslabs = 0;
+}
+
+/*--------------------------------------------------------------*/
+/* pool_alloc() ---						*/
+/*								*/
+/* Return one record from the pool, preferring the most	*/
+/* recently freed record.  Records are not cleared.		*/
+/*--------------------------------------------------------------*/
+
+void *
+pool_alloc(RecPool *pool)
+{
+    void *rec;
+    SlabHdr *slab;
+
+    if (pool->freelist) {
+	rec = pool->freelist;
+	pool->freelist = *((void **)rec);
+    }
+    else {
+	if (pool->cur + pool->recsize > pool->end) {
+	    slab = (SlabHdr *)mem_malloc(MEM_ROUTES, POOL_SLAB_SIZE);
+	    if (slab == NULL) {
+		fprintf(stderr, "pool_alloc: Out of memory.\n");
+		exit(1);
+	    }
+	    slab->next = pool->slabs;
+	    pool->slabs = (void *)slab;
+	    pool->nslabs++;
+	    pool->cur = (char *)slab + sizeof(SlabHdr);
+	    pool->end = (char *)slab + POOL_SLAB_SIZE;
+	}
+	rec = (void *)pool->cur;
+	pool->cur += pool->recsize;
+    }
+    pool->inuse++;
+    if (pool->inuse > pool->peak) pool->peak = pool->inuse;
+    return rec;
+}
+
+/*--------------------------------------------------------------*/
+/* pool_free() ---						*/
+/*								*/
+/* Return a record to the pool.  NULL is ignored.		*/
+/*--------------------------------------------------------------*/
+
+void
+pool_free(RecPool *pool, void *rec)
+{
+    if (rec == NULL) return;
+    *((void **)rec) = pool->freelist;
+    pool->freelist = rec;
+    pool->inuse--;
+}
+
+/*--------------------------------------------------------------*/
+/* pool_free_list() ---						*/
+/*								*/
+/* Return a linked list of records to the pool.  The records	*/
+/* must be linked through their first word.			*/
+/*--------------------------------------------------------------*/
+
+void
+pool_free_list(RecPool *pool, void *rec)
+{
+    void *next;
+
+    while (rec) {
+	next = *((void **)rec);
+	pool_free(pool, rec);
+	rec = next;
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* pool_release() ---						*/
+/*								*/
+/* Free all of the slabs of a pool made with pool_init(),	*/
+/* including any records still handed out, and leave the pool	*/
+/* empty.							*/
+/*--------------------------------------------------------------*/
+
+void
+pool_release(RecPool *pool)
+{
+    void *slab, *next;
+
+    for (slab = pool->slabs; slab; slab = next) {
+	next = ((SlabHdr *)slab)->next;
+	mem_free(MEM_ROUTES, slab, POOL_SLAB_SIZE);
+    }
+    pool_init(pool, pool->recsize);
+}
+
+/*--------------------------------------------------------------*/
+/* Type-specific wrappers					*/
+/*--------------------------------------------------------------*/
+
+SEG
+allocSEG(void)
+{
+    return (SEG)pool_alloc(&SEGPool);
+}
+
+void
+freeSEG(SEG seg)
+{
+    pool_free(&SEGPool, (void *)seg);
+}
+
+/* Free a linked list of segments */
+
+void
+freeSEGlist(SEG seg)
+{
+    SEG nseg;
+
+    while (seg) {
+	nseg = seg->next;
+	pool_free(&SEGPool, (void *)seg);
+	seg = nseg;
+    }
+}
+
+ROUTE
+allocROUTE(void)
+{
+    return (ROUTE)pool_alloc(&ROUTEPool);
+}
+
+void
+freeROUTE(ROUTE rt)
+{
+    pool_free(&ROUTEPool, (void *)rt);
+}
+
+NETLIST
+allocNETLIST(void)
+{
+    return (NETLIST)pool_alloc(&NETLISTPool);
+}
+
+void
+freeNETLIST(NETLIST nl)
+{
+    pool_free(&NETLISTPool, (void *)nl);
+}
+
+/* Free a linked list of net list records (not the nets) */
+
+void
+freeNETLISTlist(NETLIST nl)
+{
+    NETLIST nnl;
+
+    while (nl) {
+	nnl = nl->next;
+	pool_free(&NETLISTPool, (void *)nl);
+	nl = nnl;
+    }
+}
+
+/* end of pool.c */
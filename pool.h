@@ -0,0 +1,49 @@
+/*--------------------------------------------------------------*/
+/* pool.h --							*/
+/*								*/
+/* Pooled allocation of route records (header file)		*/
+/*--------------------------------------------------------------*/
+
+#ifndef POOL_H
+
+/* Records are carved out of slabs of this size (64 pages of 4KB) */
+#define POOL_SLAB_SIZE (4 * 1024 * 64)
+
+/* A pool of fixed-size records.  Free records are kept on a	*/
+/* LIFO list linked through their first word, which for SEG,	*/
+/* ROUTE, and NETLIST is the "next" pointer.			*/
+
+typedef struct recpool_ {
+    size_t recsize;	/* Size of one record			*/
+    void  *freelist;	/* Records returned to the pool		*/
+    void  *slabs;	/* All slabs, linked through first word	*/
+    char  *cur;		/* Next unused record in current slab	*/
+    char  *end;		/* End of current slab			*/
+    long   inuse;	/* Number of records handed out		*/
+    long   peak;	/* Maximum value of inuse		*/
+    long   nslabs;	/* Number of slabs allocated		*/
+} RecPool;
+
+extern RecPool SEGPool;
+extern RecPool ROUTEPool;
+extern RecPool NETLISTPool;
+
+extern void    pool_init(RecPool *pool, size_t recsize);
+extern void   *pool_alloc(RecPool *pool);
+extern void    pool_free(RecPool *pool, void *rec);
+extern void    pool_free_list(RecPool *pool, void *rec);
+extern void    pool_release(RecPool *pool);
+
+extern SEG     allocSEG(void);
+extern void    freeSEG(SEG seg);
+extern void    freeSEGlist(SEG seg);
+extern ROUTE   allocROUTE(void);
+extern void    freeROUTE(ROUTE rt);
+extern NETLIST allocNETLIST(void);
+extern void    freeNETLIST(NETLIST nl);
+extern void    freeNETLISTlist(NETLIST nl);
+
+#define POOL_H
+#endif
+
+/* end of pool.h */
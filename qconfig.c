@@ -22,6 +22,7 @@
 
 #include "qrouter.h"
 #include "qconfig.h"
+#include "point.h"
 #include "lef.h"
 
 int    CurrentPin = 0;
@@ -57,6 +58,8 @@ int     BlockCost = 25;            // Cost of a crossover when node has
 int	OffsetCost = 50;	   // Cost per micron of a node offset
 int 	ConflictCost = 50;	   // Cost of shorting another route
 				   // during the rip-up and reroute stage
+int	AntennaCost = 0;	   // Cost of filling the antenna limit
+				   // of a layer (0 = no antenna costing)
 
 char    *ViaXX[MAX_LAYERS];
 char    *ViaXY[MAX_LAYERS];
@@ -104,6 +107,10 @@ post_config(u_char noprint)
     i = LefGetMaxRouteLayer();
     if (i < Num_layers) Num_layers = i;
 
+    // Bring the flattened LEF technology table up to date.
+
+    LefTechBuild();
+
     // Make sure all layers have a pitch in both X and Y even if not
     // specified separately in the configuration or def files.
     for (i = 0; i < Num_layers; i++) {
@@ -203,6 +210,7 @@ int read_config(FILE *fconfig, int is_info)
     STRING strl;
     GATE   gateinfo = NULL;   // gate information, pin location, etc
     DSEG   drect;
+    char  *lefcache = NULL;   // LEF cache file name
 
     if (Firstcall) {
 	for (i = 0; i < MAX_LAYERS; i++) {
@@ -212,6 +220,7 @@ int read_config(FILE *fconfig, int is_info)
 	    ViaYX[i] = NULL;
 	    ViaYY[i] = NULL;
 	}
+	LefTechInvalidate();
 
 	DontRoute = (STRING)NULL;
 	CriticalNet = (STRING)NULL;
@@ -234,7 +243,19 @@ int read_config(FILE *fconfig, int is_info)
 	lineptr = line;
 	while (isspace(*lineptr)) lineptr++;
 
-	if (!strncasecmp(lineptr, "lef", 3) || !strncmp(lineptr, "read_lef", 8)) {
+	if (!strncasecmp(lineptr, "lef_cache", 9)) {
+	    if ((i = sscanf(lineptr, "%*s %s\n", sarg)) == 1) {
+	       // Argument is the name of a binary cache of the LEF
+	       // data.  If it is current, the LEF files it was made
+	       // from are not parsed again.  Otherwise, it is written
+	       // after the configuration file has been read.
+	       OK = 1;
+	       if (lefcache != NULL) free(lefcache);
+	       lefcache = strdup(sarg);
+	       LefReadCache(lefcache);
+	    }
+	}
+	else if (!strncasecmp(lineptr, "lef", 3) || !strncmp(lineptr, "read_lef", 8)) {
 	    int mscale;
 	    if ((i = sscanf(lineptr, "%*s %s\n", sarg)) == 1) {
 	       // Argument is a filename of a LEF file from which we
@@ -368,6 +389,9 @@ int read_config(FILE *fconfig, int is_info)
 	if ((i = sscanf(lineptr, "route block cost %d", &iarg)) == 1) {
 	    OK = 1; BlockCost = iarg;
 	}
+	if ((i = sscanf(lineptr, "route antenna cost %d", &iarg)) == 1) {
+	    OK = 1; AntennaCost = iarg;
+	}
 
 	if ((i = sscanf(lineptr, "do not route node %s\n", sarg)) == 1) {
 	    OK = 1; 
@@ -409,6 +433,15 @@ int read_config(FILE *fconfig, int is_info)
 	    if (StackedContacts == 0) StackedContacts = 1;
 	}
 
+	// Search for "point store watermark N", the number of kbytes
+	// of maze router point storage to keep between nets.
+
+	if ((i = sscanf(lineptr, "point store watermark %d", &iarg)) == 1) {
+	    OK = 1;
+	    if (iarg < 0) iarg = 0;
+	    PointStoreWatermark = (u_long)iarg * 1024;
+	}
+
 	if ((i = sscanf(lineptr, "obstruction %lf %lf %lf %lf %s\n",
 			&darg, &darg2, &darg3, &darg4, sarg)) == 5) {
 	    OK = 1;
@@ -513,6 +546,10 @@ int read_config(FILE *fconfig, int is_info)
 	line[0] = line[1] = '\0';
 
     }
+    if (lefcache != NULL) {
+	if (LefCacheModified()) LefWriteCache(lefcache);
+	free(lefcache);
+    }
     post_config(FALSE);
     return count;
 
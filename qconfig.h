@@ -36,6 +36,7 @@ extern int     XverCost;
 extern int     BlockCost;
 extern int     OffsetCost;
 extern int     ConflictCost;
+extern int     AntennaCost;
 
 // If vias are non-square, then they can have up to four orientations,
 // with the top and/or bottom metal layers oriented with the longest
@@ -22,6 +22,9 @@
 #include "qrouter.h"
 #include "qconfig.h"
 #include "point.h"
+#include "pool.h"
+#include "memstat.h"
+#include "congest.h"
 #include "node.h"
 #include "maze.h"
 #include "mask.h"
@@ -29,6 +32,7 @@
 #include "lef.h"
 #include "def.h"
 #include "graphics.h"
+#include "zfile.h"
 
 int  TotalRoutes = 0;
 
@@ -41,7 +45,7 @@ GATE	PinMacro;	// macro definition for a pin
 GATE    Nlgates;	// gate instance information
 NETLIST FailedNets;	// list of nets that failed to route
 
-u_int    *Obs[MAX_LAYERS];      // net obstructions in layer
+obsword   *Obs[MAX_LAYERS];      // net obstructions in layer
 PROUTE   *Obs2[MAX_LAYERS];     // used for pt->pt routes on layer
 ObsInfoRec *Obsinfo[MAX_LAYERS];  // temporary array used for detailed obstruction info
 NODEINFO *Nodeinfo[MAX_LAYERS]; // nodes and stub information is here. . .
@@ -62,6 +66,7 @@ u_char Verbose = 3;	// Default verbose level
 u_char forceRoutable = FALSE;
 u_char maskMode = MASK_AUTO;
 u_char mapType = MAP_OBSTRUCT | DRAW_ROUTES;
+int    Numthreads = 0;	// Worker threads (0 = one per processor)
 u_char ripLimit = 10;	// Fail net rather than rip up more than
 			// this number of other nets.
 u_char unblockAll = FALSE;
@@ -102,6 +107,26 @@ update_mscale(int mscale)
 }
 
 
+/*--------------------------------------------------------------*/
+/* Return the number of worker threads to use:  the value set	*/
+/* with "-t", or the number of processors online.  Always 1 if	*/
+/* the router was compiled without thread support.		*/
+/*--------------------------------------------------------------*/
+
+int thread_count(void)
+{
+#ifdef HAVE_PTHREAD_H
+    long ncpu;
+
+    if (Numthreads > 0) return Numthreads;
+#ifdef _SC_NPROCESSORS_ONLN
+    ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (ncpu > 0) return (int)ncpu;
+#endif
+#endif
+    return 1;
+}
+
 /*--------------------------------------------------------------*/
 /* Check track pitch and set the number of channels (may be	*/
 /* called from DefRead)						*/
@@ -202,8 +227,7 @@ int allocate_obs_array(void)
    if (Obs[0] != NULL) return 0;	/* Already been called */
 
    for (i = 0; i < Num_layers; i++) {
-      Obs[i] = (u_int *)calloc(NumChannelsX * NumChannelsY,
-			sizeof(u_int));
+      Obs[i] = (obsword *)mem_calloc(MEM_GRID, NUMCHANNELS, sizeof(obsword));
       if (!Obs[i]) {
 	 Fprintf(stderr, "Out of memory 4.\n");
 	 return(4);
@@ -250,7 +274,7 @@ runqrouter(int argc, char *argv[])
    static char configdefault[] = CONFIGFILENAME;
    char *configfile = configdefault;
    char *infofile = NULL;
-   char *dotptr;
+   char *dotptr, *zsuffix;
    char *Filename = NULL;
    u_char readconfig = FALSE;
    u_char doscript = FALSE;
@@ -280,6 +304,7 @@ runqrouter(int argc, char *argv[])
 	    case 'g':
 	    case 'r':
 	    case 's':
+	    case 't':
 	       argsep = *(argv[i] + 2);
 	       if (argsep == '\0') {
 		  i++;
@@ -335,6 +360,13 @@ runqrouter(int argc, char *argv[])
 		   Scales.iscale = 1;
 	       }
 	       break;
+	    case 't':
+	       if ((sscanf(optarg, "%d", &Numthreads) != 1) || (Numthreads < 0)) {
+		   Fprintf(stderr, "Bad number of threads \"%s\", "
+			"integer expected.\n", optarg);
+		   Numthreads = 0;
+	       }
+	       break;
 	    case 'h':
 	       helpmessage();
 	       return 1;
@@ -442,13 +474,22 @@ runqrouter(int argc, char *argv[])
 
    if (Filename != NULL) {
 
-      /* process last non-option string */
+      /* process last non-option string.  A compression suffix	*/
+      /* (e.g., "name.def.gz") is kept.				*/
 
+      zsuffix = zfile_suffix(Filename);
+      if (zsuffix != NULL) {
+	 zsuffix = strdup(zsuffix);
+	 *zfile_suffix(Filename) = '\0';
+      }
       dotptr = strrchr(Filename, '.');
       if (dotptr != NULL) *dotptr = '\0';
       if (DEFfilename != NULL) free(DEFfilename);
-      DEFfilename = (char *)malloc(strlen(Filename) + 5);
-      sprintf(DEFfilename, "%s.def", Filename);
+      DEFfilename = (char *)malloc(strlen(Filename) + 5 +
+		((zsuffix != NULL) ? strlen(zsuffix) : 0));
+      sprintf(DEFfilename, "%s.def%s", Filename,
+		(zsuffix != NULL) ? zsuffix : "");
+      free(zsuffix);
    }
    else if (readconfig) {
       Fprintf(stdout, "No netlist file specified, continuing without.\n");
@@ -457,7 +498,7 @@ runqrouter(int argc, char *argv[])
       helpmessage();
    }
 
-   Obs[0] = (u_int *)NULL;
+   Obs[0] = (obsword *)NULL;
    NumChannelsX = 0;	// This is so we can check if NumChannelsX/Y were
 			// set from within DefRead() due to reading in
 			// existing nets.
@@ -485,7 +526,7 @@ u_char remove_from_failed(NET net)
 		FailedNets = nl->next;
 	    else
 		lastnl->next = nl->next;
-	    free(nl);
+	    freeNETLIST(nl);
 	    return TRUE;
 	}
 	lastnl = nl;
@@ -501,12 +542,8 @@ u_char remove_from_failed(NET net)
 
 void remove_failed()
 {
-    NETLIST nl;
-    while (FailedNets) {
-	nl = FailedNets;
-	FailedNets = FailedNets->next;
-	free(nl);
-    }
+    freeNETLISTlist(FailedNets);
+    FailedNets = (NETLIST)NULL;
 }
 
 /*--------------------------------------------------------------*/
@@ -516,16 +553,12 @@ void remove_failed()
 void remove_top_route(NET net)
 {
     ROUTE rt;
-    SEG seg;
 
     rt = net->routes;
     net->routes = net->routes->next;
-    while (rt->segments) {
-	seg = rt->segments;
-	rt->segments = rt->segments->next;
-	    free(seg);
-    }
-    free(rt);
+    net->flags |= NET_DIRTY | NET_RC_DIRTY;
+    freeSEGlist(rt->segments);
+    freeROUTE(rt);
 }
 
 /*--------------------------------------------------------------*/
@@ -536,7 +569,8 @@ void remove_top_route(NET net)
 
 static void reinitialize()
 {
-    int i, j;
+    int i;
+    gindex j;
     NETLIST nl;
     NET net;
     ROUTE rt;
@@ -549,21 +583,22 @@ static void reinitialize()
     // Free up all of the matrices
 
     for (i = 0; i < Pinlayers; i++) {
-	for (j = 0; j < NumChannelsX * NumChannelsY; j++)
+	for (j = 0; j < NUMCHANNELS; j++)
 	    if (Nodeinfo[i][j])
-		free(Nodeinfo[i][j]);
-	free(Nodeinfo[i]);
+		mem_free(MEM_NODEINFO, Nodeinfo[i][j],
+			sizeof(struct nodeinfo_));
+	mem_free(MEM_NODEINFO, Nodeinfo[i], NUMCHANNELS * sizeof(NODEINFO));
 	Nodeinfo[i] = NULL;
     }
     for (i = 0; i < Num_layers; i++) {
-	free(Obs2[i]);
-	free(Obs[i]);
+	mem_free(MEM_GRID, Obs2[i], NUMCHANNELS * sizeof(PROUTE));
+	mem_free(MEM_GRID, Obs[i], NUMCHANNELS * sizeof(obsword));
 
 	Obs2[i] = NULL;
 	Obs[i] = NULL;
     }
     if (RMask != NULL) {
-	free(RMask);
+	mem_free(MEM_GRID, RMask, NUMCHANNELS * sizeof(u_char));
 	RMask = NULL;
     }
 
@@ -575,11 +610,8 @@ static void reinitialize()
 
     for (i = 0; i < Numnets; i++) {
 	net = Nlnets[i];
-	while (net->noripup) {
-	    nl = net->noripup;
-	    net->noripup = net->noripup->next;
-	    free(nl);
-	}
+	freeNETLISTlist(net->noripup);
+	net->noripup = (NETLIST)NULL;
 	while (net->routes)
             remove_top_route(net);
 
@@ -590,17 +622,18 @@ static void reinitialize()
 	    while (node->taps) {
 		dpt = node->taps;
 		node->taps = node->taps->next;
-		free(dpt);
+		mem_free(MEM_TAPS, dpt, sizeof(struct dpoint_));
 	    }
 	    while (node->extend) {
 		dpt = node->extend;
 		node->extend = node->extend->next;
-		free(dpt);
+		mem_free(MEM_TAPS, dpt, sizeof(struct dpoint_));
 	    }
 	    // Note: node->netname is not allocated
 	    // but copied from net record
 	    free(node);
 	}
+	free_net_delays(net);
 	free (net->netname);
 	free (net);
     }
@@ -785,11 +818,12 @@ void apply_drc_blocks(int layer, double via_except, double route_except)
 void
 remove_tap_blocks(int netnum)
 {
-    int i, j;
+    int i;
+    gindex j;
     NODE node;
 
     for (i = 0; i < Pinlayers; i++) {
-	for (j = 0; j < NumChannelsX * NumChannelsY; j++) {
+	for (j = 0; j < NUMCHANNELS; j++) {
 	    if (Nodeinfo[i][j]) {
 		node = Nodeinfo[i][j]->nodeloc;
 		if (node != (NODE)NULL)
@@ -840,15 +874,15 @@ static int post_def_setup()
 
    for (i = 0; i < Num_layers; i++) {
 
-      Obsinfo[i] = (ObsInfoRec *)calloc(NumChannelsX * NumChannelsY,
-			sizeof(ObsInfoRec));
+      Obsinfo[i] = (ObsInfoRec *)mem_calloc(MEM_GRID, NUMCHANNELS,
+		sizeof(ObsInfoRec));
       if (!Obsinfo[i]) {
 	 fprintf(stderr, "Out of memory 5.\n");
 	 exit(5);
       }
 
-      Nodeinfo[i] = (NODEINFO *)calloc(NumChannelsX * NumChannelsY,
-			sizeof(NODEINFO));
+      Nodeinfo[i] = (NODEINFO *)mem_calloc(MEM_NODEINFO, NUMCHANNELS,
+		sizeof(NODEINFO));
       if (!Nodeinfo[i]) {
 	 fprintf( stderr, "Out of memory 6.\n");
 	 exit(6);
@@ -857,8 +891,8 @@ static int post_def_setup()
    Flush(stdout);
 
    if (Verbose > 1)
-      Fprintf(stderr, "Diagnostic: memory block is %d bytes\n",
-		(int)sizeof(u_int) * NumChannelsX * NumChannelsY);
+      Fprintf(stderr, "Diagnostic: memory block is %ld bytes\n",
+		(long)sizeof(obsword) * (long)NUMCHANNELS);
 
    /* If any watch points were made, make sure that they have	*/
    /* the correct geometry values, since they were made before	*/
@@ -903,14 +937,18 @@ static int post_def_setup()
       writeback_all_routes(net);
    }
 
+   // Make the congestion map, which is kept up to date from here on
+
+   congestion_init();
+
    // Remove the Obsinfo array, which is no longer needed, and allocate
    // the Obs2 array for costing information
 
-   for (i = 0; i < Num_layers; i++) free(Obsinfo[i]);
+   for (i = 0; i < Num_layers; i++)
+      mem_free(MEM_GRID, Obsinfo[i], NUMCHANNELS * sizeof(ObsInfoRec));
 
    for (i = 0; i < Num_layers; i++) {
-      Obs2[i] = (PROUTE *)calloc(NumChannelsX * NumChannelsY,
-			sizeof(PROUTE));
+      Obs2[i] = (PROUTE *)mem_calloc(MEM_GRID, NUMCHANNELS, sizeof(PROUTE));
       if (!Obs2[i]) {
          fprintf( stderr, "Out of memory 9.\n");
          exit(9);
@@ -929,8 +967,11 @@ static int post_def_setup()
 
    FailedNets = (NETLIST)NULL;
    Flush(stdout);
-   if (Verbose > 0)
+   if (Verbose > 0) {
       Fprintf(stdout, "There are %d nets in this design.\n", Numnets);
+      mem_summary("setup");
+      if (Verbose > 1) reportPOINTStore();
+   }
 
    return 0;
 }
@@ -986,7 +1027,6 @@ int dofirststage(u_char graphdebug, int debug_netnum)
 {
    int i, failcount, remaining, result;
    NET net;
-   NETLIST nl;
 
    // Clear the lists of failed routes, in case first
    // stage is being called more than once.
@@ -1037,8 +1077,11 @@ int dofirststage(u_char graphdebug, int debug_netnum)
       if (FailedNets != (NETLIST)NULL)
           Fprintf(stdout, "Failed net routes: %d\n", failcount);
    }
-   if (Verbose > 0)
+   if (Verbose > 0) {
+      mem_summary("stage 1");
+      if (Verbose > 1) reportPOINTStore();
       Fprintf(stdout, "----------------------------------------------\n");
+   }
 
    return failcount;
 }
@@ -1101,11 +1144,7 @@ static int ripup_colliding(NET net, u_char onlybreak)
     // cause the number of failed nets to keep increasing.
 
     if (ripped > ripLimit) {
-	while (nl) {
-	    nl2 = nl->next;
-	    free(nl);
-	    nl = nl2;
-	}
+	freeNETLISTlist(nl);
 	return -1;
     }
 
@@ -1129,7 +1168,7 @@ static int ripup_colliding(NET net, u_char onlybreak)
 	    // routed over again by the net.  Avoids infinite looping in
 	    // the second stage.
 
-	    fn = (NETLIST)malloc(sizeof(struct netlist_));
+	    fn = allocNETLIST();
 	    fn->next = net->noripup;
 	    net->noripup = fn;
 	    fn->net = nl->net;
@@ -1156,7 +1195,7 @@ int route_net_ripup(NET net, u_char graphdebug, u_char onlybreak)
 	if (FailedNets->net == net) {
 	    nl2 = FailedNets;
 	    FailedNets = FailedNets->next;
-	    free(nl2);
+	    freeNETLIST(nl2);
 	}
 	else {
 	    for (nl = FailedNets; nl->next; nl = nl->next) {
@@ -1165,7 +1204,7 @@ int route_net_ripup(NET net, u_char graphdebug, u_char onlybreak)
 	    }
 	    nl2 = nl->next;
 	    nl->next = nl2->next;
-	    free(nl2);
+	    freeNETLIST(nl2);
 	}
     }
 
@@ -1175,11 +1214,8 @@ int route_net_ripup(NET net, u_char graphdebug, u_char onlybreak)
 	    if ((net->flags & NET_PENDING) == 0) {
 		// Clear this net's "noripup" list and try again.
 
-		while (net->noripup) {
-		    nl = net->noripup->next;
-		    free(net->noripup);
-		    net->noripup = nl;
-		}
+		freeNETLISTlist(net->noripup);
+		net->noripup = (NETLIST)NULL;
 		result = doroute(net, TRUE, graphdebug);
 		net->flags |= NET_PENDING;	// Next time we abandon it.
 	    }
@@ -1217,7 +1253,6 @@ dosecondstage(u_char graphdebug, u_char singlestep, u_char onlybreak, u_int effo
    NETLIST nl, nl2;
    NETLIST Abandoned;	// Abandoned routes---not even trying any more.
    ROUTE rt, rt2;
-   SEG seg;
    u_int loceffort = (effort > minEffort) ? effort : minEffort;
 
    fillMask((u_char)0);
@@ -1229,11 +1264,8 @@ dosecondstage(u_char graphdebug, u_char singlestep, u_char onlybreak, u_int effo
 
    for (nl2 = FailedNets; nl2; nl2 = nl2->next) {
        net = nl2->net;
-       while (net->noripup) {
-          nl = net->noripup->next;
-          free(net->noripup);
-          net->noripup = nl;
-       }
+       freeNETLISTlist(net->noripup);
+       net->noripup = (NETLIST)NULL;
        net->flags &= ~NET_PENDING;
    }
 
@@ -1250,7 +1282,7 @@ dosecondstage(u_char graphdebug, u_char singlestep, u_char onlybreak, u_int effo
       // Remove this net from the fail list
       nl2 = FailedNets;
       FailedNets = FailedNets->next;
-      free(nl2);
+      freeNETLIST(nl2);
 
       // Keep track of which routes existed before the call to doroute().
       for (rt = net->routes; rt && rt->next; rt = rt->next);
@@ -1266,11 +1298,8 @@ dosecondstage(u_char graphdebug, u_char singlestep, u_char onlybreak, u_int effo
 	    if ((net->flags & NET_PENDING) == 0) {
 	       // Clear this net's "noripup" list and try again.
 
-	       while (net->noripup) {
-	          nl = net->noripup->next;
-	          free(net->noripup);
-	          net->noripup = nl;
-	       }
+	       freeNETLISTlist(net->noripup);
+	       net->noripup = (NETLIST)NULL;
 	       result = doroute(net, TRUE, graphdebug);
 	       net->flags |= NET_PENDING;	// Next time we abandon it.
 	    }
@@ -1300,14 +1329,14 @@ dosecondstage(u_char graphdebug, u_char singlestep, u_char onlybreak, u_int effo
 			net->netname);
 
 	 // Add the net to the "abandoned" list
-	 nl = (NETLIST)malloc(sizeof(struct netlist_));
+	 nl = allocNETLIST();
 	 nl->net = net;
 	 nl->next = Abandoned;
 	 Abandoned = nl;
 
 	 while (FailedNets && (FailedNets->net == net)) {
 	    nl = FailedNets->next;
-	    free(FailedNets);
+	    freeNETLIST(FailedNets);
 	    FailedNets = nl;
 	 }
 
@@ -1324,12 +1353,8 @@ dosecondstage(u_char graphdebug, u_char singlestep, u_char onlybreak, u_int effo
 	 }
 	 while (rt != NULL) {
 	    rt2 = rt->next;
-            while (rt->segments) {
-              seg = rt->segments->next;
-              free(rt->segments);
-              rt->segments = seg;
-            }
-	    free(rt);
+	    freeSEGlist(rt->segments);
+	    freeROUTE(rt);
 	    rt = rt2;
 	 }
 
@@ -1393,8 +1418,11 @@ dosecondstage(u_char graphdebug, u_char singlestep, u_char onlybreak, u_int effo
       if (FailedNets != (NETLIST)NULL)
           Fprintf(stdout, "Failed net routes: %d\n", failcount);
    }
-   if (Verbose > 0)
+   if (Verbose > 0) {
+      mem_summary("stage 2");
+      if (Verbose > 1) reportPOINTStore();
       Fprintf(stdout, "----------------------------------------------\n");
+   }
 
    return failcount;
 }
@@ -1481,7 +1509,7 @@ int dothirdstage(u_char graphdebug, int debug_netnum, u_int effort)
 	    /* Pull net from FailedNets, since we restored it. */
 	    if (FailedNets && (FailedNets->net == net)) {
 	       nl = FailedNets->next;
-	       free(FailedNets);
+	       freeNETLIST(FailedNets);
 	       FailedNets = nl;
 	    }
 	 }
@@ -1530,8 +1558,11 @@ int dothirdstage(u_char graphdebug, int debug_netnum, u_int effort)
       if (FailedNets != (NETLIST)NULL)
           Fprintf(stdout, "Failed net routes: %d\n", failcount);
    }
-   if (Verbose > 0)
+   if (Verbose > 0) {
+      mem_summary("stage 3");
+      if (Verbose > 1) reportPOINTStore();
       Fprintf(stdout, "----------------------------------------------\n");
+   }
 
    return failcount;
 }
@@ -1609,6 +1640,9 @@ int doroute(NET net, u_char stage, u_char graphdebug)
   unroutable = result - 1;
   if (graphdebug) highlight_mask();
 
+  // Set up antenna-aware costing, if enabled
+  antenna_cost_net(net);
+
   // Keep going until we are unable to route to a terminal
 
   while (net && (result > 0)) {
@@ -1636,11 +1670,11 @@ int doroute(NET net, u_char stage, u_char graphdebug)
 	// working on this net and move on to the next.
 	if (FailedNets && (FailedNets->net == net)) break;
 
-	nlist = (NETLIST)malloc(sizeof(struct netlist_));
+	nlist = allocNETLIST();
 	nlist->net = net;
 	nlist->next = FailedNets;
 	FailedNets = nlist;
-	free(rt1);
+	freeROUTE(rt1);
      }
      else {
 
@@ -1666,12 +1700,14 @@ int doroute(NET net, u_char stage, u_char graphdebug)
   }
 
   /* Finished routing (or error occurred) */
+  antenna_cost_net(NULL);
   free_glist(&iroute);
+  trimPOINTStore();
 
   /* Route failure due to no taps or similar error---Log it */
   if ((result < 0) || (unroutable > 0)) {
      if ((FailedNets == NULL) || (FailedNets->net != net)) {
-	nlist = (NETLIST)malloc(sizeof(struct netlist_));
+	nlist = allocNETLIST();
 	nlist->net = net;
 	nlist->next = FailedNets;
 	FailedNets = nlist;
@@ -1805,8 +1841,9 @@ static int next_route_setup(struct routeinfo_ *iroute, u_char stage)
 
 static int route_setup(struct routeinfo_ *iroute, u_char stage)
 {
-  int  i, j;
-  u_int netnum, dir;
+  int  i;
+  gindex j;
+  obsword netnum, dir;
   int  result, rval, unroutable;
   NODE node;
   NODEINFO lnode;
@@ -1816,7 +1853,7 @@ static int route_setup(struct routeinfo_ *iroute, u_char stage)
   // terminal positions for the net being routed.
 
   for (i = 0; i < Num_layers; i++) {
-      for (j = 0; j < NumChannelsX * NumChannelsY; j++) {
+      for (j = 0; j < NUMCHANNELS; j++) {
 	  netnum = Obs[i][j] & (~BLOCKED_MASK);
 	  Pr = &Obs2[i][j];
 	  if (netnum != 0) {
@@ -2018,7 +2055,7 @@ int route_segs(struct routeinfo_ *iroute, u_char stage, u_char graphdebug)
   POINT gpoint, gunproc, newpt;
   int  i, o;
   int  pass, maskpass;
-  u_int forbid;
+  obsword forbid;
   GRIDP best, curpt;
   int rval;
   u_char first = TRUE;
@@ -2138,7 +2175,7 @@ int route_segs(struct routeinfo_ *iroute, u_char stage, u_char graphdebug)
 	 // is not under the current route mask, which identifies a narrow
 	 // "best route" solution.
 
-	 if (RMASK(curpt.x, curpt.y) > (u_char)maskpass) {
+	 if (MASKVAL(curpt.x, curpt.y) > (u_char)maskpass) {
 	    gpoint->next = gunproc;
 	    gunproc = gpoint;
 	    continue;
@@ -2280,6 +2317,7 @@ int route_segs(struct routeinfo_ *iroute, u_char stage, u_char graphdebug)
 	curpt.x = best.x;
 	curpt.y = best.y;
 	curpt.lay = best.lay;
+	iroute->net->flags |= NET_DIRTY | NET_RC_DIRTY;
 	if ((rval = commit_proute(iroute->rt, &curpt, stage)) != 1) break;
 	if (Verbose > 2) {
 	   Fprintf(stdout, "\nCommit to a route of cost %d\n", best.cost);
@@ -2338,7 +2376,7 @@ done:
 /* createemptyroute - begin a ROUTE structure			*/
 /*								*/
 /*   ARGS: a nodes						*/
-/*   RETURNS: ROUTE calloc'd and ready to begin			*/
+/*   RETURNS: ROUTE allocated and ready to begin		*/
 /*   SIDE EFFECTS: 						*/
 /*   AUTHOR and DATE: steve beccue      Fri Aug 8		*/
 /*--------------------------------------------------------------*/
@@ -2347,7 +2385,7 @@ ROUTE createemptyroute(void)
 {
    ROUTE rt;
 
-   rt = (ROUTE)calloc(1, sizeof(struct route_));
+   rt = allocROUTE();
    rt->netnum = 0;
    rt->segments = (SEG)NULL;
    rt->flags = (u_char)0;
@@ -2381,6 +2419,7 @@ static void helpmessage(void)
 	Fprintf(stdout, "switches:\n");
 	Fprintf(stdout, "\t-c <file>\t\t\tConfiguration file name if not route.cfg.\n");
 	Fprintf(stdout, "\t-d <file>\t\t\tGenerate delay information output.\n");
+	Fprintf(stdout, "\t         \t\t\t(SPEF if <file> ends in .spef.)\n");
 	Fprintf(stdout, "\t-v <level>\t\t\tVerbose output level.\n");
 	Fprintf(stdout, "\t-i <file>\t\t\tPrint route names and pitches and exit.\n");
 	Fprintf(stdout, "\t-p <name>\t\t\tSpecify global power bus name.\n");
@@ -2388,6 +2427,7 @@ static void helpmessage(void)
 	Fprintf(stdout, "\t-r <value>\t\t\tForce output resolution scale.\n");
 	Fprintf(stdout, "\t-f       \t\t\tForce all pins to be routable.\n");
 	Fprintf(stdout, "\t-e <level>\t\t\tLevel of effort to keep trying.\n");
+	Fprintf(stdout, "\t-t <number>\t\t\tNumber of threads (default one per CPU).\n");
 	Fprintf(stdout, "\n");
     }
 #ifdef TCL_QROUTER
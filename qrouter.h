@@ -7,7 +7,11 @@
 
 #ifndef QROUTER_H
 
+#ifdef WIDE_GRID
+#define OGRID(x, y) ((long)(x) + ((long)(y) * (long)NumChannelsX))
+#else
 #define OGRID(x, y) ((int)((x) + ((y) * NumChannelsX)))
+#endif
 #define MIN(x, y) (((x) < (y)) ? (x) : (y))
 #define MAX(x, y) (((x) > (y)) ? (x) : (y))
 #define ABSDIFF(x, y) (((x) > (y)) ? ((x) - (y)) : ((y) - (x)))
@@ -39,6 +43,24 @@ typedef unsigned long  u_long;
 #endif
 #endif /* _SYS_TYPES_H */
 
+/* Grid cell types.  A grid index (gindex) addresses one cell of a	*/
+/* layer plane, and an obstruction word (obsword) holds the net number	*/
+/* and flags of one cell of Obs[].  Compiling with WIDE_GRID (configure	*/
+/* --enable-wide-grid) makes both 64 bits wide, for grids with more	*/
+/* than 2^31 cells per layer and netlists of more than 4M nets, at the	*/
+/* cost of doubling the size of Obs[].					*/
+
+#ifdef WIDE_GRID
+typedef long gindex;
+typedef unsigned long long obsword;
+#else
+typedef int gindex;
+typedef u_int obsword;
+#endif
+
+/* Number of cells in one layer of the grid */
+#define NUMCHANNELS	((gindex)NumChannelsX * (gindex)NumChannelsY)
+
 /* Compare functions aren't defined in the Mac's standard library */
 #if defined(__APPLE__) || defined(__FreeBSD__) || defined(__OpenBSD__)
 typedef int (*__compar_fn_t)(const void*, const void*);
@@ -122,7 +144,7 @@ struct proute_ {        // partial route
    u_short flags; 	// values PR_PROCESSED and PR_CONFLICT, and others
    union {
       u_int cost;	// cost of route coming from predecessor
-      u_int net;	// net number at route point
+      obsword net;	// net number at route point
    } prdata;
 };
 
@@ -274,6 +296,8 @@ struct node_ {
   int     numnodes;		// number of nodes on this net
   int	  branchx;		// position of the node branch in x
   int	  branchy;		// position of the node branch in y
+  struct gate_ *gate;		// gate instance this node is a pin of
+  int	  gateidx;		// index of the node in the gate's noderec
 };
 
 // these are instances of gates in the netlist.  The description of a 
@@ -300,16 +324,6 @@ struct gate_ {
     int orient;
 };
 
-// Define record holding information pointing to a gate and the
-// index into a specific node of that gate.
-
-typedef struct gatenode_ *GATENODE;
-
-struct gatenode_ {
-    GATE gate;
-    int idx;
-};
-
 // Structure for a network to be routed
 
 typedef struct net_ *NET;
@@ -331,6 +345,9 @@ struct net_ {
 			// route this net.  This will not be allowed
 			// a second time, to avoid looping.
    ROUTE   routes;	// routes for this net
+   long long defpos[2];	// Offset of the route text (NETS, SPECIALNETS)
+   long    deflen[2];	// in the last DEF file written, and its length
+   struct netrc_ *rc;	// R and C of the routes (see delays.c)
 };
 
 // Flags used by NET "flags" record
@@ -340,6 +357,17 @@ struct net_ {
 #define NET_IGNORED  		4	// net is ignored by router
 #define NET_STUB     		8	// Net has at least one stub
 #define NET_VERTICAL_TRUNK	16	// Trunk line is (preferred) vertical
+#define NET_DIRTY		32	// Routes changed since last DEF output
+#define NET_RC_DIRTY		64	// Routes changed since last R, C extraction
+
+// R and C from the driver of a net to one of its receivers, as
+// found by the delay calculation (see delays.c)
+
+typedef struct rcsink_ {
+   NODE   node;		// receiver node
+   double res;		// resistance of the routes from the driver
+   double delay;	// Elmore delay of the routes from the driver
+} RCSINK;
 
 // List of nets, used to maintain a list of failed routes
 
@@ -374,31 +402,48 @@ struct routeinfo_ {
 // The Stub[] vector indicates the distance needed to avoid the obstruction.
 //
 // The maximum number of nets must not overrun the area used by flags, so
-// the maximum number of nets is 0x3fffff, or 4,194,303 nets
-
-#define OFFSET_TAP	((u_int)0x80000000)  // tap position needs to be offset
-#define STUBROUTE	((u_int)0x40000000)  // route stub to reach terminal
-#define PINOBSTRUCTMASK	((u_int)0xc0000000)  // either offset tap or stub route
-#define NO_NET		((u_int)0x20000000)  // indicates a non-routable obstruction
-#define ROUTED_NET	((u_int)0x10000000)  // indicates position occupied by a routed
-
-#define BLOCKED_N	((u_int)0x08000000)  // grid point cannot be routed from the N
-#define BLOCKED_S	((u_int)0x04000000)  // grid point cannot be routed from the S
-#define BLOCKED_E	((u_int)0x02000000)  // grid point cannot be routed from the E
-#define BLOCKED_W	((u_int)0x01000000)  // grid point cannot be routed from the W
-#define BLOCKED_U	((u_int)0x00800000)  // grid point cannot be routed from top
-#define BLOCKED_D	((u_int)0x00400000)  // grid point cannot be routed from bottom
-#define BLOCKED_MASK	((u_int)0x0fc00000)
-#define OBSTRUCT_MASK	((u_int)0x0000000f)  // with NO_NET, directional obstruction
-#define OBSTRUCT_N	((u_int)0x00000008)  // Tells where the obstruction is
-#define OBSTRUCT_S	((u_int)0x00000004)  // relative to the grid point.  Nodeinfo
-#define OBSTRUCT_E	((u_int)0x00000002)  // offset contains distance to grid point
-#define OBSTRUCT_W	((u_int)0x00000001)
-#define MAX_NETNUMS	((u_int)0x003fffff)  // Maximum net number
-
-#define NETNUM_MASK	((u_int)0x203fffff)  // Mask for the net number field
+// the maximum number of nets is 0x3fffff, or 4,194,303 nets.  In the
+// WIDE_GRID build the flags occupy the upper 32 bits of the obstruction
+// word, and the net number may use any positive int value.  OBSTRUCT_*
+// share the net number field and are only meaningful with NO_NET set.
+
+#ifdef WIDE_GRID
+#define OBSFLAG(f)	((obsword)(f) << 32)
+#else
+#define OBSFLAG(f)	((obsword)(f))
+#endif
+
+#define OFFSET_TAP	OBSFLAG(0x80000000)  // tap position needs to be offset
+#define STUBROUTE	OBSFLAG(0x40000000)  // route stub to reach terminal
+#define PINOBSTRUCTMASK	OBSFLAG(0xc0000000)  // either offset tap or stub route
+#define NO_NET		OBSFLAG(0x20000000)  // indicates a non-routable obstruction
+#define ROUTED_NET	OBSFLAG(0x10000000)  // indicates position occupied by a routed
+
+#define BLOCKED_N	OBSFLAG(0x08000000)  // grid point cannot be routed from the N
+#define BLOCKED_S	OBSFLAG(0x04000000)  // grid point cannot be routed from the S
+#define BLOCKED_E	OBSFLAG(0x02000000)  // grid point cannot be routed from the E
+#define BLOCKED_W	OBSFLAG(0x01000000)  // grid point cannot be routed from the W
+#define BLOCKED_U	OBSFLAG(0x00800000)  // grid point cannot be routed from top
+#define BLOCKED_D	OBSFLAG(0x00400000)  // grid point cannot be routed from bottom
+#define BLOCKED_MASK	OBSFLAG(0x0fc00000)
+#define OBSTRUCT_MASK	((obsword)0x0000000f)  // with NO_NET, directional obstruction
+#define OBSTRUCT_N	((obsword)0x00000008)  // Tells where the obstruction is
+#define OBSTRUCT_S	((obsword)0x00000004)  // relative to the grid point.  Nodeinfo
+#define OBSTRUCT_E	((obsword)0x00000002)  // offset contains distance to grid point
+#define OBSTRUCT_W	((obsword)0x00000001)
+
+#ifdef WIDE_GRID
+#define MAX_NETNUMS	((obsword)0x7fffffff) // Maximum net number
+#define NETNUM_FIELD	((obsword)0xffffffff) // Net number field, unshifted
+#else
+#define MAX_NETNUMS	((obsword)0x003fffff) // Maximum net number
+#define NETNUM_FIELD	((obsword)0x003fffff) // Net number field, unshifted
+#endif
+
+#define NETNUM_MASK	(NO_NET | NETNUM_FIELD)	     // Mask for the net number field
 					     // (includes NO_NET)
-#define ROUTED_NET_MASK ((u_int)0x303fffff)  // Mask for the net number field
+#define ROUTED_NET_MASK (NO_NET | ROUTED_NET | NETNUM_FIELD)
+					     // Mask for the net number field
 					     // (includes NO_NET and ROUTED_NET)
 #define DRC_BLOCKAGE	(NO_NET | ROUTED_NET) // Special case
 
@@ -450,7 +495,7 @@ extern GATE   Nlgates;
 extern NET    *Nlnets;
 
 extern u_char *RMask;
-extern u_int  *Obs[MAX_LAYERS];		// obstructions by layer, y, x
+extern obsword *Obs[MAX_LAYERS];		// obstructions by layer, y, x
 extern PROUTE *Obs2[MAX_LAYERS]; 	// working copy of Obs 
 extern ObsInfoRec *Obsinfo[MAX_LAYERS];	// temporary detailed obstruction info
 extern NODEINFO *Nodeinfo[MAX_LAYERS];	// stub route distances to pins and
@@ -464,6 +509,16 @@ extern NODEINFO *Nodeinfo[MAX_LAYERS];	// stub route distances to pins and
 #define RMASK(x, y)      (RMask[OGRID(x, y)])
 #define CONGEST(x, y)	 (Congestion[OGRID(x, y)])
 
+/* Only the area MaskArea of RMask[] is set for the current net (see	*/
+/* mask.c);  everything outside of it has the value MaskFill.		*/
+
+extern struct seg_ MaskArea;
+extern u_char MaskFill;
+
+#define MASKVAL(x, y)	 (((x) < MaskArea.x1 || (x) > MaskArea.x2 || \
+			   (y) < MaskArea.y1 || (y) > MaskArea.y2) ? \
+			   MaskFill : RMASK(x, y))
+
 extern DSEG  UserObs;			// user-defined obstruction layers
 
 extern u_char needblock[MAX_LAYERS];
@@ -475,6 +530,7 @@ extern u_char Verbose;
 extern u_char forceRoutable;
 extern u_char maskMode;
 extern u_char mapType;
+extern int    Numthreads;
 extern u_char ripLimit;
 extern u_char unblockAll;
 
@@ -501,6 +557,7 @@ int route_segs(struct routeinfo_ *iroute, u_char stage, u_char graphdebug);
 ROUTE createemptyroute(void);
 
 int    set_num_channels(void);
+int    thread_count(void);
 int    allocate_obs_array(void);
 int    countlist(NETLIST net);
 int    runqrouter(int argc, char *argv[]);
@@ -511,21 +568,24 @@ char  *get_annotate_info(NET net, char **pinptr);
 
 void   free_glist(struct routeinfo_ *iroute);
 
-#ifdef TCL_QROUTER
 void   find_free_antenna_taps(char *antennacell);
-#endif
 
 void   resolve_antenna(char *antennacell, u_char do_fix);
+void   antenna_cost_net(NET net);
+extern u_short **AntennaRun;
+extern int AntennaRunLimit[MAX_LAYERS];
 
 void   createMask(NET net, u_char slack, u_char halo);
 void   createBboxMask(NET net, u_char halo);
+void   createBoxMask(int xmin, int ymin, int xmax, int ymax, u_char halo);
 
 int    read_def(char *filename);
 
-#ifdef TCL_QROUTER
 int    write_delays(char *filename);
+int    write_delays_incremental(char *filename);
+int    get_net_delays(NET net, double *totalcap, RCSINK **sinks);
+void   free_net_delays(NET net);
 int    write_spef(char *filename);
-#endif
 
 int    dofirststage(u_char graphdebug, int debug_netnum);
 int    dosecondstage(u_char graphdebug, u_char singlestep,
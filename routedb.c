@@ -0,0 +1,629 @@
+/*--------------------------------------------------------------*/
+/* routedb.c --							*/
+/*								*/
+/* Binary route database.  The routes of all nets are saved in	*/
+/* grid coordinates, with the start and end of each route	*/
+/* recorded as an index into the net's node list or route list,	*/
+/* so that they can be put back without parsing DEF text and	*/
+/* without searching for route endpoints.			*/
+/*								*/
+/* The file is laid out so that it can be used directly from	*/
+/* memory:  a header, an index of nets sorted by name, the	*/
+/* route and segment records of each net, and a table of net	*/
+/* names.  Loading the routes of a few nets reads only their	*/
+/* index entries and records.					*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef HAVE_SYS_MMAN_H
+#include <sys/stat.h>
+#include <sys/mman.h>
+#endif
+
+#include "qrouter.h"
+#include "qconfig.h"
+#include "maze.h"
+#include "def.h"
+#include "pool.h"
+#include "routedb.h"
+
+#define ROUTEDB_MAGIC	  "qrroute"
+#define ROUTEDB_VERSION	  1
+#define ROUTEDB_BYTEORDER 0x01020304
+
+/* File header */
+
+typedef struct {
+    char      magic[8];
+    int       version;
+    int       byteorder;
+    int       numchannelsx;	/* Grid dimensions the routes	*/
+    int       numchannelsy;	/* were made on			*/
+    int       numlayers;
+    int       numnets;		/* Number of index entries	*/
+    long long names;		/* Offset of the net name table	*/
+} RouteDBHeader;
+
+/* Index entry for one net.  Entries are sorted by net name. */
+
+typedef struct {
+    int       name;		/* Offset in the net name table	*/
+    int       netnum;
+    int       numroutes;
+    int       numsegs;
+    long long data;		/* Offset of the route records,	*/
+				/* followed by the segments	*/
+} RouteDBNet;
+
+/* Route record.  "start" and "end" index the net's node list	*/
+/* if RT_START_NODE or RT_END_NODE is set in "flags", and the	*/
+/* net's route list otherwise;  -1 if not connected.		*/
+
+typedef struct {
+    int       start;
+    int       end;
+    int       numsegs;
+    u_char    flags;
+    u_char    pad[3];
+} RouteDBRoute;
+
+typedef struct {
+    int       x1, y1, x2, y2;
+    u_char    layer;
+    u_char    segtype;
+    u_char    pad[2];
+} RouteDBSeg;
+
+/* Route flags that are saved;  the others are transient */
+
+#define ROUTEDB_FLAGS	(RT_STUB | RT_START_NODE | RT_END_NODE)
+
+#define ROUTEDB_ALIGN(n)	(((n) + 7) & ~(long long)7)
+
+/* A route database file opened for reading */
+
+typedef struct {
+    char   *base;
+    size_t  size;
+    size_t  maplen;		/* Nonzero if "base" is mapped	*/
+    RouteDBHeader *header;
+    RouteDBNet    *index;
+    char   *names;
+} RouteDB;
+
+/*--------------------------------------------------------------*/
+/* Position of route "rt" in the route list of "net", or -1.	*/
+/*--------------------------------------------------------------*/
+
+static int
+rdb_route_index(NET net, ROUTE rt)
+{
+    ROUTE r;
+    int i;
+
+    if (rt == NULL) return -1;
+    for (r = net->routes, i = 0; r; r = r->next, i++)
+	if (r == rt) return i;
+    return -1;
+}
+
+/*--------------------------------------------------------------*/
+/* Position of "node" in the node list of "net", or -1.		*/
+/*--------------------------------------------------------------*/
+
+static int
+rdb_node_index(NET net, NODE node)
+{
+    NODE n;
+    int i;
+
+    if (node == NULL) return -1;
+    for (n = net->netnodes, i = 0; n; n = n->next, i++)
+	if (n == node) return i;
+    return -1;
+}
+
+static int
+rdb_compare_nets(const void *a, const void *b)
+{
+    NET net1 = *((NET *)a);
+    NET net2 = *((NET *)b);
+
+    return strcmp(net1->netname, net2->netname);
+}
+
+/*--------------------------------------------------------------*/
+/* write_routedb() ---						*/
+/*								*/
+/* Save the routes of all nets that have any to the binary	*/
+/* route database "filename".					*/
+/*								*/
+/* Results:							*/
+/*	0 on success, -1 if the file cannot be written.		*/
+/*--------------------------------------------------------------*/
+
+int
+write_routedb(char *filename)
+{
+    FILE *f;
+    NET net, *nets;
+    ROUTE rt;
+    SEG seg;
+    RouteDBHeader header;
+    RouteDBNet *index;
+    RouteDBRoute *routes;
+    RouteDBSeg *segs;
+    char *buf = NULL;
+    size_t bufsize = 0, datasize;
+    long long offset, nameoffset;
+    int numnets, i, r, s, result;
+    static char zeros[8];
+
+    if (Nlnets == NULL) {
+	Fprintf(stderr, "write_routedb():  No nets to write.\n");
+	return -1;
+    }
+
+    f = fopen(filename, "wb");
+    if (f == NULL) {
+	Fprintf(stderr, "write_routedb():  Couldn't open file %s for writing.\n",
+		filename);
+	return -1;
+    }
+
+    nets = (NET *)malloc(((Numnets > 0) ? Numnets : 1) * sizeof(NET));
+    numnets = 0;
+    for (i = 0; i < Numnets; i++)
+	if (Nlnets[i]->routes != NULL)
+	    nets[numnets++] = Nlnets[i];
+    qsort(nets, numnets, sizeof(NET), rdb_compare_nets);
+
+    /* Lay out the index */
+
+    index = (RouteDBNet *)calloc((numnets > 0) ? numnets : 1,
+		sizeof(RouteDBNet));
+    offset = sizeof(RouteDBHeader) + (long long)numnets * sizeof(RouteDBNet);
+    nameoffset = 0;
+    for (i = 0; i < numnets; i++) {
+	net = nets[i];
+	index[i].name = (int)nameoffset;
+	index[i].netnum = net->netnum;
+	for (rt = net->routes; rt; rt = rt->next) {
+	    index[i].numroutes++;
+	    for (seg = rt->segments; seg; seg = seg->next)
+		index[i].numsegs++;
+	}
+	index[i].data = offset;
+	offset += ROUTEDB_ALIGN((long long)index[i].numroutes * sizeof(RouteDBRoute)
+		+ (long long)index[i].numsegs * sizeof(RouteDBSeg));
+	nameoffset += strlen(net->netname) + 1;
+    }
+
+    memset(&header, 0, sizeof(RouteDBHeader));
+    strcpy(header.magic, ROUTEDB_MAGIC);
+    header.version = ROUTEDB_VERSION;
+    header.byteorder = ROUTEDB_BYTEORDER;
+    header.numchannelsx = NumChannelsX;
+    header.numchannelsy = NumChannelsY;
+    header.numlayers = Num_layers;
+    header.numnets = numnets;
+    header.names = offset;
+
+    fwrite(&header, sizeof(RouteDBHeader), 1, f);
+    fwrite(index, sizeof(RouteDBNet), numnets, f);
+
+    /* Route and segment records of each net */
+
+    for (i = 0; i < numnets; i++) {
+	net = nets[i];
+	datasize = (size_t)index[i].numroutes * sizeof(RouteDBRoute)
+		+ (size_t)index[i].numsegs * sizeof(RouteDBSeg);
+	if (datasize > bufsize) {
+	    bufsize = datasize;
+	    buf = (char *)realloc(buf, bufsize);
+	}
+	memset(buf, 0, datasize);
+	routes = (RouteDBRoute *)buf;
+	segs = (RouteDBSeg *)(buf + (size_t)index[i].numroutes
+		* sizeof(RouteDBRoute));
+
+	for (rt = net->routes, r = 0, s = 0; rt; rt = rt->next, r++) {
+	    routes[r].flags = rt->flags & ROUTEDB_FLAGS;
+	    if (rt->flags & RT_START_NODE)
+		routes[r].start = rdb_node_index(net, rt->start.node);
+	    else
+		routes[r].start = rdb_route_index(net, rt->start.route);
+	    if (rt->flags & RT_END_NODE)
+		routes[r].end = rdb_node_index(net, rt->end.node);
+	    else
+		routes[r].end = rdb_route_index(net, rt->end.route);
+
+	    for (seg = rt->segments; seg; seg = seg->next, s++) {
+		segs[s].x1 = seg->x1;
+		segs[s].y1 = seg->y1;
+		segs[s].x2 = seg->x2;
+		segs[s].y2 = seg->y2;
+		segs[s].layer = (u_char)seg->layer;
+		segs[s].segtype = seg->segtype;
+		routes[r].numsegs++;
+	    }
+	}
+	fwrite(buf, 1, datasize, f);
+	if (ROUTEDB_ALIGN(datasize) > datasize)
+	    fwrite(zeros, 1, ROUTEDB_ALIGN(datasize) - datasize, f);
+    }
+
+    /* Net name table */
+
+    for (i = 0; i < numnets; i++)
+	fwrite(nets[i]->netname, 1, strlen(nets[i]->netname) + 1, f);
+
+    result = (ferror(f)) ? -1 : 0;
+    if (fclose(f) != 0) result = -1;
+    if (result != 0)
+	Fprintf(stderr, "write_routedb():  Error writing file %s.\n", filename);
+    else if (Verbose > 0)
+	Fprintf(stdout, "Wrote routes of %d nets to %s.\n", numnets, filename);
+
+    free(buf);
+    free(index);
+    free(nets);
+    return result;
+}
+
+/*--------------------------------------------------------------*/
+/* Open a route database and check its header.  Returns 0 on	*/
+/* success, or -1 if the file cannot be read or does not match	*/
+/* the current routing grid.					*/
+/*--------------------------------------------------------------*/
+
+static int
+rdb_open(char *filename, RouteDB *db)
+{
+    FILE *f;
+    RouteDBHeader *header;
+    size_t alloc, n;
+
+    f = fopen(filename, "rb");
+    if (f == NULL) {
+	Fprintf(stderr, "read_routedb():  Couldn't open file %s.\n", filename);
+	return -1;
+    }
+
+    db->base = NULL;
+    db->size = 0;
+    db->maplen = 0;
+
+#ifdef HAVE_SYS_MMAN_H
+    {
+	struct stat st;
+	void *map;
+
+	if ((fstat(fileno(f), &st) == 0) && S_ISREG(st.st_mode) &&
+		(st.st_size > 0)) {
+	    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE,
+			fileno(f), 0);
+	    if (map != MAP_FAILED) {
+		db->base = (char *)map;
+		db->size = db->maplen = (size_t)st.st_size;
+	    }
+	}
+    }
+#endif
+
+    if (db->base == NULL) {
+	alloc = 0;
+	do {
+	    if (db->size == alloc) {
+		alloc = (alloc == 0) ? 65536 : alloc * 2;
+		db->base = (char *)realloc(db->base, alloc);
+	    }
+	    n = fread(db->base + db->size, 1, alloc - db->size, f);
+	    db->size += n;
+	} while (n > 0);
+    }
+    fclose(f);
+
+    header = (RouteDBHeader *)db->base;
+    if ((db->size < sizeof(RouteDBHeader)) ||
+		strncmp(header->magic, ROUTEDB_MAGIC, 8) ||
+		(header->version != ROUTEDB_VERSION) ||
+		(header->byteorder != ROUTEDB_BYTEORDER) ||
+		(header->numnets < 0) ||
+		((size_t)header->numnets > (db->size - sizeof(RouteDBHeader))
+			/ sizeof(RouteDBNet)) ||
+		(header->names < (long long)(sizeof(RouteDBHeader) +
+			(size_t)header->numnets * sizeof(RouteDBNet))) ||
+		(header->names > (long long)db->size) ||
+		((header->numnets > 0) && (db->base[db->size - 1] != '\0'))) {
+	Fprintf(stderr, "read_routedb():  %s is not a valid route database.\n",
+		filename);
+	goto fail;
+    }
+    if ((header->numchannelsx != NumChannelsX) ||
+		(header->numchannelsy != NumChannelsY) ||
+		(header->numlayers != Num_layers)) {
+	Fprintf(stderr, "read_routedb():  Routes in %s were made on a "
+		"%d x %d x %d grid, but the grid is %d x %d x %d.\n",
+		filename, header->numchannelsx, header->numchannelsy,
+		header->numlayers, NumChannelsX, NumChannelsY, Num_layers);
+	goto fail;
+    }
+
+    db->header = header;
+    db->index = (RouteDBNet *)(db->base + sizeof(RouteDBHeader));
+    db->names = db->base + header->names;
+    return 0;
+
+fail:
+#ifdef HAVE_SYS_MMAN_H
+    if (db->maplen > 0) {
+	munmap((void *)db->base, db->maplen);
+	return -1;
+    }
+#endif
+    free(db->base);
+    return -1;
+}
+
+static void
+rdb_close(RouteDB *db)
+{
+#ifdef HAVE_SYS_MMAN_H
+    if (db->maplen > 0) {
+	munmap((void *)db->base, db->maplen);
+	return;
+    }
+#endif
+    free(db->base);
+}
+
+/* Name of the net of index entry "entry", or NULL if out of bounds */
+
+static char *
+rdb_net_name(RouteDB *db, RouteDBNet *entry)
+{
+    if ((entry->name < 0) || ((long long)entry->name >=
+		(long long)db->size - db->header->names))
+	return NULL;
+    return db->names + entry->name;
+}
+
+/* Find the index entry for net name "name" */
+
+static RouteDBNet *
+rdb_find_net(RouteDB *db, char *name)
+{
+    int lo, hi, mid, cmp;
+    char *entryname;
+
+    lo = 0;
+    hi = db->header->numnets - 1;
+    while (lo <= hi) {
+	mid = (lo + hi) >> 1;
+	entryname = rdb_net_name(db, &db->index[mid]);
+	if (entryname == NULL) return NULL;
+	cmp = strcmp(name, entryname);
+	if (cmp == 0)
+	    return &db->index[mid];
+	else if (cmp < 0)
+	    hi = mid - 1;
+	else
+	    lo = mid + 1;
+    }
+    return NULL;
+}
+
+/*--------------------------------------------------------------*/
+/* rdb_load_net() ---						*/
+/*								*/
+/* Replace the routes of "net" with the routes recorded in the	*/
+/* index entry "entry", and write them into the Obs array.	*/
+/* The records are checked before the net is changed.		*/
+/*								*/
+/* Results:							*/
+/*	0 on success, -1 if the records are not valid.		*/
+/*--------------------------------------------------------------*/
+
+static int
+rdb_load_net(RouteDB *db, RouteDBNet *entry, NET net)
+{
+    RouteDBRoute *routes;
+    RouteDBSeg *segs;
+    ROUTE rt, lastrt, *rtlist;
+    SEG seg, lastseg;
+    NODE node, *nodelist;
+    int numnodes, i, r, s, total;
+    long long datasize;
+
+    if ((entry->numroutes <= 0) || (entry->numsegs <= 0) ||
+		(entry->data < (long long)sizeof(RouteDBHeader)) ||
+		(entry->data & 7))
+	return -1;
+    datasize = (long long)entry->numroutes * sizeof(RouteDBRoute)
+		+ (long long)entry->numsegs * sizeof(RouteDBSeg);
+    if (entry->data + datasize > db->header->names) return -1;
+
+    routes = (RouteDBRoute *)(db->base + entry->data);
+    segs = (RouteDBSeg *)(db->base + entry->data
+		+ (long long)entry->numroutes * sizeof(RouteDBRoute));
+
+    for (numnodes = 0, node = net->netnodes; node; node = node->next)
+	numnodes++;
+
+    total = 0;
+    for (r = 0; r < entry->numroutes; r++) {
+	if ((routes[r].numsegs <= 0) ||
+		(routes[r].numsegs > entry->numsegs - total))
+	    return -1;
+	if (routes[r].start >= ((routes[r].flags & RT_START_NODE) ?
+		numnodes : entry->numroutes))
+	    return -1;
+	if (routes[r].end >= ((routes[r].flags & RT_END_NODE) ?
+		numnodes : entry->numroutes))
+	    return -1;
+	if (((routes[r].flags & RT_START_NODE) && (routes[r].start < 0)) ||
+		((routes[r].flags & RT_END_NODE) && (routes[r].end < 0)))
+	    return -1;
+	total += routes[r].numsegs;
+    }
+    if (total != entry->numsegs) return -1;
+
+    for (s = 0; s < entry->numsegs; s++) {
+	if ((segs[s].layer >= Num_layers) ||
+		(segs[s].x1 < 0) || (segs[s].x1 >= NumChannelsX) ||
+		(segs[s].x2 < 0) || (segs[s].x2 >= NumChannelsX) ||
+		(segs[s].y1 < 0) || (segs[s].y1 >= NumChannelsY) ||
+		(segs[s].y2 < 0) || (segs[s].y2 >= NumChannelsY))
+	    return -1;
+	if ((segs[s].segtype & ST_VIA) && (segs[s].layer + 1 >= Num_layers))
+	    return -1;
+    }
+
+    /* Records are good;  replace the routes of the net */
+
+    if (net->routes != NULL)
+	ripup_net(net, TRUE, FALSE, FALSE);
+
+    nodelist = (NODE *)malloc(((numnodes > 0) ? numnodes : 1) * sizeof(NODE));
+    for (i = 0, node = net->netnodes; node; node = node->next)
+	nodelist[i++] = node;
+    rtlist = (ROUTE *)malloc(entry->numroutes * sizeof(ROUTE));
+
+    lastrt = NULL;
+    for (r = 0, s = 0; r < entry->numroutes; r++) {
+	rt = allocROUTE();
+	rt->next = NULL;
+	rt->netnum = net->netnum;
+	rt->flags = routes[r].flags & ROUTEDB_FLAGS;
+	rt->segments = NULL;
+	rtlist[r] = rt;
+	if (lastrt == NULL)
+	    net->routes = rt;
+	else
+	    lastrt->next = rt;
+	lastrt = rt;
+
+	lastseg = NULL;
+	for (i = 0; i < routes[r].numsegs; i++, s++) {
+	    seg = allocSEG();
+	    seg->next = NULL;
+	    seg->layer = segs[s].layer;
+	    seg->x1 = segs[s].x1;
+	    seg->y1 = segs[s].y1;
+	    seg->x2 = segs[s].x2;
+	    seg->y2 = segs[s].y2;
+	    seg->segtype = segs[s].segtype;
+	    if (lastseg == NULL)
+		rt->segments = seg;
+	    else
+		lastseg->next = seg;
+	    lastseg = seg;
+	}
+    }
+
+    for (r = 0; r < entry->numroutes; r++) {
+	rt = rtlist[r];
+	if (rt->flags & RT_START_NODE)
+	    rt->start.node = nodelist[routes[r].start];
+	else
+	    rt->start.route = (routes[r].start >= 0) ?
+			rtlist[routes[r].start] : NULL;
+	if (rt->flags & RT_END_NODE)
+	    rt->end.node = nodelist[routes[r].end];
+	else
+	    rt->end.route = (routes[r].end >= 0) ?
+			rtlist[routes[r].end] : NULL;
+    }
+
+    free(rtlist);
+    free(nodelist);
+
+    writeback_all_routes(net);
+    return 0;
+}
+
+/*--------------------------------------------------------------*/
+/* read_routedb() ---						*/
+/*								*/
+/* Load routes from the binary route database "filename".  If	*/
+/* "numnames" is zero, the routes of every net in the database	*/
+/* are loaded;  otherwise only those of the nets named in	*/
+/* "netnames".  Nets that are loaded have their current routes	*/
+/* ripped up first.  Other nets are not changed.		*/
+/*								*/
+/* Results:							*/
+/*	Number of nets loaded, or -1 if the database cannot be	*/
+/*	used.							*/
+/*--------------------------------------------------------------*/
+
+int
+read_routedb(char *filename, char **netnames, int numnames)
+{
+    RouteDB db;
+    RouteDBNet *entry;
+    NET net;
+    char *name;
+    int i, loaded = 0;
+
+    if ((Nlnets == NULL) || (Obs[0] == NULL)) {
+	Fprintf(stderr, "read_routedb():  No DEF file has been read.\n");
+	return -1;
+    }
+    if (rdb_open(filename, &db) != 0) return -1;
+
+    if (numnames == 0) {
+	for (i = 0; i < db.header->numnets; i++) {
+	    entry = &db.index[i];
+	    name = rdb_net_name(&db, entry);
+	    if (name == NULL) {
+		Fprintf(stderr, "read_routedb():  Bad net name in %s.\n",
+			filename);
+		continue;
+	    }
+	    net = DefFindNet(name);
+	    if (net == NULL) {
+		Fprintf(stderr, "read_routedb():  No net %s in the design.\n",
+			name);
+		continue;
+	    }
+	    if (rdb_load_net(&db, entry, net) != 0)
+		Fprintf(stderr, "read_routedb():  Bad route records for "
+			"net %s.\n", name);
+	    else
+		loaded++;
+	}
+    }
+    else {
+	for (i = 0; i < numnames; i++) {
+	    net = DefFindNet(netnames[i]);
+	    if (net == NULL) {
+		Fprintf(stderr, "read_routedb():  No net %s in the design.\n",
+			netnames[i]);
+		continue;
+	    }
+	    entry = rdb_find_net(&db, net->netname);
+	    if (entry == NULL) {
+		Fprintf(stderr, "read_routedb():  No routes for net %s in %s.\n",
+			net->netname, filename);
+		continue;
+	    }
+	    if (rdb_load_net(&db, entry, net) != 0)
+		Fprintf(stderr, "read_routedb():  Bad route records for "
+			"net %s.\n", net->netname);
+	    else
+		loaded++;
+	}
+    }
+
+    rdb_close(&db);
+
+    if (Verbose > 0)
+	Fprintf(stdout, "Loaded routes of %d nets from %s.\n", loaded, filename);
+    return loaded;
+}
+
+/* end of routedb.c */
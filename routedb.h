@@ -0,0 +1,14 @@
+/*
+ * routedb.h --
+ *
+ * This file includes the binary route database functions
+ *
+ */
+
+#ifndef _ROUTEDBINT_H
+#define _ROUTEDBINT_H
+
+int    write_routedb(char *filename);
+int    read_routedb(char *filename, char **netnames, int numnames);
+
+#endif /* _ROUTEDBINT_H */
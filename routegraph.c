@@ -0,0 +1,336 @@
+/*--------------------------------------------------------------*/
+/* routegraph.c --						*/
+/*								*/
+/* Connectivity of the routes of a net.  The delay and antenna	*/
+/* calculations walk the routes of a net as a tree, and at	*/
+/* every route end they need to find the other routes that	*/
+/* connect there.  Searching the whole route list of the net	*/
+/* each time makes the walk quadratic in the number of routes,	*/
+/* which is slow for clock and reset nets with high fanout.	*/
+/* The route graph is made once for a net, and indexes the	*/
+/* route endpoints by grid position and by node, and the	*/
+/* routes by the route that they start or end on.		*/
+/*--------------------------------------------------------------*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "qrouter.h"
+#include "routegraph.h"
+
+/* Entry of an index while it is being sorted */
+
+typedef struct {
+    unsigned long long key;
+    int id;
+} rgentry;
+
+/*--------------------------------------------------------------*/
+/* Keys for grid positions and pointers				*/
+/*--------------------------------------------------------------*/
+
+static unsigned long long
+rg_point_key(int x, int y, int layer)
+{
+    return ((unsigned long long)(x & 0xfffffff) << 36) |
+		((unsigned long long)(y & 0xfffffff) << 8) |
+		(unsigned long long)(layer & 0xff);
+}
+
+static unsigned long long
+rg_pointer_key(void *ptr)
+{
+    return (unsigned long long)(size_t)ptr;
+}
+
+static int
+rg_hash(unsigned long long key, int size)
+{
+    key *= 0x9e3779b97f4a7c15ULL;
+    return (int)(key >> 32) & (size - 1);
+}
+
+/*--------------------------------------------------------------*/
+/* Add an entry to an index.					*/
+/*--------------------------------------------------------------*/
+
+static void
+rg_index_add(RGINDEX *idx, unsigned long long key, int id)
+{
+    if (idx->count == idx->alloc) {
+	idx->alloc = (idx->alloc == 0) ? 16 : 2 * idx->alloc;
+	idx->keys = (unsigned long long *)realloc(idx->keys,
+			idx->alloc * sizeof(unsigned long long));
+	idx->ids = (int *)realloc(idx->ids, idx->alloc * sizeof(int));
+    }
+    idx->keys[idx->count] = key;
+    idx->ids[idx->count] = id;
+    idx->count++;
+}
+
+static int
+rg_entry_compare(const void *a, const void *b)
+{
+    const rgentry *ea = (const rgentry *)a;
+    const rgentry *eb = (const rgentry *)b;
+
+    if (ea->key != eb->key) return (ea->key < eb->key) ? -1 : 1;
+    return (ea->id < eb->id) ? -1 : (ea->id > eb->id) ? 1 : 0;
+}
+
+/*--------------------------------------------------------------*/
+/* Sort the entries of an index by key and ID, drop duplicate	*/
+/* entries, and hash the first entry of each key.		*/
+/*--------------------------------------------------------------*/
+
+static void
+rg_index_finish(RGINDEX *idx)
+{
+    rgentry *ents;
+    int i, n, s;
+
+    if (idx->count > 1) {
+	ents = (rgentry *)malloc(idx->count * sizeof(rgentry));
+	for (i = 0; i < idx->count; i++) {
+	    ents[i].key = idx->keys[i];
+	    ents[i].id = idx->ids[i];
+	}
+	qsort(ents, idx->count, sizeof(rgentry), rg_entry_compare);
+	n = 0;
+	for (i = 0; i < idx->count; i++) {
+	    if ((n > 0) && (ents[i].key == idx->keys[n - 1]) &&
+			(ents[i].id == idx->ids[n - 1]))
+		continue;
+	    idx->keys[n] = ents[i].key;
+	    idx->ids[n] = ents[i].id;
+	    n++;
+	}
+	idx->count = n;
+	free(ents);
+    }
+
+    for (idx->size = 16; idx->size < 2 * idx->count; idx->size <<= 1);
+    idx->slots = (int *)malloc(idx->size * sizeof(int));
+    for (s = 0; s < idx->size; s++) idx->slots[s] = -1;
+
+    for (i = 0; i < idx->count; i++) {
+	if ((i > 0) && (idx->keys[i] == idx->keys[i - 1])) continue;
+	s = rg_hash(idx->keys[i], idx->size);
+	while (idx->slots[s] >= 0) s = (s + 1) & (idx->size - 1);
+	idx->slots[s] = i;
+    }
+}
+
+/*--------------------------------------------------------------*/
+/* Find the IDs recorded for "key".  Set "ids" to the first	*/
+/* of them and return their number.				*/
+/*--------------------------------------------------------------*/
+
+static int
+rg_index_lookup(RGINDEX *idx, unsigned long long key, int **ids)
+{
+    int s, i, n;
+
+    *ids = NULL;
+    if (idx->slots == NULL) return 0;
+
+    s = rg_hash(key, idx->size);
+    while ((i = idx->slots[s]) >= 0) {
+	if (idx->keys[i] == key) {
+	    for (n = i + 1; (n < idx->count) && (idx->keys[n] == key); n++);
+	    *ids = idx->ids + i;
+	    return n - i;
+	}
+	s = (s + 1) & (idx->size - 1);
+    }
+    return 0;
+}
+
+static void
+rg_index_free(RGINDEX *idx)
+{
+    if (idx->keys != NULL) free(idx->keys);
+    if (idx->ids != NULL) free(idx->ids);
+    if (idx->slots != NULL) free(idx->slots);
+}
+
+/*--------------------------------------------------------------*/
+/* routegraph_new() ---						*/
+/*								*/
+/* Create an empty route graph for "numroutes" routes.  Add	*/
+/* the routes and their endpoints with routegraph_add_route()	*/
+/* and routegraph_add_endpoint(), then call			*/
+/* routegraph_finish() before looking anything up.		*/
+/*--------------------------------------------------------------*/
+
+ROUTEGRAPH
+routegraph_new(int numroutes)
+{
+    ROUTEGRAPH rg;
+
+    rg = (ROUTEGRAPH)calloc(1, sizeof(struct routegraph_));
+    rg->numroutes = numroutes;
+    if (numroutes > 0)
+	rg->routes = (ROUTE *)calloc(numroutes, sizeof(ROUTE));
+    return rg;
+}
+
+/*--------------------------------------------------------------*/
+/* routegraph_add_route() ---					*/
+/*								*/
+/* Record route "rt" as route number "idx", and index it by	*/
+/* the routes that its start and end land on.			*/
+/*--------------------------------------------------------------*/
+
+void
+routegraph_add_route(ROUTEGRAPH rg, int idx, ROUTE rt)
+{
+    rg->routes[idx] = rt;
+
+    if (!(rt->flags & RT_START_NODE) && (rt->start.route != NULL))
+	rg_index_add(&rg->attach, rg_pointer_key(rt->start.route), idx);
+    if (!(rt->flags & RT_END_NODE) && (rt->end.route != NULL))
+	rg_index_add(&rg->attach, rg_pointer_key(rt->end.route), idx);
+}
+
+/*--------------------------------------------------------------*/
+/* routegraph_add_endpoint() ---				*/
+/*								*/
+/* Record the start ("end" = 0) or end ("end" = 1) of route	*/
+/* number "idx" at grid position (x, y, layer), and on node	*/
+/* "node" if it is not NULL.					*/
+/*--------------------------------------------------------------*/
+
+void
+routegraph_add_endpoint(ROUTEGRAPH rg, int idx, int end, int x, int y,
+		int layer, NODE node)
+{
+    int e = 2 * idx + end;
+
+    rg_index_add(&rg->points, rg_point_key(x, y, layer), e);
+    if (node != NULL)
+	rg_index_add(&rg->nodes, rg_pointer_key(node), e);
+}
+
+/*--------------------------------------------------------------*/
+/* routegraph_finish() ---					*/
+/*								*/
+/* Build the lookup tables once all routes and endpoints have	*/
+/* been added.							*/
+/*--------------------------------------------------------------*/
+
+void
+routegraph_finish(ROUTEGRAPH rg)
+{
+    rg_index_finish(&rg->points);
+    rg_index_finish(&rg->nodes);
+    rg_index_finish(&rg->attach);
+}
+
+/*--------------------------------------------------------------*/
+/* routegraph_build() ---					*/
+/*								*/
+/* Make the route graph of the routes of "net", in the order	*/
+/* of the net's route list.  The layer of an endpoint is the	*/
+/* layer of the metal at the end of the route, so a via at the	*/
+/* end of a route counts as being on the layer that the route	*/
+/* leaves it on.						*/
+/*--------------------------------------------------------------*/
+
+ROUTEGRAPH
+routegraph_build(NET net)
+{
+    ROUTEGRAPH rg;
+    ROUTE rt;
+    SEG seg;
+    int n, layer, testl;
+
+    n = 0;
+    for (rt = net->routes; rt; rt = rt->next) n++;
+    rg = routegraph_new(n);
+
+    n = 0;
+    for (rt = net->routes; rt; rt = rt->next, n++) {
+	routegraph_add_route(rg, n, rt);
+
+	seg = rt->segments;
+	if (seg == NULL) continue;
+
+	layer = seg->layer;
+	if ((seg->segtype & ST_VIA) && seg->next &&
+			(seg->next->layer <= seg->layer))
+	    layer++;
+	routegraph_add_endpoint(rg, n, 0, seg->x1, seg->y1, layer,
+		(rt->flags & RT_START_NODE) ? rt->start.node : NULL);
+
+	testl = layer;
+	for (; seg->next; seg = seg->next) testl = seg->layer;
+	layer = seg->layer;
+	if ((seg->segtype & ST_VIA) && (testl <= seg->layer))
+	    layer++;
+	routegraph_add_endpoint(rg, n, 1, seg->x2, seg->y2, layer,
+		(rt->flags & RT_END_NODE) ? rt->end.node : NULL);
+    }
+    routegraph_finish(rg);
+    return rg;
+}
+
+/*--------------------------------------------------------------*/
+/* routegraph_free() ---					*/
+/*--------------------------------------------------------------*/
+
+void
+routegraph_free(ROUTEGRAPH rg)
+{
+    if (rg == NULL) return;
+    rg_index_free(&rg->points);
+    rg_index_free(&rg->nodes);
+    rg_index_free(&rg->attach);
+    if (rg->routes != NULL) free(rg->routes);
+    free(rg);
+}
+
+/*--------------------------------------------------------------*/
+/* routegraph_at_point() ---					*/
+/*								*/
+/* Find the route endpoints at grid position (x, y, layer).	*/
+/* Set "ends" to the list of endpoint IDs, in increasing	*/
+/* order, and return their number.				*/
+/*--------------------------------------------------------------*/
+
+int
+routegraph_at_point(ROUTEGRAPH rg, int x, int y, int layer, int **ends)
+{
+    return rg_index_lookup(&rg->points, rg_point_key(x, y, layer), ends);
+}
+
+/*--------------------------------------------------------------*/
+/* routegraph_at_node() ---					*/
+/*								*/
+/* Find the route endpoints that land on "node".  Set "ends"	*/
+/* to the list of endpoint IDs, in increasing order, and	*/
+/* return their number.						*/
+/*--------------------------------------------------------------*/
+
+int
+routegraph_at_node(ROUTEGRAPH rg, NODE node, int **ends)
+{
+    return rg_index_lookup(&rg->nodes, rg_pointer_key(node), ends);
+}
+
+/*--------------------------------------------------------------*/
+/* routegraph_attached() ---					*/
+/*								*/
+/* Find the routes whose start or end lands on route "rt".	*/
+/* Set "routes" to the list of route indexes, in increasing	*/
+/* order, and return their number.				*/
+/*--------------------------------------------------------------*/
+
+int
+routegraph_attached(ROUTEGRAPH rg, ROUTE rt, int **routes)
+{
+    return rg_index_lookup(&rg->attach, rg_pointer_key(rt), routes);
+}
+
+/* end of routegraph.c */
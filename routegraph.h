@@ -0,0 +1,59 @@
+/*--------------------------------------------------------------*/
+/* routegraph.h --						*/
+/*								*/
+/* Connectivity of the routes of a net (header file)		*/
+/*--------------------------------------------------------------*/
+
+#ifndef _ROUTEGRAPH_H
+#define _ROUTEGRAPH_H
+
+/* A multi-valued index from a 64-bit key to a list of integer	*/
+/* IDs.  Entries are added in any order;  once the index is	*/
+/* finished, the IDs found for a key are in increasing order.	*/
+
+typedef struct rgindex_ {
+    int   count;		/* Number of entries		*/
+    int   alloc;		/* Allocated size of keys/ids	*/
+    unsigned long long *keys;	/* Key of each entry		*/
+    int  *ids;			/* ID of each entry		*/
+    int  *slots;		/* Hash of first entry by key	*/
+    int   size;			/* Number of slots (power of 2)	*/
+} RGINDEX;
+
+/* The route graph of a net.  Each route has an index, and	*/
+/* each route end has an endpoint ID of (2 * index + end),	*/
+/* where "end" is 0 for the start and 1 for the end of the	*/
+/* route.  Endpoints are indexed by grid position and by the	*/
+/* node they land on, and routes are indexed by the route that	*/
+/* their start or end lands on.					*/
+
+typedef struct routegraph_ *ROUTEGRAPH;
+
+struct routegraph_ {
+    int     numroutes;
+    ROUTE  *routes;	/* Routes by index			*/
+    RGINDEX points;	/* Endpoint IDs by (x, y, layer)	*/
+    RGINDEX nodes;	/* Endpoint IDs by node			*/
+    RGINDEX attach;	/* Route indexes by the route they	*/
+			/* start or end on			*/
+};
+
+#define RG_ROUTE(e)	((e) >> 1)	/* Route index of an endpoint	*/
+#define RG_END(e)	((e) & 1)	/* 0 = start, 1 = end		*/
+
+extern ROUTEGRAPH routegraph_new(int numroutes);
+extern void routegraph_add_route(ROUTEGRAPH rg, int idx, ROUTE rt);
+extern void routegraph_add_endpoint(ROUTEGRAPH rg, int idx, int end,
+		int x, int y, int layer, NODE node);
+extern void routegraph_finish(ROUTEGRAPH rg);
+extern ROUTEGRAPH routegraph_build(NET net);
+extern void routegraph_free(ROUTEGRAPH rg);
+
+extern int routegraph_at_point(ROUTEGRAPH rg, int x, int y, int layer,
+		int **ends);
+extern int routegraph_at_node(ROUTEGRAPH rg, NODE node, int **ends);
+extern int routegraph_attached(ROUTEGRAPH rg, ROUTE rt, int **routes);
+
+#endif /* _ROUTEGRAPH_H */
+
+/* end of routegraph.h */
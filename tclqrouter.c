@@ -27,6 +27,12 @@
 #include "graphics.h"
 #include "node.h"
 #include "output.h"
+#include "routedb.h"
+#include "eco.h"
+#include "point.h"
+#include "pool.h"
+#include "memstat.h"
+#include "congest.h"
 #include "tkSimple.h"
 
 /* Global variables */
@@ -75,6 +81,9 @@ static int qrouter_writefailed(
 static int qrouter_writedelays(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *CONST objv[]);
+static int qrouter_writespef(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *CONST objv[]);
 static int qrouter_antenna(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *CONST objv[]);
@@ -84,6 +93,21 @@ static int qrouter_readdef(
 static int qrouter_readlef(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *CONST objv[]);
+static int qrouter_readlefcache(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *CONST objv[]);
+static int qrouter_writelefcache(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *CONST objv[]);
+static int qrouter_readroutedb(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *CONST objv[]);
+static int qrouter_writeroutedb(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *CONST objv[]);
+static int qrouter_eco(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *CONST objv[]);
 static int qrouter_readconfig(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *CONST objv[]);
@@ -144,6 +168,9 @@ static int qrouter_verbose(
 static int qrouter_print(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *CONST objv[]);
+static int qrouter_memory(
+    ClientData clientData, Tcl_Interp *interp,
+    int objc, Tcl_Obj *CONST objv[]);
 static int qrouter_quit(
     ClientData clientData, Tcl_Interp *interp,
     int objc, Tcl_Obj *CONST objv[]);
@@ -168,8 +195,14 @@ static cmdstruct qrouter_commands[] =
    {"write_def", qrouter_writedef},
    {"read_def", qrouter_readdef},
    {"read_lef", qrouter_readlef},
+   {"read_lefcache", qrouter_readlefcache},
+   {"write_lefcache", qrouter_writelefcache},
+   {"read_routedb", qrouter_readroutedb},
+   {"write_routedb", qrouter_writeroutedb},
+   {"eco", qrouter_eco},
    {"read_config", qrouter_readconfig},
    {"write_delays", qrouter_writedelays},
+   {"write_spef", qrouter_writespef},
    {"antenna", qrouter_antenna},
    {"write_failed", qrouter_writefailed},
    {"layer_info", qrouter_layerinfo},
@@ -195,6 +228,7 @@ static cmdstruct qrouter_commands[] =
    {"verbose", qrouter_verbose},
    {"redraw", redraw},
    {"print", qrouter_print},
+   {"memory", qrouter_memory},
    {"quit", qrouter_quit},
    {"", NULL}  /* sentinel */
 };
@@ -985,7 +1019,7 @@ qrouter_stage1(ClientData clientData, Tcl_Interp *interp,
 			    FailedNets = fnet->next;
 			else
 			    lnet->next = fnet->next;
-			free(fnet);
+			freeNETLIST(fnet);
 			break;
 		    }
 		    lnet = fnet;
@@ -1366,7 +1400,7 @@ qrouter_stage3(ClientData clientData, Tcl_Interp *interp,
 			    FailedNets = fnet->next;
 			else
 			    lnet->next = fnet->next;
-			free(fnet);
+			freeNETLIST(fnet);
 			break;
 		    }
 		    lnet = fnet;
@@ -1539,15 +1573,12 @@ qrouter_failing(ClientData clientData, Tcl_Interp *interp,
 	    // Free up FailedNets list and then move all
 	    // nets to FailedNets
 
-	    while (FailedNets != NULL) {
-		nl = FailedNets->next;
-		FailedNets = FailedNets->next;
-		free(nl);
-	    }
+	    freeNETLISTlist(FailedNets);
+	    FailedNets = (NETLIST)NULL;
 	    nlast = NULL;
 	    for (i = 0; i < Numnets; i++) {
 		net = Nlnets[i];
-		nl = (NETLIST)malloc(sizeof(struct netlist_));
+		nl = allocNETLIST();
 		nl->net = net;
 		nl->next = NULL;
 		if (nlast == NULL)
@@ -1558,16 +1589,13 @@ qrouter_failing(ClientData clientData, Tcl_Interp *interp,
 	    }
 	}
 	else if (!strncmp(Tcl_GetString(objv[1]), "all", 3)) {
-	    while (FailedNets != NULL) {
-		nl = FailedNets->next;
-		FailedNets = FailedNets->next;
-		free(nl);
-	    }
+	    freeNETLISTlist(FailedNets);
+	    FailedNets = (NETLIST)NULL;
 	    create_netorder(0);
 	    nlast = NULL;
 	    for (i = 0; i < Numnets; i++) {
 		net = Nlnets[i];
-		nl = (NETLIST)malloc(sizeof(struct netlist_));
+		nl = allocNETLIST();
 		nl->net = net;
 		nl->next = NULL;
 		if (nlast == NULL)
@@ -1642,6 +1670,188 @@ qrouter_readlef(ClientData clientData, Tcl_Interp *interp,
     return QrouterTagCallback(interp, objc, objv);
 }
 
+/*------------------------------------------------------*/
+/* Command "read_lefcache"				*/
+/*							*/
+/* Load the technology and macro library from a cache	*/
+/* written by "write_lefcache".  If any of the LEF	*/
+/* files the cache was made from has changed, they are	*/
+/* read again and the cache is rewritten.		*/
+/*							*/
+/* Use:							*/
+/*	read_lefcache <filename>			*/
+/*------------------------------------------------------*/
+
+static int
+qrouter_readlefcache(ClientData clientData, Tcl_Interp *interp,
+                int objc, Tcl_Obj *CONST objv[])
+{
+    char *cachefile, *LEFfile;
+    int mscale;
+    int i, result;
+
+    if (objc != 2) {
+	Tcl_SetResult(interp, "No LEF cache filename specified!", NULL);
+	return TCL_ERROR;
+    }
+    cachefile = Tcl_GetString(objv[1]);
+
+    result = LefReadCache(cachefile);
+    if (result == 0) {
+	Tcl_SetResult(interp, "Cannot read LEF cache file.", NULL);
+	return TCL_ERROR;
+    }
+
+    /* Files loaded from the cache are not parsed again */
+
+    for (i = 0; (LEFfile = LefCacheSource(i)) != NULL; i++) {
+	mscale = LefRead(LEFfile);
+	update_mscale(mscale);
+    }
+    if (result < 0 && LefCacheModified()) LefWriteCache(cachefile);
+
+    for (i = 0; i < Num_layers; i++)
+       Vert[i] = (1 - LefGetRouteOrientation(i));
+
+    post_config(FALSE);
+    apply_drc_blocks(-1, 0.0, 0.0);
+
+    return QrouterTagCallback(interp, objc, objv);
+}
+
+/*------------------------------------------------------*/
+/* Command "write_lefcache"				*/
+/*							*/
+/* Save the technology and macro library read from LEF	*/
+/* files to a binary cache file.  This should be done	*/
+/* before reading the DEF file.				*/
+/*							*/
+/* Use:							*/
+/*	write_lefcache <filename>			*/
+/*------------------------------------------------------*/
+
+static int
+qrouter_writelefcache(ClientData clientData, Tcl_Interp *interp,
+                int objc, Tcl_Obj *CONST objv[])
+{
+    if (objc != 2) {
+	Tcl_SetResult(interp, "No LEF cache filename specified!", NULL);
+	return TCL_ERROR;
+    }
+    if (LefWriteCache(Tcl_GetString(objv[1])) != 0) {
+	Tcl_SetResult(interp, "Cannot write LEF cache file.", NULL);
+	return TCL_ERROR;
+    }
+    return QrouterTagCallback(interp, objc, objv);
+}
+
+/*------------------------------------------------------*/
+/* Command "read_routedb"				*/
+/*							*/
+/* Load routes saved by "write_routedb".  With net	*/
+/* names, only the routes of those nets are loaded.	*/
+/* The routes of each net loaded replace any routes	*/
+/* the net already has.  Must be run after read_def.	*/
+/*							*/
+/* Use:							*/
+/*	read_routedb <filename> [<netname> ...]		*/
+/*------------------------------------------------------*/
+
+static int
+qrouter_readroutedb(ClientData clientData, Tcl_Interp *interp,
+                int objc, Tcl_Obj *CONST objv[])
+{
+    char **netnames = NULL;
+    int i, numnames, result;
+
+    if (objc < 2) {
+	Tcl_SetResult(interp, "No route database filename specified!", NULL);
+	return TCL_ERROR;
+    }
+
+    numnames = objc - 2;
+    if (numnames > 0) {
+	netnames = (char **)malloc(numnames * sizeof(char *));
+	for (i = 0; i < numnames; i++)
+	    netnames[i] = Tcl_GetString(objv[i + 2]);
+    }
+    result = read_routedb(Tcl_GetString(objv[1]), netnames, numnames);
+    free(netnames);
+
+    if (result < 0) {
+	Tcl_SetResult(interp, "Cannot read route database.", NULL);
+	return TCL_ERROR;
+    }
+
+    // Redisplay
+    draw_layout();
+
+    Tcl_SetObjResult(interp, Tcl_NewIntObj(result));
+    return QrouterTagCallback(interp, objc, objv);
+}
+
+/*------------------------------------------------------*/
+/* Command "write_routedb"				*/
+/*							*/
+/* Save the routes of all nets to a binary route	*/
+/* database file.					*/
+/*							*/
+/* Use:							*/
+/*	write_routedb <filename>			*/
+/*------------------------------------------------------*/
+
+static int
+qrouter_writeroutedb(ClientData clientData, Tcl_Interp *interp,
+                int objc, Tcl_Obj *CONST objv[])
+{
+    if (objc != 2) {
+	Tcl_SetResult(interp, "No route database filename specified!", NULL);
+	return TCL_ERROR;
+    }
+    if (write_routedb(Tcl_GetString(objv[1])) != 0) {
+	Tcl_SetResult(interp, "Cannot write route database.", NULL);
+	return TCL_ERROR;
+    }
+    return QrouterTagCallback(interp, objc, objv);
+}
+
+/*------------------------------------------------------*/
+/* Command "eco"					*/
+/*							*/
+/* Read a new placement of the design, keep the routes	*/
+/* of nets that the change does not affect, and route	*/
+/* the nets whose pins moved or whose routes are now	*/
+/* blocked.  Nets that fail are left for "stage2".	*/
+/* Returns the number of nets routed.			*/
+/*							*/
+/* Use:							*/
+/*	eco <filename>					*/
+/*------------------------------------------------------*/
+
+static int
+qrouter_eco(ClientData clientData, Tcl_Interp *interp,
+                int objc, Tcl_Obj *CONST objv[])
+{
+    int result;
+
+    if (objc != 2) {
+	Tcl_SetResult(interp, "No DEF filename specified!", NULL);
+	return TCL_ERROR;
+    }
+
+    result = eco_def(Tcl_GetString(objv[1]));
+    if (result < 0) {
+	Tcl_SetResult(interp, "No design has been read.", NULL);
+	return TCL_ERROR;
+    }
+
+    // Redisplay
+    draw_layout();
+
+    Tcl_SetObjResult(interp, Tcl_NewIntObj(result));
+    return QrouterTagCallback(interp, objc, objv);
+}
+
 /*------------------------------------------------------*/
 /* Command "read_def"					*/
 /*------------------------------------------------------*/
@@ -1689,6 +1899,13 @@ qrouter_readdef(ClientData clientData, Tcl_Interp *interp,
 
 /*------------------------------------------------------*/
 /* Command "write_def"					*/
+/* Use:							*/
+/*	write_def [-incremental] [<filename>]		*/
+/*							*/
+/* With "-incremental", the routes of nets that have	*/
+/* not changed since the file was last written are	*/
+/* copied from that file instead of being formatted	*/
+/* again.						*/
 /*------------------------------------------------------*/
 
 static int
@@ -1696,16 +1913,30 @@ qrouter_writedef(ClientData clientData, Tcl_Interp *interp,
                  int objc, Tcl_Obj *CONST objv[])
 {
     char *DEFoutfile = NULL;
+    u_char incremental = FALSE;
+    int argc = 1;
 
-    if (objc == 2)
-	DEFoutfile = Tcl_GetString(objv[1]);
+    if ((objc > 1) && !strcmp(Tcl_GetString(objv[1]), "-incremental")) {
+	incremental = TRUE;
+	argc++;
+    }
+    if (objc > argc + 1) {
+	Tcl_WrongNumArgs(interp, 1, objv, "[-incremental] [filename]");
+	return TCL_ERROR;
+    }
+
+    if (objc == argc + 1)
+	DEFoutfile = Tcl_GetString(objv[argc]);
     else if (DEFfilename == NULL) {
 	Tcl_SetResult(interp, "No DEF filename specified!", NULL);
 	return TCL_ERROR;
     }
     else DEFoutfile = DEFfilename;
 
-    write_def(DEFoutfile);
+    if (incremental)
+	write_def_incremental(DEFoutfile);
+    else
+	write_def(DEFoutfile);
     return QrouterTagCallback(interp, objc, objv);
 }
 
@@ -1793,6 +2024,12 @@ qrouter_writefailed(ClientData clientData, Tcl_Interp *interp,
 
 /*------------------------------------------------------*/
 /* Command "write_delays"				*/
+/* Use:							*/
+/*	write_delays [-incremental] [<filename>]	*/
+/*							*/
+/* With "-incremental", only the nets whose routes have	*/
+/* changed since the delays were last written (or	*/
+/* queried) are extracted again.			*/
 /*------------------------------------------------------*/
 
 static int
@@ -1800,16 +2037,64 @@ qrouter_writedelays(ClientData clientData, Tcl_Interp *interp,
                  int objc, Tcl_Obj *CONST objv[])
 {
     char *delayoutfile = NULL;
+    u_char incremental = FALSE;
+    int argc = 1;
 
-    if (objc == 2)
-	delayoutfile = Tcl_GetString(objv[1]);
+    if ((objc > 1) && !strcmp(Tcl_GetString(objv[1]), "-incremental")) {
+	incremental = TRUE;
+	argc++;
+    }
+    if (objc > argc + 1) {
+	Tcl_WrongNumArgs(interp, 1, objv, "[-incremental] [filename]");
+	return TCL_ERROR;
+    }
+
+    if (objc == argc + 1)
+	delayoutfile = Tcl_GetString(objv[argc]);
     else if (delayfilename == NULL) {
 	Tcl_SetResult(interp, "No delay filename specified!", NULL);
 	return TCL_ERROR;
     }
     else delayoutfile = delayfilename;
 
-    write_delays(delayoutfile);
+    if (incremental)
+	write_delays_incremental(delayoutfile);
+    else
+	write_delays(delayoutfile);
+    return QrouterTagCallback(interp, objc, objv);
+}
+
+/*------------------------------------------------------*/
+/* Command "write_spef"					*/
+/* Use:							*/
+/*	write_spef [<filename>]				*/
+/*							*/
+/* Write the R and C of the routes of all nets as a	*/
+/* SPEF file.  The default file name is the DEF file	*/
+/* name with the extension ".spef".			*/
+/*------------------------------------------------------*/
+
+static int
+qrouter_writespef(ClientData clientData, Tcl_Interp *interp,
+                 int objc, Tcl_Obj *CONST objv[])
+{
+    char *spefoutfile = NULL;
+
+    if (objc > 2) {
+	Tcl_WrongNumArgs(interp, 1, objv, "[filename]");
+	return TCL_ERROR;
+    }
+    if (objc == 2)
+	spefoutfile = Tcl_GetString(objv[1]);
+    else if (DEFfilename == NULL) {
+	Tcl_SetResult(interp, "No DEF filename specified!", NULL);
+	return TCL_ERROR;
+    }
+
+    if (write_spef(spefoutfile) != 0) {
+	Tcl_SetResult(interp, "Cannot write SPEF file.", NULL);
+	return TCL_ERROR;
+    }
     return QrouterTagCallback(interp, objc, objv);
 }
 
@@ -2386,6 +2671,89 @@ qrouter_verbose(ClientData clientData, Tcl_Interp *interp,
 }
 
 
+/*------------------------------------------------------*/
+/* Command "memory"					*/
+/*							*/
+/* Report memory use by subsystem.  With no argument,	*/
+/* return a list of {name current peak} for each	*/
+/* subsystem and for the total, in bytes.		*/
+/*							*/
+/* Options:						*/
+/*							*/
+/*	memory [<subsystem>]	Current and peak bytes	*/
+/*	memory print		Print a summary table	*/
+/*	memory reset		Set peaks to current use */
+/*------------------------------------------------------*/
+
+static int
+qrouter_memory(ClientData clientData, Tcl_Interp *interp,
+                int objc, Tcl_Obj *CONST objv[])
+{
+    Tcl_Obj *lobj, *sobj;
+    char *option;
+    int i;
+
+    if (objc == 1) {
+	lobj = Tcl_NewListObj(0, NULL);
+	for (i = 0; i < MEM_NUMCLASSES; i++) {
+	    sobj = Tcl_NewListObj(0, NULL);
+	    Tcl_ListObjAppendElement(interp, sobj,
+			Tcl_NewStringObj(mem_classname(i), -1));
+	    Tcl_ListObjAppendElement(interp, sobj,
+			Tcl_NewWideIntObj((Tcl_WideInt)mem_inuse(i)));
+	    Tcl_ListObjAppendElement(interp, sobj,
+			Tcl_NewWideIntObj((Tcl_WideInt)mem_peak(i)));
+	    Tcl_ListObjAppendElement(interp, lobj, sobj);
+	}
+	sobj = Tcl_NewListObj(0, NULL);
+	Tcl_ListObjAppendElement(interp, sobj, Tcl_NewStringObj("total", -1));
+	Tcl_ListObjAppendElement(interp, sobj,
+			Tcl_NewWideIntObj((Tcl_WideInt)mem_total_inuse()));
+	Tcl_ListObjAppendElement(interp, sobj,
+			Tcl_NewWideIntObj((Tcl_WideInt)mem_total_peak()));
+	Tcl_ListObjAppendElement(interp, lobj, sobj);
+	Tcl_SetObjResult(interp, lobj);
+    }
+    else if (objc == 2) {
+	option = Tcl_GetString(objv[1]);
+	if (!strcmp(option, "print")) {
+	    mem_summary(NULL);
+	    reportPOINTStore();
+	}
+	else if (!strcmp(option, "reset"))
+	    mem_reset_peak();
+	else {
+	    lobj = Tcl_NewListObj(0, NULL);
+	    if (!strcmp(option, "total")) {
+		Tcl_ListObjAppendElement(interp, lobj,
+			Tcl_NewWideIntObj((Tcl_WideInt)mem_total_inuse()));
+		Tcl_ListObjAppendElement(interp, lobj,
+			Tcl_NewWideIntObj((Tcl_WideInt)mem_total_peak()));
+	    }
+	    else {
+		for (i = 0; i < MEM_NUMCLASSES; i++)
+		    if (!strcmp(option, mem_classname(i)))
+			break;
+		if (i == MEM_NUMCLASSES) {
+		    Tcl_DecrRefCount(lobj);
+		    Tcl_SetResult(interp, "Unknown memory subsystem", NULL);
+		    return TCL_ERROR;
+		}
+		Tcl_ListObjAppendElement(interp, lobj,
+			Tcl_NewWideIntObj((Tcl_WideInt)mem_inuse(i)));
+		Tcl_ListObjAppendElement(interp, lobj,
+			Tcl_NewWideIntObj((Tcl_WideInt)mem_peak(i)));
+	    }
+	    Tcl_SetObjResult(interp, lobj);
+	}
+    }
+    else {
+	Tcl_WrongNumArgs(interp, 1, objv, "?option?");
+	return TCL_ERROR;
+    }
+    return QrouterTagCallback(interp, objc, objv);
+}
+
 /*------------------------------------------------------*/
 /* Command "resolution"					*/
 /*							*/
@@ -2444,6 +2812,14 @@ qrouter_resolution(ClientData clientData, Tcl_Interp *interp,
 /*	query instance <instance>			*/
 /*	query node <instance>/<pin>			*/
 /*	query net <name>				*/
+/*	query delays <name>				*/
+/*							*/
+/* "query delays" returns a list of the total route	*/
+/* capacitance of the net followed by a list of		*/
+/* {<instance>/<pin> <resistance> <delay>} for each	*/
+/* receiver, with the resistance and Elmore delay of	*/
+/* the routes from the driver.  The net is extracted	*/
+/* only if its routes have changed.			*/
 /*							*/
 /* <layer> may be either a layer name or integer index.	*/
 /* <dx> and <dy> should be given in microns. <ix> and	*/
@@ -2456,16 +2832,20 @@ qrouter_query(ClientData clientData, Tcl_Interp *interp,
                int objc, Tcl_Obj *CONST objv[])
 {
     char *layername, *instname, *netname, *pinname;
-    int idx, result, layer;
+    int idx, result, layer, i, numsinks, pinidx;
     int gridx, gridy;
-    double dx, dy;
+    double dx, dy, totalcap;
     unsigned char is_index, do_watch, do_unwatch;
+    NET net;
+    GATE gate;
+    RCSINK *sinks;
+    Tcl_Obj *lobj, *sobj, *pobj;
 
     static char *subCmds[] = {
-	"grid", "position", "instance", "node", "net", NULL
+	"grid", "position", "instance", "node", "net", "delays", NULL
     };
     enum SubIdx {
-	GridIdx, PosIdx, InstIdx, NodeIdx, NetIdx
+	GridIdx, PosIdx, InstIdx, NodeIdx, NetIdx, DelaysIdx
     };
    
     if (objc < 2) {
@@ -2475,6 +2855,7 @@ qrouter_query(ClientData clientData, Tcl_Interp *interp,
 	Fprintf(stderr, "   query instance <inst_name>\n");
 	Fprintf(stderr, "   query node <inst_name>/<pin_name>\n");
 	Fprintf(stderr, "   query net <net_name>\n");
+	Fprintf(stderr, "   query delays <net_name>\n");
 	Tcl_WrongNumArgs(interp, 1, objv, "option ?arg?");
 	return TCL_ERROR;
     }
@@ -2649,6 +3030,46 @@ qrouter_query(ClientData clientData, Tcl_Interp *interp,
 	    netname = Tcl_GetString(objv[2]);
 	    print_net_information(netname);
 	    break;
+
+	case DelaysIdx:
+	    if (objc != 3) {
+		Tcl_WrongNumArgs(interp, 1, objv, "option ?arg?");
+		return TCL_ERROR;
+	    }
+	    netname = Tcl_GetString(objv[2]);
+	    net = DefFindNet(netname);
+	    if (net == NULL) {
+		Tcl_SetResult(interp, "No such net.", NULL);
+		return TCL_ERROR;
+	    }
+	    numsinks = get_net_delays(net, &totalcap, &sinks);
+	    if (numsinks < 0) {
+		Tcl_SetResult(interp, "Net has no routes or no driver.", NULL);
+		return TCL_ERROR;
+	    }
+	    lobj = Tcl_NewListObj(0, NULL);
+	    Tcl_ListObjAppendElement(interp, lobj, Tcl_NewDoubleObj(totalcap));
+	    for (i = 0; i < numsinks; i++) {
+		gate = FindGateNode(sinks[i].node, &pinidx);
+		if (!strcmp(gate->gatetype->node[pinidx], "pin")) {
+		    pobj = Tcl_NewStringObj("PIN/", -1);
+		    Tcl_AppendToObj(pobj, gate->gatename, -1);
+		}
+		else {
+		    pobj = Tcl_NewStringObj(gate->gatename, -1);
+		    Tcl_AppendStringsToObj(pobj, "/",
+				gate->gatetype->node[pinidx], NULL);
+		}
+		sobj = Tcl_NewListObj(0, NULL);
+		Tcl_ListObjAppendElement(interp, sobj, pobj);
+		Tcl_ListObjAppendElement(interp, sobj,
+			Tcl_NewDoubleObj(sinks[i].res));
+		Tcl_ListObjAppendElement(interp, sobj,
+			Tcl_NewDoubleObj(sinks[i].delay));
+		Tcl_ListObjAppendElement(interp, lobj, sobj);
+	    }
+	    Tcl_SetObjResult(interp, lobj);
+	    break;
     }
     return QrouterTagCallback(interp, objc, objv);
 }
@@ -2893,6 +3314,7 @@ qrouter_gnd(ClientData clientData, Tcl_Interp *interp,
 /*	cost block					*/
 /*	cost offset					*/
 /*	cost conflict					*/
+/*	cost antenna					*/
 /*------------------------------------------------------*/
 
 static int
@@ -2903,10 +3325,11 @@ qrouter_cost(ClientData clientData, Tcl_Interp *interp,
 
     static char *subCmds[] = {
 	"segment", "via", "jog", "crossover",
-	"block", "offset", "conflict", NULL
+	"block", "offset", "conflict", "antenna", NULL
     };
     enum SubIdx {
-	SegIdx, ViaIdx, JogIdx, XOverIdx, BlockIdx, OffsetIdx, ConflictIdx
+	SegIdx, ViaIdx, JogIdx, XOverIdx, BlockIdx, OffsetIdx, ConflictIdx,
+	AntennaIdx
     };
    
     value = 0;
@@ -2993,6 +3416,13 @@ qrouter_cost(ClientData clientData, Tcl_Interp *interp,
 	    else
 		ConflictCost = value;
 	    break;
+
+	case AntennaIdx:
+	    if (objc == 2)
+		Tcl_SetObjResult(interp, Tcl_NewIntObj(AntennaCost));
+	    else
+		AntennaCost = value;
+	    break;
     }
 
     return QrouterTagCallback(interp, objc, objv);
@@ -3042,14 +3472,12 @@ static int
 qrouter_congested(ClientData clientData, Tcl_Interp *interp,
                   int objc, Tcl_Obj *CONST objv[])
 {
-    NET net;
-    int i, x, y, nwidth, nheight, area, length;
-    int entries, numgates, result;
-    float density, *Congestion;
+    int i, entries, numgates, result;
+    float *Congestion;
     CLIST *cgates, csrch;
     GATE gsrch;
     struct seg_ bbox;
-    double dx, dy, cavg;
+    double dx, dy, cavg, *table;
     Tcl_Obj *lobj, *dobj;
 
     if (objc == 2) {
@@ -3064,30 +3492,11 @@ qrouter_congested(ClientData clientData, Tcl_Interp *interp,
     else
 	entries = 0;
 
-    Congestion = (float *)calloc(NumChannelsX * NumChannelsY,
-			sizeof(float));
+    // Use net bounding boxes to estimate congestion, and make a
+    // table of its sums over areas of the grid.
 
-    // Use net bounding boxes to estimate congestion
-
-    for (i = 0; i < Numnets; i++) {
-	net = Nlnets[i];
-	nwidth = (net->xmax - net->xmin + 1);
-	nheight = (net->ymax - net->ymin + 1);
-	area = nwidth * nheight;
-	if (nwidth > nheight) {
-	    length = nwidth + (nheight >> 1) * net->numnodes;
-	}
-	else {
-	    length = nheight + (nwidth >> 1) * net->numnodes;
-	}
-	density = (float)length / (float)area;
-
-	for (x = net->xmin; x < net->xmax; x++)
-	    for (y = net->ymin; y < net->ymax; y++)
-		if (x >= 0 && x < NumChannelsX &&
-			y >= 0 && y < NumChannelsY)
-		    CONGEST(x, y) += density;
-    }
+    Congestion = congestion_estimate();
+    table = congestion_table(Congestion);
 
     // Use instance bounding boxes to estimate average congestion
     // in the area of an instance.
@@ -3117,12 +3526,7 @@ qrouter_congested(ClientData clientData, Tcl_Interp *interp,
 	bbox.x2 = (int)((dx - Xlowerbound) / PitchX) - 1;
 	bbox.y2 = (int)((dy - Ylowerbound) / PitchY) - 1;
 
-	cavg = 0.0;
-	for (x = bbox.x1; x <= bbox.x2; x++) {
-	    for (y = bbox.y1; y <= bbox.y2; y++) {
-		cavg += CONGEST(x, y);
-	    }
-	}
+	cavg = congestion_table_sum(table, bbox.x1, bbox.y1, bbox.x2, bbox.y2);
 	cavg /= (bbox.x2 - bbox.x1 + 1);
 	cavg /= (bbox.y2 - bbox.y1 + 1);
 
@@ -3155,6 +3559,7 @@ qrouter_congested(ClientData clientData, Tcl_Interp *interp,
     Tcl_SetObjResult(interp, lobj);
 
     // Cleanup
+    free(table);
     free(Congestion);
     for (i = 0; i < numgates; i++) free(cgates[i]);
     free(cgates);
@@ -0,0 +1,304 @@
+/*--------------------------------------------------------------*/
+/* zfile.c --							*/
+/*								*/
+/* Reading and writing compressed files.  zfile_open() returns	*/
+/* an ordinary stdio stream for a file that may be compressed	*/
+/* with gzip or zstd.  An input file is recognized as		*/
+/* compressed by its first bytes, and an output file is		*/
+/* compressed if its name ends in ".gz", ".zst", or ".zstd".	*/
+/* Data is decompressed as it is read and compressed as it is	*/
+/* written, so no uncompressed copy of the file is made on	*/
+/* disk.							*/
+/*								*/
+/* gzip files are handled by zlib through a custom stdio	*/
+/* stream if the system has fopencookie() or funopen().		*/
+/* Otherwise, and for zstd files, the data is passed through	*/
+/* the "gzip" or "zstd" program on a pipe.			*/
+/*--------------------------------------------------------------*/
+
+#ifdef HAVE_FOPENCOOKIE
+#define _GNU_SOURCE	/* for fopencookie() */
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#if defined(HAVE_ZLIB_H) && defined(HAVE_LIBZ) && \
+	(defined(HAVE_FOPENCOOKIE) || defined(HAVE_FUNOPEN))
+#define ZFILE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "qrouter.h"
+#include "zfile.h"
+
+/* Size of the zlib and stdio buffers of a gzip stream */
+#define ZFILE_BUFSIZE	(1 << 17)
+
+/* Streams opened with popen(), which must be closed with pclose() */
+
+typedef struct zpipe_ *ZPIPE;
+
+struct zpipe_ {
+    ZPIPE next;
+    FILE *f;
+};
+
+static ZPIPE zfilePipes = NULL;
+
+/*--------------------------------------------------------------*/
+/* zfile_suffix() ---						*/
+/*								*/
+/* Return a pointer to the compression suffix (".gz", ".zst",	*/
+/* or ".zstd") at the end of "filename", or NULL if it has	*/
+/* none.							*/
+/*--------------------------------------------------------------*/
+
+char *
+zfile_suffix(char *filename)
+{
+    static char *suffixes[] = {".gz", ".zst", ".zstd", NULL};
+    size_t len, slen;
+    int i;
+
+    if (filename == NULL) return NULL;
+    len = strlen(filename);
+    for (i = 0; suffixes[i] != NULL; i++) {
+	slen = strlen(suffixes[i]);
+	if ((len > slen) && !strcmp(filename + len - slen, suffixes[i]))
+	    return filename + len - slen;
+    }
+    return NULL;
+}
+
+/* Compression type of an output file, from its name */
+
+static int
+zfile_suffix_type(char *filename)
+{
+    char *sptr = zfile_suffix(filename);
+
+    if (sptr == NULL) return ZFILE_NONE;
+    return (*(sptr + 1) == 'g') ? ZFILE_GZIP : ZFILE_ZSTD;
+}
+
+/* Compression type of an input file, from its first bytes.	*/
+/* The stream is left at the start of the file.		*/
+
+static int
+zfile_magic_type(FILE *f)
+{
+    u_char magic[4];
+    size_t n;
+
+    n = fread(magic, 1, 4, f);
+    rewind(f);
+
+    if ((n >= 2) && (magic[0] == 0x1f) && (magic[1] == 0x8b))
+	return ZFILE_GZIP;
+    if ((n == 4) && (magic[0] == 0x28) && (magic[1] == 0xb5) &&
+		(magic[2] == 0x2f) && (magic[3] == 0xfd))
+	return ZFILE_ZSTD;
+    return ZFILE_NONE;
+}
+
+/*--------------------------------------------------------------*/
+/* zfile_popen() ---						*/
+/*								*/
+/* Run "command" followed by "filename" (quoted for the shell)	*/
+/* on a pipe that is read from or written to, by "mode".	*/
+/*--------------------------------------------------------------*/
+
+static FILE *
+zfile_popen(char *command, char *filename, char *mode)
+{
+    char *cmd, *cptr, *sptr;
+    FILE *f;
+    ZPIPE zp;
+
+    cmd = (char *)malloc(strlen(command) + 4 * strlen(filename) + 4);
+    strcpy(cmd, command);
+    cptr = cmd + strlen(cmd);
+    *cptr++ = ' ';
+    *cptr++ = '\'';
+    for (sptr = filename; *sptr != '\0'; sptr++) {
+	if (*sptr == '\'') {
+	    strcpy(cptr, "'\\''");
+	    cptr += 4;
+	}
+	else
+	    *cptr++ = *sptr;
+    }
+    *cptr++ = '\'';
+    *cptr = '\0';
+
+    Flush(stdout);
+    f = popen(cmd, (*mode == 'r') ? "r" : "w");
+    free(cmd);
+    if (f == NULL) return NULL;
+
+    zp = (ZPIPE)malloc(sizeof(struct zpipe_));
+    zp->f = f;
+    zp->next = zfilePipes;
+    zfilePipes = zp;
+    return f;
+}
+
+#ifdef ZFILE_ZLIB
+
+/*--------------------------------------------------------------*/
+/* stdio stream functions for a gzip file open in zlib		*/
+/*--------------------------------------------------------------*/
+
+#ifdef HAVE_FOPENCOOKIE
+static ssize_t
+zfile_gzread(void *cookie, char *buf, size_t size)
+#else
+static int
+zfile_gzread(void *cookie, char *buf, int size)
+#endif
+{
+    int n;
+
+    if (size > (1 << 30)) size = (1 << 30);
+    n = gzread((gzFile)cookie, buf, (unsigned)size);
+    return (n < 0) ? -1 : n;
+}
+
+#ifdef HAVE_FOPENCOOKIE
+static ssize_t
+zfile_gzwrite(void *cookie, const char *buf, size_t size)
+#else
+static int
+zfile_gzwrite(void *cookie, const char *buf, int size)
+#endif
+{
+    int n;
+
+    if (size == 0) return 0;
+    if (size > (1 << 30)) size = (1 << 30);
+    n = gzwrite((gzFile)cookie, buf, (unsigned)size);
+
+    /* fopencookie() takes 0 as an error, funopen() takes -1 */
+#ifdef HAVE_FOPENCOOKIE
+    return (n <= 0) ? 0 : n;
+#else
+    return (n <= 0) ? -1 : n;
+#endif
+}
+
+static int
+zfile_gzclose(void *cookie)
+{
+    return (gzclose((gzFile)cookie) == Z_OK) ? 0 : EOF;
+}
+
+/* Open a gzip file in zlib as a stdio stream */
+
+static FILE *
+zfile_gzopen(char *filename, char *mode)
+{
+    gzFile gz;
+    FILE *f;
+
+    gz = gzopen(filename, (*mode == 'r') ? "rb" : "wb");
+    if (gz == NULL) return NULL;
+    gzbuffer(gz, ZFILE_BUFSIZE);
+
+#ifdef HAVE_FOPENCOOKIE
+    {
+	cookie_io_functions_t io;
+
+	io.read = (*mode == 'r') ? zfile_gzread : NULL;
+	io.write = (*mode == 'r') ? NULL : zfile_gzwrite;
+	io.seek = NULL;
+	io.close = zfile_gzclose;
+	f = fopencookie((void *)gz, (*mode == 'r') ? "r" : "w", io);
+    }
+#else
+    f = funopen((void *)gz, (*mode == 'r') ? zfile_gzread : NULL,
+		(*mode == 'r') ? NULL : zfile_gzwrite, NULL, zfile_gzclose);
+#endif
+
+    if (f == NULL)
+	gzclose(gz);
+    else
+	setvbuf(f, NULL, _IOFBF, ZFILE_BUFSIZE);
+    return f;
+}
+
+#endif /* ZFILE_ZLIB */
+
+/*--------------------------------------------------------------*/
+/* zfile_open() ---						*/
+/*								*/
+/* Open "filename" for reading (mode "r") or writing (mode	*/
+/* "w"), decompressing or compressing it if needed.		*/
+/*								*/
+/* Results:							*/
+/*	A stdio stream, which must be closed with zfile_close(),	*/
+/*	or NULL if the file cannot be opened.			*/
+/*--------------------------------------------------------------*/
+
+FILE *
+zfile_open(char *filename, char *mode)
+{
+    FILE *f;
+    int type;
+
+    if (*mode == 'r') {
+	f = fopen(filename, mode);
+	if (f == NULL) return NULL;
+	type = zfile_magic_type(f);
+	if (type == ZFILE_NONE) return f;
+	fclose(f);
+    }
+    else
+	type = zfile_suffix_type(filename);
+
+    switch (type) {
+	case ZFILE_GZIP:
+#ifdef ZFILE_ZLIB
+	    return zfile_gzopen(filename, mode);
+#else
+	    return zfile_popen((*mode == 'r') ? "gzip -dc --" : "gzip -c >",
+			filename, mode);
+#endif
+	case ZFILE_ZSTD:
+	    return zfile_popen((*mode == 'r') ? "zstd -dcq --" : "zstd -cq >",
+			filename, mode);
+    }
+    return fopen(filename, mode);
+}
+
+/*--------------------------------------------------------------*/
+/* zfile_close() ---						*/
+/*								*/
+/* Close a stream opened with zfile_open().  For a compressed	*/
+/* output file, this finishes writing the compressed data.	*/
+/*								*/
+/* Results:							*/
+/*	0 on success, nonzero on error.				*/
+/*--------------------------------------------------------------*/
+
+int
+zfile_close(FILE *f)
+{
+    ZPIPE zp, lastzp = NULL;
+
+    for (zp = zfilePipes; zp; lastzp = zp, zp = zp->next) {
+	if (zp->f == f) {
+	    if (lastzp == NULL)
+		zfilePipes = zp->next;
+	    else
+		lastzp->next = zp->next;
+	    free(zp);
+	    return pclose(f);
+	}
+    }
+    return fclose(f);
+}
+
+/* end of zfile.c */
@@ -0,0 +1,22 @@
+/*--------------------------------------------------------------*/
+/* zfile.h --							*/
+/*								*/
+/* Reading and writing compressed files (header file)		*/
+/*--------------------------------------------------------------*/
+
+#ifndef _ZFILE_H
+#define _ZFILE_H
+
+/* Compression types */
+
+#define ZFILE_NONE	0
+#define ZFILE_GZIP	1
+#define ZFILE_ZSTD	2
+
+extern FILE *zfile_open(char *filename, char *mode);
+extern int   zfile_close(FILE *f);
+extern char *zfile_suffix(char *filename);
+
+#endif /* _ZFILE_H */
+
+/* end of zfile.h */